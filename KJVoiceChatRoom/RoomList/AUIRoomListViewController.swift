@@ -100,6 +100,7 @@ final class AUIRoomListViewController: UIViewController {
         commonConfig.imClientId = KeyCenter.IMClientId
         commonConfig.imClientSecret = KeyCenter.IMClientSecret
         commonConfig.host = KeyCenter.HostUrl
+        commonConfig.collectionDeltaSyncEnabled = true
         let ownerInfo = AUIUserThumbnailInfo()
         ownerInfo.userId = userInfo.userId
         ownerInfo.userName = userInfo.userName
@@ -0,0 +1,192 @@
+//
+//  AUICollectionDeltaTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+@testable import AUIKitCore
+
+final class AUICollectionDeltaTests: XCTestCase {
+    private let channelName = "delta_test"
+    private let observeKey = "song"
+    private var rtmManager: AUIRtmManager!
+
+    override func setUpWithError() throws {
+        rtmManager = try AUICollectionTestSupport.makeRtmManager()
+    }
+
+    override func tearDown() {
+        rtmManager = nil
+    }
+
+    /// 房间内的一端, 记录最近一次变化回调的列表
+    private final class Peer {
+        let collection: AUIListCollection
+        private(set) var list: [[String: Any]] = []
+
+        init(channelName: String, observeKey: String, rtmManager: AUIRtmManager, deltaSyncEnabled: Bool = true) {
+            collection = AUIListCollection(channelName: channelName, observeKey: observeKey, rtmManager: rtmManager)
+            collection.deltaSyncEnabled = deltaSyncEnabled
+            collection.subscribeAttributesDidChanged { [weak self] _, _, model in
+                self?.list = model.getList() ?? []
+            }
+        }
+
+        /// 与 AUIRtmMsgProxy 一样按 key 排序送达, 快照先于 delta
+        func receive(_ metadata: [String: String], channelName: String) {
+            for key in metadata.keys.sorted() {
+                guard let value = decodeToJsonObj(metadata[key]!) else { continue }
+                collection.onAttributesDidChanged(channelName: channelName, key: key, value: value)
+            }
+        }
+    }
+
+    private func makePeer(deltaSyncEnabled: Bool = true) -> Peer {
+        return Peer(channelName: channelName, observeKey: observeKey, rtmManager: rtmManager, deltaSyncEnabled: deltaSyncEnabled)
+    }
+
+    /// 仲裁者写入一次, 写入的内容送达所有端(包括仲裁者自己)
+    @discardableResult
+    private func write(_ writer: Peer, from oldValue: [[String: Any]], to newValue: [[String: Any]], peers: [Peer]) throws -> [String: String] {
+        let metadata = try XCTUnwrap(writer.collection.encodeMetadata(oldValue: oldValue, newValue: newValue))
+        for peer in peers {
+            peer.receive(metadata, channelName: channelName)
+        }
+        return metadata
+    }
+
+    private func assertSynced(_ peer: Peer, _ expected: [[String: Any]], _ message: String, line: UInt = #line) {
+        XCTAssertTrue(AUICollectionDelta.isEqual(peer.list, expected), message, line: line)
+    }
+
+    func testReceiverFollowsDeltas() throws {
+        let writer = makePeer()
+        let receiver = makePeer()
+        var simulator = AUISongListSimulator(count: 30)
+        var current = simulator.list
+        try write(writer, from: [], to: current, peers: [writer, receiver])
+        var deltaOnlyCount = 0
+        for step in 0..<300 {
+            let next = simulator.step()
+            let metadata = try write(writer, from: current, to: next, peers: [writer, receiver])
+            if metadata[observeKey] == nil {
+                deltaOnlyCount += 1
+            }
+            current = next
+            assertSynced(receiver, current, "step \(step)")
+        }
+        XCTAssertGreaterThan(deltaOnlyCount, 150)
+    }
+
+    func testSequenceRestartAfterCleanReplaysSnapshot() throws {
+        let writer = makePeer()
+        let receiver = makePeer()
+        var simulator = AUISongListSimulator(count: 20)
+        var current = simulator.list
+        try write(writer, from: [], to: current, peers: [writer, receiver])
+        for _ in 0..<40 {
+            let next = simulator.step()
+            try write(writer, from: current, to: next, peers: [writer, receiver])
+            current = next
+        }
+        let oldEpoch = receiver.collection.deltaState.document?.epoch
+        XCTAssertGreaterThan(receiver.collection.deltaState.seq, 1)
+
+        /** 清理后序号从 1 开始, 新列表与清理前无关 **/
+        _ = writer.collection.cleanMetadataKeys()
+        simulator = AUISongListSimulator(count: 10, seed: 2)
+        current = simulator.list
+        try write(writer, from: [], to: current, peers: [writer, receiver])
+        XCTAssertEqual(receiver.collection.deltaState.seq, 1)
+        XCTAssertNotEqual(receiver.collection.deltaState.document?.epoch, oldEpoch)
+        assertSynced(receiver, current, "after clean")
+        for step in 0..<40 {
+            let next = simulator.step()
+            try write(writer, from: current, to: next, peers: [writer, receiver])
+            current = next
+            assertSynced(receiver, current, "step \(step) after clean")
+        }
+    }
+
+    func testNewArbiterWithoutDeltaReplaysSnapshot() throws {
+        let writer = makePeer()
+        let receiver = makePeer()
+        var simulator = AUISongListSimulator(count: 20)
+        var current = simulator.list
+        try write(writer, from: [], to: current, peers: [writer, receiver])
+        for _ in 0..<40 {
+            let next = simulator.step()
+            try write(writer, from: current, to: next, peers: [writer, receiver])
+            current = next
+        }
+
+        /** 仲裁者换成一个没有收到过 delta 的新实例 **/
+        let arbiter = makePeer()
+        let next = simulator.step()
+        try write(arbiter, from: current, to: next, peers: [arbiter, writer, receiver])
+        current = next
+        assertSynced(receiver, current, "new arbiter snapshot")
+        assertSynced(writer, current, "old arbiter")
+        for step in 0..<40 {
+            let next = simulator.step()
+            try write(arbiter, from: current, to: next, peers: [arbiter, writer, receiver])
+            current = next
+            assertSynced(receiver, current, "step \(step) after arbiter change")
+            assertSynced(writer, current, "step \(step) old arbiter")
+        }
+    }
+
+    /// 旧版本写入的 delta 没有 epoch, 序号变小同样视为重新开始
+    func testSequenceRestartWithoutEpoch() throws {
+        let receiver = makePeer()
+        let first = AUISongListSimulator(count: 5).list
+        receiver.receive([observeKey: try XCTUnwrap(encodeToJsonStr(first)),
+                          AUICollectionDelta.key(observeKey: observeKey): #"{"v":1,"base":1,"seq":3,"ops":[{"seq":2,"op":"remove","path":"/0"},{"seq":3,"op":"remove","path":"/0"}]}"#],
+                         channelName: channelName)
+        assertSynced(receiver, Array(first.dropFirst(2)), "first delta")
+
+        let second = AUISongListSimulator(count: 4, seed: 3).list
+        receiver.receive([observeKey: try XCTUnwrap(encodeToJsonStr(second)),
+                          AUICollectionDelta.key(observeKey: observeKey): #"{"v":1,"base":1,"seq":1,"ops":[]}"#],
+                         channelName: channelName)
+        assertSynced(receiver, second, "restarted")
+    }
+
+    // MARK: - 增量与全量改写的对比
+
+    /// 点歌列表 50 首左右, 修改 300 次: 仲裁者编码加接收端解析的总耗时, 以及平均每次写入的字节数
+    private func runSession(deltaSyncEnabled: Bool, steps: Int = 300) throws -> Int {
+        let writer = makePeer(deltaSyncEnabled: deltaSyncEnabled)
+        let receiver = makePeer(deltaSyncEnabled: deltaSyncEnabled)
+        var simulator = AUISongListSimulator(count: 50)
+        var current = simulator.list
+        try write(writer, from: [], to: current, peers: [writer, receiver])
+        var bytes = 0
+        for _ in 0..<steps {
+            let next = simulator.step()
+            bytes += try write(writer, from: current, to: next, peers: [writer, receiver]).values.reduce(0) { $0 + $1.utf8.count }
+            current = next
+        }
+        assertSynced(receiver, current, "deltaSyncEnabled: \(deltaSyncEnabled)")
+        return bytes / steps
+    }
+
+    func testDeltaWritesFewerBytes() throws {
+        let full = try runSession(deltaSyncEnabled: false)
+        let delta = try runSession(deltaSyncEnabled: true)
+        XCTContext.runActivity(named: "bytes per write: full \(full), delta \(delta)") { _ in }
+        XCTAssertLessThan(delta * 2, full)
+    }
+
+    func testPerformanceFullRewrite() {
+        measure {
+            _ = try? runSession(deltaSyncEnabled: false)
+        }
+    }
+
+    func testPerformanceDeltaSync() {
+        measure {
+            _ = try? runSession(deltaSyncEnabled: true)
+        }
+    }
+}
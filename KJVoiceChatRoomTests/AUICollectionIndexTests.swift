@@ -0,0 +1,208 @@
+//
+//  AUICollectionIndexTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+@testable import AUIKitCore
+
+final class AUICollectionIndexTests: XCTestCase {
+    private let channelName = "index_test"
+    private let observeKey = "song"
+    private var rtmManager: AUIRtmManager!
+
+    override func setUpWithError() throws {
+        rtmManager = try AUICollectionTestSupport.makeRtmManager()
+        AUICollectionTestSupport.becomeArbiter(channelName: channelName, rtmManager: rtmManager)
+    }
+
+    override func tearDown() {
+        AUIRoomContext.shared.clean(channelName: channelName)
+        rtmManager = nil
+    }
+
+    /// count 首歌, 另外带一个 Bool 字段
+    private func makeRows(count: Int) -> [[String: Any]] {
+        return (0..<count).map { index in
+            var row = AUICollectionTestSupport.song(index: index)
+            row["status"] = index % 3
+            row["isChorus"] = index % 5 == 0
+            return row
+        }
+    }
+
+    /// 按服务里常用的查询方式生成 filter: songCode、owner.userId、多个条件、多个 filter item、不存在的取值
+    private func makeFilters(rows: [[String: Any]], count: Int, seed: UInt64 = 1) -> [[[String: Any]]] {
+        var rng = AUISongListSimulator(count: 0, seed: seed)
+        return (0..<count).map { _ -> [[String: Any]] in
+            let row = rows[rng.random(rows.count)]
+            let userId = (row["owner"] as? [String: Any])?["userId"] ?? ""
+            switch rng.random(6) {
+            case 0:
+                return [["songCode": row["songCode"]!]]
+            case 1:
+                return [["owner": ["userId": userId]]]
+            case 2:
+                return [["owner": ["userId": userId], "status": row["status"]!]]
+            case 3:
+                return [["songCode": row["songCode"]!], ["isChorus": true, "status": 1]]
+            case 4:
+                return [["songCode": "missing"]]
+            default:
+                return [["songCode": row["songCode"]!, "owner": ["userId": "missing"]]]
+            }
+        }
+    }
+
+    func testItemIndexesMatchesLinearFilter() {
+        var rows = makeRows(count: 2000)
+        let index = AUICollectionIndex()
+        let filters = makeFilters(rows: rows, count: 500) + [[], [[:]], [["status": 1.5]], [["owner": ["userId": "10001", "userName": "用户 1"]]]]
+        for filter in filters {
+            XCTAssertEqual(index.itemIndexes(rows: rows, filter: filter), getItemIndexes(array: rows, filter: filter), "filter: \(filter)")
+        }
+        XCTAssertNil(index.itemIndexes(rows: rows, filter: [["songCode": "missing"]]))
+        XCTAssertEqual(index.itemIndexes(rows: rows, filter: nil)?.count, rows.count)
+
+        /** 增量维护后与重新扫描一致 **/
+        var rng = AUISongListSimulator(count: 0, seed: 2)
+        for step in 0..<200 {
+            if step % 2 == 0 {
+                let row = AUICollectionTestSupport.song(index: rows.count)
+                rows.append(row)
+                index.append(row: row)
+            } else {
+                let rowIndex = rng.random(rows.count)
+                var row = rows[rowIndex]
+                row["status"] = rng.random(3)
+                row["owner"] = ["userId": "\(10_000 + rng.random(8))"]
+                index.replace(at: rowIndex, oldRow: rows[rowIndex], newRow: row)
+                rows[rowIndex] = row
+            }
+            for filter in makeFilters(rows: rows, count: 5, seed: UInt64(step)) {
+                XCTAssertEqual(index.itemIndexes(rows: rows, filter: filter), getItemIndexes(array: rows, filter: filter), "step \(step) filter: \(filter)")
+            }
+        }
+    }
+
+    /// 状态降序, 同状态按点歌时间
+    private static func sorted(_ list: [[String: Any]]) -> [[String: Any]] {
+        return list.sorted { lhs, rhs in
+            let lhsStatus = lhs["status"] as? Int ?? 0
+            let rhsStatus = rhs["status"] as? Int ?? 0
+            if lhsStatus != rhsStatus {
+                return lhsStatus > rhsStatus
+            }
+            return (lhs["createAt"] as? Int ?? 0) < (rhs["createAt"] as? Int ?? 0)
+        }
+    }
+
+    /// 仲裁者上随机增删改, 与按 getItemIndexes 逐行过滤得到的结果比较
+    /// valueCmd 为 "sort" 时 attributesWillSet 重新排序, 索引需要重建; 其余修改走增量维护
+    func testCollectionIndexConsistency() {
+        let collection = AUIListCollection(channelName: channelName, observeKey: observeKey, rtmManager: rtmManager)
+        var list: [[String: Any]] = []
+        collection.subscribeAttributesDidChanged { _, _, model in
+            list = model.getList() ?? []
+        }
+        collection.subscribeAttributesWillSet { _, _, valueCmd, attr in
+            guard valueCmd == "sort", let rows = attr.getList() else { return }
+            attr.setList(AUICollectionIndexTests.sorted(rows))
+        }
+        var expected = makeRows(count: 40)
+        collection.onAttributesDidChanged(channelName: channelName, key: observeKey, value: expected)
+        XCTAssertTrue(AUICollectionDelta.isEqual(list, expected))
+
+        var rng = AUISongListSimulator(count: 0, seed: 3)
+        var nextIndex = expected.count
+        var failed = false
+        let callback: (NSError?) -> () = { error in
+            if error != nil {
+                failed = true
+            }
+        }
+        for step in 0..<400 {
+            /** 其他端写入的快照, 整体替换列表 **/
+            if step % 100 == 99 {
+                expected = Self.sorted(expected)
+                collection.onAttributesDidChanged(channelName: channelName, key: observeKey, value: expected)
+                XCTAssertTrue(AUICollectionDelta.isEqual(list, expected), "step \(step) snapshot")
+                continue
+            }
+            let valueCmd: String? = rng.random(4) == 0 ? "sort" : nil
+            var filter: [[String: Any]] = expected.isEmpty ? [["songCode": "missing"]] : makeFilters(rows: expected, count: 1, seed: UInt64(step)).first!
+            var next = expected
+            var shouldFail = false
+            failed = false
+            switch rng.random(5) {
+            case 0:
+                let song = AUICollectionTestSupport.song(index: nextIndex)
+                nextIndex += 1
+                //一半用新歌的 songCode 查重, 另一半沿用随机的 filter(命中时添加失败)
+                if rng.random(2) == 0 {
+                    filter = [["songCode": song["songCode"]!]]
+                }
+                shouldFail = getItemIndexes(array: expected, filter: filter) != nil
+                next.append(song)
+                collection.addMetaData(valueCmd: valueCmd, value: song, filter: filter, callback: callback)
+            case 1:
+                let value: [String: Any] = rng.random(2) == 0
+                    ? ["status": rng.random(3)]
+                    : ["owner": ["userId": "\(10_000 + rng.random(8))", "userName": "用户"]]
+                let indexes = getItemIndexes(array: expected, filter: filter) ?? []
+                shouldFail = indexes.isEmpty
+                for itemIdx in indexes {
+                    value.forEach { next[itemIdx][$0] = $1 }
+                }
+                collection.updateMetaData(valueCmd: valueCmd, value: value, filter: filter, callback: callback)
+            case 2:
+                let value: [String: Any] = ["owner": ["userId": "\(10_000 + rng.random(8))"]]
+                let indexes = getItemIndexes(array: expected, filter: filter) ?? []
+                shouldFail = indexes.isEmpty
+                for itemIdx in indexes {
+                    next[itemIdx] = mergeMap(origMap: next[itemIdx], newMap: value)
+                }
+                collection.mergeMetaData(valueCmd: valueCmd, value: value, filter: filter, callback: callback)
+            default:
+                let indexes = getItemIndexes(array: expected, filter: filter) ?? []
+                shouldFail = indexes.isEmpty
+                next = expected.enumerated().filter { !indexes.contains($0.offset) }.map { $0.element }
+                collection.removeMetaData(valueCmd: valueCmd, filter: filter, callback: callback)
+            }
+            if !shouldFail {
+                expected = valueCmd == "sort" ? Self.sorted(next) : next
+            }
+            XCTAssertEqual(failed, shouldFail, "step \(step) filter: \(filter)")
+            XCTAssertTrue(AUICollectionDelta.isEqual(list, expected), "step \(step) filter: \(filter)")
+        }
+    }
+
+    // MARK: - 索引与逐行扫描的对比
+
+    /// 10000 行, 200 次查询, 包含第一次查询时建索引的耗时
+    func testPerformanceItemIndexes() {
+        let rows = makeRows(count: 10_000)
+        let filters = makeFilters(rows: rows, count: 200)
+        measure {
+            let index = AUICollectionIndex()
+            var hits = 0
+            for filter in filters {
+                hits += index.itemIndexes(rows: rows, filter: filter)?.count ?? 0
+            }
+            XCTAssertGreaterThan(hits, 0)
+        }
+    }
+
+    /// 对照: 每次查询逐行匹配
+    func testPerformanceItemIndexesLinearScan() {
+        let rows = makeRows(count: 10_000)
+        let filters = makeFilters(rows: rows, count: 200)
+        measure {
+            var hits = 0
+            for filter in filters {
+                hits += getItemIndexes(array: rows, filter: filter)?.count ?? 0
+            }
+            XCTAssertGreaterThan(hits, 0)
+        }
+    }
+}
@@ -0,0 +1,209 @@
+//
+//  AUICollectionMessageCodecTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+@testable import AUIKitCore
+
+final class AUICollectionMessageCodecTests: XCTestCase {
+
+    /// 点歌请求: filter 为两个 filter item, data 带嵌套字典、列表和各种长度的整数与字符串
+    private func makeRequest() -> AUICollectionMessage {
+        var song = AUICollectionTestSupport.song(index: 7)
+        song["tags"] = (0..<20).map { "tag\($0)" }
+        song["extra"] = Dictionary(uniqueKeysWithValues: (0..<20).map { ("key\($0)", $0 * 1000) })
+        song["numbers"] = [0, 127, -1, -32, -33, -129, 255, 70_000, -70_000, 5_000_000_000, Int.max, Int.min]
+        song["isChorus"] = true
+        song["intro"] = String(repeating: "歌", count: 100)
+        song["lyric"] = String(repeating: "la ", count: 30_000)
+        let payload = AUICollectionMessagePayload(type: .add,
+                                                  dataCmd: "chooseSong",
+                                                  filter: AUIAnyType(array: [["songCode": song["songCode"]!],
+                                                                             ["owner": ["userId": "10007"]]]),
+                                                  data: AUIAnyType(map: song))
+        return AUICollectionMessage(channelName: "room_1",
+                                    messageType: .normal,
+                                    sceneKey: "song",
+                                    uniqueId: UUID().uuidString,
+                                    payload: payload)
+    }
+
+    private func makeReceipt() -> AUICollectionMessage {
+        let payload = AUICollectionMessagePayload(data: AUIAnyType(map: ["code": 0, "reason": ""]))
+        return AUICollectionMessage(channelName: "room_1",
+                                    messageType: .receipt,
+                                    sceneKey: "song",
+                                    uniqueId: UUID().uuidString,
+                                    payload: payload)
+    }
+
+    private func assertEqual(_ lhs: AUICollectionMessage?, _ rhs: AUICollectionMessage, line: UInt = #line) {
+        guard let lhs = lhs else {
+            XCTFail("decode fail", line: line)
+            return
+        }
+        XCTAssertEqual(lhs.channelName, rhs.channelName, line: line)
+        XCTAssertEqual(lhs.messageType, rhs.messageType, line: line)
+        XCTAssertEqual(lhs.sceneKey, rhs.sceneKey, line: line)
+        XCTAssertEqual(lhs.uniqueId, rhs.uniqueId, line: line)
+        XCTAssertEqual(lhs.payload.type, rhs.payload.type, line: line)
+        XCTAssertEqual(lhs.payload.dataCmd, rhs.payload.dataCmd, line: line)
+        XCTAssertEqual(lhs.payload.filter, rhs.payload.filter, line: line)
+        XCTAssertEqual(lhs.payload.data, rhs.payload.data, line: line)
+    }
+
+    func testRequestRoundTrip() {
+        let request = makeRequest()
+        let data = AUICollectionMessageCodec.encode(request)
+        XCTAssertEqual(AUICollectionMessageCodec.version(of: data), AUICollectionMessageCodec.version)
+        assertEqual(AUICollectionMessageCodec.decode(data), request)
+        assertEqual(AUICollectionMessageCodec.decode(data, sceneKey: "song"), request)
+        XCTAssertNil(AUICollectionMessageCodec.decode(data, sceneKey: "micSeat"))
+    }
+
+    func testReceiptRoundTrip() {
+        let receipt = makeReceipt()
+        let data = AUICollectionMessageCodec.encode(receipt)
+        assertEqual(AUICollectionMessageCodec.decode(data), receipt)
+        let decoded = AUICollectionMessageCodec.decode(data)
+        XCTAssertNil(decoded?.payload.type)
+        XCTAssertNil(decoded?.payload.dataCmd)
+        XCTAssertNil(decoded?.payload.filter)
+    }
+
+    /// 新版本在数组末尾追加的字段被忽略
+    func testDecodeIgnoresAppendedFields() {
+        let receipt = makeReceipt()
+        var bytes = [UInt8](AUICollectionMessageCodec.encode(receipt))
+        XCTAssertEqual(bytes[2], 0x98)
+        bytes[2] = 0x9A
+        bytes += [0x01, 0xA1, 0x78]
+        assertEqual(AUICollectionMessageCodec.decode(Data(bytes)), receipt)
+    }
+
+    func testDecodeRejectsTruncatedData() {
+        for message in [makeReceipt(), makeRequest()] {
+            let data = AUICollectionMessageCodec.encode(message)
+            let step = max(1, data.count / 2000)
+            for count in stride(from: 0, to: data.count, by: step) {
+                XCTAssertNil(AUICollectionMessageCodec.decode(data.prefix(count)), "prefix \(count) of \(data.count)")
+            }
+            XCTAssertNil(AUICollectionMessageCodec.decode(data.dropLast()))
+        }
+    }
+
+    func testDecodeRejectsHostileLengths() {
+        let header: [UInt8] = [0xC1, 0x01]
+        let fields: [UInt8] = [0xA1, 0x61, 0x01, 0xA1, 0x62, 0xA1, 0x63, 0x00, 0xC0]
+        let cases: [[UInt8]] = [
+            /** 数组、字符串、map 的长度远超剩余字节 **/
+            header + [0xDD, 0xFF, 0xFF, 0xFF, 0xFF] + fields,
+            header + [0x98, 0xDB, 0xFF, 0xFF, 0xFF, 0xFF, 0x61],
+            header + [0x98] + fields + [0xDD, 0xFF, 0xFF, 0xFF, 0xFF, 0x01],
+            header + [0x98] + fields + [0xDF, 0xFF, 0xFF, 0xFF, 0xFF, 0xA1, 0x61, 0x01],
+            header + [0x98] + fields + [0xDA, 0xFF, 0xFF, 0x61],
+            /** 字段数不足 **/
+            header + [0x97] + fields,
+            /** 嵌套过深 **/
+            header + [0x98] + fields + [UInt8](repeating: 0x91, count: 200) + [0x01],
+            /** 非法的 messageType、type **/
+            header + [0x98, 0xA1, 0x61, 0x09, 0xA1, 0x62, 0xA1, 0x63, 0x00, 0xC0, 0xC0, 0xC0],
+            header + [0x98, 0xA1, 0x61, 0x01, 0xA1, 0x62, 0xA1, 0x63, 0x63, 0xC0, 0xC0, 0xC0],
+            /** 版本 0、不是二进制消息 **/
+            [0xC1, 0x00, 0x98] + fields + [0xC0],
+            [UInt8]("{\"channelName\":\"room_1\"}".utf8),
+            [],
+        ]
+        for (index, bytes) in cases.enumerated() {
+            XCTAssertNil(AUICollectionMessageCodec.decode(Data(bytes)), "case \(index)")
+        }
+        /** 合法的最短消息, 确认上面失败的原因是长度而不是格式 **/
+        XCTAssertNotNil(AUICollectionMessageCodec.decode(Data(header + [0x98] + fields + [0xC0, 0xC0])))
+    }
+
+    /// 随机改写字节, 只要求不崩溃
+    func testDecodeMutatedData() {
+        let data = [UInt8](AUICollectionMessageCodec.encode(makeReceipt()))
+        var rng = AUISongListSimulator(count: 0, seed: 9)
+        for _ in 0..<5000 {
+            var bytes = data
+            for _ in 0...rng.random(4) {
+                bytes[2 + rng.random(bytes.count - 2)] = UInt8(rng.random(256))
+            }
+            _ = AUICollectionMessageCodec.decode(Data(bytes))
+        }
+    }
+
+    func testMessageCodecVersionsArePruned() throws {
+        let rtmManager = try AUICollectionTestSupport.makeRtmManager()
+        rtmManager.updateMessageCodecVersion(channelName: "room_1", userId: "a", version: 1)
+        rtmManager.updateMessageCodecVersion(channelName: "room_1", userId: "b", version: 1)
+        rtmManager.updateMessageCodecVersion(channelName: "room_2", userId: "a", version: 1)
+
+        rtmManager.onUserDidLeaved(channelName: "room_1", userId: "a", userInfo: [:])
+        XCTAssertEqual(rtmManager.messageCodecVersion(channelName: "room_1", userId: "a"), 0)
+        XCTAssertEqual(rtmManager.messageCodecVersion(channelName: "room_1", userId: "b"), 1)
+        XCTAssertEqual(rtmManager.messageCodecVersion(channelName: "room_2", userId: "a"), 1)
+
+        rtmManager.unSubscribe(channelName: "room_1")
+        XCTAssertNil(rtmManager.messageCodecVersions["room_1"])
+        XCTAssertEqual(rtmManager.messageCodecVersions, ["room_2": ["a": 1]])
+    }
+
+    // MARK: - json 与二进制的对比
+
+    /// 请求与回执各一条, 编码后再解析
+    private func sampleMessages() -> [AUICollectionMessage] {
+        var song = AUICollectionTestSupport.song(index: 7)
+        song["numbers"] = [1, 2, 3]
+        let payload = AUICollectionMessagePayload(type: .add,
+                                                  dataCmd: "chooseSong",
+                                                  filter: AUIAnyType(array: [["songCode": song["songCode"]!]]),
+                                                  data: AUIAnyType(map: song))
+        let request = AUICollectionMessage(channelName: "room_1",
+                                           messageType: .normal,
+                                           sceneKey: "song",
+                                           uniqueId: UUID().uuidString,
+                                           payload: payload)
+        return [request, makeReceipt()]
+    }
+
+    func testBinaryIsSmallerThanJson() throws {
+        for message in sampleMessages() {
+            let json = try XCTUnwrap(encodeModelToJsonStr(message))
+            let binary = AUICollectionMessageCodec.encode(message)
+            XCTContext.runActivity(named: "\(message.messageType): json \(json.utf8.count) bytes, binary \(binary.count) bytes") { _ in }
+            XCTAssertLessThan(binary.count, json.utf8.count)
+        }
+    }
+
+    func testPerformanceJsonCodec() {
+        let messages = sampleMessages()
+        measure {
+            for _ in 0..<1000 {
+                for message in messages {
+                    guard let json = encodeModelToJsonStr(message),
+                          let map = decodeToJsonObj(json) as? [String: Any] else {
+                        XCTFail("json fail")
+                        return
+                    }
+                    let decoded: AUICollectionMessage? = decodeModel(map)
+                    XCTAssertNotNil(decoded)
+                }
+            }
+        }
+    }
+
+    func testPerformanceBinaryCodec() {
+        let messages = sampleMessages()
+        measure {
+            for _ in 0..<1000 {
+                for message in messages {
+                    let data = AUICollectionMessageCodec.encode(message)
+                    XCTAssertNotNil(AUICollectionMessageCodec.decode(data))
+                }
+            }
+        }
+    }
+}
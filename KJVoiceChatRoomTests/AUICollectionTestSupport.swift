@@ -0,0 +1,91 @@
+//
+//  AUICollectionTestSupport.swift
+//  KJVoiceChatRoomTests
+//
+
+import Foundation
+import AgoraRtmKit
+@testable import AUIKitCore
+
+enum AUICollectionTestSupport {
+    /// 不登录的 AUIRtmManager, 只用于创建 collection; 测试直接调用 collection 的回调, 不经过 rtm
+    /// inMemoryMetadata 为true时 metadata 的写入不会发到 rtm, 直接回调成功
+    static func makeRtmManager(userId: String = "1", inMemoryMetadata: Bool = true) throws -> AUIRtmManager {
+        let config = AgoraRtmClientConfig(appId: "aui_collection_test", userId: userId)
+        let client = try AgoraRtmClientKit(config, delegate: nil)
+        let rtmManager = AUIRtmManager(rtmClient: client, rtmChannelType: .message, isExternalLogin: true)
+        guard inMemoryMetadata else { return rtmManager }
+        rtmManager.metadataScheduler = AUIMetadataCommitScheduler(setHandler: { _, _, _, completion in
+            completion(nil)
+        }, removeHandler: { _, _, _, completion in
+            completion(nil)
+        })
+        return rtmManager
+    }
+
+    /// 让当前用户成为 channelName 的仲裁者, collection 的修改直接在本地执行; 测试结束时调用 AUIRoomContext.shared.clean(channelName:)
+    static func becomeArbiter(channelName: String, rtmManager: AUIRtmManager) {
+        let userInfo = AUIRoomContext.shared.currentUserInfo
+        let arbiter = AUIArbiter(channelName: channelName, rtmManager: rtmManager, userInfo: userInfo)
+        let lockDetail = AgoraRtmLockDetail()
+        lockDetail.owner = userInfo.userId
+        arbiter.onReceiveLockDetail(channelName: channelName, lockDetail: lockDetail)
+        AUIRoomContext.shared.roomArbiterMap[channelName] = arbiter
+    }
+
+    /// 点歌列表中的一首歌, 字段与 AUIChooseMusicModel 一致
+    static func song(index: Int) -> [String: Any] {
+        return ["songCode": "\(6_625_526_000 + index)",
+                "name": "示例歌曲 \(index)",
+                "singer": "示例歌手 \(index % 17)",
+                "poster": "https://accktv.sd-rtn.com/202309/poster/\(index).jpg",
+                "duration": 180 + index % 120,
+                "musicUrl": "",
+                "lrcUrl": "https://accktv.sd-rtn.com/202309/lyric/\(index).zip",
+                "owner": ["userId": "\(10_000 + index % 8)",
+                          "userName": "用户 \(index % 8)",
+                          "userAvatar": "https://accktv.sd-rtn.com/avatar/\(index % 8).png"],
+                "pinAt": 0,
+                "createAt": 1_700_000_000_000 + index * 1000,
+                "status": 0]
+    }
+}
+
+/// 按固定种子随机修改点歌列表: 点歌、删歌、改状态, 偶尔置顶
+struct AUISongListSimulator {
+    private var state: UInt64
+    private var nextIndex = 0
+    private(set) var list: [[String: Any]] = []
+
+    init(count: Int, seed: UInt64 = 1) {
+        state = seed
+        for _ in 0..<count {
+            list.append(AUICollectionTestSupport.song(index: nextIndex))
+            nextIndex += 1
+        }
+    }
+
+    mutating func random(_ bound: Int) -> Int {
+        state = state &* 6364136223846793005 &+ 1442695040888963407
+        return Int(state >> 33) % bound
+    }
+
+    /// 修改一次, 返回修改后的列表
+    mutating func step() -> [[String: Any]] {
+        switch random(8) {
+        case 0...2 where list.count < 80, _ where list.count < 5:
+            list.append(AUICollectionTestSupport.song(index: nextIndex))
+            nextIndex += 1
+        case 3, 4:
+            list.remove(at: random(list.count))
+        case 5, 6:
+            let index = random(list.count)
+            list[index]["status"] = ((list[index]["status"] as? Int ?? 0) + 1) % 3
+        default:
+            var item = list.remove(at: 1 + random(list.count - 1))
+            item["pinAt"] = 1_700_000_000_000 + nextIndex
+            list.insert(item, at: 1)
+        }
+        return list
+    }
+}
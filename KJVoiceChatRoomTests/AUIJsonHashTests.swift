@@ -0,0 +1,172 @@
+//
+//  AUIJsonHashTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+import AgoraRtmKit
+@testable import AUIKitCore
+
+final class AUIJsonHashTests: XCTestCase {
+
+    private func hash(_ json: String, line: UInt = #line) throws -> UInt64 {
+        return try XCTUnwrap(AUIJsonHash.hash(jsonString: json), json, line: line)
+    }
+
+    /// 不同终端序列化出的同一个值
+    func testSameValueSameHash() throws {
+        let cases: [(String, String)] = [
+            ("{\"a\":1,\"b\":[1,2],\"c\":{\"d\":null,\"e\":true}}",
+             " {\n\t\"c\" : { \"e\" : true , \"d\" : null } ,\r\n \"b\" : [ 1 , 2 ] , \"a\" : 1 } "),
+            ("{\"url\":\"http:\\/\\/x\\/y\"}", "{\"url\":\"http://x/y\"}"),
+            ("\"\\uD83C\\uDFB5 \\u4e2d\"", "\"🎵 中\""),
+            ("\"\\\"\\\\\\b\\f\\n\\r\\t\"", "\"\\u0022\\u005C\\u0008\\u000C\\u000A\\u000D\\u0009\""),
+            ("[1]", "[1.0]"),
+            ("[100]", "[1e2]"),
+            ("[-3]", "[-3.000]"),
+            ("[0.5]", "[5e-1]"),
+            ("[]", "[ ]"),
+            ("{}", "{ }"),
+        ]
+        for (lhs, rhs) in cases {
+            XCTAssertEqual(try hash(lhs), try hash(rhs), "\(lhs) vs \(rhs)")
+        }
+    }
+
+    /// JSONSerialization 不同选项的输出(key 顺序、缩进)
+    func testJSONSerializationOptions() throws {
+        var rng = AUISongListSimulator(count: 0, seed: 3)
+        for index in 0..<50 {
+            var song = AUICollectionTestSupport.song(index: index)
+            song["cover"] = "https://example.com/cover/\(index).jpg"
+            song["tags"] = (0..<rng.random(5)).map { "标签\($0)" }
+            song["score"] = Double(rng.random(1000)) / 8
+            let compact = try JSONSerialization.data(withJSONObject: song)
+            let pretty = try JSONSerialization.data(withJSONObject: song, options: [.prettyPrinted, .sortedKeys])
+            XCTAssertEqual(try hash(String(decoding: compact, as: UTF8.self)),
+                           try hash(String(decoding: pretty, as: UTF8.self)), "song \(index)")
+        }
+    }
+
+    func testDifferentValueDifferentHash() throws {
+        let cases: [(String, String)] = [
+            ("{\"a\":1,\"b\":2}", "{\"a\":2,\"b\":1}"),
+            ("[1,2]", "[2,1]"),
+            ("{\"a\":{\"b\":1}}", "{\"a\":{\"c\":1}}"),
+            ("{\"a\":[1]}", "{\"a\":1}"),
+            ("\"1\"", "1"),
+            ("1", "1.5"),
+            ("0", "false"),
+            ("null", "false"),
+            ("{}", "[]"),
+            ("\"a\"", "\"a \""),
+            ("\"\"", "[]"),
+            ("12345678901234567890", "12345678901234567891"),
+            ("-98765432109876543210", "98765432109876543210"),
+            ("9223372036854775807", "9223372036854775808"),
+        ]
+        for (lhs, rhs) in cases {
+            XCTAssertNotEqual(try hash(lhs), try hash(rhs), "\(lhs) vs \(rhs)")
+        }
+    }
+
+    func testInvalidJsonReturnsNil() {
+        let cases = [
+            "",
+            "   ",
+            "{",
+            "{\"a\":1,}",
+            "{\"a\" 1}",
+            "{'a':1}",
+            "{a:1}",
+            "[1,]",
+            "[,1]",
+            "[1]]",
+            "1 2",
+            "tru",
+            "nul",
+            "\"abc",
+            "\"\\x\"",
+            "\"\\u12\"",
+            "-",
+            "+1",
+            "NaN",
+            "1e999",
+            "<song/>",
+            String(repeating: "[", count: 600) + String(repeating: "]", count: 600),
+        ]
+        for json in cases {
+            XCTAssertNil(AUIJsonHash.hash(jsonString: json), json)
+        }
+        XCTAssertNotNil(AUIJsonHash.hash(jsonString: String(repeating: "[", count: 100) + String(repeating: "]", count: 100)))
+    }
+
+    // MARK: - AUIRtmMsgProxy
+
+    /// 记录回调的 "a" 字段
+    private final class AttributesRecorder: NSObject, AUIRtmAttributesProxyDelegate {
+        var values: [Int] = []
+
+        func onAttributesDidChanged(channelName: String, key: String, value: Any) {
+            values.append((value as? [String: Any])?["a"] as? Int ?? -1)
+        }
+    }
+
+    private func process(_ proxy: AUIRtmMsgProxy, _ value: String) {
+        proxy.processMetaData(channelName: "room_1", data: AgoraRtmMetadata.createMetadata(metadata: ["song": value]))
+    }
+
+    private func drainMainQueue() {
+        let drained = expectation(description: "main queue")
+        DispatchQueue.main.async {
+            drained.fulfill()
+        }
+        wait(for: [drained], timeout: 1)
+    }
+
+    /// 没变的值(序列化不同)不再回调; 后订阅的 delegate 从缓存补发一次, 补发前收到同样的值不重复回调
+    func testUnchangedValueIsNotRedispatched() {
+        let proxy = AUIRtmMsgProxy(rtmChannelType: .message)
+        let first = AttributesRecorder()
+        proxy.subscribeAttributes(channelName: "room_1", itemKey: "song", delegate: first)
+        drainMainQueue()
+        XCTAssertEqual(first.values, [])
+
+        process(proxy, "{\"a\":1,\"b\":\"x/y\"}")
+        XCTAssertEqual(first.values, [1])
+        process(proxy, "{ \"b\" : \"x\\/y\", \"a\" : 1.0 }")
+        XCTAssertEqual(first.values, [1])
+        process(proxy, "{\"a\":2,\"b\":\"x/y\"}")
+        XCTAssertEqual(first.values, [1, 2])
+
+        let late = AttributesRecorder()
+        proxy.subscribeAttributes(channelName: "room_1", itemKey: "song", delegate: late)
+        XCTAssertEqual(late.values, [])
+        process(proxy, "{\"b\":\"x/y\",\"a\":2}")
+        drainMainQueue()
+        XCTAssertEqual(first.values, [1, 2])
+        XCTAssertEqual(late.values, [2])
+
+        /** 补发之后没变的值不回调, 变化的值两个 delegate 各回调一次 **/
+        process(proxy, "{\"a\":2,\"b\":\"x/y\"}")
+        XCTAssertEqual(late.values, [2])
+        process(proxy, "{\"a\":3,\"b\":\"x/y\"}")
+        XCTAssertEqual(first.values, [1, 2, 3])
+        XCTAssertEqual(late.values, [2, 3])
+
+        /** 取消订阅后再订阅, 补发一次 **/
+        proxy.unsubscribeAttributes(channelName: "room_1", itemKey: "song", delegate: late)
+        process(proxy, "{\"a\":4,\"b\":\"x/y\"}")
+        proxy.subscribeAttributes(channelName: "room_1", itemKey: "song", delegate: late)
+        process(proxy, "{\"a\":4,\"b\":\"x/y\"}")
+        drainMainQueue()
+        XCTAssertEqual(first.values, [1, 2, 3, 4])
+        XCTAssertEqual(late.values, [2, 3, 4])
+
+        /** 清理缓存后同样的值重新回调 **/
+        proxy.cleanCache(channelName: "room_1")
+        process(proxy, "{\"a\":4,\"b\":\"x/y\"}")
+        XCTAssertEqual(first.values, [1, 2, 3, 4, 4])
+        XCTAssertEqual(late.values, [2, 3, 4, 4])
+    }
+}
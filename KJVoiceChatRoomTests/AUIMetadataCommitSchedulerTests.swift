@@ -0,0 +1,176 @@
+//
+//  AUIMetadataCommitSchedulerTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+@testable import AUIKitCore
+
+final class AUIMetadataCommitSchedulerTests: XCTestCase {
+    typealias Completion = AUIMetadataCommitScheduler.Completion
+
+    /// 记录实际的写入, completion 由测试决定何时回调
+    private struct SetCall {
+        let channelName: String
+        let lockName: String
+        let metadata: [String: String]
+        let completion: Completion
+    }
+
+    private struct RemoveCall {
+        let channelName: String
+        let lockName: String
+        let keys: [String]
+        let completion: Completion
+    }
+
+    private var setCalls: [SetCall] = []
+    private var removeCalls: [RemoveCall] = []
+    private var scheduler: AUIMetadataCommitScheduler!
+
+    override func setUp() {
+        setCalls = []
+        removeCalls = []
+        scheduler = AUIMetadataCommitScheduler(setHandler: { [unowned self] channelName, lockName, metadata, completion in
+            self.setCalls.append(SetCall(channelName: channelName, lockName: lockName, metadata: metadata, completion: completion))
+        }, removeHandler: { [unowned self] channelName, lockName, keys, completion in
+            self.removeCalls.append(RemoveCall(channelName: channelName, lockName: lockName, keys: keys, completion: completion))
+        })
+    }
+
+    override func tearDown() {
+        scheduler = nil
+    }
+
+    private func runLoop(for interval: TimeInterval) {
+        RunLoop.current.run(until: Date(timeIntervalSinceNow: interval))
+    }
+
+    func testBatchesAreIsolatedByChannelAndLock() {
+        scheduler.set(channelName: "a", lockName: "lock1", metadata: ["k": "a1"]) { _ in }
+        scheduler.set(channelName: "b", lockName: "lock1", metadata: ["k": "b1"]) { _ in }
+        scheduler.set(channelName: "a", lockName: "lock2", metadata: ["k": "a2"]) { _ in }
+        scheduler.remove(channelName: "b", lockName: "lock2", keys: ["k"]) { _ in }
+        XCTAssertTrue(setCalls.isEmpty)
+
+        scheduler.flush(channelName: "a")
+        XCTAssertEqual(setCalls.count, 2)
+        XCTAssertTrue(removeCalls.isEmpty)
+        let channelA = Dictionary(uniqueKeysWithValues: setCalls.map { ($0.lockName, $0.metadata) })
+        XCTAssertEqual(channelA, ["lock1": ["k": "a1"], "lock2": ["k": "a2"]])
+        XCTAssertTrue(setCalls.allSatisfy { $0.channelName == "a" })
+
+        /** 其他 channel 按 window 提交 **/
+        let committed = expectation(description: "window")
+        DispatchQueue.main.asyncAfter(deadline: .now() + 0.1) {
+            committed.fulfill()
+        }
+        wait(for: [committed], timeout: 1)
+        XCTAssertEqual(setCalls.count, 3)
+        XCTAssertEqual(setCalls.last?.channelName, "b")
+        XCTAssertEqual(setCalls.last?.lockName, "lock1")
+        XCTAssertEqual(setCalls.last?.metadata, ["k": "b1"])
+        XCTAssertEqual(removeCalls.count, 1)
+        XCTAssertEqual(removeCalls.first?.channelName, "b")
+        XCTAssertEqual(removeCalls.first?.lockName, "lock2")
+        XCTAssertEqual(removeCalls.first?.keys, ["k"])
+    }
+
+    func testLastWriteWinsBetweenSetAndRemove() {
+        scheduler.set(channelName: "a", lockName: "lock", metadata: ["k1": "v1", "k2": "v1"]) { _ in }
+        scheduler.remove(channelName: "a", lockName: "lock", keys: ["k1", "k3"]) { _ in }
+        scheduler.remove(channelName: "a", lockName: "lock", keys: ["k2"]) { _ in }
+        scheduler.set(channelName: "a", lockName: "lock", metadata: ["k2": "v2", "k3": "v2"]) { _ in }
+        scheduler.set(channelName: "a", lockName: "lock", metadata: ["k3": "v3"]) { _ in }
+        scheduler.flushAll()
+
+        XCTAssertEqual(setCalls.count, 1)
+        XCTAssertEqual(setCalls.first?.metadata, ["k2": "v2", "k3": "v3"])
+        XCTAssertEqual(removeCalls.count, 1)
+        XCTAssertEqual(removeCalls.first?.keys, ["k1"])
+    }
+
+    func testMaxPendingBytesCommitsImmediately() {
+        scheduler.maxPendingBytes = 100
+        let value = String(repeating: "x", count: 60)
+        scheduler.set(channelName: "a", lockName: "lock", metadata: ["k1": value]) { _ in }
+        /** 覆盖同一个 key 不累加字节数 **/
+        scheduler.set(channelName: "a", lockName: "lock", metadata: ["k1": value]) { _ in }
+        XCTAssertTrue(setCalls.isEmpty)
+
+        scheduler.set(channelName: "a", lockName: "lock", metadata: ["k2": value]) { _ in }
+        XCTAssertEqual(setCalls.count, 1)
+        XCTAssertEqual(setCalls.first?.metadata.keys.sorted(), ["k1", "k2"])
+
+        scheduler.set(channelName: "a", lockName: "lock", metadata: ["k3": "v"]) { _ in }
+        XCTAssertEqual(setCalls.count, 1)
+        scheduler.set(channelName: "a", lockName: "lock", metadata: ["k4": "v"], fetchImmediately: true) { _ in }
+        XCTAssertEqual(setCalls.count, 2)
+        XCTAssertEqual(setCalls.last?.metadata, ["k3": "v", "k4": "v"])
+    }
+
+    /// 连续写入的间隔小于 window 时, 最多等 maxDelay 提交一次
+    func testMaxDelayBoundsContinuousWrites() {
+        scheduler.window = 0.05
+        scheduler.maxDelay = 0.15
+        let start = Date()
+        var firstCommit: TimeInterval?
+        for index in 0..<20 {
+            scheduler.set(channelName: "a", lockName: "lock", metadata: ["k\(index)": "v"]) { _ in }
+            runLoop(for: 0.02)
+            if firstCommit == nil, !setCalls.isEmpty {
+                firstCommit = -start.timeIntervalSinceNow
+            }
+        }
+        XCTAssertGreaterThanOrEqual(setCalls.count, 2)
+        XCTAssertLessThan(firstCommit ?? .infinity, 0.3)
+
+        scheduler.flushAll()
+        let keys = setCalls.flatMap { $0.metadata.keys }
+        XCTAssertEqual(keys.count, 20)
+        XCTAssertEqual(Set(keys).count, 20)
+    }
+
+    func testCompletionFanOutWithFirstError() {
+        var results: [NSError?] = []
+        for index in 0..<3 {
+            scheduler.set(channelName: "a", lockName: "lock", metadata: ["k\(index)": "v"]) { results.append($0) }
+        }
+        scheduler.remove(channelName: "a", lockName: "lock", keys: ["old"]) { results.append($0) }
+        scheduler.flushAll()
+        XCTAssertEqual(setCalls.count, 1)
+        XCTAssertEqual(removeCalls.count, 1)
+
+        /** set 和 remove 都完成后才回调, 所有调用方拿到先返回的错误 **/
+        let removeError = NSError(domain: "test", code: 1)
+        let setError = NSError(domain: "test", code: 2)
+        removeCalls[0].completion(removeError)
+        XCTAssertTrue(results.isEmpty)
+        setCalls[0].completion(setError)
+        XCTAssertEqual(results.count, 4)
+        XCTAssertTrue(results.allSatisfy { $0 === removeError })
+
+        /** 没有实际写入的批次直接回调成功 **/
+        var emptyResult: NSError? = removeError
+        scheduler.set(channelName: "a", lockName: "lock", metadata: [:], fetchImmediately: true) { emptyResult = $0 }
+        XCTAssertNil(emptyResult)
+        XCTAssertEqual(setCalls.count, 1)
+    }
+
+    /// manager 释放时未提交的写入回调失败, 不会丢失
+    func testPendingWritesFailWhenManagerReleased() throws {
+        var result: NSError?
+        var isCalled = false
+        try autoreleasepool {
+            let rtmManager = try AUICollectionTestSupport.makeRtmManager(inMemoryMetadata: false)
+            rtmManager.metadataCommitWindow = 10
+            rtmManager.metadataCommitMaxDelay = 10
+            rtmManager.setBatchMetadata(channelName: "a", lockName: "lock", metadata: ["k": "v"]) { error in
+                isCalled = true
+                result = error
+            }
+        }
+        XCTAssertTrue(isCalled)
+        XCTAssertNotNil(result)
+    }
+}
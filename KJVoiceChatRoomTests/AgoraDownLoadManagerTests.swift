@@ -0,0 +1,102 @@
+//
+//  AgoraDownLoadManagerTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+import Zip
+@testable import AUIKitCore
+
+final class AgoraDownLoadManagerTests: XCTestCase {
+
+    private var server: LocalHTTPServer!
+
+    override func setUpWithError() throws {
+        server = try LocalHTTPServer(chunkSize: 2 * 1024)
+        try server.start()
+    }
+
+    override func tearDownWithError() throws {
+        server.stop()
+        server = nil
+    }
+
+    /// 每个用例用不同的文件名, 不会命中上一次留下的缓存
+    private func uniqueName() -> String {
+        let name = "lyric_\(UUID().uuidString.replacingOccurrences(of: "-", with: ""))"
+        addTeardownBlock {
+            let folder = String.cacheFolderPath()
+            try? FileManager.default.removeItem(atPath: "\(folder)/\(name).xml")
+            try? FileManager.default.removeItem(atPath: "\(folder)/\(name).zip")
+        }
+        return name
+    }
+
+    func testStreamingDownloadDeliversLyrics() throws {
+        let name = uniqueName()
+        let xml = ZipTests.sampleText(lines: 3000)
+        let archive = try Zip.zipToData([ArchiveFile(filename: "\(name).xml", data: xml as NSData, modifiedTime: nil)])
+        server.setRoute("/\(name).zip", body: archive)
+
+        let manager = AgoraDownLoadManager()
+        let finished = expectation(description: "completion")
+        finished.assertForOverFulfill = false
+        var lyricPath: String?
+        manager.downloadLrcFile(urlString: "\(server.baseURL)/\(name).zip", completion: { path in
+            if lyricPath == nil {
+                lyricPath = path
+            }
+            finished.fulfill()
+        }, failure: {
+            XCTFail("download failed")
+        })
+        wait(for: [finished], timeout: 10)
+
+        let path = try XCTUnwrap(lyricPath)
+        XCTAssertTrue(path.hasSuffix("\(name).xml"))
+        XCTAssertEqual(try Data(contentsOf: URL(fileURLWithPath: path)), xml)
+    }
+
+    func testMissingFileCallsFailure() {
+        let manager = AgoraDownLoadManager()
+        let failed = expectation(description: "failure")
+        manager.downloadLrcFile(urlString: "\(server.baseURL)/\(uniqueName()).zip", completion: { _ in
+            XCTFail("missing file completed")
+        }, failure: {
+            failed.fulfill()
+        })
+        wait(for: [failed], timeout: 10)
+    }
+
+    func testRequestWithoutCacheReportsError() throws {
+        let name = uniqueName()
+        server.setRoute("/\(name).zip", body: try Zip.zipToData([ArchiveFile(filename: "\(name).xml", data: ZipTests.sampleText(lines: 100) as NSData, modifiedTime: nil)]))
+
+        for streaming in [true, false] {
+            let delegate = RequestDelegate()
+            delegate.failed = expectation(description: "error streaming: \(streaming)")
+            let request = AgoraRequestTask()
+            request.cache = false
+            request.delegate = delegate
+            request.dataReceived = streaming ? { _ in } : nil
+            request.download(requestURL: URL(string: "\(server.baseURL)/\(name).zip"))
+            wait(for: [delegate.failed!], timeout: 10)
+            XCTAssertFalse(delegate.didFinish)
+        }
+        XCTAssertNil(AgoraCacheFileHandle.cacheFileExists(with: "\(name).zip"))
+    }
+}
+
+private class RequestDelegate: NSObject, AgoraLrcDownloadDelegate {
+    var failed: XCTestExpectation?
+    var didFinish = false
+
+    func downloadLrcFinished(url: String) {
+        didFinish = true
+    }
+
+    func downloadLrcError(url: String, error: Error?) {
+        XCTAssertNotNil(error)
+        failed?.fulfill()
+    }
+}
@@ -0,0 +1,186 @@
+//
+//  DTWScoreAlgorithmTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+@testable import AgoraLyricsScore
+
+final class DTWScoreAlgorithmTests: XCTestCase {
+
+    /// 一行歌词, 每个字 toneDuration 毫秒, 字之间空 gap 毫秒, 从 10s 开始
+    private func makeLyric(stdPitches: [Double], toneDuration: Int = 300, gap: Int = 20) -> LyricModel {
+        var tones = [LyricToneModel]()
+        var time = 10_000
+        for pitch in stdPitches {
+            tones.append(LyricToneModel(beginTime: time, duration: toneDuration, word: "啦", pitch: pitch, lang: .zh, pronounce: ""))
+            time += toneDuration + gap
+        }
+        let line = LyricLineModel(beginTime: tones.first!.beginTime,
+                                  duration: tones.last!.endTime - tones.first!.beginTime,
+                                  content: String(repeating: "啦", count: tones.count),
+                                  tones: tones)
+        return LyricModel(name: "dtw", singer: "", type: .slow, lines: [line], preludeEndPosition: 0, duration: time + 1000, hasPitch: true)
+    }
+
+    /// 每 10ms 一个pitch, 第 i 个字在 [开始 + lagMs, 结束 + lagMs] 内唱 sungPitches[i], 其余时间无声
+    private func makePitchTrack(lyric: LyricModel, sungPitches: [Double], lagMs: Int) -> [(timeMs: Int, pitch: Double)] {
+        let tones = lyric.lines.flatMap({ $0.tones })
+        var track = [(timeMs: Int, pitch: Double)]()
+        for time in stride(from: tones.first!.beginTime - 1000, through: tones.last!.endTime + 1000, by: 10) {
+            let index = tones.firstIndex(where: { $0.beginTime + lagMs <= time && time <= $0.endTime + lagMs })
+            track.append((time, index.map({ sungPitches[$0] }) ?? 0))
+        }
+        return track
+    }
+
+    private func score(lyric: LyricModel, pitchTrack: [(timeMs: Int, pitch: Double)], algorithm: IScoreAlgorithm) -> PerformanceScore {
+        let engine = ScoreEngine()
+        engine.scoreAlgorithm = algorithm
+        return engine.score(lyric: lyric, pitchTrack: pitchTrack)
+    }
+
+    /// 相邻的字相差 6 个半音 (不触发八度补偿), 唱准但整体落后: 按进度打分时每个字前半段算到上一个字上, 对齐后不丢分
+    func testLateLineKeepsScore() {
+        let stdPitches: [Double] = (0..<8).map({ $0 % 2 == 0 ? 200 : 283 })
+        let lyric = makeLyric(stdPitches: stdPitches)
+        var cursorScores = [Int]()
+        for lagMs in [0, 150, 250] {
+            let track = makePitchTrack(lyric: lyric, sungPitches: stdPitches, lagMs: lagMs)
+            let cursor = score(lyric: lyric, pitchTrack: track, algorithm: ScoreAlgorithm()).lineScores[0]
+            let aligned = score(lyric: lyric, pitchTrack: track, algorithm: DTWScoreAlgorithm()).lineScores[0]
+            XCTContext.runActivity(named: "\(lagMs)ms late: cursor \(cursor), aligned \(aligned)") { _ in }
+            XCTAssertEqual(aligned, 100, "lagMs: \(lagMs)")
+            cursorScores.append(cursor)
+        }
+        XCTAssertEqual(cursorScores[0], 100)
+        XCTAssertLessThan(cursorScores[1], 70)
+        XCTAssertLessThan(cursorScores[2], cursorScores[1])
+
+        /** 超出 bandMs 的偏差不再补偿 **/
+        let algorithm = DTWScoreAlgorithm()
+        algorithm.bandMs = 100
+        let track = makePitchTrack(lyric: lyric, sungPitches: stdPitches, lagMs: 250)
+        XCTAssertLessThan(score(lyric: lyric, pitchTrack: track, algorithm: algorithm).lineScores[0], 100)
+    }
+
+    /// 标准pitch都相同, 按时演唱, 其中两个字唱偏: 每个字只用自己的采样, 唱偏的字不会借用相邻字的采样
+    func testOnTimeLineKeepsOwnSamples() {
+        let stdPitches = [Double](repeating: 200, count: 6)
+        let sungPitches: [Double] = [200, 200, 240, 200, 170, 200]
+        let lyric = makeLyric(stdPitches: stdPitches, toneDuration: 230)
+        let track = makePitchTrack(lyric: lyric, sungPitches: sungPitches, lagMs: 0)
+        let cursor = score(lyric: lyric, pitchTrack: track, algorithm: ScoreAlgorithm())
+        let aligned = score(lyric: lyric, pitchTrack: track, algorithm: DTWScoreAlgorithm())
+        XCTAssertEqual(aligned.lineScores, cursor.lineScores)
+        for (lhs, rhs) in zip(cursor.toneScores[0], aligned.toneScores[0]) {
+            XCTAssertEqual(lhs.score, rhs.score, accuracy: 0.001)
+        }
+        XCTAssertLessThan(aligned.toneScores[0][2].score, 100)
+        XCTAssertLessThan(aligned.toneScores[0][4].score, 100)
+    }
+
+    // MARK: - 与穷举的对比
+
+    /// 穷举每个采样对齐到带内的字 (单调不减), 返回所有累计得分最大的对齐对应的字得分
+    private func bruteForceOptima(beginTimes: [Int], endTimes: [Int], stdPitches: [Double],
+                                  samples: [(time: Int, pitch: Double)], bandMs: Int) -> [[Float]] {
+        let toneCount = stdPitches.count
+        func cellScore(_ sample: Int, _ tone: Int) -> Float {
+            let pitch = pitchScorerHandlePitch(nil, stdPitches[tone], samples[sample].pitch, 0)
+            return pitchScorerScore(nil, pitch, stdPitches[tone], 15, 0)
+        }
+        func penalty(_ sample: Int, _ tone: Int) -> Double {
+            let time = samples[sample].time
+            let distance = time < beginTimes[tone] ? beginTimes[tone] - time : max(0, time - endTimes[tone])
+            return bandMs > 0 ? Double(distance) / Double(bandMs) : 0
+        }
+        var best = -Double.greatestFiniteMagnitude
+        var optima = [[Float]]()
+        var assignment = [Int](repeating: 0, count: samples.count)
+        func visit(_ sample: Int, _ minTone: Int, _ total: Double) {
+            if sample == samples.count {
+                if total > best + 1e-9 {
+                    best = total
+                    optima = []
+                }
+                if abs(total - best) <= 1e-9 {
+                    var sums = [Float](repeating: 0, count: toneCount)
+                    var counts = [Int](repeating: 0, count: toneCount)
+                    for index in stride(from: samples.count - 1, through: 0, by: -1) {
+                        sums[assignment[index]] += cellScore(index, assignment[index])
+                        counts[assignment[index]] += 1
+                    }
+                    optima.append((0..<toneCount).map({ counts[$0] > 0 ? sums[$0] / Float(counts[$0]) : 0 }))
+                }
+                return
+            }
+            let time = samples[sample].time
+            for tone in minTone..<toneCount where beginTimes[tone] - bandMs <= time && time <= endTimes[tone] + bandMs {
+                assignment[sample] = tone
+                visit(sample + 1, tone, total + Double(cellScore(sample, tone)) - penalty(sample, tone))
+            }
+        }
+        visit(0, 0, 0)
+        return optima
+    }
+
+    /// 随机的短句 (1~4 个字, 8 个采样, 含无声和带外的采样), PitchAligner 的结果是穷举的最优解之一
+    func testAlignerMatchesBruteForce() {
+        var state: UInt64 = 1
+        func next(_ bound: Int) -> Int {
+            state = state &* 6364136223846793005 &+ 1442695040888963407
+            return Int(state >> 33) % bound
+        }
+        let aligner = pitchAlignerCreate()
+        defer { pitchAlignerDestroy(aligner) }
+        var checked = 0
+        for round in 0..<1000 {
+            let toneCount = 1 + next(4)
+            let bandMs = next(3) * 150
+            var beginTimes = [Int]()
+            var endTimes = [Int]()
+            var stdPitches = [Double]()
+            var time = 1000
+            for _ in 0..<toneCount {
+                beginTimes.append(time)
+                endTimes.append(time + 100 + next(300))
+                stdPitches.append(Double(100 + next(300)))
+                time = endTimes.last! + next(80)
+            }
+            XCTAssertEqual(pitchAlignerBeginLine(aligner,
+                                                 beginTimes.map({ Int32($0) }),
+                                                 endTimes.map({ Int32($0) }),
+                                                 stdPitches,
+                                                 Int32(toneCount),
+                                                 Int32(bandMs),
+                                                 15,
+                                                 0), 0)
+            /** 无声和不在任何字带内的采样被忽略, 穷举时同样去掉 **/
+            var samples = [(time: Int, pitch: Double)]()
+            var sampleTime = beginTimes[0] - bandMs - 50
+            for _ in 0..<8 {
+                sampleTime += 20 + next(80)
+                let pitch = next(6) == 0 ? 0 : Double(100 + next(300))
+                XCTAssertEqual(pitchAlignerAddPitch(aligner, Int32(sampleTime), pitch), 0)
+                let inBand = (0..<toneCount).contains(where: { beginTimes[$0] - bandMs <= sampleTime && sampleTime <= endTimes[$0] + bandMs })
+                if pitch > 0, inBand {
+                    samples.append((sampleTime, pitch))
+                }
+            }
+            XCTAssertEqual(Int(pitchAlignerSampleCount(aligner)), samples.count, "round \(round)")
+            if samples.isEmpty {
+                continue
+            }
+            var scores = [Float](repeating: 0, count: toneCount)
+            pitchAlignerToneScores(aligner, &scores)
+            let optima = bruteForceOptima(beginTimes: beginTimes, endTimes: endTimes, stdPitches: stdPitches, samples: samples, bandMs: bandMs)
+            let isOptimal = optima.contains(where: { optimum in
+                zip(optimum, scores).allSatisfy({ abs($0 - $1) <= 0.001 })
+            })
+            XCTAssertTrue(isOptimal, "round \(round): \(scores) not in \(optima)")
+            checked += 1
+        }
+        XCTAssertGreaterThan(checked, 900)
+    }
+}
@@ -0,0 +1,121 @@
+//
+//  LocalHTTPServer.swift
+//  KJVoiceChatRoomTests
+//
+
+import Foundation
+import Network
+
+/// Local stand-in for the lyric server. Answers GET requests from a route table and sends each body in
+/// small chunks, so that clients see it arrive piece by piece.
+final class LocalHTTPServer {
+    private let listener: NWListener
+    private let queue = DispatchQueue(label: "LocalHTTPServer")
+    private var routes: [String: Data] = [:]
+    private let chunkSize: Int
+
+    private(set) var port: UInt16 = 0
+
+    var baseURL: String {
+        return "http://127.0.0.1:\(port)"
+    }
+
+    init(chunkSize: Int = 4 * 1024) throws {
+        self.chunkSize = chunkSize
+        let parameters = NWParameters.tcp
+        parameters.requiredLocalEndpoint = NWEndpoint.hostPort(host: .ipv4(.loopback), port: .any)
+        listener = try NWListener(using: parameters)
+    }
+
+    /// Paths without a route answer 404.
+    func setRoute(_ path: String, body: Data) {
+        queue.sync {
+            routes[path] = body
+        }
+    }
+
+    func start() throws {
+        let ready = DispatchSemaphore(value: 0)
+        var startError: Error?
+        listener.stateUpdateHandler = { state in
+            switch state {
+            case .ready:
+                ready.signal()
+            case .failed(let error):
+                startError = error
+                ready.signal()
+            default:
+                break
+            }
+        }
+        listener.newConnectionHandler = { [weak self] connection in
+            self?.accept(connection)
+        }
+        listener.start(queue: queue)
+        if ready.wait(timeout: .now() + 5) == .timedOut {
+            throw URLError(.cannotConnectToHost)
+        }
+        if let error = startError {
+            throw error
+        }
+        port = listener.port?.rawValue ?? 0
+    }
+
+    func stop() {
+        listener.cancel()
+    }
+
+    private func accept(_ connection: NWConnection) {
+        connection.start(queue: queue)
+        receiveRequest(connection, received: Data())
+    }
+
+    private func receiveRequest(_ connection: NWConnection, received: Data) {
+        connection.receive(minimumIncompleteLength: 1, maximumLength: 64 * 1024) { [weak self] content, _, isComplete, error in
+            guard let self = self else { return }
+            var received = received
+            if let content = content {
+                received.append(content)
+            }
+            guard let headerEnd = received.range(of: Data("\r\n\r\n".utf8)) else {
+                if isComplete || error != nil {
+                    connection.cancel()
+                } else {
+                    self.receiveRequest(connection, received: received)
+                }
+                return
+            }
+            let requestLine = String(decoding: received[..<headerEnd.lowerBound], as: UTF8.self)
+                .components(separatedBy: "\r\n").first ?? ""
+            let parts = requestLine.components(separatedBy: " ")
+            let path = parts.count > 1 ? parts[1] : ""
+            self.respond(connection, body: self.routes[path])
+        }
+    }
+
+    private func respond(_ connection: NWConnection, body: Data?) {
+        let status = body == nil ? "404 Not Found" : "200 OK"
+        let body = body ?? Data()
+        let header = "HTTP/1.1 \(status)\r\nContent-Length: \(body.count)\r\nContent-Type: application/octet-stream\r\nConnection: close\r\n\r\n"
+        connection.send(content: Data(header.utf8), isComplete: false, completion: .contentProcessed { [weak self] _ in
+            self?.sendBody(connection, body: body, offset: 0)
+        })
+    }
+
+    private func sendBody(_ connection: NWConnection, body: Data, offset: Int) {
+        guard offset < body.count else {
+            connection.send(content: nil, contentContext: .finalMessage, isComplete: true, completion: .contentProcessed { _ in
+                connection.cancel()
+            })
+            return
+        }
+        let end = min(offset + chunkSize, body.count)
+        connection.send(content: body.subdata(in: offset..<end), isComplete: false, completion: .contentProcessed { [weak self] error in
+            guard error == nil else {
+                connection.cancel()
+                return
+            }
+            self?.sendBody(connection, body: body, offset: end)
+        })
+    }
+}
@@ -0,0 +1,91 @@
+//
+//  LrcTokenizerTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+@testable import AgoraLyricsScore
+
+final class LrcTokenizerTests: XCTestCase {
+
+    /// lines 行 LRC, 每 10 行有一行带两个时间标签, 以 \r\n 换行; 5000 行时不超过 59 分钟, 旧的解析也能处理
+    static func sampleLrc(lines: Int) -> Data {
+        var text = "[ti:示例歌曲]\r\n[ar:示例歌手]\r\n"
+        text.reserveCapacity(lines * 48)
+        for line in 0..<lines {
+            let time = line * 690
+            let tag = String(format: "[%02d:%02d.%02d]", time / 60000, time / 1000 % 60, time / 10 % 100)
+            if line % 10 == 9 {
+                let repeated = time + 30_000
+                text += String(format: "[%02d:%02d.%02d]", repeated / 60000, repeated / 1000 % 60, repeated / 10 % 100)
+            }
+            text += "\(tag)第\(line)句歌词 la la la\r\n"
+        }
+        return Data(text.utf8)
+    }
+
+    func testTokenize() {
+        let lrc = "\u{FEFF}[ar:歌手]\n[00:01.50][00:03.5]副歌\r\n[00:02.250]第二句\n[1:02.3]第三句\n[00:00.00]"
+        let tokens = LrcTokenizer.tokenize(string: lrc)
+        XCTAssertEqual(tokens.map({ $0.beginTime }), [0, 1500, 2250, 3500, 62300])
+        XCTAssertEqual(tokens.map({ $0.text }), ["", "副歌", "第二句", "副歌", "第三句"])
+    }
+
+    func testTokenizeSampleMatchesLegacyParse() {
+        let data = Self.sampleLrc(lines: 200)
+        let tokens = LrcTokenizer.tokenize(data: data)
+        let legacy = legacyParse(data: data).sorted(by: { $0.beginTime < $1.beginTime })
+        XCTAssertEqual(tokens.map({ $0.beginTime }), legacy.map({ $0.beginTime }))
+        XCTAssertEqual(tokens.map({ $0.text }), legacy.map({ $0.text }))
+    }
+
+    /// 改为共用 tokenizer 之前 LrcParser 的解析: 每行正则匹配, 每个时间标签新建 DateFormatter
+    private func legacyParse(data: Data) -> [(beginTime: Int, text: String)] {
+        guard let string = String(data: data, encoding: .utf8),
+              let regular = try? NSRegularExpression(pattern: "\\[[0-9][0-9]:[0-9][0-9].[0-9]{1,}\\]", options: .caseInsensitive) else {
+            return []
+        }
+        var result = [(beginTime: Int, text: String)]()
+        for line in string.components(separatedBy: "\r\n") {
+            let matches = regular.matches(in: line, options: .reportProgress, range: NSRange(location: 0, length: (line as NSString).length))
+            guard let lrc = line.components(separatedBy: "]").last else {
+                continue
+            }
+            for match in matches {
+                let tag = (line as NSString).substring(with: match.range)
+                let formatter = DateFormatter()
+                formatter.dateFormat = "mm:ss.SS"
+                guard let date = formatter.date(from: String(tag.dropFirst().dropLast())),
+                      let zero = formatter.date(from: "00:00.00") else {
+                    continue
+                }
+                result.append((Int((abs(date.timeIntervalSince1970 - zero.timeIntervalSince1970) * 1000).rounded()), lrc))
+            }
+        }
+        return result
+    }
+
+    func testPerformanceTokenize() {
+        let data = Self.sampleLrc(lines: 5000)
+        XCTAssertEqual(LrcTokenizer.tokenize(data: data).count, 5500)
+        measure {
+            _ = LrcTokenizer.tokenize(data: data)
+        }
+    }
+
+    func testPerformanceLrcParser() {
+        let data = Self.sampleLrc(lines: 5000)
+        measure {
+            _ = LrcParser().parseLyricData(data: data)
+        }
+    }
+
+    /// 对照: 旧的正则 + DateFormatter 解析
+    func testPerformanceLegacyParse() {
+        let data = Self.sampleLrc(lines: 5000)
+        XCTAssertEqual(legacyParse(data: data).count, 5500)
+        measure {
+            _ = legacyParse(data: data)
+        }
+    }
+}
@@ -0,0 +1,146 @@
+//
+//  LyricBinaryTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+@testable import AgoraLyricsScore
+
+final class LyricBinaryTests: XCTestCase {
+    private var source = Data()
+
+    override func setUpWithError() throws {
+        let url = try XCTUnwrap(Bundle(for: LyricBinaryTests.self).url(forResource: "lyric_sample", withExtension: "xml"))
+        /** 末尾加一个换行, 与其他用例的缓存文件区分开 **/
+        source = try Data(contentsOf: url) + Data("\n".utf8)
+        try? FileManager.default.removeItem(atPath: cachePath)
+    }
+
+    override func tearDown() {
+        try? FileManager.default.removeItem(atPath: cachePath)
+    }
+
+    private var cachePath: String {
+        return LyricBinary.cachePath(sourceHash: LyricBinary.hash(data: source))
+    }
+
+    private func xmlModel() throws -> LyricModel {
+        return try XCTUnwrap(XmlParser().parseLyricData(data: source))
+    }
+
+    static func assertEqual(_ lhs: LyricModel?, _ rhs: LyricModel, file: StaticString = #file, line: UInt = #line) {
+        guard let lhs = lhs else {
+            XCTFail("model is nil", file: file, line: line)
+            return
+        }
+        XCTAssertEqual(lhs.name, rhs.name, file: file, line: line)
+        XCTAssertEqual(lhs.singer, rhs.singer, file: file, line: line)
+        XCTAssertEqual(lhs.type, rhs.type, file: file, line: line)
+        XCTAssertEqual(lhs.hasPitch, rhs.hasPitch, file: file, line: line)
+        XCTAssertEqual(lhs.preludeEndPosition, rhs.preludeEndPosition, file: file, line: line)
+        XCTAssertEqual(lhs.duration, rhs.duration, file: file, line: line)
+        XCTAssertEqual(lhs.lines.count, rhs.lines.count, file: file, line: line)
+        for (index, (lhsLine, rhsLine)) in zip(lhs.lines, rhs.lines).enumerated() {
+            XCTAssertEqual(lhsLine.beginTime, rhsLine.beginTime, "line \(index)", file: file, line: line)
+            XCTAssertEqual(lhsLine.duration, rhsLine.duration, "line \(index)", file: file, line: line)
+            XCTAssertEqual(lhsLine.content, rhsLine.content, "line \(index)", file: file, line: line)
+            XCTAssertEqual(lhsLine.tones.count, rhsLine.tones.count, "line \(index)", file: file, line: line)
+            for (lhsTone, rhsTone) in zip(lhsLine.tones, rhsLine.tones) {
+                XCTAssertEqual(lhsTone.beginTime, rhsTone.beginTime, "line \(index)", file: file, line: line)
+                XCTAssertEqual(lhsTone.duration, rhsTone.duration, "line \(index)", file: file, line: line)
+                XCTAssertEqual(lhsTone.pitch.bitPattern, rhsTone.pitch.bitPattern, "line \(index)", file: file, line: line)
+                XCTAssertEqual(lhsTone.lang, rhsTone.lang, "line \(index)", file: file, line: line)
+                XCTAssertEqual(lhsTone.word, rhsTone.word, "line \(index)", file: file, line: line)
+                XCTAssertEqual(lhsTone.pronounce, rhsTone.pronounce, "line \(index)", file: file, line: line)
+            }
+        }
+    }
+
+    func testEncodeDecodeMatchesXmlParse() throws {
+        let model = try xmlModel()
+        XCTAssertFalse(model.lines.isEmpty)
+        let sourceHash = LyricBinary.hash(data: source)
+        let data = LyricBinary.encode(model: model, sourceLength: source.count, sourceHash: sourceHash)
+        XCTContext.runActivity(named: "xml \(source.count) bytes, binary \(data.count) bytes") { _ in }
+        Self.assertEqual(LyricBinary.decode(data: data, sourceLength: source.count, sourceHash: sourceHash), model)
+
+        /** 空字符串、多字节字符、未知语言、负的pitch **/
+        let tone = LyricToneModel(beginTime: 0, duration: 10, word: "", pitch: -1.5, lang: .unknown, pronounce: "ひ")
+        let edge = LyricModel(name: "", singer: "歌手 🎤", type: .fast,
+                              lines: [LyricLineModel(beginTime: 0, duration: 10, content: "", tones: [tone]),
+                                      LyricLineModel(beginTime: 20, duration: 0, content: "空行", tones: [])],
+                              preludeEndPosition: 0, duration: 20, hasPitch: false)
+        let edgeData = LyricBinary.encode(model: edge, sourceLength: 1, sourceHash: 2)
+        Self.assertEqual(LyricBinary.decode(data: edgeData, sourceLength: 1, sourceHash: 2), edge)
+    }
+
+    func testSourceMismatchIsMiss() throws {
+        let sourceHash = LyricBinary.hash(data: source)
+        let data = LyricBinary.encode(model: try xmlModel(), sourceLength: source.count, sourceHash: sourceHash)
+        XCTAssertNil(LyricBinary.decode(data: data, sourceLength: source.count + 1, sourceHash: sourceHash))
+        XCTAssertNil(LyricBinary.decode(data: data, sourceLength: source.count, sourceHash: sourceHash ^ 1))
+
+        /** 缓存按源文件 hash 命名, 改动一个字节即不命中 **/
+        LyricBinary.compile(source: source)
+        XCTAssertTrue(FileManager.default.fileExists(atPath: cachePath))
+        Self.assertEqual(LyricBinary.load(source: source), try xmlModel())
+        var changed = source
+        changed[changed.count - 1] = UInt8(ascii: " ")
+        XCTAssertNil(LyricBinary.load(source: changed))
+        XCTAssertTrue(FileManager.default.fileExists(atPath: cachePath))
+    }
+
+    /// 缓存文件损坏时 load 删除它, Parser 退回解析 xml
+    func testCorruptCacheIsDeletedAndParserFallsBack() throws {
+        let model = try xmlModel()
+        LyricBinary.compile(source: source)
+        let valid = try Data(contentsOf: URL(fileURLWithPath: cachePath))
+        Self.assertEqual(Parser().parseLyricData(data: source), model)
+
+        let lineCount = model.lines.count
+        func align(_ size: Int) -> Int { (size + 7) & ~7 }
+        let lineFirstTones = 72 + 2 * align(4 * lineCount)
+        func patched(_ offset: Int, _ value: UInt32) -> Data {
+            var data = valid
+            var value = value.littleEndian
+            withUnsafeBytes(of: &value) { data.replaceSubrange(offset..<offset + 4, with: $0) }
+            return data
+        }
+        let cases: [(String, Data)] = [
+            ("empty", Data()),
+            ("header only", valid.prefix(72)),
+            ("truncated", valid.dropLast(8)),
+            ("appended", valid + Data(count: 8)),
+            ("magic", patched(0, 0)),
+            ("version", patched(4, 1)),
+            ("music type", patched(24, 99)),
+            ("name out of pool", patched(60, UInt32.max)),
+            ("tone count", patched(44, 1)),
+            ("line tones out of range", patched(lineFirstTones + 4, UInt32.max)),
+        ]
+        for (name, data) in cases {
+            try data.write(to: URL(fileURLWithPath: cachePath))
+            XCTAssertNil(LyricBinary.load(source: source), name)
+            XCTAssertFalse(FileManager.default.fileExists(atPath: cachePath), name)
+
+            try data.write(to: URL(fileURLWithPath: cachePath))
+            Self.assertEqual(Parser().parseLyricData(data: source), model)
+            XCTAssertFalse(FileManager.default.fileExists(atPath: cachePath), name)
+        }
+    }
+
+    // MARK: - 映射加载与解析 xml 的对比
+
+    func testPerformanceLoadBinary() throws {
+        LyricBinary.compile(source: source)
+        measure {
+            XCTAssertNotNil(LyricBinary.load(source: source))
+        }
+    }
+
+    func testPerformanceParseXml() {
+        measure {
+            XCTAssertNotNil(XmlParser().parseLyricData(data: source))
+        }
+    }
+}
@@ -0,0 +1,293 @@
+//
+//  LyricXmlParserTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+@testable import AgoraLyricsScore
+
+final class LyricXmlParserTests: XCTestCase {
+
+    private func sampleData() throws -> Data {
+        let url = try XCTUnwrap(Bundle(for: LyricXmlParserTests.self).url(forResource: "lyric_sample", withExtension: "xml"))
+        return try Data(contentsOf: url)
+    }
+
+    private func parse(_ xml: String) throws -> LyricXmlDocument {
+        return try XCTUnwrap(LyricXmlDocument(data: Data(xml.utf8)))
+    }
+
+    // MARK: - 与 XMLParser 的对比
+
+    /// 改为 LyricXmlDocument 之前 XmlParser 的解析 (process 之前的部分): XMLParser 回调, 按元素栈收集文本
+    /// - Note: 原实现未知的 lang 直接 Lang(rawValue:)! 崩溃, 这里改为 .unknown, 其余保持原样
+    private final class LegacyXmlParser: NSObject, XMLParserDelegate {
+        private enum ParserType {
+            case general, name, singer, type, sentence, tone, word, overlap
+        }
+
+        private var parserTypes: [ParserType] = []
+        private var song: LyricModel?
+
+        func parse(data: Data) -> LyricModel? {
+            song = nil
+            parserTypes = []
+            let parser = XMLParser(data: data)
+            parser.delegate = self
+            return parser.parse() ? song : nil
+        }
+
+        private func makeTone(attributes: [String: String], hasPitch: Bool) -> LyricToneModel {
+            let begin = Int((Double(attributes["begin"] ?? "0") ?? 0) * 1000)
+            let end = Int((Double(attributes["end"] ?? "0") ?? 0) * 1000)
+            let pitch = hasPitch ? Double(Float(attributes["pitch"] ?? "0") ?? 0) : 0
+            let lang = Lang(rawValue: Int(attributes["lang"] ?? "") ?? -1) ?? .unknown
+            return LyricToneModel(beginTime: begin,
+                                  duration: end - begin,
+                                  word: "",
+                                  pitch: pitch,
+                                  lang: lang,
+                                  pronounce: hasPitch ? attributes["pronounce"] ?? "" : "")
+        }
+
+        func parser(_: XMLParser,
+                    didStartElement elementName: String,
+                    namespaceURI _: String?,
+                    qualifiedName _: String?,
+                    attributes attributeDict: [String: String] = [:]) {
+            switch elementName {
+            case "song":
+                song = LyricModel()
+            case "general":
+                parserTypes.append(.general)
+            case "name":
+                parserTypes.append(.name)
+            case "singer":
+                parserTypes.append(.singer)
+            case "type":
+                parserTypes.append(.type)
+            case "sentence":
+                parserTypes.append(.sentence)
+                song?.lines.append(LyricLineModel(beginTime: -1, duration: -1, content: "", tones: []))
+            case "tone":
+                parserTypes.append(.tone)
+                song?.lines.last?.tones.append(makeTone(attributes: attributeDict, hasPitch: true))
+            case "word":
+                parserTypes.append(.word)
+            case "overlap":
+                parserTypes.append(.overlap)
+                let tone = makeTone(attributes: attributeDict, hasPitch: false)
+                song?.lines.append(LyricLineModel(beginTime: 0, duration: 0, content: "", tones: [tone]))
+            default:
+                break
+            }
+        }
+
+        func parser(_: XMLParser, foundCharacters string: String) {
+            guard let song = song, let last = parserTypes.last else {
+                return
+            }
+            switch last {
+            case .name:
+                song.name = string
+            case .singer:
+                song.singer = string
+            case .type:
+                song.type = Int(string).flatMap({ MusicType(rawValue: $0) }) ?? .fast
+            case .word, .overlap:
+                if let tone = song.lines.last?.tones.last {
+                    tone.word = tone.word + string
+                    if tone.lang == .unknown { /** 补偿语言 **/
+                        tone.lang = tone.word.range(of: "^[a-zA-Z]", options: .regularExpression) == nil ? .zh : .en
+                    }
+                }
+            default:
+                break
+            }
+        }
+
+        func parser(_: XMLParser,
+                    didEndElement elementName: String,
+                    namespaceURI _: String?,
+                    qualifiedName _: String?) {
+            let types: [String: ParserType] = ["general": .general, "name": .name, "singer": .singer, "type": .type,
+                                               "sentence": .sentence, "tone": .tone, "word": .word, "overlap": .overlap]
+            if let type = types[elementName], parserTypes.last == type {
+                parserTypes.removeLast()
+            }
+        }
+    }
+
+    /// 逐字对比, 返回旧解析截断成少 1ms 的时间个数
+    @discardableResult
+    private func assertMatchesLegacy(data: Data, file: StaticString = #file, line: UInt = #line) throws -> Int {
+        let legacy = try XCTUnwrap(LegacyXmlParser().parse(data: data), file: file, line: line)
+        let document = try XCTUnwrap(LyricXmlDocument(data: data), file: file, line: line)
+        XCTAssertEqual(document.name, legacy.name, file: file, line: line)
+        XCTAssertEqual(document.singer, legacy.singer, file: file, line: line)
+        XCTAssertEqual(MusicType(rawValue: document.type) ?? .fast, legacy.type, file: file, line: line)
+
+        let sentences = document.sentences
+        XCTAssertEqual(sentences.map({ $0.count }), legacy.lines.map({ $0.tones.count }), file: file, line: line)
+        var truncatedCount = 0
+        for (range, legacyLine) in zip(sentences, legacy.lines) {
+            for (index, legacyTone) in zip(range, legacyLine.tones) {
+                let tone = document.tone(at: index)
+                XCTAssertEqual(document.word(of: tone), legacyTone.word, "tone \(index)", file: file, line: line)
+                XCTAssertEqual(document.pronounce(of: tone), legacyTone.pronounce, "tone \(index)", file: file, line: line)
+                XCTAssertEqual(Double(tone.pitch), legacyTone.pitch, "tone \(index)", file: file, line: line)
+                XCTAssertEqual(Lang(rawValue: Int(tone.lang)), legacyTone.lang, "tone \(index)", file: file, line: line)
+                /** 旧解析 Int(秒 * 1000) 在浮点误差下会少 1ms **/
+                for (time, legacyTime) in [(Int(tone.beginTime), legacyTone.beginTime), (Int(tone.endTime), legacyTone.endTime)] {
+                    XCTAssertTrue(time == legacyTime || time == legacyTime + 1, "tone \(index): \(time) vs \(legacyTime)", file: file, line: line)
+                    truncatedCount += time == legacyTime ? 0 : 1
+                }
+            }
+        }
+        return truncatedCount
+    }
+
+    func testSampleMatchesLegacyXmlParser() throws {
+        let data = try sampleData()
+        let truncatedCount = try assertMatchesLegacy(data: data)
+        XCTContext.runActivity(named: "legacy truncated \(truncatedCount) times by 1ms") { _ in }
+        XCTAssertEqual(truncatedCount, 10)
+        XCTAssertEqual(Int(Double("64.859")! * 1000), 64858)
+
+        let document = try XCTUnwrap(LyricXmlDocument(data: data))
+        XCTAssertEqual(document.sentences.count, 48)
+        XCTAssertEqual(document.sentences.last?.upperBound, 474)
+        XCTAssertEqual(document.name, "示例歌曲")
+        XCTAssertEqual(document.type, 1)
+        let first = document.tone(at: 0)
+        XCTAssertEqual(first.beginTime, 12000)
+        XCTAssertEqual(first.endTime, 12597)
+
+        /** 相同的文本只存一份 **/
+        let third = document.tone(at: 2)
+        XCTAssertEqual(document.pronounce(of: third), "ta")
+        XCTAssertEqual(first.pronounceOffset, third.pronounceOffset)
+
+        let model = try XCTUnwrap(XmlParser().parseLyricData(data: data))
+        XCTAssertEqual(model.lines.count, 48)
+        for (range, line) in zip(document.sentences, model.lines) {
+            XCTAssertEqual(line.content, range.map({ document.word(of: document.tone(at: $0)) }).joined())
+            XCTAssertEqual(line.beginTime, Int(document.tone(at: range.lowerBound).beginTime))
+        }
+    }
+
+    func testOverlapMatchesLegacyXmlParser() throws {
+        let xml = """
+        <song><paragraph><sentence><tone begin="1.0" end="1.5" pitch="60" lang="1"><word>我</word></tone></sentence>
+        <overlap begin="1.2" end="1.8" pitch="70" pronounce="x">和声</overlap>
+        <sentence><tone begin="2.0" end="2.5" pitch="61"><word>你</word></tone></sentence></paragraph></song>
+        """
+        try assertMatchesLegacy(data: Data(xml.utf8))
+
+        /** <overlap> 单独成句, 不读 pitch 与 pronounce **/
+        let document = try parse(xml)
+        XCTAssertEqual(document.sentences, [0..<1, 1..<2, 2..<3])
+        let overlap = document.tone(at: 1)
+        XCTAssertEqual(overlap.beginTime, 1200)
+        XCTAssertEqual(overlap.endTime, 1800)
+        XCTAssertEqual(overlap.pitch, 0)
+        XCTAssertEqual(overlap.lang, 1)
+        XCTAssertEqual(document.word(of: overlap), "和声")
+        XCTAssertEqual(document.pronounce(of: overlap), "")
+
+        let model = try XCTUnwrap(XmlParser().parseLyricData(data: Data(xml.utf8)))
+        XCTAssertEqual(model.lines.map({ $0.content }), ["我", "和声", "你"])
+        XCTAssertTrue(model.hasPitch)
+    }
+
+    // MARK: - 数值与文本
+
+    /// 时间按小数位直接换算 ms, 不经过浮点; 未知的 lang 为 .unknown, 缺失时按 word 首字母补偿
+    func testTimesAndLang() throws {
+        let xml = """
+        <song><general><name>n</name><singer>s</singer><type> 2 </type></general><paragraph>
+        <sentence><tone begin="1.001" end="2.0005" pitch="50.5" lang="1"><word>a</word></tone>
+        <tone begin="0.1" end="3" pitch="-1" lang="7"><word>中</word></tone>
+        <tone begin="64.859" end="100.999"><word>Hey</word></tone>
+        <tone begin="x" end="4.5"><word>好</word></tone></sentence></paragraph></song>
+        """
+        let document = try parse(xml)
+        XCTAssertEqual(document.type, 2)
+        let tones = document.sentences[0].map({ document.tone(at: $0) })
+        XCTAssertEqual(tones.map({ $0.beginTime }), [1001, 100, 64859, 0])
+        XCTAssertEqual(tones.map({ $0.endTime }), [2000, 3000, 100999, 4500])
+        XCTAssertEqual(tones.map({ $0.pitch }), [50.5, -1, 0, 0])
+        XCTAssertEqual(tones.map({ $0.lang }), [1, 7, 2, 1])
+
+        let model = try XCTUnwrap(XmlParser().parseLyricData(data: Data(xml.utf8)))
+        XCTAssertEqual(model.type, .slow)
+        XCTAssertEqual(model.lines[0].tones.map({ $0.lang }), [.zh, .unknown, .en, .zh])
+        XCTAssertEqual(model.lines[0].tones.map({ $0.beginTime }), [1001, 100, 64859, 0])
+    }
+
+    /// 实体与 CDATA 解码后拼接; 无法识别的实体原样保留 (XMLParser 对这些情况报错或只保留最后一段文本, 不做对比)
+    func testEntitiesAndCData() throws {
+        let xml = """
+        <?xml version="1.0" encoding="UTF-8"?>
+        <!DOCTYPE song>
+        <song><general><name>A &amp; B &lt;Live&gt;</name><singer><![CDATA[歌手 <1> & 2]]></singer></general>
+        <paragraph><sentence>
+        <tone begin="1.000" end="1.500" pitch="60" pronounce="&quot;zh&apos;ong&quot;"><word>&#x4E2D;&#25991;</word></tone>
+        <tone begin="1.500" end="2.000" pitch="60"><word><![CDATA[R&B]]></word></tone>
+        <tone begin="2.000" end="2.500" pitch="60"><!-- 注释 <tone> --><word>a&unknown;b &#0; &</word></tone>
+        </sentence></paragraph></song>
+        """
+        let document = try parse(xml)
+        XCTAssertEqual(document.name, "A & B <Live>")
+        XCTAssertEqual(document.singer, "歌手 <1> & 2")
+        XCTAssertEqual(document.type, 0)
+        XCTAssertEqual(document.sentences, [0..<3])
+        let tones = (0..<3).map({ document.tone(at: $0) })
+        XCTAssertEqual(tones.map({ document.word(of: $0) }), ["中文", "R&B", "a&unknown;b &#0; &"])
+        XCTAssertEqual(document.pronounce(of: tones[0]), "\"zh'ong\"")
+        XCTAssertEqual(tones.map({ $0.lang }), [1, 2, 2])
+    }
+
+    // MARK: - 格式错误
+
+    func testMalformedReturnsNil() {
+        let cases = [
+            "<song><name>x</song>",
+            "<song><sentence><tone begin=\"1.0\"",
+            "<song><tone begin=\"1.0></song>",
+            "<song><!-- comment",
+            "<song><![CDATA[abc",
+            "<song></song></song>",
+            "<song></>",
+            "<song>",
+            "<paragraph><sentence></sentence></paragraph>",
+            "",
+        ]
+        for xml in cases {
+            XCTAssertNil(LyricXmlDocument(data: Data(xml.utf8)), xml)
+            XCTAssertNil(XmlParser().parseLyricData(data: Data(xml.utf8)), xml)
+        }
+
+        /** 有 <song> 但没有句子: 文档合法, XmlParser 返回nil **/
+        let empty = LyricXmlDocument(data: Data("<song/>".utf8))
+        XCTAssertEqual(empty?.sentences.count, 0)
+        XCTAssertNil(XmlParser().parseLyricData(data: Data("<song/>".utf8)))
+        XCTAssertNotNil(LyricXmlDocument(data: Data([0xEF, 0xBB, 0xBF]) + Data("<song></song>".utf8)))
+    }
+
+    // MARK: - XMLParser 与直接扫描的对比
+
+    func testPerformanceLegacyXmlParser() throws {
+        let data = try sampleData()
+        measure {
+            XCTAssertNotNil(LegacyXmlParser().parse(data: data))
+        }
+    }
+
+    func testPerformanceLyricXmlDocument() throws {
+        let data = try sampleData()
+        measure {
+            XCTAssertNotNil(LyricXmlDocument(data: data))
+        }
+    }
+}
@@ -0,0 +1,131 @@
+//
+//  PitchDetectorTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+@testable import AgoraLyricsScore
+
+final class PitchDetectorTests: XCTestCase {
+
+    /// sweep_<采样率>.wav: 16bit PCM 正弦波, 从 110Hz 起每 120ms 升高 5 个半音, 共 8 段, 44.1kHz 的为双声道
+    private static let stepSeconds = 0.12
+    private static let stepCount = 8
+    private static let tolerance = 0.05
+
+    private static func expectedPitch(step: Int) -> Double {
+        return 110 * pow(2, 5 * Double(step) / 12)
+    }
+
+    private struct Wave {
+        let sampleRate: Int
+        let channels: Int
+        let samples: [Int16]
+    }
+
+    /// 只解析 fmt 和 data 块, 其余块跳过
+    private func loadWave(_ name: String) throws -> Wave {
+        let url = try XCTUnwrap(Bundle(for: PitchDetectorTests.self).url(forResource: name, withExtension: "wav"))
+        let data = try Data(contentsOf: url)
+        func uint(_ offset: Int, _ size: Int) -> Int {
+            return (0..<size).reduce(0) { $0 | Int(data[offset + $1]) << (8 * $1) }
+        }
+        XCTAssertEqual(String(decoding: data[0..<4], as: UTF8.self), "RIFF")
+        XCTAssertEqual(String(decoding: data[8..<12], as: UTF8.self), "WAVE")
+        var sampleRate = 0
+        var channels = 0
+        var offset = 12
+        while offset + 8 <= data.count {
+            let id = String(decoding: data[offset..<offset + 4], as: UTF8.self)
+            let size = uint(offset + 4, 4)
+            let body = offset + 8
+            if id == "fmt " {
+                XCTAssertEqual(uint(body, 2), 1, "PCM")
+                channels = uint(body + 2, 2)
+                sampleRate = uint(body + 4, 4)
+                XCTAssertEqual(uint(body + 14, 2), 16)
+            }
+            else if id == "data" {
+                let samples = stride(from: body, to: body + size - 1, by: 2).map { Int16(truncatingIfNeeded: uint($0, 2)) }
+                return Wave(sampleRate: sampleRate, channels: channels, samples: samples)
+            }
+            offset = body + size + (size & 1)
+        }
+        throw CocoaError(.fileReadCorruptFile)
+    }
+
+    /// 以 10ms 一帧送入, 返回每个 pitch 及其产生的时刻 (s)
+    private func detect(_ wave: Wave) -> [(time: Double, pitch: Double)] {
+        let detector = pitchDetectorCreate()
+        defer { pitchDetectorDestroy(detector) }
+        let frameSamples = wave.sampleRate / 100
+        var results = [(time: Double, pitch: Double)]()
+        var pitches = [Double](repeating: 0, count: 8)
+        wave.samples.withUnsafeBufferPointer { samples in
+            var start = 0
+            while start + frameSamples * wave.channels <= samples.count {
+                var frame = PitchAudioFrame(samplesPerChannel: Int32(frameSamples),
+                                            bytesPerSample: 2,
+                                            channels: Int32(wave.channels),
+                                            samplesPerSec: Int32(wave.sampleRate),
+                                            buffer: UnsafeRawPointer(samples.baseAddress! + start))
+                let count = Int(pitchDetectorProcess(detector, &frame, &pitches, Int32(pitches.count)))
+                XCTAssertGreaterThanOrEqual(count, 0)
+                for pitch in pitches.prefix(max(count, 0)) {
+                    results.append((Double(results.count + 1) * Double(PITCH_DETECTOR_HOP_MS) / 1000, pitch))
+                }
+                start += frameSamples * wave.channels
+            }
+        }
+        return results
+    }
+
+    private func checkSweep(sampleRate: Int) throws {
+        let wave = try loadWave("sweep_\(sampleRate)")
+        XCTAssertEqual(wave.sampleRate, sampleRate)
+        var checked = 0
+        var worst = 0.0
+        for (time, pitch) in detect(wave) {
+            /** 分析窗 (不超过 40ms) 完全落在同一段内时才比较 **/
+            let step = Int(((time - 1e-9) / Self.stepSeconds).rounded(.down))
+            guard step < Self.stepCount, time - 0.04 >= Double(step) * Self.stepSeconds - 1e-9 else {
+                continue
+            }
+            let expected = Self.expectedPitch(step: step)
+            XCTAssertGreaterThan(pitch, 0, "\(sampleRate)Hz at \(time)s")
+            let error = pitch > 0 ? abs(12 * log2(pitch / expected)) : .infinity
+            XCTAssertLessThanOrEqual(error, Self.tolerance, "\(sampleRate)Hz at \(time)s: \(pitch) for \(expected)")
+            worst = max(worst, error)
+            checked += 1
+        }
+        XCTAssertGreaterThan(checked, Self.stepCount * 5)
+        XCTContext.runActivity(named: "\(sampleRate)Hz: \(checked) pitches, worst \(worst) semitone") { _ in }
+    }
+
+    func testSweep8k() throws {
+        try checkSweep(sampleRate: 8000)
+    }
+
+    func testSweep16k() throws {
+        try checkSweep(sampleRate: 16000)
+    }
+
+    func testSweep22k() throws {
+        try checkSweep(sampleRate: 22050)
+    }
+
+    func testSweep44kStereo() throws {
+        try checkSweep(sampleRate: 44100)
+    }
+
+    func testSweep48k() throws {
+        try checkSweep(sampleRate: 48000)
+    }
+
+    func testSilenceHasNoPitch() {
+        let wave = Wave(sampleRate: 48000, channels: 1, samples: [Int16](repeating: 0, count: 48000))
+        let results = detect(wave)
+        XCTAssertEqual(results.count, 100)
+        XCTAssertTrue(results.allSatisfy({ $0.pitch == 0 }))
+    }
+}
@@ -0,0 +1,188 @@
+//
+//  ScoreEngineTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+@testable import AgoraLyricsScore
+
+final class ScoreEngineTests: XCTestCase {
+
+    static func loadLyric() throws -> LyricModel {
+        let url = try XCTUnwrap(Bundle(for: ScoreEngineTests.self).url(forResource: "lyric_sample", withExtension: "xml"))
+        return try XCTUnwrap(XmlParser().parseLyricData(data: try Data(contentsOf: url)))
+    }
+
+    /// 每 10ms 一个pitch: 字内在标准pitch上下 3 个半音内浮动, 夹杂换气(0)和高八度; 句间空档偶尔有噪声
+    static func makePitchTrack(lyric: LyricModel, seed: UInt64 = 1) -> [(timeMs: Int, pitch: Double)] {
+        var state = seed
+        func next(_ bound: Int) -> Int {
+            state = state &* 6364136223846793005 &+ 1442695040888963407
+            return Int(state >> 33) % bound
+        }
+        let tones = lyric.lines.flatMap({ $0.tones })
+        let end = (tones.last?.endTime ?? 0) + 500
+        var track = [(timeMs: Int, pitch: Double)]()
+        var toneIndex = 0
+        for time in stride(from: 0, to: end, by: 10) {
+            while toneIndex < tones.count, tones[toneIndex].endTime < time {
+                toneIndex += 1
+            }
+            guard toneIndex < tones.count, tones[toneIndex].beginTime <= time else {
+                track.append((time, next(10) == 0 ? Double(100 + next(300)) : 0))
+                continue
+            }
+            let stdPitch = tones[toneIndex].pitch
+            switch next(10) {
+            case 0:
+                track.append((time, 0))
+            case 1:
+                track.append((time, stdPitch * 2))
+            default:
+                track.append((time, stdPitch * pow(2, Double(next(61) - 30) / 120)))
+            }
+        }
+        return track
+    }
+
+    /// 记录实时打分回调的每行分数
+    private final class LineRecorder: NSObject, ScoringMachineDelegate {
+        var lineScores: [Int?]
+        var cumulativeScore = 0
+        let finished: XCTestExpectation
+
+        init(lineCount: Int, finished: XCTestExpectation) {
+            self.lineScores = .init(repeating: nil, count: lineCount)
+            self.finished = finished
+        }
+
+        func sizeOfCanvasView(_ scoringMachine: ScoringMachine) -> CGSize {
+            return CGSize(width: 375, height: 180)
+        }
+
+        func scoringMachine(_ scoringMachine: ScoringMachine,
+                            didUpdateDraw standardInfos: [ScoringMachine.DrawInfo],
+                            highlightInfos: [ScoringMachine.DrawInfo]) {}
+
+        func scoringMachine(_ scoringMachine: ScoringMachine,
+                            didUpdateCursor centerY: CGFloat,
+                            showAnimation: Bool,
+                            debugInfo: ScoringMachine.DebugInfo) {}
+
+        func scoringMachine(_ scoringMachine: ScoringMachine,
+                            didFinishLineWith model: LyricLineModel,
+                            score: Int,
+                            cumulativeScore: Int,
+                            lineIndex: Int,
+                            lineCount: Int) {
+            lineScores[lineIndex] = score
+            self.cumulativeScore = cumulativeScore
+            if lineIndex == lineCount - 1 {
+                finished.fulfill()
+            }
+        }
+    }
+
+    /// 按正常进度把 pitchTrack 送入 ScoringMachine, 返回每行回调的分数
+    private func liveScores(lyric: LyricModel,
+                            pitchTrack: [(timeMs: Int, pitch: Double)],
+                            scoreLevel: Int,
+                            scoreCompensationOffset: Int) -> (lineScores: [Int?], cumulativeScore: Int) {
+        let finished = expectation(description: "last line")
+        let recorder = LineRecorder(lineCount: lyric.lines.count, finished: finished)
+        let machine = ScoringMachine()
+        machine.scoreLevel = scoreLevel
+        machine.scoreCompensationOffset = scoreCompensationOffset
+        machine.delegate = recorder
+        machine.setLyricData(data: lyric)
+        for (progress, pitch) in pitchTrack {
+            machine.setProgress(progress: progress)
+            machine.setPitch(pitch: pitch)
+        }
+        machine.setProgress(progress: (pitchTrack.last?.timeMs ?? 0) + 1000)
+        wait(for: [finished], timeout: 30)
+        return (recorder.lineScores, recorder.cumulativeScore)
+    }
+
+    func testScoreMatchesScoringMachine() throws {
+        let lyric = try Self.loadLyric()
+        XCTAssertTrue(lyric.hasPitch)
+        for (scoreLevel, scoreCompensationOffset) in [(10, 0), (15, 0), (40, 20)] {
+            let track = Self.makePitchTrack(lyric: lyric, seed: UInt64(scoreLevel))
+            let engine = ScoreEngine()
+            engine.scoreLevel = scoreLevel
+            engine.scoreCompensationOffset = scoreCompensationOffset
+            let offline = engine.score(lyric: lyric, pitchTrack: track)
+            let live = liveScores(lyric: lyric,
+                                  pitchTrack: track,
+                                  scoreLevel: scoreLevel,
+                                  scoreCompensationOffset: scoreCompensationOffset)
+
+            XCTAssertEqual(offline.lineScores.count, lyric.lines.count)
+            XCTAssertEqual(offline.lineScores.map({ Optional($0) }), live.lineScores, "scoreLevel: \(scoreLevel)")
+            XCTAssertEqual(offline.cumulativeScore, live.cumulativeScore, "scoreLevel: \(scoreLevel)")
+            XCTAssertGreaterThan(offline.cumulativeScore, 0)
+        }
+    }
+
+    /// 同一个 ScoreEngine 连续打分, 结果不受上一次影响
+    func testScoreIsRepeatable() throws {
+        let lyric = try Self.loadLyric()
+        let track = Self.makePitchTrack(lyric: lyric)
+        let engine = ScoreEngine()
+        let first = engine.score(lyric: lyric, pitchTrack: track)
+        _ = engine.score(lyric: lyric, pitchTrack: Self.makePitchTrack(lyric: lyric, seed: 7))
+        let second = engine.score(lyric: lyric, pitchTrack: track)
+        XCTAssertEqual(first.lineScores, second.lineScores)
+        XCTAssertEqual(ScoreEngine().score(lyric: lyric, pitchTrack: track).lineScores, first.lineScores)
+    }
+
+    /// 近似计算的字分数误差不超过 scoreLevel * 0.0001 * (1 + scoreLevel / 50) (Algorithm.h), 行分数取整后最多差 1
+    func testApproximateToneWithinTolerance() throws {
+        let lyric = try Self.loadLyric()
+        for scoreLevel in [1, 15, 50, 100] {
+            let track = Self.makePitchTrack(lyric: lyric, seed: UInt64(scoreLevel) + 100)
+            let exactEngine = ScoreEngine()
+            exactEngine.scoreLevel = scoreLevel
+            let approximateEngine = ScoreEngine()
+            approximateEngine.scoreLevel = scoreLevel
+            approximateEngine.useApproximateTone = true
+            let exact = exactEngine.score(lyric: lyric, pitchTrack: track)
+            let approximate = approximateEngine.score(lyric: lyric, pitchTrack: track)
+
+            let tolerance = Float(scoreLevel) * 0.0001 * (1 + Float(scoreLevel) / 50) + 0.0001
+            var maxError: Float = 0
+            for (exactLine, approximateLine) in zip(exact.toneScores, approximate.toneScores) {
+                for (lhs, rhs) in zip(exactLine, approximateLine) {
+                    maxError = max(maxError, abs(lhs.score - rhs.score))
+                }
+            }
+            XCTContext.runActivity(named: "scoreLevel \(scoreLevel): max tone error \(maxError)") { _ in }
+            XCTAssertLessThanOrEqual(maxError, tolerance, "scoreLevel: \(scoreLevel)")
+            for (lhs, rhs) in zip(exact.lineScores, approximate.lineScores) {
+                XCTAssertLessThanOrEqual(abs(lhs - rhs), 1, "scoreLevel: \(scoreLevel)")
+            }
+        }
+    }
+
+    // MARK: - 逐个与批量近似计算的对比
+
+    func testPerformanceScore() throws {
+        let lyric = try Self.loadLyric()
+        let track = Self.makePitchTrack(lyric: lyric)
+        let engine = ScoreEngine()
+        measure {
+            XCTAssertGreaterThan(engine.score(lyric: lyric, pitchTrack: track).cumulativeScore, 0)
+        }
+    }
+
+    func testPerformanceScoreApproximateTone() throws {
+        let lyric = try Self.loadLyric()
+        let track = Self.makePitchTrack(lyric: lyric)
+        let engine = ScoreEngine()
+        engine.useApproximateTone = true
+        measure {
+            XCTAssertGreaterThan(engine.score(lyric: lyric, pitchTrack: track).cumulativeScore, 0)
+        }
+    }
+}
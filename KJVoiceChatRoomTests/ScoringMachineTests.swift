@@ -0,0 +1,307 @@
+//
+//  ScoringMachineTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+@testable import AgoraLyricsScore
+
+final class ScoringMachineTests: XCTestCase {
+
+    /// 约5分钟的歌: 每句8个字, 字之间有 0~40ms 空档, 句子之间有 1~3s 空档
+    static func makeDataList(lines: Int = 80, seed: UInt64 = 1) -> (lineEndTimes: [Int], dataList: [ScoringMachine.Info]) {
+        var state = seed
+        func next(_ bound: Int) -> Int {
+            state = state &* 6364136223846793005 &+ 1442695040888963407
+            return Int(state >> 33) % bound
+        }
+        var dataList = [ScoringMachine.Info]()
+        var lineEndTimes = [Int]()
+        var time = 5000
+        for _ in 0..<lines {
+            for index in 0..<8 {
+                let duration = 150 + next(400)
+                dataList.append(ScoringMachine.Info(beginTime: time,
+                                                    duration: duration,
+                                                    word: "啦",
+                                                    pitch: Double(40 + next(200)),
+                                                    drawBeginTime: time,
+                                                    drawDuration: duration,
+                                                    isLastInLine: index == 7))
+                time += duration + next(40)
+            }
+            lineEndTimes.append(dataList.last!.endTime)
+            time += 1000 + next(2000)
+        }
+        return (lineEndTimes, dataList)
+    }
+
+    /// 逐句扫描, 即二分查找之前的实现
+    private func scanIndexOfLine(progress: Int, lineEndTimes: [Int]) -> Int? {
+        if lineEndTimes.isEmpty {
+            return nil
+        }
+        if progress > lineEndTimes.last! {
+            return lineEndTimes.count
+        }
+        if progress <= lineEndTimes.first! {
+            return 0
+        }
+        var lastEnd = 0
+        for (offset, value) in lineEndTimes.enumerated() {
+            if progress > lastEnd, progress <= value {
+                return offset
+            }
+            lastEnd = value
+        }
+        return nil
+    }
+
+    func testFindCurrentIndexOfLineMatchesScan() {
+        let machine = ScoringMachine()
+        let (lineEndTimes, dataList) = Self.makeDataList()
+        let duration = dataList.last!.endTime + 1000
+        for progress in stride(from: 0, through: duration, by: 7) {
+            XCTAssertEqual(machine.findCurrentIndexOfLine(progress: progress, lineEndTimes: lineEndTimes),
+                           scanIndexOfLine(progress: progress, lineEndTimes: lineEndTimes), "progress: \(progress)")
+        }
+        /** 两句之间的空档属于下一句 **/
+        let gap = lineEndTimes[3] + 1
+        XCTAssertLessThan(gap, dataList[32].beginTime)
+        XCTAssertEqual(machine.findCurrentIndexOfLine(progress: gap, lineEndTimes: lineEndTimes), 4)
+        XCTAssertNil(machine.findCurrentIndexOfLine(progress: 100, lineEndTimes: []))
+
+        /** 句子重叠, 结束时间不单调 **/
+        let overlapped = [1000, 3000, 2500, 2500, 4000, 3500, 6000]
+        for progress in stride(from: 0, through: 6500, by: 50) {
+            XCTAssertEqual(machine.findCurrentIndexOfLine(progress: progress, lineEndTimes: overlapped, isSorted: false),
+                           scanIndexOfLine(progress: progress, lineEndTimes: overlapped), "progress: \(progress)")
+        }
+    }
+
+    func testGetHitedIndexMatchesLinearScan() {
+        let (_, dataList) = Self.makeDataList()
+        let maxEndTimes = ScoringMachine.makeMaxEndTimes(dataList: dataList)
+        var cursor = 0
+        var progresses = Array(stride(from: 0, to: dataList.last!.endTime + 500, by: 10))
+        /** 拖拽: 中间插入向前和向后的跳转 **/
+        progresses.insert(contentsOf: [90_000, 20_000, 20_010, 150_000], at: progresses.count / 2)
+        for progress in progresses {
+            let index = ScoringMachine.getHitedIndex(progress: progress, dataList: dataList, maxEndTimes: maxEndTimes, cursor: &cursor)
+            let expected = dataList.firstIndex(where: { $0.drawBeginTime <= progress && progress <= $0.endTime })
+            XCTAssertEqual(index, expected, "progress: \(progress)")
+        }
+    }
+
+    func testLineScoresCumulativeScore() {
+        var lineScores = ScoringMachine.LineScores(count: 10)
+        for index in 0..<10 {
+            lineScores[index] = index * 10
+        }
+        XCTAssertEqual(lineScores.cumulativeScore(indexOfLine: 9), 450)
+        lineScores[3] = 0
+        XCTAssertEqual(lineScores.cumulativeScore(indexOfLine: 2), 30)
+        XCTAssertEqual(lineScores.cumulativeScore(indexOfLine: 9), 420)
+        XCTAssertEqual(lineScores.cumulativeScore(indexOfLine: -1), 0)
+    }
+
+    // MARK: - 可见区间
+
+    private struct LegacyFrame {
+        let visible: [CGRect]
+        let highlight: [CGRect]
+        let highlightInfos: [ScoringMachine.Info]
+    }
+
+    /// 逐个筛选再逐个计算矩形, 即 VisibleWindow 之前的 filterInfos + calculateDrawRect
+    private func legacyMakeInfos(machine: ScoringMachine,
+                                 progress: Int,
+                                 dataList: [ScoringMachine.Info],
+                                 currentHighlightInfos: [ScoringMachine.Info],
+                                 canvasViewSize: CGSize,
+                                 minPitch: Double,
+                                 maxPitch: Double) -> LegacyFrame {
+        let widthPreMs = machine.movingSpeedFactor / 1000
+        let defaultPitchCursorXTime = Int(machine.defaultPitchCursorX / widthPreMs)
+        let remainTime = Int((canvasViewSize.width - machine.defaultPitchCursorX) / widthPreMs)
+        let beginTime = max(progress - defaultPitchCursorXTime, 0)
+        let endTime = progress + remainTime
+        func filterInfos(_ infos: [ScoringMachine.Info]) -> [ScoringMachine.Info] {
+            var result = [ScoringMachine.Info]()
+            for info in infos {
+                if info.drawBeginTime >= endTime {
+                    break
+                }
+                if info.endTime <= beginTime {
+                    continue
+                }
+                result.append(info)
+            }
+            return result
+        }
+        func rect(_ info: ScoringMachine.Info) -> CGRect {
+            return machine.calculateDrawRect(progress: progress,
+                                             info: info,
+                                             standardPitchStickViewHeight: machine.standardPitchStickViewHeight,
+                                             widthPreMs: widthPreMs,
+                                             canvasViewSize: canvasViewSize,
+                                             minPitch: minPitch,
+                                             maxPitch: maxPitch)
+        }
+        let highlightInfos = filterInfos(currentHighlightInfos)
+        return LegacyFrame(visible: filterInfos(dataList).map(rect),
+                           highlight: highlightInfos.map(rect),
+                           highlightInfos: highlightInfos)
+    }
+
+    /// 正常播放中夹杂随机拖拽和视图宽度变化, 每一帧与旧实现的字、矩形一致
+    private func assertVisibleWindowMatchesLegacy(dataList: [ScoringMachine.Info], seed: UInt64, file: StaticString = #file, line: UInt = #line) {
+        var state = seed
+        func next(_ bound: Int) -> Int {
+            state = state &* 6364136223846793005 &+ 1442695040888963407
+            return Int(state >> 33) % bound
+        }
+        let machine = ScoringMachine()
+        let widthPreMs = machine.movingSpeedFactor / 1000
+        var canvasViewSize = CGSize(width: 375, height: 180)
+        let (minPitch, maxPitch) = machine.makeMinMaxPitch(dataList: dataList)
+        let maxEndTimes = ScoringMachine.makeMaxEndTimes(dataList: dataList)
+        let rects = machine.makeDrawRects(dataList: dataList,
+                                          widthPreMs: widthPreMs,
+                                          canvasViewSize: canvasViewSize,
+                                          standardPitchStickViewHeight: machine.standardPitchStickViewHeight,
+                                          minPitch: minPitch,
+                                          maxPitch: maxPitch)
+        var visibleWindow = ScoringMachine.VisibleWindow(dataList: dataList, maxEndTimes: maxEndTimes, rects: rects)
+        var highlightBuffer = ScoringMachine.DrawBuffer()
+        var highlightInfos = [ScoringMachine.Info]()
+        var hitCursor = 0
+        var previous: (frame: [ScoringMachine.DrawInfo], expected: [CGRect])?
+        let end = dataList.last!.endTime + 2000
+        var progress = 0
+        for step in 0..<6000 {
+            switch next(100) {
+            case 0, 1:
+                progress = next(end)
+                highlightInfos = []
+            case 2:
+                canvasViewSize.width = CGFloat(300 + next(120))
+            default:
+                progress += 20
+                if progress > end {
+                    progress = 0
+                    highlightInfos = []
+                }
+            }
+            /** 与打分时一样, 击中的字追加高亮 **/
+            if next(3) > 0, let hitedIndex = ScoringMachine.getHitedIndex(progress: progress, dataList: dataList, maxEndTimes: maxEndTimes, cursor: &hitCursor) {
+                highlightInfos = machine.makeHighlightInfos(progress: progress,
+                                                            hitedInfo: dataList[hitedIndex],
+                                                            currentHighlightInfos: highlightInfos)
+            }
+
+            let expected = legacyMakeInfos(machine: machine,
+                                           progress: progress,
+                                           dataList: dataList,
+                                           currentHighlightInfos: highlightInfos,
+                                           canvasViewSize: canvasViewSize,
+                                           minPitch: minPitch,
+                                           maxPitch: maxPitch)
+            let (visible, highlight) = machine.makeInfos(progress: progress,
+                                                         visibleWindow: &visibleWindow,
+                                                         highlightBuffer: &highlightBuffer,
+                                                         currentHighlightInfos: &highlightInfos,
+                                                         defaultPitchCursorX: machine.defaultPitchCursorX,
+                                                         widthPreMs: widthPreMs,
+                                                         canvasViewSize: canvasViewSize,
+                                                         standardPitchStickViewHeight: machine.standardPitchStickViewHeight,
+                                                         minPitch: minPitch,
+                                                         maxPitch: maxPitch)
+            XCTAssertEqual(visible.map({ $0.rect }), expected.visible, "step \(step) progress \(progress)", file: file, line: line)
+            XCTAssertEqual(highlight.map({ $0.rect }), expected.highlight, "step \(step) progress \(progress)", file: file, line: line)
+            XCTAssertEqual(highlightInfos.map({ ObjectIdentifier($0) }), expected.highlightInfos.map({ ObjectIdentifier($0) }), "step \(step)", file: file, line: line)
+            /** 上一帧交给界面的数组不被下一帧覆盖 **/
+            if let previous = previous {
+                XCTAssertEqual(previous.frame.map({ $0.rect }), previous.expected, "step \(step)", file: file, line: line)
+            }
+            previous = (visible, expected.visible)
+        }
+    }
+
+    func testVisibleWindowMatchesLegacyFilter() {
+        for seed in 1...3 {
+            let (_, dataList) = Self.makeDataList(lines: 40, seed: UInt64(seed))
+            assertVisibleWindowMatchesLegacy(dataList: dataList, seed: UInt64(seed))
+        }
+    }
+
+    func testVisibleWindowMatchesLegacyFilterForLyricSample() throws {
+        let lyric = try ScoreEngineTests.loadLyric()
+        let (_, dataList) = ScoringMachine.createData(data: lyric)
+        assertVisibleWindowMatchesLegacy(dataList: dataList, seed: 4)
+    }
+
+    /// 每 10ms 一个pitch, 按正常进度播放整首歌
+    func testPerformanceGetHitedIndex() {
+        let (_, dataList) = Self.makeDataList(lines: 400)
+        let maxEndTimes = ScoringMachine.makeMaxEndTimes(dataList: dataList)
+        let end = dataList.last!.endTime
+        measure {
+            var cursor = 0
+            var hits = 0
+            for progress in stride(from: 0, to: end, by: 10) {
+                if ScoringMachine.getHitedIndex(progress: progress, dataList: dataList, maxEndTimes: maxEndTimes, cursor: &cursor) != nil {
+                    hits += 1
+                }
+            }
+            XCTAssertGreaterThan(hits, 0)
+        }
+    }
+
+    /// 对照: 每个pitch从头查找击中的字
+    func testPerformanceGetHitedIndexLinearScan() {
+        let (_, dataList) = Self.makeDataList(lines: 400)
+        let end = dataList.last!.endTime
+        measure {
+            var hits = 0
+            for progress in stride(from: 0, to: end, by: 10) {
+                if dataList.firstIndex(where: { $0.drawBeginTime <= progress && progress <= $0.endTime }) != nil {
+                    hits += 1
+                }
+            }
+            XCTAssertGreaterThan(hits, 0)
+        }
+    }
+
+    /// 每句结束时写入该句分数并取累计分数
+    func testPerformanceLineScores() {
+        let count = 1000
+        measure {
+            var lineScores = ScoringMachine.LineScores(count: count)
+            var total = 0
+            for _ in 0..<10 {
+                for index in 0..<count {
+                    lineScores[index] = index % 100
+                    total = lineScores.cumulativeScore(indexOfLine: index)
+                }
+            }
+            XCTAssertGreaterThan(total, 0)
+        }
+    }
+
+    /// 对照: 每句结束时重新累加所有句子的分数
+    func testPerformanceLineScoresReduce() {
+        let count = 1000
+        measure {
+            var scores = [Int](repeating: 0, count: count)
+            var total = 0
+            for _ in 0..<10 {
+                for index in 0..<count {
+                    scores[index] = index % 100
+                    total = scores[0...index].reduce(0, +)
+                }
+            }
+            XCTAssertGreaterThan(total, 0)
+        }
+    }
+}
@@ -0,0 +1,173 @@
+//
+//  ZipTests.swift
+//  KJVoiceChatRoomTests
+//
+
+import XCTest
+import Zip
+
+final class ZipTests: XCTestCase {
+
+    /// Text shaped like lyric xml, compressible but not a single repeated block.
+    static func sampleText(lines: Int, seed: UInt64 = 1) -> Data {
+        let words = ["<word>", "</word>", "<sentence>", "</sentence>", "pitch=", "begin=", "end=", "mode=", "\"", " ", "la", "dee", "da"]
+        var state = seed
+        var text = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<song>\n"
+        text.reserveCapacity(lines * 64)
+        for line in 0..<lines {
+            text += "<tone begin=\"\(line * 250)\" end=\"\(line * 250 + 240)\" pitch=\"\(40 + line % 37)\">"
+            for _ in 0..<6 {
+                state = state &* 6364136223846793005 &+ 1442695040888963407
+                text += words[Int(state >> 33) % words.count]
+            }
+            text += "</tone>\n"
+        }
+        text += "</song>\n"
+        return Data(text.utf8)
+    }
+
+    func testParallelCompressionRoundTrip() throws {
+        let data = Self.sampleText(lines: 120_000)
+        let files = [ArchiveFile(filename: "big.xml", data: data as NSData, modifiedTime: nil),
+                     ArchiveFile(filename: "small.xml", data: Self.sampleText(lines: 10) as NSData, modifiedTime: nil)]
+        let archive = try Zip.zipToData(files, compression: .ParallelCompression)
+        let entries = try Zip.unzipData(archive)
+        XCTAssertEqual(entries["big.xml"], data)
+        XCTAssertEqual(entries["small.xml"], Self.sampleText(lines: 10))
+    }
+
+    private func temporaryDirectory() throws -> URL {
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString)
+        try FileManager.default.createDirectory(at: url, withIntermediateDirectories: true)
+        addTeardownBlock {
+            try? FileManager.default.removeItem(at: url)
+        }
+        return url
+    }
+
+    func testUnzipFileCallbacksOnCallingThread() throws {
+        let directory = try temporaryDirectory()
+        let files = (0..<64).map {
+            ArchiveFile(filename: "lyrics/\($0).xml", data: Self.sampleText(lines: 200, seed: UInt64($0)) as NSData, modifiedTime: nil)
+        }
+        let zipURL = directory.appendingPathComponent("lyrics.zip")
+        try Zip.zipToData(files).write(to: zipURL)
+
+        let destination = directory.appendingPathComponent("out")
+        let callingThread = Thread.current
+        var outputCount = 0
+        var lastProgress = 0.0
+        try Zip.unzipFile(zipURL, destination: destination, overwrite: true, password: nil, progress: { progress in
+            XCTAssertTrue(Thread.current === callingThread)
+            XCTAssertGreaterThanOrEqual(progress, lastProgress)
+            lastProgress = progress
+        }, fileOutputHandler: { _ in
+            XCTAssertTrue(Thread.current === callingThread)
+            outputCount += 1
+        })
+        XCTAssertEqual(outputCount, files.count)
+        XCTAssertEqual(lastProgress, 1.0)
+        for (index, file) in files.enumerated() {
+            let data = try Data(contentsOf: destination.appendingPathComponent("lyrics/\(index).xml"))
+            XCTAssertEqual(data, Self.sampleText(lines: 200, seed: UInt64(index)), file.filename)
+        }
+    }
+
+    func testUnzipFileDuplicatePathKeepsLastEntry() throws {
+        let directory = try temporaryDirectory()
+        let first = Self.sampleText(lines: 5000, seed: 1)
+        let last = Self.sampleText(lines: 10, seed: 2)
+        let files = [ArchiveFile(filename: "a.xml", data: first as NSData, modifiedTime: nil),
+                     ArchiveFile(filename: "./a.xml", data: first as NSData, modifiedTime: nil),
+                     ArchiveFile(filename: "a.xml", data: last as NSData, modifiedTime: nil)]
+        let zipURL = directory.appendingPathComponent("duplicate.zip")
+        try Zip.zipToData(files).write(to: zipURL)
+
+        let destination = directory.appendingPathComponent("out")
+        try Zip.unzipFile(zipURL, destination: destination, overwrite: true, password: nil)
+        XCTAssertEqual(try Data(contentsOf: destination.appendingPathComponent("a.xml")), last)
+    }
+
+    func testUnzipFileWithoutOverwriteFailsOnExistingFile() throws {
+        let directory = try temporaryDirectory()
+        let zipURL = directory.appendingPathComponent("lyric.zip")
+        try Zip.zipToData([ArchiveFile(filename: "a.xml", data: Self.sampleText(lines: 10) as NSData, modifiedTime: nil)]).write(to: zipURL)
+
+        let destination = directory.appendingPathComponent("out")
+        try FileManager.default.createDirectory(at: destination, withIntermediateDirectories: true)
+        try Data("old".utf8).write(to: destination.appendingPathComponent("a.xml"))
+        XCTAssertThrowsError(try Zip.unzipFile(zipURL, destination: destination, overwrite: false, password: nil))
+    }
+
+    /// Overwrites the uncompressed size of every entry in the local and central headers.
+    static func patchUncompressedSize(_ archive: Data, to size: UInt32) -> Data {
+        var bytes = [UInt8](archive)
+        func write(_ offset: Int) {
+            for i in 0..<4 {
+                bytes[offset + i] = UInt8(truncatingIfNeeded: size >> (8 * UInt32(i)))
+            }
+        }
+        var i = 0
+        while i + 46 <= bytes.count {
+            if bytes[i] == 0x50, bytes[i + 1] == 0x4B, bytes[i + 2] == 0x03, bytes[i + 3] == 0x04 {
+                write(i + 22)
+            } else if bytes[i] == 0x50, bytes[i + 1] == 0x4B, bytes[i + 2] == 0x01, bytes[i + 3] == 0x02 {
+                write(i + 24)
+            }
+            i += 1
+        }
+        return Data(bytes)
+    }
+
+    func testUnzipDataRejectsHostileUncompressedSize() throws {
+        let archive = try Zip.zipToData([ArchiveFile(filename: "a.xml", data: Self.sampleText(lines: 100) as NSData, modifiedTime: nil)])
+        // Claims almost 4 GB for a few KB of deflated data: must fail without allocating the claimed size
+        XCTAssertThrowsError(try Zip.unzipData(Self.patchUncompressedSize(archive, to: 0xFFFF_FFF0)))
+        XCTAssertThrowsError(try Zip.unzipData(Self.patchUncompressedSize(archive, to: 16)))
+        XCTAssertEqual(try Zip.unzipData(archive)["a.xml"], Self.sampleText(lines: 100))
+    }
+
+    func testMergeLaterArchiveWins() throws {
+        let directory = try temporaryDirectory()
+        let first = directory.appendingPathComponent("first.zip")
+        let second = directory.appendingPathComponent("second.zip")
+        try Zip.zipToData([ArchiveFile(filename: "a.xml", data: Data("a1".utf8) as NSData, modifiedTime: nil),
+                           ArchiveFile(filename: "b.xml", data: Self.sampleText(lines: 500) as NSData, modifiedTime: nil)]).write(to: first)
+        try Zip.zipToData([ArchiveFile(filename: "a.xml", data: Data("a2".utf8) as NSData, modifiedTime: nil),
+                           ArchiveFile(filename: "c.xml", data: Data("c2".utf8) as NSData, modifiedTime: nil)],
+                          compression: .NoCompression).write(to: second)
+
+        let merged = directory.appendingPathComponent("merged.zip")
+        try Zip.merge([first, second], into: merged)
+        let entries = try Zip.unzipData(Data(contentsOf: merged))
+        XCTAssertEqual(entries, ["a.xml": Data("a2".utf8), "b.xml": Self.sampleText(lines: 500), "c.xml": Data("c2".utf8)])
+
+        let filtered = directory.appendingPathComponent("filtered.zip")
+        try Zip.filter(merged, destination: filtered) { $0 != "b.xml" }
+        XCTAssertEqual(try Zip.unzipData(Data(contentsOf: filtered)).keys.sorted(), ["a.xml", "c.xml"])
+    }
+
+    func testPerformanceDefaultCompression() throws {
+        let files = [ArchiveFile(filename: "big.xml", data: Self.sampleText(lines: 120_000) as NSData, modifiedTime: nil)]
+        measure {
+            _ = try? Zip.zipToData(files, compression: .DefaultCompression)
+        }
+    }
+
+    func testPerformanceParallelCompression() throws {
+        let files = [ArchiveFile(filename: "big.xml", data: Self.sampleText(lines: 120_000) as NSData, modifiedTime: nil)]
+        measure {
+            _ = try? Zip.zipToData(files, compression: .ParallelCompression)
+        }
+    }
+
+    /// Many small entries: time and memory are dominated by building the central directory.
+    func testPerformanceManyEntries() throws {
+        let data = Self.sampleText(lines: 2) as NSData
+        let files = (0..<10_000).map { ArchiveFile(filename: "lyrics/\($0).xml", data: data, modifiedTime: nil) }
+        XCTAssertEqual(try Zip.unzipData(Zip.zipToData(files)).count, files.count)
+        measure(metrics: [XCTClockMetric(), XCTMemoryMetric()]) {
+            _ = try? Zip.zipToData(files, compression: .BestSpeed)
+        }
+    }
+}
@@ -0,0 +1,263 @@
+//
+//  AUIJsonHash.swift
+//  AUIKitCore
+//
+
+import Foundation
+
+/// json 的结构哈希: 直接扫描 json 字符串, 不创建对象
+/// 与序列化方式无关: 忽略空白, object 的 key 顺序不影响结果, 字符串按转义还原后的内容计算("\/" 与 "/" 相同),
+/// 数值按值计算("1" 与 "1.0" 相同, 超出 Int64 的整数按数字串计算)
+/// 64 位哈希, 不同的值碰撞的概率可以忽略
+enum AUIJsonHash {
+    private static let maxDepth = 512
+
+    private enum Tag: UInt64 {
+        case null = 1, bool, int, bigInt, double, string, array, object
+    }
+
+    /// 不是合法 json 时返回nil
+    static func hash(jsonString: String) -> UInt64? {
+        if let hash = jsonString.utf8.withContiguousStorageIfAvailable({ hash(bytes: $0) }) {
+            return hash
+        }
+        let bytes = Array(jsonString.utf8)
+        return bytes.withUnsafeBufferPointer { hash(bytes: $0) }
+    }
+
+    static func hash(bytes: UnsafeBufferPointer<UInt8>) -> UInt64? {
+        var reader = Reader(bytes: bytes)
+        guard let hash = reader.value(depth: 0) else { return nil }
+        reader.skipWhitespace()
+        return reader.isAtEnd ? hash : nil
+    }
+
+    /// splitmix64 的 finalizer
+    fileprivate static func mix(_ value: UInt64) -> UInt64 {
+        var z = value &+ 0x9E3779B97F4A7C15
+        z = (z ^ (z >> 30)) &* 0xBF58476D1CE4E5B9
+        z = (z ^ (z >> 27)) &* 0x94D049BB133111EB
+        return z ^ (z >> 31)
+    }
+
+    fileprivate static func mix(_ tag: Tag, _ value: UInt64) -> UInt64 {
+        return mix(mix(tag.rawValue) ^ value)
+    }
+
+    private struct Reader {
+        let bytes: UnsafeBufferPointer<UInt8>
+        var pos = 0
+
+        init(bytes: UnsafeBufferPointer<UInt8>) {
+            self.bytes = bytes
+        }
+
+        var isAtEnd: Bool {
+            return pos >= bytes.count
+        }
+
+        mutating func skipWhitespace() {
+            while pos < bytes.count {
+                switch bytes[pos] {
+                case 0x20, 0x09, 0x0A, 0x0D:
+                    pos += 1
+                default:
+                    return
+                }
+            }
+        }
+
+        mutating func consume(_ byte: UInt8) -> Bool {
+            skipWhitespace()
+            guard pos < bytes.count, bytes[pos] == byte else { return false }
+            pos += 1
+            return true
+        }
+
+        mutating func value(depth: Int) -> UInt64? {
+            skipWhitespace()
+            guard pos < bytes.count, depth < AUIJsonHash.maxDepth else { return nil }
+            switch bytes[pos] {
+            case UInt8(ascii: "{"):
+                pos += 1
+                return object(depth: depth)
+            case UInt8(ascii: "["):
+                pos += 1
+                return array(depth: depth)
+            case UInt8(ascii: "\""):
+                pos += 1
+                return string()
+            case UInt8(ascii: "t"):
+                return literal("true") ? AUIJsonHash.mix(.bool, 1) : nil
+            case UInt8(ascii: "f"):
+                return literal("false") ? AUIJsonHash.mix(.bool, 0) : nil
+            case UInt8(ascii: "n"):
+                return literal("null") ? AUIJsonHash.mix(.null, 0) : nil
+            default:
+                return number()
+            }
+        }
+
+        /// 成员哈希相加, 与 key 的顺序无关
+        private mutating func object(depth: Int) -> UInt64? {
+            var sum: UInt64 = 0
+            var count: UInt64 = 0
+            if consume(UInt8(ascii: "}")) {
+                return AUIJsonHash.mix(.object, 0)
+            }
+            repeat {
+                guard consume(UInt8(ascii: "\"")), let key = string(),
+                      consume(UInt8(ascii: ":")), let member = value(depth: depth + 1) else {
+                    return nil
+                }
+                sum = sum &+ AUIJsonHash.mix(key &+ AUIJsonHash.mix(member))
+                count += 1
+            } while consume(UInt8(ascii: ","))
+            guard consume(UInt8(ascii: "}")) else { return nil }
+            return AUIJsonHash.mix(.object, AUIJsonHash.mix(sum ^ count))
+        }
+
+        private mutating func array(depth: Int) -> UInt64? {
+            var hash: UInt64 = 0
+            if consume(UInt8(ascii: "]")) {
+                return AUIJsonHash.mix(.array, 0)
+            }
+            repeat {
+                guard let element = value(depth: depth + 1) else { return nil }
+                hash = AUIJsonHash.mix(hash ^ element)
+            } while consume(UInt8(ascii: ","))
+            guard consume(UInt8(ascii: "]")) else { return nil }
+            return AUIJsonHash.mix(.array, hash)
+        }
+
+        /// 起始的引号已读过, FNV-1a 处理转义还原后的 utf8
+        private mutating func string() -> UInt64? {
+            var hash: UInt64 = 0xCBF29CE484222325
+            var length: UInt64 = 0
+            func update(_ byte: UInt8) {
+                hash = (hash ^ UInt64(byte)) &* 0x100000001B3
+                length += 1
+            }
+            while pos < bytes.count {
+                let byte = bytes[pos]
+                pos += 1
+                if byte == UInt8(ascii: "\"") {
+                    return AUIJsonHash.mix(.string, AUIJsonHash.mix(hash ^ length))
+                }
+                if byte != UInt8(ascii: "\\") {
+                    update(byte)
+                    continue
+                }
+                guard pos < bytes.count else { return nil }
+                let escape = bytes[pos]
+                pos += 1
+                switch escape {
+                case UInt8(ascii: "\""), UInt8(ascii: "\\"), UInt8(ascii: "/"):
+                    update(escape)
+                case UInt8(ascii: "b"): update(0x08)
+                case UInt8(ascii: "f"): update(0x0C)
+                case UInt8(ascii: "n"): update(0x0A)
+                case UInt8(ascii: "r"): update(0x0D)
+                case UInt8(ascii: "t"): update(0x09)
+                case UInt8(ascii: "u"):
+                    guard var scalar = hex4() else { return nil }
+                    //代理对
+                    if scalar >= 0xD800, scalar < 0xDC00, pos + 1 < bytes.count,
+                       bytes[pos] == UInt8(ascii: "\\"), bytes[pos + 1] == UInt8(ascii: "u") {
+                        let save = pos
+                        pos += 2
+                        if let low = hex4(), low >= 0xDC00, low < 0xE000 {
+                            scalar = 0x10000 + ((scalar - 0xD800) << 10) + (low - 0xDC00)
+                        } else {
+                            pos = save
+                        }
+                    }
+                    //落单的代理按 U+FFFD 计算, 与 JSONSerialization 的容错一致
+                    let unicodeScalar = Unicode.Scalar(scalar) ?? "\u{FFFD}"
+                    for byte in UTF8.encode(unicodeScalar)! {
+                        update(byte)
+                    }
+                default:
+                    return nil
+                }
+            }
+            return nil
+        }
+
+        private mutating func hex4() -> UInt32? {
+            guard pos + 4 <= bytes.count else { return nil }
+            var value: UInt32 = 0
+            for _ in 0..<4 {
+                let byte = bytes[pos]
+                pos += 1
+                switch byte {
+                case UInt8(ascii: "0")...UInt8(ascii: "9"):
+                    value = value << 4 | UInt32(byte - UInt8(ascii: "0"))
+                case UInt8(ascii: "a")...UInt8(ascii: "f"):
+                    value = value << 4 | UInt32(byte - UInt8(ascii: "a") + 10)
+                case UInt8(ascii: "A")...UInt8(ascii: "F"):
+                    value = value << 4 | UInt32(byte - UInt8(ascii: "A") + 10)
+                default:
+                    return nil
+                }
+            }
+            return value
+        }
+
+        private mutating func literal(_ text: StaticString) -> Bool {
+            let count = text.utf8CodeUnitCount
+            guard pos + count <= bytes.count else { return false }
+            for i in 0..<count where bytes[pos + i] != text.utf8Start[i] {
+                return false
+            }
+            pos += count
+            return true
+        }
+
+        /// 整数按 Int64 计算, 小数能精确表示为整数时与整数相同, 其余按 double 计算
+        private mutating func number() -> UInt64? {
+            let start = pos
+            var isInteger = true
+            while pos < bytes.count {
+                switch bytes[pos] {
+                case UInt8(ascii: "0")...UInt8(ascii: "9"), UInt8(ascii: "-"), UInt8(ascii: "+"):
+                    break
+                case UInt8(ascii: "."), UInt8(ascii: "e"), UInt8(ascii: "E"):
+                    isInteger = false
+                default:
+                    return number(start: start, isInteger: isInteger)
+                }
+                pos += 1
+            }
+            return number(start: start, isInteger: isInteger)
+        }
+
+        private func number(start: Int, isInteger: Bool) -> UInt64? {
+            let token = UnsafeBufferPointer(rebasing: bytes[start..<pos])
+            guard let first = token.first, first == UInt8(ascii: "-") || (first >= UInt8(ascii: "0") && first <= UInt8(ascii: "9")) else {
+                return nil
+            }
+            let text = String(decoding: token, as: UTF8.self)
+            if isInteger {
+                if let value = Int64(text) {
+                    return AUIJsonHash.mix(.int, UInt64(bitPattern: value))
+                }
+                //超出 Int64 的整数按数字串计算, 保证不同的大整数哈希不同
+                let digits = token.dropFirst(first == UInt8(ascii: "-") ? 1 : 0)
+                guard !digits.isEmpty, digits.allSatisfy({ $0 >= UInt8(ascii: "0") && $0 <= UInt8(ascii: "9") }) else {
+                    return nil
+                }
+                var hash: UInt64 = 0xCBF29CE484222325
+                for byte in token {
+                    hash = (hash ^ UInt64(byte)) &* 0x100000001B3
+                }
+                return AUIJsonHash.mix(.bigInt, hash)
+            }
+            guard let value = Double(text), value.isFinite else { return nil }
+            if value == value.rounded(), abs(value) < 9007199254740992 {
+                return AUIJsonHash.mix(.int, UInt64(bitPattern: Int64(value)))
+            }
+            return AUIJsonHash.mix(.double, value.bitPattern)
+        }
+    }
+}
@@ -0,0 +1,164 @@
+//
+//  AUIMetadataCommitScheduler.swift
+//  AUIKitCore
+//
+
+import Foundation
+
+/// 合并 channel metadata 的写入
+/// 同一个 channel + lock 在 window 内的多次写入/删除合并成一次 set 和一次 remove, 同一个 key 以最后一次操作为准
+/// 每次调用的 completion 都在合并后的请求全部完成时回调(仲裁者据此回 receipt)
+class AUIMetadataCommitScheduler {
+    typealias Completion = (NSError?) -> ()
+    /// 实际的写入, AUIRtmManager 里对应 setMetadata/cleanMetadata, 测试时可以换成本地内存里的存储
+    typealias SetHandler = (_ channelName: String, _ lockName: String, _ metadata: [String: String], _ completion: @escaping Completion) -> ()
+    typealias RemoveHandler = (_ channelName: String, _ lockName: String, _ keys: [String], _ completion: @escaping Completion) -> ()
+
+    /// 最后一次写入后等待合并的时间
+    var window: TimeInterval = 0.01
+    /// 第一次写入后最多等待的时间, 避免连续写入时一直不提交
+    var maxDelay: TimeInterval = 0.1
+    /// 待提交的 key + value 字节数达到上限时立即提交
+    var maxPendingBytes: Int = 16 * 1024
+
+    private class Batch {
+        let channelName: String
+        let lockName: String
+        let firstDate = Date()
+        var metadata: [String: String] = [:]
+        var removeKeys: [String] = []
+        var pendingBytes: Int = 0
+        var callbacks: [Completion] = []
+        var workItem: DispatchWorkItem?
+
+        init(channelName: String, lockName: String) {
+            self.channelName = channelName
+            self.lockName = lockName
+        }
+
+        func set(key: String, value: String) {
+            if let oldValue = metadata[key] {
+                pendingBytes -= key.utf8.count + oldValue.utf8.count
+            }
+            metadata[key] = value
+            pendingBytes += key.utf8.count + value.utf8.count
+            removeKeys.removeAll { $0 == key }
+        }
+
+        func remove(key: String) {
+            if let oldValue = metadata.removeValue(forKey: key) {
+                pendingBytes -= key.utf8.count + oldValue.utf8.count
+            }
+            guard !removeKeys.contains(key) else { return }
+            removeKeys.append(key)
+            pendingBytes += key.utf8.count
+        }
+    }
+
+    private let queue: DispatchQueue
+    private let setHandler: SetHandler
+    private let removeHandler: RemoveHandler
+    private var batches: [String: Batch] = [:]
+
+    required init(queue: DispatchQueue = .main,
+                  setHandler: @escaping SetHandler,
+                  removeHandler: @escaping RemoveHandler) {
+        self.queue = queue
+        self.setHandler = setHandler
+        self.removeHandler = removeHandler
+    }
+
+    func set(channelName: String,
+             lockName: String,
+             metadata: [String: String],
+             fetchImmediately: Bool = false,
+             completion: @escaping Completion) {
+        let batch = pendingBatch(channelName: channelName, lockName: lockName)
+        metadata.forEach { key, value in
+            batch.set(key: key, value: value)
+        }
+        batch.callbacks.append(completion)
+        schedule(batch: batch, fetchImmediately: fetchImmediately)
+    }
+
+    func remove(channelName: String,
+                lockName: String,
+                keys: [String],
+                fetchImmediately: Bool = false,
+                completion: @escaping Completion) {
+        let batch = pendingBatch(channelName: channelName, lockName: lockName)
+        keys.forEach { key in
+            batch.remove(key: key)
+        }
+        batch.callbacks.append(completion)
+        schedule(batch: batch, fetchImmediately: fetchImmediately)
+    }
+
+    /// 立即提交 channel 下所有待写入的修改
+    func flush(channelName: String) {
+        batches.values.filter { $0.channelName == channelName }.forEach { commit(batch: $0) }
+    }
+
+    func flushAll() {
+        batches.values.forEach { commit(batch: $0) }
+    }
+
+    private func pendingBatch(channelName: String, lockName: String) -> Batch {
+        let key = "\(channelName)__\(lockName)"
+        if let batch = batches[key] {
+            return batch
+        }
+        let batch = Batch(channelName: channelName, lockName: lockName)
+        batches[key] = batch
+        return batch
+    }
+
+    private func schedule(batch: Batch, fetchImmediately: Bool) {
+        batch.workItem?.cancel()
+        if fetchImmediately
+            || batch.pendingBytes >= maxPendingBytes
+            || -batch.firstDate.timeIntervalSinceNow >= maxDelay {
+            commit(batch: batch)
+            return
+        }
+        let workItem = DispatchWorkItem { [weak self, weak batch] in
+            guard let self = self, let batch = batch else { return }
+            self.commit(batch: batch)
+        }
+        batch.workItem = workItem
+        queue.asyncAfter(deadline: .now() + min(window, max(0, maxDelay + batch.firstDate.timeIntervalSinceNow)),
+                         execute: workItem)
+    }
+
+    private func commit(batch: Batch) {
+        let key = "\(batch.channelName)__\(batch.lockName)"
+        guard batches[key] === batch else { return }
+        batches[key] = nil
+        batch.workItem?.cancel()
+
+        let callbacks = batch.callbacks
+        var pendingCount = (batch.removeKeys.isEmpty ? 0 : 1) + (batch.metadata.isEmpty ? 0 : 1)
+        var firstError: NSError?
+        let onFinished: Completion = { error in
+            if firstError == nil {
+                firstError = error
+            }
+            pendingCount -= 1
+            guard pendingCount <= 0 else { return }
+            callbacks.forEach { callback in
+                callback(firstError)
+            }
+        }
+        aui_info("commit metadata[\(batch.channelName)][\(batch.lockName)] calls: \(callbacks.count) set: \(batch.metadata.keys) remove: \(batch.removeKeys)", tag: "AUIRtmManager")
+        if pendingCount == 0 {
+            onFinished(nil)
+            return
+        }
+        if !batch.removeKeys.isEmpty {
+            removeHandler(batch.channelName, batch.lockName, batch.removeKeys, onFinished)
+        }
+        if !batch.metadata.isEmpty {
+            setHandler(batch.channelName, batch.lockName, batch.metadata, onFinished)
+        }
+    }
+}
@@ -21,8 +21,42 @@ open class AUIRtmManager: NSObject {
     
     public private(set) var isLogin: Bool = false
     private var isExternalLogin: Bool!
-    private var throttlerUpdateModel = AUIThrottlerUpdateMetaDataModel()
-    private var throttlerRemoveModel = AUIThrottlerRemoveMetaDataModel()
+    /// 按 channel + lock 合并 setBatchMetadata/cleanBatchMetadata 的写入, 测试时可以换成写入本地内存的实例
+    /// manager 释放后提交的写入直接回调失败, 调用方(例如等待 receipt 的仲裁者)不会一直等下去
+    lazy var metadataScheduler = AUIMetadataCommitScheduler(setHandler: { [weak self] channelName, lockName, metadata, completion in
+        guard let self = self else {
+            completion(AUICommonError.noResponse.toNSError())
+            return
+        }
+        self.setMetadata(channelName: channelName, lockName: lockName, metadata: metadata, completion: completion)
+    }, removeHandler: { [weak self] channelName, lockName, keys, completion in
+        guard let self = self else {
+            completion(AUICommonError.noResponse.toNSError())
+            return
+        }
+        self.cleanMetadata(channelName: channelName, removeKeys: keys, lockName: lockName, completion: completion)
+    })
+    
+    /// 合并 metadata 写入的时间窗口(秒), 最后一次写入后等待这么久再提交
+    public var metadataCommitWindow: TimeInterval {
+        get { return metadataScheduler.window }
+        set { metadataScheduler.window = newValue }
+    }
+    
+    /// 第一次写入后最多等待的时间(秒)
+    public var metadataCommitMaxDelay: TimeInterval {
+        get { return metadataScheduler.maxDelay }
+        set { metadataScheduler.maxDelay = newValue }
+    }
+    
+    /// 待提交的 metadata 字节数达到上限时立即提交
+    public var metadataCommitMaxBytes: Int {
+        get { return metadataScheduler.maxPendingBytes }
+        set { metadataScheduler.maxPendingBytes = newValue }
+    }
+    
+    /// channelName -> userId -> 对端支持的 collection 消息二进制编码版本, 没有记录的只支持 json; 用户离开或退订 channel 时移除
+    private(set) var messageCodecVersions: [String: [String: Int]] = [:]
     
     private var receiptTimer: Timer?
     private(set) var receiptCallbackMap: [String: AUIReceipt] = [:] {
@@ -52,6 +86,9 @@ open class AUIRtmManager: NSObject {
     
     deinit {
         aui_info("deinit AUIRtmManager", tag: "AUIRtmManager")
+        //还没提交的写入回调失败
+        metadataScheduler.flushAll()
+        proxy.unsubscribeUser(channelName: "", delegate: self)
         self.rtmClient.removeDelegate(proxy)
     }
     
@@ -64,6 +101,8 @@ open class AUIRtmManager: NSObject {
         self.rtmChannelType = rtmChannelType
         super.init()
         self.rtmClient.addDelegate(proxy)
+        //用户离开时清理 messageCodecVersions; proxy 的 user 回调不区分 channel
+        proxy.subscribeUser(channelName: "", delegate: self)
         aui_info("init AUIRtmManager", tag: "AUIRtmManager")
     }
     
@@ -243,7 +282,9 @@ extension AUIRtmManager {
     }
     
     public func unSubscribe(channelName: String) {
+        metadataScheduler.flush(channelName: channelName)
         proxy.cleanCache(channelName: channelName)
+        messageCodecVersions[channelName] = nil
         rtmClient.unsubscribe(channelName)
     }
 }
@@ -256,25 +297,11 @@ extension AUIRtmManager {
                                    fetchImmediately: Bool = false,
                                    completion: @escaping (NSError?)->()) {
         aui_info("cleanBatchMetadata[\(channelName)] removeKeys:\(removeKeys)")
-        throttlerRemoveModel.appendMetaDataInfo(keys: removeKeys, completion: completion)
-        //TODO: throttler by channel & lockName
-        throttlerRemoveModel.throttler.triggerLastEvent(after: 0.01, execute: { [weak self] in
-            guard let self = self else {return}
-            guard self.throttlerRemoveModel.keys.count > 0 else {return}
-            let callbacks = self.throttlerRemoveModel.callbacks
-            aui_info("cleanBatchMetadata[\(channelName)] keys count: \(self.throttlerRemoveModel.keys.count)")
-            self.cleanMetadata(channelName: channelName,
-                               removeKeys: self.throttlerRemoveModel.keys,
-                               lockName: lockName) { err in
-                callbacks.forEach { callback in
-                    callback(err)
-                }
-            }
-            self.throttlerRemoveModel.reset()
-        })
-        if fetchImmediately {
-            throttlerRemoveModel.throttler.triggerNow()
-        }
+        metadataScheduler.remove(channelName: channelName,
+                                 lockName: lockName,
+                                 keys: removeKeys,
+                                 fetchImmediately: fetchImmediately,
+                                 completion: completion)
     }
     
     public func cleanMetadata(channelName: String, 
@@ -306,26 +333,12 @@ extension AUIRtmManager {
                                  metadata: [String: String],
                                  fetchImmediately: Bool = false,
                                  completion: @escaping (NSError?)->()) {
-        aui_info("setBatchMetadata1[\(channelName)] metadata keys: \(metadata.keys)")
-        throttlerUpdateModel.appendMetaDataInfo(metaData: metadata, completion: completion)
-        //TODO: throttler by channel & lockName
-        throttlerUpdateModel.throttler.triggerLastEvent(after: 0.01, execute: { [weak self] in
-            guard let self = self else {return}
-            guard self.throttlerUpdateModel.metaData.count > 0 else {return}
-            let callbacks = self.throttlerUpdateModel.callbacks
-            aui_info("setBatchMetadata2[\(channelName)] metadata keys: \(self.throttlerUpdateModel.metaData.keys)")
-            self.setMetadata(channelName: channelName,
-                             lockName: lockName,
-                             metadata: self.throttlerUpdateModel.metaData) { err in
-                callbacks.forEach { callback in
-                    callback(err)
-                }
-            }
-            self.throttlerUpdateModel.reset()
-        })
-        if fetchImmediately {
-            throttlerUpdateModel.throttler.triggerNow()
-        }
+        aui_info("setBatchMetadata[\(channelName)] metadata keys: \(metadata.keys)")
+        metadataScheduler.set(channelName: channelName,
+                              lockName: lockName,
+                              metadata: metadata,
+                              fetchImmediately: fetchImmediately,
+                              completion: completion)
     }
 
     public func setMetadata(channelName: String,
@@ -518,18 +531,52 @@ extension AUIRtmManager {
         publish(userId: userId, 
                 channelName: channelName,
                 message: message) {[weak self] err in
-            guard let self = self else {return}
-            if let err = err {
-                completion?(err)
+            guard let self = self else {
+                completion?(err ?? AUICommonError.noResponse.toNSError())
+                return
+            }
+            self.waitReceipt(uniqueId: uniqueId, date: date, error: err, completion: completion)
+        }
+    }
+    
+    public func publishAndWaitReceipt(userId: String,
+                                      channelName: String,
+                                      data: Data,
+                                      uniqueId: String,
+                                      completion: ( (NSError?)->())?) {
+        let date = Date()
+        publish(userId: userId,
+                channelName: channelName,
+                data: data) {[weak self] err in
+            guard let self = self else {
+                completion?(err ?? AUICommonError.noResponse.toNSError())
                 return
             }
-            self.receiptCallbackMap[uniqueId] = AUIReceipt(closure: { error in
-                aui_benchmark("publishAndWaitReceipt completion", cost: -date.timeIntervalSinceNow)
-                completion?(error)
-            }, uniqueId: uniqueId)
+            self.waitReceipt(uniqueId: uniqueId, date: date, error: err, completion: completion)
         }
     }
     
+    private func waitReceipt(uniqueId: String, date: Date, error: NSError?, completion: ( (NSError?)->())?) {
+        if let error = error {
+            completion?(error)
+            return
+        }
+        self.receiptCallbackMap[uniqueId] = AUIReceipt(closure: { error in
+            aui_benchmark("publishAndWaitReceipt completion", cost: -date.timeIntervalSinceNow)
+            completion?(error)
+        }, uniqueId: uniqueId)
+    }
+    
+    func updateMessageCodecVersion(channelName: String, userId: String, version: Int) {
+        guard messageCodecVersions[channelName]?[userId] != version else { return }
+        aui_info("message codec of '\(userId)' in '\(channelName)': \(version)", tag: "AUIRtmManager")
+        messageCodecVersions[channelName, default: [:]][userId] = version
+    }
+    
+    func messageCodecVersion(channelName: String, userId: String) -> Int {
+        return messageCodecVersions[channelName]?[userId] ?? 0
+    }
+    
     public func publish(userId: String, 
                         channelName: String,
                         message: String,
@@ -550,6 +597,25 @@ extension AUIRtmManager {
         aui_info("publish '\(message)' to '\(channelName)'", tag: "AUIRtmManager")
     }
     
+    public func publish(userId: String,
+                        channelName: String,
+                        data: Data,
+                        completion: @escaping (NSError?)->()) {
+        let options = AgoraRtmPublishOptions()
+        options.channelType = .user
+        rtmClient.publish(channelName: userId,
+                          data: data,
+                          option: options) { resp, error in
+            var callbackError: NSError?
+            if let error = error {
+                callbackError = AUICommonError.httpError(error.errorCode.rawValue, error.reason).toNSError()
+            }
+            completion(callbackError)
+            aui_info("publish \(data.count) bytes to '\(channelName)': \(error?.errorCode.rawValue ?? 0)", tag: "AUIRtmManager")
+        }
+        aui_info("publish \(data.count) bytes to '\(channelName)'", tag: "AUIRtmManager")
+    }
+    
     public func publish(channelName: String, 
                         message: String,
                         completion: @escaping (NSError?)->()) {
@@ -642,3 +708,22 @@ extension AgoraRtmErrorInfo {
     }
 }
 
+//MARK: AUIRtmUserProxyDelegate
+extension AUIRtmManager: AUIRtmUserProxyDelegate {
+    public func onCurrentUserJoined(channelName: String) {
+    }
+    
+    public func onUserSnapshotRecv(channelName: String, userId: String, userList: [[String : Any]]) {
+    }
+    
+    public func onUserDidJoined(channelName: String, userId: String, userInfo: [String : Any]) {
+    }
+    
+    public func onUserDidLeaved(channelName: String, userId: String, userInfo: [String : Any]) {
+        //重新加入的用户可能换了版本, 等它再声明
+        messageCodecVersions[channelName]?[userId] = nil
+    }
+    
+    public func onUserDidUpdated(channelName: String, userId: String, userInfo: [String : Any]) {
+    }
+}
@@ -35,6 +35,9 @@ import AgoraRtmKit
 
 @objc public protocol AUIRtmMessageProxyDelegate: NSObjectProtocol {
     func onMessageReceive(publisher: String, message: String)
+    
+    /// 收到二进制消息
+    @objc optional func onMessageReceive(publisher: String, data: Data)
 }
 
 @objc public protocol AUIRtmUserProxyDelegate: NSObjectProtocol {
@@ -56,6 +59,10 @@ open class AUIRtmMsgProxy: NSObject {
     private var rtmChannelType: AgoraRtmChannelType!
     private var attributesDelegates:[String: NSHashTable<AUIRtmAttributesProxyDelegate>] = [:]
     private var attributesCacheAttr: [String: [String: String]] = [:]
+    /// channelName -> key -> 缓存值的结构哈希(AUIJsonHash)
+    private var attributesHashCache: [String: [String: UInt64]] = [:]
+    /// "\(channelName)__\(key)" -> delegate -> 最近一次回调给它的值的结构哈希
+    private var attributesDeliveredHashes: [String: [ObjectIdentifier: UInt64]] = [:]
     private var lockDelegates: [String: NSHashTable<AUIRtmLockProxyDelegate>] = [:]
     private var lockDetailCaches: [String: [AgoraRtmLockDetail]] = [:]
     private var messageDelegates:NSHashTable<AUIRtmMessageProxyDelegate> = NSHashTable<AUIRtmMessageProxyDelegate>.weakObjects()
@@ -69,6 +76,8 @@ open class AUIRtmMsgProxy: NSObject {
     
     func cleanCache(channelName: String) {
         attributesCacheAttr[channelName] = nil
+        attributesHashCache[channelName] = nil
+        attributesDeliveredHashes = attributesDeliveredHashes.filter { !$0.key.hasPrefix("\(channelName)__") }
     }
     
     func subscribeAttributes(channelName: String, itemKey: String, delegate: AUIRtmAttributesProxyDelegate) {
@@ -87,6 +96,9 @@ open class AUIRtmMsgProxy: NSObject {
         guard let itemData = item?.data(using: .utf8), let itemValue = try? JSONSerialization.jsonObject(with: itemData) else {
             return
         }
+        if let hash = attributesHashCache[channelName]?[itemKey] {
+            attributesDeliveredHashes[key, default: [:]][ObjectIdentifier(delegate)] = hash
+        }
         //To ensure that the callback can be correctly received by using async dispatch of changes (such as direct callback but external incomplete forwarding processing)
         DispatchQueue.main.async {
             delegate.onAttributesDidChanged(channelName: channelName, key: itemKey, value: itemValue)
@@ -99,6 +111,7 @@ open class AUIRtmMsgProxy: NSObject {
             return
         }
         value.remove(delegate)
+        attributesDeliveredHashes[key]?[ObjectIdentifier(delegate)] = nil
     }
     
     func subscribeMessage(channelName: String, delegate: AUIRtmMessageProxyDelegate) {
@@ -166,30 +179,45 @@ open class AUIRtmMsgProxy: NSObject {
     
     func processMetaData(channelName: String, data: AgoraRtmMetadata?) {
         guard let data = data else { return }
-        let items = data.items ?? []
+        //按 key 排序, 保证 collection 的快照("key")先于它的增量("key__delta")回调
+        let items = (data.items ?? []).sorted { $0.key < $1.key }
         
         var cache = self.attributesCacheAttr[channelName] ?? [:]
+        var hashCache = self.attributesHashCache[channelName] ?? [:]
         items.forEach { item in
 //            aui_info("\(item.key): \(item.value)", tag: "AUIRtmMsgProxy")
-            //判断value和缓存里是否一致，这里用string可能会不准，例如不同终端序列化的时候json obj不同kv的位置不一样会造成生成的json string不同
-            if cache[item.key] == item.value {
+            //用结构哈希判断value和缓存里是否一致，不同终端序列化的json string kv的位置、空白、转义不同时也能识别为同一个值
+            //无法计算哈希时(非标准的json)退回到每次都解析并回调
+            let hash = AUIJsonHash.hash(jsonString: item.value)
+            cache[item.key] = item.value
+            hashCache[item.key] = hash
+            //只回调给还没收到过这个值的delegate(例如订阅时已经从缓存回调过), 都收到过时不再解析
+            let delegateKey = "\(channelName)__\(item.key)"
+            let delegates = self.attributesDelegates[delegateKey]?.allObjects ?? []
+            var deliveredHashes = self.attributesDeliveredHashes[delegateKey] ?? [:]
+            let receivers = delegates.filter { hash == nil || deliveredHashes[ObjectIdentifier($0)] != hash }
+            if receivers.isEmpty {
                 aui_info("there are no changes of [\(item.key)]", tag: "AUIRtmMsgProxy")
                 return
             }
-            cache[item.key] = item.value
             guard let itemData = item.value.data(using: .utf8),
                   let itemValue = try? JSONSerialization.jsonObject(with: itemData) else {
                 aui_info("parse itemData fail: \(item.key) \(item.value)", tag: "AUIRtmMsgProxy")
                 return
             }
-            let delegateKey = "\(channelName)__\(item.key)"
 //            aui_info("itemValue: \(item.value)")
-            guard let value = self.attributesDelegates[delegateKey] else { return }
-            for element in value.allObjects {
+            //只保留仍然存活的delegate, 避免释放后地址被复用
+            deliveredHashes = deliveredHashes.filter { entry in delegates.contains { ObjectIdentifier($0) == entry.key } }
+            for element in receivers {
+                deliveredHashes[ObjectIdentifier(element)] = hash
+            }
+            self.attributesDeliveredHashes[delegateKey] = deliveredHashes
+            for element in receivers {
                 element.onAttributesDidChanged(channelName: channelName, key: item.key, value: itemValue)
             }
         }
         self.attributesCacheAttr[channelName] = cache
+        self.attributesHashCache[channelName] = hashCache
         if items.count > 0 {
             return
         }
@@ -292,6 +320,10 @@ extension AUIRtmMsgProxy: AgoraRtmClientDelegate {
             for element in messageDelegates.allObjects {
                 element.onMessageReceive(publisher: event.publisher, message: message)
             }
+        } else if let data = event.message.rawData {
+            for element in messageDelegates.allObjects {
+                element.onMessageReceive?(publisher: event.publisher, data: data)
+            }
         } else {
             aui_warn("recv unknown type message", tag: "AUIRtmMsgProxy")
         }
@@ -30,8 +30,14 @@ public class AUIBaseCollection: NSObject {
     private(set) var attributesWillSetClosure: AUICollectionAttributesWillSetClosure?
     private(set) var attributesDidChangedClosure: AUICollectionAttributesDidChangedClosure?
     
+    /// 仲裁者写入时是否只写增量(见 AUICollectionDelta.swift), 房间内所有端都需要支持增量才能开启
+    public var deltaSyncEnabled: Bool = false
+    private(set) var deltaKey: String
+    private(set) var deltaState = AUICollectionDeltaState()
+    
     deinit {
         rtmManager.unsubscribeAttributes(channelName: channelName, itemKey: observeKey, delegate: self)
+        rtmManager.unsubscribeAttributes(channelName: channelName, itemKey: deltaKey, delegate: self)
         rtmManager.unsubscribeMessage(channelName: channelName, delegate: self)
         aui_collection_log("[\(observeKey)]deinit AUICollection")
     }
@@ -40,11 +46,115 @@ public class AUIBaseCollection: NSObject {
         self.rtmManager = rtmManager
         self.observeKey = observeKey
         self.channelName = channelName
+        self.deltaKey = AUICollectionDelta.key(observeKey: observeKey)
         super.init()
         rtmManager.subscribeAttributes(channelName: channelName, itemKey: observeKey, delegate: self)
+        rtmManager.subscribeAttributes(channelName: channelName, itemKey: deltaKey, delegate: self)
         rtmManager.subscribeMessage(channelName: channelName, delegate: self)
         aui_collection_log("[\(observeKey)]init AUICollection")
     }
+    
+    /// 子类实现: snapshot 不为nil时先把当前值替换为 snapshot, 再按顺序应用 ops, 只触发一次变化回调
+    /// - Returns: 类型不符或 ops 无法应用时返回false
+    func applyDelta(ops: [AUICollectionDeltaOp], snapshot: Any?) -> Bool {
+        return false
+    }
+}
+
+//MARK: delta
+extension AUIBaseCollection {
+    /// 生成写入 rtm 的 metadata
+    /// 开启增量时只写 delta; 本地序号未知、本地没有写过快照、修改过多或 delta 过长时写快照并清空 ops
+    /// 未开启但房间里已有 delta 时同样写快照并清空 ops, 保证其他端不会用旧的快照重放
+    func encodeMetadata(oldValue: Any, newValue: Any) -> [String: String]? {
+        let state = deltaState
+        guard deltaSyncEnabled || state.document != nil else {
+            guard let value = encodeToJsonStr(newValue) else { return nil }
+            return [observeKey: value]
+        }
+        
+        if deltaSyncEnabled,
+           var document = state.document,
+           state.seq >= 0, state.seq == document.seq,
+           let changes = AUICollectionDelta.diff(oldValue: oldValue, newValue: newValue, maxCount: 64) {
+            var seq = document.seq
+            for change in changes {
+                seq += 1
+                document.ops.append(AUICollectionDeltaOp(seq: seq, op: change.op, path: change.path, value: change.value))
+            }
+            document.seq = seq
+            //delta 长度超过 sqrt(2 * 单条 op 长度 * 快照长度) 时改写快照, 此时平均每次写入的长度最小
+            if let value = document.toJsonStr(),
+               value.utf8.count * value.utf8.count <= 2 * (value.utf8.count / max(document.ops.count, 1)) * state.snapshotLength {
+                state.document = document
+                state.seq = seq
+                return [deltaKey: value]
+            }
+        }
+        
+        guard let value = encodeToJsonStr(newValue) else { return nil }
+        let seq = max(state.seq, state.document?.seq ?? 0) + 1
+        //没有 delta 时(清理过或从未写过)序号从 1 开始, 换新的 epoch
+        let epoch = state.document?.epoch ?? AUICollectionDeltaDocument.makeEpoch()
+        let document = AUICollectionDeltaDocument(epoch: epoch, base: seq, seq: seq, ops: [])
+        guard let deltaValue = document.toJsonStr() else { return nil }
+        state.document = document
+        state.seq = seq
+        state.snapshot = newValue
+        state.snapshotLength = value.utf8.count
+        return [observeKey: value, deltaKey: deltaValue]
+    }
+    
+    /// 清理时需要移除的 key
+    func cleanMetadataKeys() -> [String] {
+        let keys = deltaState.document == nil ? [observeKey] : [observeKey, deltaKey]
+        deltaState.reset()
+        return keys
+    }
+    
+    private func onSnapshotDidChanged(value: Any) {
+        let state = deltaState
+        state.snapshot = value
+        //已有 delta 时快照和 delta 同时写入, 由随后的 delta 决定是否需要从快照重放(本地已经更新的不需要)
+        if state.document != nil {
+            return
+        }
+        state.seq = -1
+        _ = applyDelta(ops: [], snapshot: value)
+    }
+    
+    private func onDeltaDidChanged(value: Any) {
+        guard let map = value as? [String: Any],
+              let document = AUICollectionDeltaDocument(map: map) else {
+            aui_collection_warn("[\(observeKey)]invalid delta")
+            return
+        }
+        let state = deltaState
+        var seq = state.seq
+        var snapshot: Any? = nil
+        //序号重新开始时本地序号不可比较, 与落后于 base 一样从快照重放
+        let isRestarted = state.document.map { document.isRestarted(from: $0) } ?? false
+        if isRestarted || seq < document.base {
+            snapshot = state.snapshot
+            seq = document.base
+        }
+        let ops = document.ops.filter { $0.seq > seq }
+        state.document = document
+        state.seq = document.seq
+        if snapshot == nil, ops.isEmpty {
+            return
+        }
+        if applyDelta(ops: ops, snapshot: snapshot) {
+            return
+        }
+        //本地值与 delta 不一致, 从快照重放
+        aui_collection_warn("[\(observeKey)]apply delta fail, seq: \(seq) base: \(document.base) restarted: \(isRestarted)")
+        let replayOps = document.ops.filter { $0.seq > document.base }
+        if let snapshot = state.snapshot, applyDelta(ops: replayOps, snapshot: snapshot) {
+            return
+        }
+        state.seq = -1
+    }
 }
 
 extension AUIBaseCollection: IAUICollection {
@@ -95,12 +205,20 @@ extension AUIBaseCollection: IAUICollection {
             }
             
             guard let jsonStr = map?[self.observeKey],
-                  let jsonDict = decodeToJsonObj(jsonStr) else {
+                  var jsonDict = decodeToJsonObj(jsonStr) else {
                 //TODO: error
                 callback?(nil, nil)
                 return
             }
             
+            //快照之后的增量
+            if let deltaStr = map?[self.deltaKey],
+               let deltaMap = decodeToJsonObj(deltaStr) as? [String: Any],
+               let document = AUICollectionDeltaDocument(map: deltaMap),
+               let value = AUICollectionDelta.apply(ops: document.ops.filter { $0.seq > document.base }, snapshot: jsonDict) {
+                jsonDict = value
+            }
+            
             callback?(nil, jsonDict)
         }
     }
@@ -146,11 +264,40 @@ extension AUIBaseCollection: IAUICollection {
 
 extension AUIBaseCollection: AUIRtmAttributesProxyDelegate {
     public func onAttributesDidChanged(channelName: String, key: String, value: Any) {
+        guard channelName == self.channelName else {return}
+        if key == observeKey {
+            onSnapshotDidChanged(value: value)
+        } else if key == deltaKey {
+            onDeltaDidChanged(value: value)
+        }
     }
 }
 
 //MARK: AUIRtmMessageProxyDelegate
 extension AUIBaseCollection: AUIRtmMessageProxyDelegate {
+    /// 发给 userId 并等待回执, 对端支持时用二进制编码(AUICollectionMessageCodec), 否则用 json 并声明自己支持的版本
+    func publishAndWaitReceipt(userId: String, message: AUICollectionMessage, callback: ((NSError?)->())?) {
+        if rtmManager.messageCodecVersion(channelName: channelName, userId: userId) >= AUICollectionMessageCodec.version {
+            rtmManager.publishAndWaitReceipt(userId: userId,
+                                             channelName: channelName,
+                                             data: AUICollectionMessageCodec.encode(message),
+                                             uniqueId: message.uniqueId,
+                                             completion: callback)
+            return
+        }
+        var message = message
+        message.codec = AUICollectionMessageCodec.version
+        guard let jsonStr = encodeModelToJsonStr(message) else {
+            callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
+            return
+        }
+        rtmManager.publishAndWaitReceipt(userId: userId,
+                                         channelName: channelName,
+                                         message: jsonStr,
+                                         uniqueId: message.uniqueId,
+                                         completion: callback)
+    }
+    
     func sendReceipt(publisher: String, uniqueId: String, error: NSError?) {
         let error = AUICollectionError(code: error?.code ?? 0, reason: error?.localizedDescription ?? "")
         guard let data: [String: Any] = encodeModel(error) else {
@@ -158,11 +305,19 @@ extension AUIBaseCollection: AUIRtmMessageProxyDelegate {
             return
         }
         let payload = AUICollectionMessagePayload(data: AUIAnyType(map: data))
-        let message = AUICollectionMessage(channelName: channelName,
+        var message = AUICollectionMessage(channelName: channelName,
                                            messageType: .receipt,
                                            sceneKey: observeKey,
                                            uniqueId: uniqueId,
                                            payload: payload)
+        if rtmManager.messageCodecVersion(channelName: channelName, userId: publisher) >= AUICollectionMessageCodec.version {
+            rtmManager.publish(userId: publisher,
+                               channelName: channelName,
+                               data: AUICollectionMessageCodec.encode(message)) { err in
+            }
+            return
+        }
+        message.codec = AUICollectionMessageCodec.version
         guard let jsonStr = encodeModelToJsonStr(message) else {
             aui_collection_warn("[\(observeKey)]sendReceipt fail")
             return
@@ -173,6 +328,40 @@ extension AUIBaseCollection: AUIRtmMessageProxyDelegate {
         }
     }
     
+    /// 解析 json 消息, 不是发给当前 collection 的返回nil
+    func decodeMessage(publisher: String, message: String) -> AUICollectionMessage? {
+        guard let map = decodeToJsonObj(message) as? [String: Any],
+              let collectionMessage: AUICollectionMessage = decodeModel(map) else {
+            return nil
+        }
+        if let codec = collectionMessage.codec {
+            rtmManager.updateMessageCodecVersion(channelName: collectionMessage.channelName, userId: publisher, version: codec)
+        }
+        guard collectionMessage.sceneKey == observeKey, collectionMessage.channelName == channelName else {
+            return nil
+        }
+        aui_collection_log("onMessageReceive: \(map)")
+        return collectionMessage
+    }
+    
+    /// 解析二进制消息, 不是发给当前 collection 的返回nil(只读到 sceneKey 为止)
+    func decodeMessage(publisher: String, data: Data) -> AUICollectionMessage? {
+        guard let version = AUICollectionMessageCodec.version(of: data) else {
+            aui_collection_warn("[\(observeKey)]onMessageReceive unknown data: \(data.count) bytes")
+            return nil
+        }
+        rtmManager.updateMessageCodecVersion(channelName: channelName, userId: publisher, version: version)
+        guard let collectionMessage = AUICollectionMessageCodec.decode(data, sceneKey: observeKey),
+              collectionMessage.channelName == channelName else {
+            return nil
+        }
+        aui_collection_log("onMessageReceive: \(collectionMessage)")
+        return collectionMessage
+    }
+    
     public func onMessageReceive(publisher: String, message: String) {
     }
+    
+    public func onMessageReceive(publisher: String, data: Data) {
+    }
 }
@@ -0,0 +1,257 @@
+//
+//  AUICollectionDelta.swift
+//  AUIKitCore
+//
+
+import Foundation
+
+/// 增量同步
+/// observeKey 仍然存放全量快照(格式不变), "\(observeKey)__delta" 存放快照之后的修改:
+/// {"v": 1, "epoch": "k3j9x2", "base": 快照的序号, "seq": 最新序号, "ops": [{"seq": 1, "op": "add", "path": "/3", "value": {...}}]}
+/// 每次修改只写 delta, delta 过长时再写一次快照并清空 ops, 迟加入的用户读快照再重放 ops
+/// 清理 metadata 或新的仲裁者没有 delta 时序号从 1 重新开始, 此时换一个随机的 epoch, 接收端据此从快照重放
+enum AUICollectionDeltaOpType: String {
+    case add        //list: 插入到 path 的下标; map: 新增 key
+    case replace    //替换 path 对应的值
+    case remove     //删除 path 对应的值
+}
+
+/// 类似 JSON Patch 的一条修改, path 为 "/<下标>"(list) 或 "/<key>"(map, 按 JSON Pointer 转义)
+struct AUICollectionDeltaOp {
+    var seq: Int
+    var op: AUICollectionDeltaOpType
+    var path: String
+    var value: Any?
+
+    init(seq: Int, op: AUICollectionDeltaOpType, path: String, value: Any?) {
+        self.seq = seq
+        self.op = op
+        self.path = path
+        self.value = value
+    }
+
+    init?(map: [String: Any]) {
+        guard let seq = map["seq"] as? Int,
+              let opStr = map["op"] as? String,
+              let op = AUICollectionDeltaOpType(rawValue: opStr),
+              let path = map["path"] as? String else {
+            return nil
+        }
+        self.init(seq: seq, op: op, path: path, value: map["value"])
+    }
+
+    func toMap() -> [String: Any] {
+        var map: [String: Any] = ["seq": seq, "op": op.rawValue, "path": path]
+        if let value = value {
+            map["value"] = value
+        }
+        return map
+    }
+}
+
+struct AUICollectionDeltaDocument {
+    static let version = 1
+    /// 序号的来源, 序号重新开始时改变; 旧版本写入的 delta 没有
+    var epoch: String?
+    var base: Int
+    var seq: Int
+    var ops: [AUICollectionDeltaOp]
+
+    init(epoch: String?, base: Int, seq: Int, ops: [AUICollectionDeltaOp]) {
+        self.epoch = epoch
+        self.base = base
+        self.seq = seq
+        self.ops = ops
+    }
+
+    static func makeEpoch() -> String {
+        return String(UInt64.random(in: 0...UInt64.max), radix: 36)
+    }
+
+    /// 相对 previous 序号重新开始了: epoch 不同, 或 base、seq 变小
+    func isRestarted(from previous: AUICollectionDeltaDocument) -> Bool {
+        return epoch != previous.epoch || base < previous.base || seq < previous.seq
+    }
+
+    init?(map: [String: Any]) {
+        guard let version = map["v"] as? Int, version <= AUICollectionDeltaDocument.version,
+              let base = map["base"] as? Int,
+              let seq = map["seq"] as? Int,
+              let opList = map["ops"] as? [[String: Any]] else {
+            return nil
+        }
+        var ops: [AUICollectionDeltaOp] = []
+        ops.reserveCapacity(opList.count)
+        for item in opList {
+            guard let op = AUICollectionDeltaOp(map: item) else { return nil }
+            ops.append(op)
+        }
+        self.init(epoch: map["epoch"] as? String, base: base, seq: seq, ops: ops)
+    }
+
+    func toJsonStr() -> String? {
+        var map: [String: Any] = ["v": AUICollectionDeltaDocument.version,
+                                  "base": base,
+                                  "seq": seq,
+                                  "ops": ops.map { $0.toMap() }]
+        if let epoch = epoch {
+            map["epoch"] = epoch
+        }
+        guard let data = try? JSONSerialization.data(withJSONObject: map),
+              let value = String(data: data, encoding: .utf8) else {
+            return nil
+        }
+        return value
+    }
+}
+
+/// 一个 collection 的增量同步状态, 收发共用
+class AUICollectionDeltaState {
+    /// 本地值对应的序号, -1 表示未知(刚收到快照或还没有 delta)
+    var seq: Int = -1
+    /// 最近收到或写入的 delta
+    var document: AUICollectionDeltaDocument?
+    /// 最近收到或写入的快照, 本地序号落后于 document.base 时从它重放
+    var snapshot: Any?
+    /// 最近写入的快照 json 的长度
+    var snapshotLength: Int = 0
+
+    func reset() {
+        seq = -1
+        document = nil
+        snapshot = nil
+        snapshotLength = 0
+    }
+}
+
+/// 未分配序号的修改
+typealias AUICollectionDeltaChange = (op: AUICollectionDeltaOpType, path: String, value: Any?)
+
+enum AUICollectionDelta {
+    static func key(observeKey: String) -> String {
+        return "\(observeKey)__delta"
+    }
+
+    static func isEqual(_ lhs: Any, _ rhs: Any) -> Bool {
+        guard let lhs = lhs as AnyObject as? NSObject else { return false }
+        return lhs.isEqual(rhs)
+    }
+
+    // MARK: - diff
+
+    /// 计算 oldValue 到 newValue 的修改, 类型不一致或修改数超过 maxCount 时返回nil
+    static func diff(oldValue: Any, newValue: Any, maxCount: Int) -> [AUICollectionDeltaChange]? {
+        if let oldList = oldValue as? [[String: Any]], let newList = newValue as? [[String: Any]] {
+            return diff(oldList: oldList, newList: newList, maxCount: maxCount)
+        }
+        if let oldMap = oldValue as? [String: Any], let newMap = newValue as? [String: Any] {
+            return diff(oldMap: oldMap, newMap: newMap, maxCount: maxCount)
+        }
+        return nil
+    }
+
+    /// 去掉相同的头尾, 中间部分逐个替换, 多出的删除或插入
+    private static func diff(oldList: [[String: Any]], newList: [[String: Any]], maxCount: Int) -> [AUICollectionDeltaChange]? {
+        var prefix = 0
+        while prefix < oldList.count, prefix < newList.count, isEqual(oldList[prefix], newList[prefix]) {
+            prefix += 1
+        }
+        var suffix = 0
+        while suffix < oldList.count - prefix, suffix < newList.count - prefix,
+              isEqual(oldList[oldList.count - 1 - suffix], newList[newList.count - 1 - suffix]) {
+            suffix += 1
+        }
+        let oldCount = oldList.count - prefix - suffix
+        let newCount = newList.count - prefix - suffix
+        var changes: [AUICollectionDeltaChange] = []
+        for i in 0..<min(oldCount, newCount) where !isEqual(oldList[prefix + i], newList[prefix + i]) {
+            changes.append((.replace, "/\(prefix + i)", newList[prefix + i]))
+            if changes.count > maxCount { return nil }
+        }
+        if oldCount > newCount {
+            for _ in newCount..<oldCount {
+                changes.append((.remove, "/\(prefix + newCount)", nil))
+                if changes.count > maxCount { return nil }
+            }
+        } else {
+            for i in oldCount..<newCount {
+                changes.append((.add, "/\(prefix + i)", newList[prefix + i]))
+                if changes.count > maxCount { return nil }
+            }
+        }
+        return changes
+    }
+
+    private static func diff(oldMap: [String: Any], newMap: [String: Any], maxCount: Int) -> [AUICollectionDeltaChange]? {
+        var changes: [AUICollectionDeltaChange] = []
+        for (key, value) in newMap {
+            if let oldValue = oldMap[key] {
+                if isEqual(oldValue, value) { continue }
+                changes.append((.replace, "/" + escape(key), value))
+            } else {
+                changes.append((.add, "/" + escape(key), value))
+            }
+            if changes.count > maxCount { return nil }
+        }
+        for key in oldMap.keys where newMap[key] == nil {
+            changes.append((.remove, "/" + escape(key), nil))
+            if changes.count > maxCount { return nil }
+        }
+        return changes
+    }
+
+    // MARK: - apply
+
+    /// 应用到快照(list 或 map), 失败时返回nil
+    static func apply(ops: [AUICollectionDeltaOp], snapshot: Any) -> Any? {
+        if var list = snapshot as? [[String: Any]] {
+            return apply(ops: ops, list: &list) ? list : nil
+        }
+        if var map = snapshot as? [String: Any] {
+            return apply(ops: ops, map: &map) ? map : nil
+        }
+        return nil
+    }
+
+    /// 按顺序应用到 list, path 越界或 op 不合法时返回false(list 可能已被部分修改)
+    static func apply(ops: [AUICollectionDeltaOp], list: inout [[String: Any]]) -> Bool {
+        for op in ops {
+            guard op.path.hasPrefix("/"), let index = Int(op.path.dropFirst()), index >= 0 else { return false }
+            switch op.op {
+            case .add:
+                guard index <= list.count, let value = op.value as? [String: Any] else { return false }
+                list.insert(value, at: index)
+            case .replace:
+                guard index < list.count, let value = op.value as? [String: Any] else { return false }
+                list[index] = value
+            case .remove:
+                guard index < list.count else { return false }
+                list.remove(at: index)
+            }
+        }
+        return true
+    }
+
+    static func apply(ops: [AUICollectionDeltaOp], map: inout [String: Any]) -> Bool {
+        for op in ops {
+            guard op.path.hasPrefix("/") else { return false }
+            let key = unescape(String(op.path.dropFirst()))
+            switch op.op {
+            case .add, .replace:
+                guard let value = op.value else { return false }
+                map[key] = value
+            case .remove:
+                map.removeValue(forKey: key)
+            }
+        }
+        return true
+    }
+
+    private static func escape(_ key: String) -> String {
+        return key.replacingOccurrences(of: "~", with: "~0").replacingOccurrences(of: "/", with: "~1")
+    }
+
+    private static func unescape(_ key: String) -> String {
+        return key.replacingOccurrences(of: "~1", with: "/").replacingOccurrences(of: "~0", with: "~")
+    }
+}
@@ -0,0 +1,183 @@
+//
+//  AUICollectionIndex.swift
+//  AUIKitCore
+//
+
+import Foundation
+
+/// filter 支持的取值: String/Bool/Int, Bool 按 0/1 与 Int 比较(与 JSON 解析出的 NSNumber 一致)
+enum AUICollectionScalar: Hashable {
+    case string(String)
+    case int(Int)
+
+    init?(_ value: Any?) {
+        switch value {
+        case let v as String:
+            self = .string(v)
+        case let v as Bool:
+            self = .int(v ? 1 : 0)
+        case let v as Int:
+            self = .int(v)
+        default:
+            return nil
+        }
+    }
+}
+
+/// 编译后的 filter: 多个 filter item 之间是或的关系, item 内的条件是与的关系
+/// 条件为 key path + 取值, 例如 ["owner": ["userId": "1"]] 编译为 (["owner", "userId"], .string("1"))
+struct AUICollectionFilter {
+    struct Term {
+        let path: [String]
+        /// 不支持的取值为nil, 永远不匹配
+        let value: AUICollectionScalar?
+    }
+
+    let items: [[Term]]
+
+    init(_ filter: [[String: Any]]) {
+        items = filter.map { filterItem in
+            filterItem.map { (key, value) in AUICollectionFilter.compile(path: [key], value: value) }
+        }
+    }
+
+    private static func compile(path: [String], value: Any) -> Term {
+        //next level match again
+        if let map = value as? [String: Any] {
+            guard map.count == 1, let (key, subValue) = map.first else {
+                return Term(path: path, value: nil)
+            }
+            return compile(path: path + [key], value: subValue)
+        }
+        return Term(path: path, value: AUICollectionScalar(value))
+    }
+
+    static func scalar(row: [String: Any], path: [String]) -> AUICollectionScalar? {
+        var map = row
+        for key in path.dropLast() {
+            guard let subMap = map[key] as? [String: Any] else { return nil }
+            map = subMap
+        }
+        guard let key = path.last else { return nil }
+        return AUICollectionScalar(map[key])
+    }
+
+    func isMatch(row: [String: Any]) -> Bool {
+        return items.contains { terms in isMatch(row: row, terms: terms) }
+    }
+
+    func isMatch(row: [String: Any], terms: [Term]) -> Bool {
+        return terms.allSatisfy { term in
+            guard let value = term.value else { return false }
+            return AUICollectionFilter.scalar(row: row, path: term.path) == value
+        }
+    }
+}
+
+/// list collection 的二级索引, 行由调用方持有
+/// 索引按 filter 用到的 key path 首次查询时建立(如 userId、songCode、seatIndex), 之后随 append/replace 增量维护,
+/// 其余修改(删除、整体替换)调用 invalidate, 索引在下次查询时重建
+final class AUICollectionIndex {
+    /// key path -> 取值 -> 行号(升序)
+    private var indexes: [[String]: [AUICollectionScalar: [Int]]] = [:]
+    /// 索引对应的行数, 与查询时的行数不一致说明漏了维护, 重建索引
+    private var rowCount: Int = 0
+
+    func invalidate() {
+        indexes.removeAll()
+    }
+
+    func append(row: [String: Any]) {
+        let rowIndex = rowCount
+        rowCount += 1
+        for path in indexes.keys {
+            guard let value = AUICollectionFilter.scalar(row: row, path: path) else { continue }
+            indexes[path]?[value, default: []].append(rowIndex)
+        }
+    }
+
+    func replace(at rowIndex: Int, oldRow: [String: Any], newRow: [String: Any]) {
+        for path in indexes.keys {
+            let oldValue = AUICollectionFilter.scalar(row: oldRow, path: path)
+            let newValue = AUICollectionFilter.scalar(row: newRow, path: path)
+            if oldValue == newValue { continue }
+            if let oldValue = oldValue, let bucket = indexes[path]?[oldValue] {
+                let position = AUICollectionIndex.lowerBound(bucket, rowIndex)
+                if position < bucket.count, bucket[position] == rowIndex {
+                    if bucket.count == 1 {
+                        indexes[path]?[oldValue] = nil
+                    } else {
+                        indexes[path]?[oldValue]?.remove(at: position)
+                    }
+                }
+            }
+            if let newValue = newValue {
+                let position = AUICollectionIndex.lowerBound(indexes[path]?[newValue] ?? [], rowIndex)
+                indexes[path]?[newValue, default: []].insert(rowIndex, at: position)
+            }
+        }
+    }
+
+    /// 根据filter条件过滤出 rows 命中的行号(升序)，如果filter为空，则默认选中所有; 没有命中时返回nil
+    func itemIndexes(rows: [[String: Any]], filter: [[String: Any]]?) -> [Int]? {
+        guard let filter = filter, filter.count > 0 else {
+            return rows.isEmpty ? nil : Array(rows.indices)
+        }
+        if rowCount != rows.count {
+            indexes.removeAll()
+            rowCount = rows.count
+        }
+        let compiled = AUICollectionFilter(filter)
+        var result: [Int] = []
+        for terms in compiled.items {
+            //空的 filter item 匹配所有行
+            guard !terms.isEmpty else {
+                return rows.isEmpty ? nil : Array(rows.indices)
+            }
+            //取候选最少的条件走索引, 其余条件逐行校验
+            var candidates: [Int]? = nil
+            for term in terms {
+                guard let value = term.value else {
+                    candidates = []
+                    break
+                }
+                let bucket = index(rows: rows, path: term.path)[value] ?? []
+                if candidates == nil || bucket.count < candidates!.count {
+                    candidates = bucket
+                }
+            }
+            result += (candidates ?? []).filter { compiled.isMatch(row: rows[$0], terms: terms) }
+        }
+        if compiled.items.count > 1 {
+            result = Array(Set(result)).sorted()
+        }
+        return result.isEmpty ? nil : result
+    }
+
+    private func index(rows: [[String: Any]], path: [String]) -> [AUICollectionScalar: [Int]] {
+        if let index = indexes[path] {
+            return index
+        }
+        var index: [AUICollectionScalar: [Int]] = [:]
+        for (rowIndex, row) in rows.enumerated() {
+            guard let value = AUICollectionFilter.scalar(row: row, path: path) else { continue }
+            index[value, default: []].append(rowIndex)
+        }
+        indexes[path] = index
+        return index
+    }
+
+    private static func lowerBound(_ array: [Int], _ value: Int) -> Int {
+        var low = 0
+        var high = array.count
+        while low < high {
+            let mid = (low + high) / 2
+            if array[mid] < value {
+                low = mid + 1
+            } else {
+                high = mid
+            }
+        }
+        return low
+    }
+}
@@ -0,0 +1,328 @@
+//
+//  AUICollectionMessageCodec.swift
+//  AUIKitCore
+//
+
+import Foundation
+
+/// collection 消息(请求与回执)的二进制编码, 替代 json 以减小消息体积和解析开销
+/// 格式: [0xC1, 版本] + MessagePack 数组 [channelName, messageType, sceneKey, uniqueId, type, dataCmd, filter, data]
+/// 0xC1 在 MessagePack 和 utf8 里都不会出现, 接收端据此区分二进制与 json; 新版本只能在数组末尾追加字段
+/// 只在确认对端支持时使用: json 消息带 codec 字段声明支持的版本, 收到对端的二进制消息同样视为支持, 否则仍然发送 json
+enum AUICollectionMessageCodec {
+    static let version: Int = 1
+    private static let magic: UInt8 = 0xC1
+    private static let fieldCount = 8
+    private static let maxDepth = 64
+
+    /// 二进制消息的版本, 不是二进制消息时返回nil
+    static func version(of data: Data) -> Int? {
+        guard data.count >= 2, data[data.startIndex] == magic else { return nil }
+        return Int(data[data.startIndex + 1])
+    }
+
+    static func encode(_ message: AUICollectionMessage) -> Data {
+        var writer = Writer()
+        writer.bytes.append(magic)
+        writer.bytes.append(UInt8(version))
+        writer.arrayHeader(fieldCount)
+        writer.string(message.channelName)
+        writer.int(message.messageType.rawValue)
+        writer.string(message.sceneKey)
+        writer.string(message.uniqueId)
+        let payload = message.payload
+        if let type = payload.type {
+            writer.int(type.rawValue)
+        } else {
+            writer.writeNil()
+        }
+        if let dataCmd = payload.dataCmd {
+            writer.string(dataCmd)
+        } else {
+            writer.writeNil()
+        }
+        if let filter = payload.filter {
+            writer.any(filter)
+        } else {
+            writer.writeNil()
+        }
+        if let data = payload.data {
+            writer.any(data)
+        } else {
+            writer.writeNil()
+        }
+        return Data(writer.bytes)
+    }
+
+    /// 格式错误或版本不支持时返回nil; 指定 sceneKey 时, 不匹配的消息读到 sceneKey 就返回nil, 不再解析 payload
+    static func decode(_ data: Data, sceneKey expectedSceneKey: String? = nil) -> AUICollectionMessage? {
+        guard let messageVersion = version(of: data), messageVersion >= 1 else { return nil }
+        return data.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) -> AUICollectionMessage? in
+            var reader = Reader(bytes: bytes, pos: 2)
+            //多出的字段是新版本追加的, 忽略
+            guard let count = reader.arrayHeader(), count >= fieldCount,
+                  let channelName = reader.string(),
+                  let messageTypeValue = reader.int(),
+                  let messageType = AUIMessageType(rawValue: messageTypeValue),
+                  let sceneKey = reader.string(),
+                  expectedSceneKey == nil || expectedSceneKey == sceneKey,
+                  let uniqueId = reader.string() else {
+                return nil
+            }
+            var payload = AUICollectionMessagePayload()
+            if !reader.consumeNil() {
+                guard let typeValue = reader.int(), let type = AUICollectionOprationType(rawValue: typeValue) else { return nil }
+                payload.type = type
+            }
+            if !reader.consumeNil() {
+                guard let dataCmd = reader.string() else { return nil }
+                payload.dataCmd = dataCmd
+            }
+            if !reader.consumeNil() {
+                guard let filter = reader.any(depth: 0) else { return nil }
+                payload.filter = filter
+            }
+            if !reader.consumeNil() {
+                guard let value = reader.any(depth: 0) else { return nil }
+                payload.data = value
+            }
+            return AUICollectionMessage(channelName: channelName,
+                                        messageType: messageType,
+                                        sceneKey: sceneKey,
+                                        uniqueId: uniqueId,
+                                        payload: payload)
+        }
+    }
+
+    private struct Writer {
+        var bytes: [UInt8] = []
+
+        mutating func append(_ value: UInt64, size: Int) {
+            for shift in stride(from: (size - 1) * 8, through: 0, by: -8) {
+                bytes.append(UInt8(truncatingIfNeeded: value >> UInt64(shift)))
+            }
+        }
+
+        mutating func writeNil() {
+            bytes.append(0xC0)
+        }
+
+        mutating func int(_ value: Int) {
+            switch value {
+            case 0...0x7F:
+                bytes.append(UInt8(value))
+            case -32..<0:
+                bytes.append(UInt8(bitPattern: Int8(value)))
+            case Int(Int8.min)...Int(Int8.max):
+                bytes.append(0xD0)
+                append(UInt64(bitPattern: Int64(value)), size: 1)
+            case Int(Int16.min)...Int(Int16.max):
+                bytes.append(0xD1)
+                append(UInt64(bitPattern: Int64(value)), size: 2)
+            case Int(Int32.min)...Int(Int32.max):
+                bytes.append(0xD2)
+                append(UInt64(bitPattern: Int64(value)), size: 4)
+            default:
+                bytes.append(0xD3)
+                append(UInt64(bitPattern: Int64(value)), size: 8)
+            }
+        }
+
+        mutating func string(_ value: String) {
+            let utf8 = value.utf8
+            let count = utf8.count
+            if count < 32 {
+                bytes.append(0xA0 | UInt8(count))
+            } else if count <= 0xFF {
+                bytes.append(0xD9)
+                append(UInt64(count), size: 1)
+            } else if count <= 0xFFFF {
+                bytes.append(0xDA)
+                append(UInt64(count), size: 2)
+            } else {
+                bytes.append(0xDB)
+                append(UInt64(count), size: 4)
+            }
+            bytes.append(contentsOf: utf8)
+        }
+
+        mutating func arrayHeader(_ count: Int) {
+            if count < 16 {
+                bytes.append(0x90 | UInt8(count))
+            } else if count <= 0xFFFF {
+                bytes.append(0xDC)
+                append(UInt64(count), size: 2)
+            } else {
+                bytes.append(0xDD)
+                append(UInt64(count), size: 4)
+            }
+        }
+
+        mutating func mapHeader(_ count: Int) {
+            if count < 16 {
+                bytes.append(0x80 | UInt8(count))
+            } else if count <= 0xFFFF {
+                bytes.append(0xDE)
+                append(UInt64(count), size: 2)
+            } else {
+                bytes.append(0xDF)
+                append(UInt64(count), size: 4)
+            }
+        }
+
+        mutating func any(_ value: AUIAnyType) {
+            switch value {
+            case .int(let int):
+                self.int(int)
+            case .string(let string):
+                self.string(string)
+            case .list(let list):
+                arrayHeader(list.count)
+                for element in list {
+                    any(element)
+                }
+            case .dictionary(let dictionary):
+                mapHeader(dictionary.count)
+                for (key, element) in dictionary {
+                    self.string(key)
+                    any(element)
+                }
+            }
+        }
+    }
+
+    private struct Reader {
+        let bytes: UnsafeRawBufferPointer
+        var pos: Int
+
+        mutating func uint(size: Int) -> UInt64? {
+            guard pos + size <= bytes.count else { return nil }
+            var value: UInt64 = 0
+            for _ in 0..<size {
+                value = value << 8 | UInt64(bytes[pos])
+                pos += 1
+            }
+            return value
+        }
+
+        mutating func consumeNil() -> Bool {
+            guard pos < bytes.count, bytes[pos] == 0xC0 else { return false }
+            pos += 1
+            return true
+        }
+
+        mutating func int() -> Int? {
+            guard pos < bytes.count else { return nil }
+            let head = bytes[pos]
+            pos += 1
+            switch head {
+            case 0x00...0x7F:
+                return Int(head)
+            case 0xE0...0xFF:
+                return Int(Int8(bitPattern: head))
+            case 0xC2, 0xC3:
+                return head == 0xC3 ? 1 : 0
+            case 0xCC, 0xCD, 0xCE, 0xCF:
+                guard let value = uint(size: 1 << Int(head - 0xCC)) else { return nil }
+                return Int(exactly: value)
+            case 0xD0, 0xD1, 0xD2, 0xD3:
+                let size = 1 << Int(head - 0xD0)
+                guard let value = uint(size: size) else { return nil }
+                //符号扩展
+                let shift = UInt64(64 - size * 8)
+                return Int(exactly: Int64(bitPattern: value << shift) >> Int64(shift))
+            default:
+                pos -= 1
+                return nil
+            }
+        }
+
+        mutating func string() -> String? {
+            guard pos < bytes.count else { return nil }
+            let head = bytes[pos]
+            let count: Int
+            switch head {
+            case 0xA0...0xBF:
+                pos += 1
+                count = Int(head & 0x1F)
+            case 0xD9, 0xDA, 0xDB:
+                pos += 1
+                guard let value = uint(size: 1 << Int(head - 0xD9)) else { return nil }
+                count = Int(value)
+            default:
+                return nil
+            }
+            guard count <= bytes.count - pos else { return nil }
+            let string = String(decoding: UnsafeRawBufferPointer(rebasing: bytes[pos..<pos + count]), as: UTF8.self)
+            pos += count
+            return string
+        }
+
+        mutating func arrayHeader() -> Int? {
+            guard pos < bytes.count else { return nil }
+            let head = bytes[pos]
+            switch head {
+            case 0x90...0x9F:
+                pos += 1
+                return Int(head & 0x0F)
+            case 0xDC, 0xDD:
+                pos += 1
+                guard let value = uint(size: head == 0xDC ? 2 : 4) else { return nil }
+                return Int(value)
+            default:
+                return nil
+            }
+        }
+
+        mutating func mapHeader() -> Int? {
+            guard pos < bytes.count else { return nil }
+            let head = bytes[pos]
+            switch head {
+            case 0x80...0x8F:
+                pos += 1
+                return Int(head & 0x0F)
+            case 0xDE, 0xDF:
+                pos += 1
+                guard let value = uint(size: head == 0xDE ? 2 : 4) else { return nil }
+                return Int(value)
+            default:
+                return nil
+            }
+        }
+
+        /// 与 AUIAnyType(array:)/AUIAnyType(map:) 一致: bool 转为 0/1, nil 的元素跳过, 不支持浮点数
+        mutating func any(depth: Int) -> AUIAnyType? {
+            guard pos < bytes.count, depth < AUICollectionMessageCodec.maxDepth else { return nil }
+            switch bytes[pos] {
+            case 0xA0...0xBF, 0xD9, 0xDA, 0xDB:
+                guard let value = string() else { return nil }
+                return .string(value)
+            case 0x90...0x9F, 0xDC, 0xDD:
+                //每个元素至少 1 字节, 数量超过剩余字节数时一定是格式错误
+                guard let count = arrayHeader(), count <= bytes.count - pos else { return nil }
+                var list: [AUIAnyType] = []
+                list.reserveCapacity(count)
+                for _ in 0..<count {
+                    if consumeNil() { continue }
+                    guard let value = any(depth: depth + 1) else { return nil }
+                    list.append(value)
+                }
+                return .list(list)
+            case 0x80...0x8F, 0xDE, 0xDF:
+                guard let count = mapHeader(), count <= bytes.count - pos else { return nil }
+                var dictionary: [String: AUIAnyType] = [:]
+                dictionary.reserveCapacity(count)
+                for _ in 0..<count {
+                    guard let key = string() else { return nil }
+                    if consumeNil() { continue }
+                    guard let value = any(depth: depth + 1) else { return nil }
+                    dictionary[key] = value
+                }
+                return .dictionary(dictionary)
+            default:
+                guard let value = int() else { return nil }
+                return .int(value)
+            }
+        }
+    }
+}
@@ -168,8 +168,9 @@ struct AUICollectionMessage: Codable {
     public var sceneKey: String   //表示修改的表字段，根据这个key每个collection自动和自己的observerKey判断是否匹配以进行下一步
     public var uniqueId: String   //唯一表示，用于校验回执
     public var payload: AUICollectionMessagePayload
+    public var codec: Int? = nil  //[可选]发送端支持的二进制编码版本(AUICollectionMessageCodec), 对端据此决定回复和后续请求的编码
     
     enum CodingKeys: String, CodingKey {
-        case channelName, messageType, sceneKey, uniqueId, payload
+        case channelName, messageType, sceneKey, uniqueId, payload, codec
     }
 }
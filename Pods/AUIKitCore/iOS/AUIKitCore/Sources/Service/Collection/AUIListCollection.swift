@@ -10,10 +10,33 @@ import Foundation
 public class AUIListCollection: AUIBaseCollection {
     private var currentList: [[String: Any]] = []{
         didSet {
-            //TODO: if oldValue == currentList {return}
+            if isIndexUpdated {
+                isIndexUpdated = false
+            } else {
+                index.invalidate()
+            }
             self.attributesDidChangedClosure?(channelName, observeKey, AUIAttributesModel(list: currentList))
         }
     }
+    /// filter 查询用的二级索引
+    private let index = AUICollectionIndex()
+    /// 写入路径已增量维护过索引, 下次给 currentList 赋值时不需要重建
+    private var isIndexUpdated = false
+    
+    override func applyDelta(ops: [AUICollectionDeltaOp], snapshot: Any?) -> Bool {
+        var list = currentList
+        if let snapshot = snapshot {
+            guard let snapshotList = snapshot as? [[String: Any]] else { return false }
+            list = snapshotList
+        }
+        guard AUICollectionDelta.apply(ops: ops, list: &list) else { return false }
+        //收到的快照与本地一致时(例如仲裁者自己写入后的回显)不再触发回调
+        if snapshot != nil, AUICollectionDelta.isEqual(list, currentList) {
+            return true
+        }
+        currentList = list
+        return true
+    }
 }
 
 //MARK: private set meta data
@@ -23,7 +46,7 @@ extension AUIListCollection {
                                 value: [String: Any],
                                 filter: [[String: Any]]?,
                                 callback: ((NSError?)->())?) {
-        if let _ = getItemIndexes(array: currentList, filter: filter) {
+        if let _ = index.itemIndexes(rows: currentList, filter: filter) {
             aui_collection_warn("rtmAddMetaData fail! list filter found: '\(filter ?? [])'")
             callback?(AUICollectionOperationError.filterNotFound.toNSError("list rtmAddMetaData: '\(filter ?? [])'"))
             return
@@ -43,7 +66,10 @@ extension AUIListCollection {
         }
         list.append(newValue)
         
+        //closure 没有改动列表时只需要把新节点追加到索引
+        var isAppendOnly = !attr.isModified
         attr.setList(list)
+        attr.isModified = false
         self.attributesWillSetClosure?(channelName,
                                        observeKey,
                                        valueCmd,
@@ -51,19 +77,24 @@ extension AUIListCollection {
         if let attrList = attr.getList() {
             list = attrList
         }
-        guard let value = encodeToJsonStr(list) else {
+        isAppendOnly = isAppendOnly && !attr.isModified
+        guard let metadata = encodeMetadata(oldValue: currentList, newValue: list) else {
             aui_collection_warn("rtmAddMetaData fail! encode to json fail")
             callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
             return
         }
         
-        aui_collection_log("rtmAddMetaData valueCmd: \(valueCmd ?? "") value: \(value), \nfilter: \(filter ?? [])")
+        aui_collection_log("rtmAddMetaData valueCmd: \(valueCmd ?? "") value: \(metadata), \nfilter: \(filter ?? [])")
         self.rtmManager.setBatchMetadata(channelName: channelName,
                                          lockName: kRTM_Referee_LockName,
-                                         metadata: [observeKey: value]) { error in
+                                         metadata: metadata) { error in
             aui_collection_log("rtmAddMetaData valueCmd: \(valueCmd ?? "") completion: \(error?.localizedDescription ?? "success")")
             callback?(error)
         }
+        if isAppendOnly {
+            index.append(row: newValue)
+            isIndexUpdated = true
+        }
         currentList = list
     }
     
@@ -72,7 +103,7 @@ extension AUIListCollection {
                                 value: [String: Any],
                                 filter: [[String: Any]]?,
                                 callback: ((NSError?)->())?) {
-        guard let itemIndexes = getItemIndexes(array: currentList, filter: filter) else {
+        guard let itemIndexes = index.itemIndexes(rows: currentList, filter: filter) else {
             aui_collection_warn("rtmSetMetaData fail! list filter not found: '\(filter ?? [])'")
             callback?(AUICollectionOperationError.filterNotFound.toNSError("list rtmSetMetaData: '\(filter ?? [])'"))
             return
@@ -104,19 +135,20 @@ extension AUIListCollection {
         if let attrList = attr.getList() {
             list = attrList
         }
-        guard let value = encodeToJsonStr(list) else {
+        guard let metadata = encodeMetadata(oldValue: currentList, newValue: list) else {
             aui_collection_warn("rtmSetMetaData fail! encode to json fail")
             callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
             return
         }
         
-        aui_collection_log("rtmSetMetaData valueCmd: \(valueCmd ?? ""), filter: \(filter ?? []), value: \(value)")
+        aui_collection_log("rtmSetMetaData valueCmd: \(valueCmd ?? ""), filter: \(filter ?? []), value: \(metadata)")
         self.rtmManager.setBatchMetadata(channelName: channelName,
                                          lockName: kRTM_Referee_LockName,
-                                         metadata: [observeKey: value]) { error in
+                                         metadata: metadata) { error in
             aui_collection_log("rtmSetMetaData valueCmd: \(valueCmd ?? "") completion: \(error?.localizedDescription ?? "success")")
             callback?(error)
         }
+        updateIndex(itemIndexes: itemIndexes, list: list, attr: attr)
         currentList = list
     }
     
@@ -125,7 +157,7 @@ extension AUIListCollection {
                                   value: [String: Any],
                                   filter: [[String: Any]]?,
                                   callback: ((NSError?)->())?) {
-        guard let itemIndexes = getItemIndexes(array: currentList, filter: filter) else {
+        guard let itemIndexes = index.itemIndexes(rows: currentList, filter: filter) else {
             aui_collection_warn("rtmMergeMetaData fail! list filter not found: '\(filter ?? [])'")
             callback?(AUICollectionOperationError.filterNotFound.toNSError("list rtmMergeMetaData: '\(filter ?? [])'"))
             return
@@ -155,19 +187,20 @@ extension AUIListCollection {
         if let attrList = attr.getList() {
             list = attrList
         }
-        guard let value = encodeToJsonStr(list) else {
+        guard let metadata = encodeMetadata(oldValue: currentList, newValue: list) else {
             aui_collection_warn("rtmMergeMetaData fail! encode to json fail")
             callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
             return
         }
         
-        aui_collection_log("rtmMergeMetaData valueCmd: \(valueCmd ?? ""), filter: \(filter ?? []), value: \(value)")
+        aui_collection_log("rtmMergeMetaData valueCmd: \(valueCmd ?? ""), filter: \(filter ?? []), value: \(metadata)")
         self.rtmManager.setBatchMetadata(channelName: channelName,
                                          lockName: kRTM_Referee_LockName,
-                                         metadata: [observeKey: value]) { error in
+                                         metadata: metadata) { error in
             aui_collection_log("rtmMergeMetaData valueCmd: \(valueCmd ?? "") completion: \(error?.localizedDescription ?? "success")")
             callback?(error)
         }
+        updateIndex(itemIndexes: itemIndexes, list: list, attr: attr)
         currentList = list
     }
     
@@ -175,7 +208,7 @@ extension AUIListCollection {
                                    valueCmd: String?,
                                    filter: [[String: Any]]?,
                                    callback: ((NSError?)->())?) {
-        guard let itemIndexes = getItemIndexes(array: currentList, filter: filter) else {
+        guard let itemIndexes = index.itemIndexes(rows: currentList, filter: filter) else {
             aui_collection_warn("rtmRemoveMetaData fail! list filter not found: '\(filter ?? [])'")
             callback?(AUICollectionOperationError.filterNotFound.toNSError("list rtmRemoveMetaData: '\(filter ?? [])'"))
             return
@@ -201,16 +234,16 @@ extension AUIListCollection {
         if let attrList = attr.getList() {
             list = attrList
         }
-        guard let value = encodeToJsonStr(list) else {
+        guard let metadata = encodeMetadata(oldValue: currentList, newValue: list) else {
             aui_collection_warn("rtmRemoveMetaData fail! encode to json fail")
             callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
             return
         }
         
-        aui_collection_log("rtmRemoveMetaData valueCmd: \(valueCmd ?? ""), filter: \(filter ?? []), value: \(value)")
+        aui_collection_log("rtmRemoveMetaData valueCmd: \(valueCmd ?? ""), filter: \(filter ?? []), value: \(metadata)")
         self.rtmManager.setBatchMetadata(channelName: channelName,
                                          lockName: kRTM_Referee_LockName,
-                                         metadata: [observeKey: value]) { error in
+                                         metadata: metadata) { error in
             aui_collection_log("rtmRemoveMetaData valueCmd: \(valueCmd ?? "") completion: \(error?.localizedDescription ?? "success")")
             callback?(error)
         }
@@ -225,7 +258,7 @@ extension AUIListCollection {
                                       callback: ((NSError?)->())?) {
         //TODO: will calculate?
         
-        guard let itemIndexes = getItemIndexes(array: currentList, filter: filter) else {
+        guard let itemIndexes = index.itemIndexes(rows: currentList, filter: filter) else {
             aui_collection_warn("rtmCalculateMetaData fail! list filter not found: '\(filter ?? [])'")
             callback?(AUICollectionOperationError.filterNotFound.toNSError("list rtmCalculateMetaData: '\(filter ?? [])'"))
             return
@@ -266,26 +299,36 @@ extension AUIListCollection {
         if let attrList = attr.getList() {
             list = attrList
         }
-        guard let value = encodeToJsonStr(list) else {
+        guard let metadata = encodeMetadata(oldValue: currentList, newValue: list) else {
             aui_collection_warn("rtmCalculateMetaData fail! encode to json fail")
             callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
             return
         }
-        aui_collection_log("rtmCalculateMetaData valueCmd: \(valueCmd ?? "") key: \(key), value: \(value)")
+        aui_collection_log("rtmCalculateMetaData valueCmd: \(valueCmd ?? "") key: \(key), value: \(metadata)")
         self.rtmManager.setBatchMetadata(channelName: channelName,
                                          lockName: kRTM_Referee_LockName,
-                                         metadata: [observeKey: value]) { error in
+                                         metadata: metadata) { error in
             aui_collection_log("rtmCalculateMetaData completion: \(error?.localizedDescription ?? "success")")
             callback?(error)
         }
+        updateIndex(itemIndexes: itemIndexes, list: list, attr: attr)
         currentList = list
     }
     
+    /// 只修改了 itemIndexes 对应的节点时增量更新索引, 否则等 currentList 赋值时重建
+    private func updateIndex(itemIndexes: [Int], list: [[String: Any]], attr: AUIAttributesModel) {
+        guard !attr.isModified else { return }
+        for itemIdx in itemIndexes {
+            index.replace(at: itemIdx, oldRow: currentList[itemIdx], newRow: list[itemIdx])
+        }
+        isIndexUpdated = true
+    }
+    
     private func rtmCleanMetaData(callback: ((NSError?)->())?) {
         aui_collection_log("rtmCleanMetaData")
         self.rtmManager.cleanBatchMetadata(channelName: channelName,
                                            lockName: kRTM_Referee_LockName,
-                                           removeKeys: [observeKey]) { error in
+                                           removeKeys: cleanMetadataKeys()) { error in
             aui_collection_log("rtmCleanMetaData completion: \(error?.localizedDescription ?? "success")")
             callback?(error)
         }
@@ -318,17 +361,8 @@ extension AUIListCollection {
                                            uniqueId: UUID().uuidString,
                                            payload: payload)
 
-        guard let jsonStr = encodeModelToJsonStr(message) else {
-            callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
-            return
-        }
-        
         let userId = AUIRoomContext.shared.getArbiter(channelName: channelName)?.lockOwnerId ?? ""
-        rtmManager.publishAndWaitReceipt(userId: userId,
-                                         channelName: channelName,
-                                         message: jsonStr,
-                                         uniqueId: message.uniqueId,
-                                         completion: callback)
+        publishAndWaitReceipt(userId: userId, message: message, callback: callback)
     }
     
     public override func mergeMetaData(valueCmd: String?,
@@ -355,17 +389,8 @@ extension AUIListCollection {
                                            uniqueId: UUID().uuidString,
                                            payload: payload)
 
-        guard let jsonStr = encodeModelToJsonStr(message) else {
-            callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
-            return
-        }
-        
         let userId = AUIRoomContext.shared.getArbiter(channelName: channelName)?.lockOwnerId ?? ""
-        rtmManager.publishAndWaitReceipt(userId: userId,
-                                         channelName: channelName,
-                                         message: jsonStr,
-                                         uniqueId: message.uniqueId,
-                                         completion: callback)
+        publishAndWaitReceipt(userId: userId, message: message, callback: callback)
     }
     
     public override func addMetaData(valueCmd: String?,
@@ -392,17 +417,8 @@ extension AUIListCollection {
                                            uniqueId: UUID().uuidString,
                                            payload: payload)
 
-        guard let jsonStr = encodeModelToJsonStr(message) else {
-            callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
-            return
-        }
-        
         let userId = AUIRoomContext.shared.getArbiter(channelName: channelName)?.lockOwnerId ?? ""
-        rtmManager.publishAndWaitReceipt(userId: userId,
-                                         channelName: channelName,
-                                         message: jsonStr,
-                                         uniqueId: message.uniqueId,
-                                         completion: callback)
+        publishAndWaitReceipt(userId: userId, message: message, callback: callback)
         
     }
     
@@ -428,17 +444,8 @@ extension AUIListCollection {
                                            uniqueId: UUID().uuidString,
                                            payload: payload)
 
-        guard let jsonStr = encodeModelToJsonStr(message) else {
-            callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
-            return
-        }
-        
         let userId = AUIRoomContext.shared.getArbiter(channelName: channelName)?.lockOwnerId ?? ""
-        rtmManager.publishAndWaitReceipt(userId: userId,
-                                         channelName: channelName,
-                                         message: jsonStr,
-                                         uniqueId: message.uniqueId,
-                                         completion: callback)
+        publishAndWaitReceipt(userId: userId, message: message, callback: callback)
     }
     
     public override func calculateMetaData(valueCmd: String?,
@@ -472,16 +479,8 @@ extension AUIListCollection {
                                            uniqueId: UUID().uuidString,
                                            payload: payload)
 
-        guard let jsonStr = encodeModelToJsonStr(message) else {
-            callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
-            return
-        }
         let userId = AUIRoomContext.shared.getArbiter(channelName: channelName)?.lockOwnerId ?? ""
-        rtmManager.publishAndWaitReceipt(userId: userId,
-                                         channelName: channelName,
-                                         message: jsonStr,
-                                         uniqueId: message.uniqueId,
-                                         completion: callback)
+        publishAndWaitReceipt(userId: userId, message: message, callback: callback)
     }
     
     public override func cleanMetaData(callback: ((NSError?) -> ())?) {
@@ -497,40 +496,25 @@ extension AUIListCollection {
                                            uniqueId: UUID().uuidString,
                                            payload: payload)
         
-        guard let jsonStr = encodeModelToJsonStr(message) else {
-            callback?(AUICollectionOperationError.removeMetaDataFail.toNSError())
-            return
-        }
         let userId = AUIRoomContext.shared.getArbiter(channelName: channelName)?.lockOwnerId ?? ""
-        rtmManager.publishAndWaitReceipt(userId: userId,
-                                         channelName: channelName,
-                                         message: jsonStr,
-                                         uniqueId: message.uniqueId,
-                                         completion: callback)
-    }
-}
-
-//MARK: override AUIRtmAttributesProxyDelegate
-extension AUIListCollection {
-    public override func onAttributesDidChanged(channelName: String, key: String, value: Any) {
-        guard channelName == self.channelName, key == self.observeKey else {return}
-        guard let list = value as? [[String: Any]] else {return}
-        self.currentList = list
+        publishAndWaitReceipt(userId: userId, message: message, callback: callback)
     }
 }
 
 //MARK: override AUIRtmMessageProxyDelegate
 extension AUIListCollection {
     public override func onMessageReceive(publisher: String, message: String) {
-        guard let map = decodeToJsonObj(message) as? [String: Any],
-              let collectionMessage: AUICollectionMessage = decodeModel(map),
-              collectionMessage.sceneKey == observeKey else {
-            return
-        }
-        aui_collection_log("onMessageReceive: \(map)")
+        guard let collectionMessage = decodeMessage(publisher: publisher, message: message) else { return }
+        onCollectionMessageReceive(publisher: publisher, collectionMessage: collectionMessage)
+    }
+    
+    public override func onMessageReceive(publisher: String, data: Data) {
+        guard let collectionMessage = decodeMessage(publisher: publisher, data: data) else { return }
+        onCollectionMessageReceive(publisher: publisher, collectionMessage: collectionMessage)
+    }
+    
+    private func onCollectionMessageReceive(publisher: String, collectionMessage: AUICollectionMessage) {
         let uniqueId = collectionMessage.uniqueId
-        let channelName = collectionMessage.channelName
-        guard channelName == self.channelName else {return}
         if collectionMessage.messageType == .receipt {
             if let callback = rtmManager.receiptCallbackMap[uniqueId]?.closure {
                 rtmManager.markReceiptFinished(uniqueId: uniqueId)
@@ -10,10 +10,24 @@ import Foundation
 public class AUIMapCollection: AUIBaseCollection {
     private var currentMap: [String: Any] = [:] {
         didSet {
-            //TODO: if oldValue == currentMap {return}
             self.attributesDidChangedClosure?(channelName, observeKey, AUIAttributesModel(map: currentMap))
         }
     }
+    
+    override func applyDelta(ops: [AUICollectionDeltaOp], snapshot: Any?) -> Bool {
+        var map = currentMap
+        if let snapshot = snapshot {
+            guard let snapshotMap = snapshot as? [String: Any] else { return false }
+            map = snapshotMap
+        }
+        guard AUICollectionDelta.apply(ops: ops, map: &map) else { return false }
+        //收到的快照与本地一致时(例如仲裁者自己写入后的回显)不再触发回调
+        if snapshot != nil, AUICollectionDelta.isEqual(map, currentMap) {
+            return true
+        }
+        currentMap = map
+        return true
+    }
 }
 
 //MARK: private set meta data
@@ -42,15 +56,15 @@ extension AUIMapCollection {
         if let attrMap = attr.getMap() {
             map = attrMap
         }
-        guard let value = encodeToJsonStr(map) else {
+        guard let metadata = encodeMetadata(oldValue: currentMap, newValue: map) else {
             aui_collection_warn("rtmSetMetaData fail! encode to json fail")
             callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
             return
         }
-        aui_collection_log("rtmSetMetaData valueCmd: \(valueCmd ?? "") value: \(value)")
+        aui_collection_log("rtmSetMetaData valueCmd: \(valueCmd ?? "") value: \(metadata)")
         self.rtmManager.setBatchMetadata(channelName: channelName,
                                          lockName: kRTM_Referee_LockName,
-                                         metadata: [observeKey: value]) { error in
+                                         metadata: metadata) { error in
             aui_collection_log("rtmSetMetaData completion: \(error?.localizedDescription ?? "success")")
             callback?(error)
         }
@@ -78,15 +92,15 @@ extension AUIMapCollection {
         if let attrMap = attr.getMap() {
             map = attrMap
         }
-        guard let valueStr = encodeToJsonStr(map) else {
+        guard let metadata = encodeMetadata(oldValue: currentMap, newValue: map) else {
             aui_collection_warn("rtmMergeMetaData fail! encode to json fail")
             callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
             return
         }
-        aui_collection_log("rtmMergeMetaData valueCmd: \(valueCmd ?? "") value: \(valueStr)")
+        aui_collection_log("rtmMergeMetaData valueCmd: \(valueCmd ?? "") value: \(metadata)")
         self.rtmManager.setBatchMetadata(channelName: channelName,
                                          lockName: kRTM_Referee_LockName,
-                                         metadata: [observeKey: valueStr]) { error in
+                                         metadata: metadata) { error in
             aui_collection_log("rtmMergeMetaData completion: \(error?.localizedDescription ?? "success")")
             callback?(error)
         }
@@ -126,15 +140,15 @@ extension AUIMapCollection {
                 map = attrMap
             }
         }
-        guard let map = map, let value = encodeToJsonStr(map) else {
+        guard let map = map, let metadata = encodeMetadata(oldValue: currentMap, newValue: map) else {
             aui_collection_warn("rtmCalculateMetaData fail! encode to json fail")
             callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
             return
         }
-        aui_collection_log("rtmCalculateMetaData valueCmd: \(valueCmd ?? "") key: \(key), value: \(value)")
+        aui_collection_log("rtmCalculateMetaData valueCmd: \(valueCmd ?? "") key: \(key), value: \(metadata)")
         self.rtmManager.setBatchMetadata(channelName: channelName,
                                          lockName: kRTM_Referee_LockName,
-                                         metadata: [observeKey: value]) { error in
+                                         metadata: metadata) { error in
             aui_collection_log("rtmCalculateMetaData completion: \(error?.localizedDescription ?? "success")")
             callback?(error)
         }
@@ -145,7 +159,7 @@ extension AUIMapCollection {
         aui_collection_log("rtmCleanMetaData")
         self.rtmManager.cleanBatchMetadata(channelName: channelName,
                                            lockName: kRTM_Referee_LockName,
-                                           removeKeys: [observeKey]) { error in
+                                           removeKeys: cleanMetadataKeys()) { error in
             aui_collection_log("rtmCleanMetaData completion: \(error?.localizedDescription ?? "success")")
             callback?(error)
         }
@@ -183,16 +197,8 @@ extension AUIMapCollection {
                                            uniqueId: UUID().uuidString,
                                            payload: payload)
 
-        guard let jsonStr = encodeModelToJsonStr(message) else {
-            callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
-            return
-        }
         let userId = AUIRoomContext.shared.getArbiter(channelName: channelName)?.lockOwnerId ?? ""
-        rtmManager.publishAndWaitReceipt(userId: userId,
-                                         channelName: channelName,
-                                         message: jsonStr,
-                                         uniqueId: message.uniqueId,
-                                         completion: callback)
+        publishAndWaitReceipt(userId: userId, message: message, callback: callback)
     }
     
     /// 合并，替换所有子节点
@@ -223,16 +229,8 @@ extension AUIMapCollection {
                                            uniqueId: UUID().uuidString,
                                            payload: payload)
 
-        guard let jsonStr = encodeModelToJsonStr(message) else {
-            callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
-            return
-        }
         let userId = AUIRoomContext.shared.getArbiter(channelName: channelName)?.lockOwnerId ?? ""
-        rtmManager.publishAndWaitReceipt(userId: userId,
-                                         channelName: channelName,
-                                         message: jsonStr,
-                                         uniqueId: message.uniqueId,
-                                         completion: callback)
+        publishAndWaitReceipt(userId: userId, message: message, callback: callback)
     }
     
     
@@ -288,16 +286,8 @@ extension AUIMapCollection {
                                            uniqueId: UUID().uuidString,
                                            payload: payload)
 
-        guard let jsonStr = encodeModelToJsonStr(message) else {
-            callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
-            return
-        }
         let userId = AUIRoomContext.shared.getArbiter(channelName: channelName)?.lockOwnerId ?? ""
-        rtmManager.publishAndWaitReceipt(userId: userId,
-                                         channelName: channelName,
-                                         message: jsonStr,
-                                         uniqueId: message.uniqueId,
-                                         completion: callback)
+        publishAndWaitReceipt(userId: userId, message: message, callback: callback)
     }
     
     /// 清理，map collection就是删除该key
@@ -315,41 +305,26 @@ extension AUIMapCollection {
                                            uniqueId: UUID().uuidString,
                                            payload: payload)
         
-        guard let jsonStr = encodeModelToJsonStr(message) else {
-            callback?(AUICollectionOperationError.encodeToJsonStringFail.toNSError())
-            return
-        }
         let userId = AUIRoomContext.shared.getArbiter(channelName: channelName)?.lockOwnerId ?? ""
-        rtmManager.publishAndWaitReceipt(userId: userId,
-                                         channelName: channelName,
-                                         message: jsonStr,
-                                         uniqueId: message.uniqueId,
-                                         completion: callback)
+        publishAndWaitReceipt(userId: userId, message: message, callback: callback)
     }
 }
 
 
-//MARK: AUIRtmAttributesProxyDelegate
-extension AUIMapCollection {
-    public override func onAttributesDidChanged(channelName: String, key: String, value: Any) {
-        guard channelName == self.channelName, key == self.observeKey else {return}
-        guard let map = value as? [String: Any] else {return}
-        self.currentMap = map
-    }
-}
-
 //MARK: override AUIRtmMessageProxyDelegate
 extension AUIMapCollection {
     public override func onMessageReceive(publisher: String, message: String) {
-        guard let map = decodeToJsonObj(message) as? [String: Any],
-              let collectionMessage: AUICollectionMessage = decodeModel(map),
-              collectionMessage.sceneKey == observeKey else {
-            return
-        }
-        aui_collection_log("onMessageReceive: \(map)")
+        guard let collectionMessage = decodeMessage(publisher: publisher, message: message) else { return }
+        onCollectionMessageReceive(publisher: publisher, collectionMessage: collectionMessage)
+    }
+    
+    public override func onMessageReceive(publisher: String, data: Data) {
+        guard let collectionMessage = decodeMessage(publisher: publisher, data: data) else { return }
+        onCollectionMessageReceive(publisher: publisher, collectionMessage: collectionMessage)
+    }
+    
+    private func onCollectionMessageReceive(publisher: String, collectionMessage: AUICollectionMessage) {
         let uniqueId = collectionMessage.uniqueId
-        let channelName = collectionMessage.channelName
-        guard channelName == self.channelName else {return}
         if collectionMessage.messageType == .receipt {
             if let callback = rtmManager.receiptCallbackMap[uniqueId]?.closure {
                 rtmManager.markReceiptFinished(uniqueId: uniqueId)
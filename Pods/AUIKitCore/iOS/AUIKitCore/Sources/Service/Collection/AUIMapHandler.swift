@@ -66,47 +66,11 @@ func getItemIndexes(array: [[String: Any]], filter: [[String: Any]]?) -> [Int]?
         return indexes.isEmpty ? nil : indexes
     }
     
-    func isMatchFilter(key: String, itemValue: [String: Any], filterValue: Any?)-> Bool {
-        let valueV = itemValue[key]
-        //only filter String/Bool/Int
-        if let valueV = valueV as? String, let filterV = filterValue as? String {
-            if valueV == filterV {
-                return true
-            }
-        } else if let valueV = valueV as? Bool, let filterV = filterValue as? Bool {
-            if valueV == filterV {
-                return true
-            }
-        } else if let valueV = valueV as? Int, let filterV = filterValue as? Int {
-            if valueV == filterV {
-                return true
-            }
-        } else if let valueV = valueV as? [String: Any], 
-                    let filterV = filterValue as? [String: Any],
-                    filterV.keys.count == 1,
-                    let filterVKey = filterV.keys.first {
-            //next level match again
-            return isMatchFilter(key: filterVKey, itemValue: valueV, filterValue: filterV[filterVKey])
-        }
-        
-        return false
-    }
-    
+    //only filter String/Bool/Int, see AUICollectionFilter
+    let compiledFilter = AUICollectionFilter(filter)
     var indexes: [Int] = []
-    for (i, value) in array.enumerated() {
-        for filterItem in filter {
-            var match = true
-            for (k, v) in filterItem {
-                if isMatchFilter(key: k, itemValue: value, filterValue: v) == false {
-                    match = false
-                    break
-                }
-            }
-            if match {
-                indexes.append(i)
-                break
-            }
-        }
+    for (i, value) in array.enumerated() where compiledFilter.isMatch(row: value) {
+        indexes.append(i)
     }
     return indexes.isEmpty ? nil : indexes
 }
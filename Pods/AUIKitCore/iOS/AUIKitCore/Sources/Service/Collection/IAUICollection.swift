@@ -32,6 +32,8 @@ public typealias AUICollectionAttributesDidChangedClosure = (String, String, AUI
 
 @objc public class AUIAttributesModel: NSObject {
     private var attributes: Any?
+    /// 是否调用过 setMap/setList, collection 据此判断能否增量维护索引
+    var isModified = false
     required init(list: [[String: Any]]) {
         self.attributes = list
         super.init()
@@ -44,12 +46,14 @@ public typealias AUICollectionAttributesDidChangedClosure = (String, String, AUI
     public func setMap(_ attributes: [String: Any]?) {
         if self.attributes is [String: Any] {
             self.attributes = attributes
+            isModified = true
         }
     }
     
     public func setList(_ attributes: [[String: Any]]?) {
         if self.attributes is [[String: Any]] {
             self.attributes = attributes
+            isModified = true
         }
     }
     
@@ -46,6 +46,7 @@ protocol AgoraLrcDownloadDelegate {
     private var completion: [String: Completion] = [:]
     private var success: [String: Sunccess] = [:]
     private var failure: [String: UnZipErrorClosure] = [:]
+    private var streamUnzipped: Set<String> = []
 
     @objc public weak var delegate: AgoraLrcDownloadDelegate?
 
@@ -73,6 +74,7 @@ protocol AgoraLrcDownloadDelegate {
             guard let url = URL(string: urlString) else { return }
             delegate?.beginDownloadLrc?(url: urlString)
             request.delegate = self
+            request.dataReceived = urlString.hasSuffix(".zip") ? streamUnzip(urlString: urlString, completion: completion) : nil
             request.download(requestURL: url)
             self.completion[urlString] = completion
             self.failure[urlString] = failure
@@ -91,6 +93,7 @@ protocol AgoraLrcDownloadDelegate {
         if cachePath == nil {
             guard let url = URL(string: urlString) else { return }
             request.delegate = self
+            request.dataReceived = nil
             request.download(requestURL: url)
             self.success[urlString] = success
         } else {
@@ -129,6 +132,38 @@ protocol AgoraLrcDownloadDelegate {
         }
     }
 
+    /// 边下载边解压, 歌词文件在下载结束前就可以解析, 失败时等下载完成后再解压
+    private func streamUnzip(urlString: String, completion: @escaping Completion) -> ((Data) -> Void)? {
+        let unZipPath = URL(fileURLWithPath: String.cacheFolderPath())
+        var reader: ZipStreamReader?
+        reader = try? ZipStreamReader { [weak self] entryName, data in
+            guard let self = self else { return }
+            let fileURL = unZipPath.appendingPathComponent(entryName)
+            do {
+                try FileManager.default.createDirectory(at: fileURL.deletingLastPathComponent(), withIntermediateDirectories: true, attributes: nil)
+                try data.write(to: fileURL)
+            } catch {
+                reader = nil
+                return
+            }
+            DispatchQueue.main.async {
+                self.streamUnzipped.insert(urlString)
+            }
+            self.parseXml(path: fileURL.path, completion: completion)
+        }
+        return { data in
+            do {
+                try reader?.append(data)
+                //中央目录之后的数据不再需要, 释放解压器和它缓存的数据
+                if reader?.isComplete == true {
+                    reader = nil
+                }
+            } catch {
+                reader = nil
+            }
+        }
+    }
+
     private func parseXml(path: String, completion: @escaping (String?) -> Void) {
         DispatchQueue.global().async {
             DispatchQueue.main.async {
@@ -165,7 +200,13 @@ extension AgoraDownLoadManager: AgoraLrcDownloadDelegate {
         } else {
             guard let completion = completion[url], let failure = failure[url] else { return }
             if url.hasSuffix(".zip") {
-                unzip(path: cacheFilePath, completion: completion, failure: failure)
+                DispatchQueue.main.async {
+                    if self.streamUnzipped.remove(url) != nil {
+                        try? FileManager.default.removeItem(atPath: cacheFilePath)
+                        return
+                    }
+                    self.unzip(path: cacheFilePath, completion: completion, failure: failure)
+                }
             } else {
                 parseLrc(path: cacheFilePath, completion: completion)
             }
@@ -179,6 +220,15 @@ extension AgoraDownLoadManager: AgoraLrcDownloadDelegate {
     public func downloadLrcError(url: String, error: Error?) {
        // Log.errorText(text: "\(error?.localizedDescription ?? "nil") url")
         delegate?.downloadLrcError?(url: url, error: error)
+        DispatchQueue.main.async {
+            self.completion[url] = nil
+            guard let failure = self.failure.removeValue(forKey: url) else { return }
+            //边下载边解压已经回调了歌词
+            if self.streamUnzipped.remove(url) != nil {
+                return
+            }
+            failure()
+        }
     }
 
     public func downloadLrcCanceld(url: String) {
@@ -25,15 +25,29 @@ class AgoraRequestTask: NSObject {
         }
     }
 
+    // 收到数据块回调, 设置后边下载边回调, 数据按顺序送达
+    var dataReceived: ((Data) -> Void)?
+
     private var session: URLSession? // 会话对象
-    private var task: URLSessionDownloadTask? // 任务
+    private var task: URLSessionTask? // 任务
     private var requestURL: URL?
+    private var fileHandle: FileHandle? // dataTask 写入的临时文件
+    private var tempFilePath: String?
+    private var receivedLength: Int64 = 0
+    private var isFinished = false // 已回调下载完成
     private lazy var queue: OperationQueue = {
         let queue = OperationQueue()
         queue.maxConcurrentOperationCount = 3
         return queue
     }()
 
+    // dataTask 的回调队列, 串行保证数据块顺序
+    private lazy var dataQueue: OperationQueue = {
+        let queue = OperationQueue()
+        queue.maxConcurrentOperationCount = 1
+        return queue
+    }()
+
     /**
      *  开始请求
      */
@@ -42,14 +56,22 @@ class AgoraRequestTask: NSObject {
                              delegate: nil,
                              delegateQueue: nil)
         self.requestURL = requestURL
+        isFinished = false
         guard let url = requestURL else {
             return
         }
+        let streaming = dataReceived != nil
         queue.addOperation { [weak self] in
-            self?.session = URLSession(configuration: URLSessionConfiguration.default, delegate: self, delegateQueue: OperationQueue.current)
+            guard let self = self else { return }
             let request = URLRequest(url: url)
-            self?.task = self?.session?.downloadTask(with: request)
-            self?.task?.resume()
+            if streaming {
+                self.session = URLSession(configuration: URLSessionConfiguration.default, delegate: self, delegateQueue: self.dataQueue)
+                self.task = self.session?.dataTask(with: request)
+            } else {
+                self.session = URLSession(configuration: URLSessionConfiguration.default, delegate: self, delegateQueue: OperationQueue.current)
+                self.task = self.session?.downloadTask(with: request)
+            }
+            self.task?.resume()
         }
     }
 }
@@ -60,6 +82,7 @@ extension AgoraRequestTask: URLSessionDownloadDelegate {
         guard cache == true, let url = requestURL else { return }
         AgoraCacheFileHandle.moveFile(with: location.path,
                                       fileName: url.fileName)
+        isFinished = true
         delegate?.downloadLrcFinished?(url: url.absoluteString)
     }
 
@@ -71,12 +94,56 @@ extension AgoraRequestTask: URLSessionDownloadDelegate {
 
     // 请求完成会调用该方法，请求失败则error有值
     func urlSession(_: URLSession, task _: URLSessionTask, didCompleteWithError error: Error?) {
+        if let handle = fileHandle, let path = tempFilePath {
+            handle.closeFile()
+            fileHandle = nil
+            tempFilePath = nil
+            defer {
+                try? FileManager.default.removeItem(atPath: path)
+            }
+            if error == nil, !cancel, cache == true, let url = requestURL {
+                AgoraCacheFileHandle.moveFile(with: path, fileName: url.fileName)
+                isFinished = true
+                delegate?.downloadLrcFinished?(url: url.absoluteString)
+                return
+            }
+        }
         if cancel {
             delegate?.downloadLrcCanceld?(url: requestURL?.absoluteString ?? "")
             return
         }
-        if error != nil {
+        // 不缓存时没有可以交给调用方的文件, 同样按失败回调, 调用方不会一直等待
+        if error != nil || !isFinished {
+            let error = error ?? NSError(domain: "AgoraRequestTask",
+                                         code: -1,
+                                         userInfo: [NSLocalizedDescriptionKey: "download finished without cache"])
             delegate?.downloadLrcError?(url: requestURL?.absoluteString ?? "", error: error)
         }
     }
 }
+
+extension AgoraRequestTask: URLSessionDataDelegate {
+    func urlSession(_: URLSession, dataTask _: URLSessionDataTask, didReceive response: URLResponse, completionHandler: @escaping (URLSession.ResponseDisposition) -> Void) {
+        if let resp = response as? HTTPURLResponse, resp.statusCode != 200 {
+            completionHandler(.cancel)
+            return
+        }
+        let path = NSTemporaryDirectory() + UUID().uuidString
+        FileManager.default.createFile(atPath: path, contents: nil, attributes: nil)
+        tempFilePath = path
+        fileHandle = FileHandle(forWritingAtPath: path)
+        receivedLength = 0
+        completionHandler(fileHandle == nil ? .cancel : .allow)
+    }
+
+    func urlSession(_: URLSession, dataTask: URLSessionDataTask, didReceive data: Data) {
+        fileHandle?.write(data)
+        receivedLength += Int64(data.count)
+        dataReceived?(data)
+        let totalLength = dataTask.response?.expectedContentLength ?? -1
+        if totalLength > 0 {
+            delegate?.downloadLrcProgress?(url: requestURL?.absoluteString ?? "",
+                                           progress: Double(receivedLength) / Double(totalLength))
+        }
+    }
+}
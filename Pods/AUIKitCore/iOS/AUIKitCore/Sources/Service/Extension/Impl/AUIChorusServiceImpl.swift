@@ -39,6 +39,7 @@ private enum AUIChorusCMd: String {
         self.ktvApi = ktvApi
         
         self.listCollection = AUIListCollection(channelName: channelName, observeKey: kChorusKey, rtmManager: rtmManager)
+        self.listCollection.deltaSyncEnabled = AUIRoomContext.shared.commonConfig?.collectionDeltaSyncEnabled ?? false
         listCollection.subscribeWillAdd {[weak self] publisherId, dataCmd, newItem, m in
             return self?.metadataWillAdd(publiserId: publisherId,
                                          dataCmd: dataCmd,
@@ -62,6 +62,7 @@ open class AUIMusicServiceImpl: NSObject {
         self.channelName = channelName
         self.ktvApi = ktvApi
         self.listCollection = AUIListCollection(channelName: channelName, observeKey: kChooseSongKey, rtmManager: rtmManager)
+        self.listCollection.deltaSyncEnabled = AUIRoomContext.shared.commonConfig?.collectionDeltaSyncEnabled ?? false
         
         listCollection.subscribeWillAdd {[weak self] publisherId, dataCmd, newItem, attr in
             return self?.metadataWillAdd(publiserId: publisherId, 
@@ -37,6 +37,7 @@ private enum AUIMicSeatCmd: String {
         self.rtmManager = rtmManager
         self.channelName = channelName
         self.mapCollection = AUIMapCollection(channelName: channelName, observeKey: kSeatAttrKey, rtmManager: rtmManager)
+        self.mapCollection.deltaSyncEnabled = AUIRoomContext.shared.commonConfig?.collectionDeltaSyncEnabled ?? false
         super.init()
         mapCollection.subscribeWillMerge {[weak self] publisherId, dataCmd, updateMap, currentMap in
             return self?.metadataWillMerge(publiserId: publisherId, dataCmd: dataCmd, updateMap: updateMap, currentMap: currentMap)
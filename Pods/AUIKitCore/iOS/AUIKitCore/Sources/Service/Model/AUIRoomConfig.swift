@@ -28,6 +28,8 @@ open class AUICommonConfig: NSObject {
     public var host: String = "" //(optional)
     /// 用户信息
     public var owner: AUIUserThumbnailInfo?
+    /// 麦位、点歌、合唱列表是否增量同步(可选), 房间内所有端都支持增量后才能开启, 见 AUIBaseCollection.deltaSyncEnabled
+    public var collectionDeltaSyncEnabled: Bool = false
     
     public func isValidate() -> Bool {
         if appId.isEmpty || owner?.isEmpty() ?? true  {
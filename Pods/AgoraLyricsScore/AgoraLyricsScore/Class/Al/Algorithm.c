@@ -7,6 +7,14 @@
 
 #include "Algorithm.h"
 #import <math.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <immintrin.h>
+#endif
 //modify by xuguangjian
 #define PTS_version "20231021001"
 
@@ -19,14 +27,47 @@ double pitchToToneC(double pitch) {
     return (fmax(0, log(pitch / 55 + eps) / log(2))) * 12;
 }
 
-float calculedScoreC(double voicePitch, double stdPitch, int scoreLevel, int scoreCompensationOffset) {
-    if (voicePitch <= 0) {
-        return 0;
+struct PitchScorer {
+    // 上一次换算的标准pitch, 一个字内标准pitch不变, 缓存其tone
+    double stdPitch;
+    double stdTone;
+};
+
+PitchScorer *pitchScorerCreate(void) {
+    PitchScorer *scorer = malloc(sizeof(PitchScorer));
+    if (scorer != NULL) {
+        pitchScorerReset(scorer);
     }
-    if(stdPitch <= 0){
-        return 0;
+    return scorer;
+}
+
+void pitchScorerDestroy(PitchScorer *scorer) {
+    free(scorer);
+}
+
+void pitchScorerReset(PitchScorer *scorer) {
+    if (scorer == NULL) {
+        return;
     }
-    
+    scorer->stdPitch = 0;
+    scorer->stdTone = 0;
+}
+
+void resetC(void) {
+}
+
+static double stdToneOf(PitchScorer *scorer, double stdPitch) {
+    if (scorer == NULL) {
+        return pitchToToneC(stdPitch);
+    }
+    if (stdPitch != scorer->stdPitch) {
+        scorer->stdPitch = stdPitch;
+        scorer->stdTone = pitchToToneC(stdPitch);
+    }
+    return scorer->stdTone;
+}
+
+static float scoreOfTones(double voiceTone, double stdTone, int scoreLevel, int scoreCompensationOffset) {
     if(scoreLevel<=0){
         scoreLevel = 1;
     }else if(scoreLevel > 100){
@@ -39,9 +80,6 @@ float calculedScoreC(double voicePitch, double stdPitch, int scoreLevel, int sco
         scoreCompensationOffset = 100;
     }
     
-    double stdTone = pitchToToneC(stdPitch);
-    double voiceTone = pitchToToneC(voicePitch);
-    
     float match = 1 - (float)scoreLevel / 100 * fabs(voiceTone - stdTone) + (float)scoreCompensationOffset / 100;
     float rate = 1 + ((float)scoreLevel/(float)50);
     
@@ -52,16 +90,20 @@ float calculedScoreC(double voicePitch, double stdPitch, int scoreLevel, int sco
     return match;
 }
 
-static double n;
-static double offset;
-
+float pitchScorerScore(PitchScorer *scorer, double voicePitch, double stdPitch, int scoreLevel, int scoreCompensationOffset) {
+    if (voicePitch <= 0) {
+        return 0;
+    }
+    if(stdPitch <= 0){
+        return 0;
+    }
+    return scoreOfTones(pitchToToneC(voicePitch), stdToneOf(scorer, stdPitch), scoreLevel, scoreCompensationOffset);
+}
 
 // octave pitch compensation v0.2
-double handlePitchC(double stdPitch, double voicePitch, double stdMaxPitch) {
+double pitchScorerHandlePitch(PitchScorer *scorer, double stdPitch, double voicePitch, double stdMaxPitch) {
     
     int cnt = 0;
-    double stdTone = pitchToToneC(stdPitch);
-    double voiceTone = pitchToToneC(voicePitch);
     
     if (voicePitch <= 0) {
         return 0;
@@ -70,6 +112,9 @@ double handlePitchC(double stdPitch, double voicePitch, double stdMaxPitch) {
         return 0;
     }
     
+    double stdTone = stdToneOf(scorer, stdPitch);
+    double voiceTone = pitchToToneC(voicePitch);
+    
     if(fabs(voiceTone - stdTone) <= 6){
         return voicePitch;
     }
@@ -94,7 +139,220 @@ double handlePitchC(double stdPitch, double voicePitch, double stdMaxPitch) {
     return voicePitch;
 }
 
-void resetC(void) {
-    offset = 0.0;
-    n = 0.0;
+float calculedScoreC(double voicePitch, double stdPitch, int scoreLevel, int scoreCompensationOffset) {
+    return pitchScorerScore(NULL, voicePitch, stdPitch, scoreLevel, scoreCompensationOffset);
+}
+
+double handlePitchC(double stdPitch, double voicePitch, double stdMaxPitch) {
+    return pitchScorerHandlePitch(NULL, stdPitch, voicePitch, stdMaxPitch);
+}
+
+// MARK: - 批量打分
+
+// log2 = 指数 + ln(m)/ln2, m 规约到 [sqrt(0.5), sqrt(2)), ln(m) = 2 * atanh((m-1)/(m+1)) 展开到 7 次
+#define LOG2_C1 2.8853900817779268f  // 2/ln2
+#define LOG2_C3 0.9617966939259756f  // 2/ln2/3
+#define LOG2_C5 0.5770780163555854f  // 2/ln2/5
+#define LOG2_C7 0.4121985831111324f  // 2/ln2/7
+#define TONE_EPS 1e-6f
+#define TONE_BLOCK 256
+
+struct PitchToneTable {
+    // 整数pitch的精确tone, 下标即pitch
+    float *tones;
+    size_t count;
+};
+
+static float log2Fast(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float e = (float)((int32_t)(bits >> 23) - 127);
+    bits = (bits & 0x007fffff) | 0x3f800000;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    if (m > 1.41421356f) {
+        m *= 0.5f;
+        e += 1;
+    }
+    float t = (m - 1) / (m + 1);
+    float t2 = t * t;
+    return e + t * (LOG2_C1 + t2 * (LOG2_C3 + t2 * (LOG2_C5 + t2 * LOG2_C7)));
+}
+
+static float pitchToToneFast(double pitch) {
+    return fmaxf(0, log2Fast((float)pitch * (1.0f / 55) + TONE_EPS)) * 12;
+}
+
+#if defined(__aarch64__)
+static void pitchesToTonesBlock(const double *pitches, size_t n, float *tones) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t p = vcombine_f32(vcvt_f32_f64(vld1q_f64(pitches + i)), vcvt_f32_f64(vld1q_f64(pitches + i + 2)));
+        float32x4_t x = vaddq_f32(vmulq_f32(p, vdupq_n_f32(1.0f / 55)), vdupq_n_f32(TONE_EPS));
+        uint32x4_t bits = vreinterpretq_u32_f32(x);
+        float32x4_t e = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(127)));
+        float32x4_t m = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007fffff)), vdupq_n_u32(0x3f800000)));
+        uint32x4_t big = vcgtq_f32(m, vdupq_n_f32(1.41421356f));
+        m = vbslq_f32(big, vmulq_f32(m, vdupq_n_f32(0.5f)), m);
+        e = vaddq_f32(e, vreinterpretq_f32_u32(vandq_u32(big, vreinterpretq_u32_f32(vdupq_n_f32(1)))));
+        float32x4_t t = vdivq_f32(vsubq_f32(m, vdupq_n_f32(1)), vaddq_f32(m, vdupq_n_f32(1)));
+        float32x4_t t2 = vmulq_f32(t, t);
+        float32x4_t poly = vfmaq_f32(vdupq_n_f32(LOG2_C5), t2, vdupq_n_f32(LOG2_C7));
+        poly = vfmaq_f32(vdupq_n_f32(LOG2_C3), t2, poly);
+        poly = vfmaq_f32(vdupq_n_f32(LOG2_C1), t2, poly);
+        float32x4_t log2x = vfmaq_f32(e, t, poly);
+        vst1q_f32(tones + i, vmulq_f32(vmaxq_f32(log2x, vdupq_n_f32(0)), vdupq_n_f32(12)));
+    }
+    for (; i < n; i++) {
+        tones[i] = pitchToToneFast(pitches[i]);
+    }
+}
+#elif defined(__SSE2__)
+#define TONES_X86_BODY(VEC, SET1, CASTPS, CASTSI, SRLI, SUBI, ANDI, ORI, SET1I, CVTI, CMPGT, AND, ADD, SUB, MUL, DIV, MAX) \
+    VEC x = ADD(MUL(p, SET1(1.0f / 55)), SET1(TONE_EPS)); \
+    VEC e = CVTI(SUBI(SRLI(CASTPS(x), 23), SET1I(127))); \
+    VEC m = CASTSI(ORI(ANDI(CASTPS(x), SET1I(0x007fffff)), SET1I(0x3f800000))); \
+    VEC big = CMPGT(m, SET1(1.41421356f)); \
+    m = SUB(m, AND(big, MUL(m, SET1(0.5f)))); \
+    e = ADD(e, AND(big, SET1(1))); \
+    VEC t = DIV(SUB(m, SET1(1)), ADD(m, SET1(1))); \
+    VEC t2 = MUL(t, t); \
+    VEC poly = ADD(SET1(LOG2_C1), MUL(t2, ADD(SET1(LOG2_C3), MUL(t2, ADD(SET1(LOG2_C5), MUL(t2, SET1(LOG2_C7))))))); \
+    VEC tone = MUL(MAX(ADD(e, MUL(t, poly)), SET1(0)), SET1(12));
+
+static __m256 cmpgt256(__m256 a, __m256 b) __attribute__((target("avx2")));
+static __m256 cmpgt256(__m256 a, __m256 b) {
+    return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+}
+
+__attribute__((target("avx2")))
+static void pitchesToTonesAVX2(const double *pitches, size_t n, float *tones) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 p = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(_mm256_loadu_pd(pitches + i))),
+                                        _mm256_cvtpd_ps(_mm256_loadu_pd(pitches + i + 4)), 1);
+        TONES_X86_BODY(__m256, _mm256_set1_ps, _mm256_castps_si256, _mm256_castsi256_ps, _mm256_srli_epi32, _mm256_sub_epi32,
+                       _mm256_and_si256, _mm256_or_si256, _mm256_set1_epi32, _mm256_cvtepi32_ps, cmpgt256, _mm256_and_ps,
+                       _mm256_add_ps, _mm256_sub_ps, _mm256_mul_ps, _mm256_div_ps, _mm256_max_ps)
+        _mm256_storeu_ps(tones + i, tone);
+    }
+    for (; i < n; i++) {
+        tones[i] = pitchToToneFast(pitches[i]);
+    }
+}
+
+static void pitchesToTonesBlock(const double *pitches, size_t n, float *tones) {
+    if (__builtin_cpu_supports("avx2")) {
+        pitchesToTonesAVX2(pitches, n, tones);
+        return;
+    }
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 p = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(pitches + i)), _mm_cvtpd_ps(_mm_loadu_pd(pitches + i + 2)));
+        TONES_X86_BODY(__m128, _mm_set1_ps, _mm_castps_si128, _mm_castsi128_ps, _mm_srli_epi32, _mm_sub_epi32,
+                       _mm_and_si128, _mm_or_si128, _mm_set1_epi32, _mm_cvtepi32_ps, _mm_cmpgt_ps, _mm_and_ps,
+                       _mm_add_ps, _mm_sub_ps, _mm_mul_ps, _mm_div_ps, _mm_max_ps)
+        _mm_storeu_ps(tones + i, tone);
+    }
+    for (; i < n; i++) {
+        tones[i] = pitchToToneFast(pitches[i]);
+    }
+}
+#else
+static void pitchesToTonesBlock(const double *pitches, size_t n, float *tones) {
+    for (size_t i = 0; i < n; i++) {
+        tones[i] = pitchToToneFast(pitches[i]);
+    }
+}
+#endif
+
+void pitchesToTonesC(const double *pitches, size_t n, float *tones) {
+    pitchesToTonesBlock(pitches, n, tones);
+}
+
+PitchToneTable *pitchToneTableCreate(const double *stdPitches, size_t n) {
+    double maxPitch = 0;
+    for (size_t i = 0; i < n; i++) {
+        double pitch = stdPitches[i];
+        if (pitch > maxPitch && pitch < PITCH_TONE_TABLE_MAX && pitch == floor(pitch)) {
+            maxPitch = pitch;
+        }
+    }
+    
+    PitchToneTable *table = malloc(sizeof(PitchToneTable));
+    if (table == NULL) {
+        return NULL;
+    }
+    table->count = (size_t)maxPitch + 1;
+    table->tones = malloc(table->count * sizeof(float));
+    if (table->tones == NULL) {
+        free(table);
+        return NULL;
+    }
+    for (size_t i = 0; i < table->count; i++) {
+        table->tones[i] = (float)pitchToToneC((double)i);
+    }
+    return table;
+}
+
+void pitchToneTableDestroy(PitchToneTable *table) {
+    if (table == NULL) {
+        return;
+    }
+    free(table->tones);
+    free(table);
+}
+
+static void stdPitchesToTones(const PitchToneTable *table, const double *pitches, size_t n, float *tones) {
+    if (table == NULL) {
+        pitchesToTonesBlock(pitches, n, tones);
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        double pitch = pitches[i];
+        size_t index = (size_t)pitch;
+        if (pitch >= 0 && index < table->count && (double)index == pitch) {
+            tones[i] = table->tones[index];
+        }
+        else {
+            tones[i] = pitchToToneFast(pitch);
+        }
+    }
+}
+
+void scorePitchesC(const double *voicePitches, const double *stdPitches, size_t n, float *scores,
+                   int scoreLevel, int scoreCompensationOffset, const PitchToneTable *stdTable) {
+    if(scoreLevel<=0){
+        scoreLevel = 1;
+    }else if(scoreLevel > 100){
+        scoreLevel = 100;
+    }
+    
+    if(scoreCompensationOffset<0){
+        scoreCompensationOffset = 0;
+    }else if(scoreCompensationOffset > 100){
+        scoreCompensationOffset = 100;
+    }
+    
+    float level = (float)scoreLevel / 100;
+    float compensation = 1 + (float)scoreCompensationOffset / 100;
+    float scale = 100 * (1 + ((float)scoreLevel/(float)50));
+    float voiceTones[TONE_BLOCK];
+    float stdTones[TONE_BLOCK];
+    
+    for (size_t start = 0; start < n; start += TONE_BLOCK) {
+        size_t count = min(TONE_BLOCK, n - start);
+        const double *voice = voicePitches + start;
+        const double *std = stdPitches + start;
+        float *out = scores + start;
+        
+        pitchesToTonesBlock(voice, count, voiceTones);
+        stdPitchesToTones(stdTable, std, count, stdTones);
+        for (size_t i = 0; i < count; i++) {
+            float match = (compensation - level * fabsf(voiceTones[i] - stdTones[i])) * scale;
+            match = max(0, match);
+            match = min(100, match);
+            out[i] = (voice[i] > 0 && std[i] > 0) ? match : 0;
+        }
+    }
 }
@@ -12,7 +12,33 @@
 
 double pitchToToneC(double pitch);
 float calculedScoreC(double voicePitch, double stdPitch, int scoreLevel, int scoreCompensationOffset);
-
-void resetC(void);
 double handlePitchC(double stdPitch, double voicePitch, double stdMaxPitch);
+
+// 打分上下文, 每个演唱者一个, 互不影响; 单个实例不可多线程同时使用
+typedef struct PitchScorer PitchScorer;
+
+PitchScorer *pitchScorerCreate(void);
+void pitchScorerDestroy(PitchScorer *scorer);
+void pitchScorerReset(PitchScorer *scorer);
+double pitchScorerHandlePitch(PitchScorer *scorer, double stdPitch, double voicePitch, double stdMaxPitch);
+float pitchScorerScore(PitchScorer *scorer, double voicePitch, double stdPitch, int scoreLevel, int scoreCompensationOffset);
+
+// 旧接口, 已没有全局状态需要重置, 不做任何事
+void resetC(void) __attribute__((deprecated("use pitchScorerReset with a PitchScorer")));
+
+// 批量换算与打分, 供回放和重新打分整首歌使用; 与逐个计算的差别:
+// log2 用有理近似计算 (NEON / SSE2 / AVX2), pitch 在 [1, 8000] 内 tone 误差不超过 0.0001 半音,
+// 对应分数误差不超过 scoreLevel * 0.0001 * (1 + scoreLevel / 50) 分
+void pitchesToTonesC(const double *pitches, size_t n, float *tones);
+
+// 标准pitch的查表: 歌词中标准pitch通常为几百个不同的整数, 整数pitch直接查精确tone, 其余按近似计算
+#define PITCH_TONE_TABLE_MAX 8192
+typedef struct PitchToneTable PitchToneTable;
+
+PitchToneTable *pitchToneTableCreate(const double *stdPitches, size_t n);
+void pitchToneTableDestroy(PitchToneTable *table);
+
+// scores[i] 等同于 calculedScoreC(voicePitches[i], stdPitches[i], scoreLevel, scoreCompensationOffset); stdTable 可为 NULL
+void scorePitchesC(const double *voicePitches, const double *stdPitches, size_t n, float *scores,
+                   int scoreLevel, int scoreCompensationOffset, const PitchToneTable *stdTable);
 #endif /* Algorithm_h */
@@ -0,0 +1,130 @@
+//
+//  LrcTokenizer.c
+//  AgoraLyricsScore
+//
+
+#include "LrcTokenizer.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define isDigit(c) ((c) >= '0' && (c) <= '9')
+
+size_t lrcTokenCapacityC(const char *data, size_t length) {
+    size_t count = 0;
+    const char *p = data;
+    const char *end = data + length;
+    while (p < end && (p = memchr(p, '[', end - p)) != NULL) {
+        count++;
+        p++;
+    }
+    return count;
+}
+
+// 解析 p 处的时间标签, 成功时返回 ']' 之后的位置并写入 time, 否则返回 NULL
+static const char *parseTag(const char *p, const char *end, int *time) {
+    p++; /** '[' **/
+    int minutes = 0;
+    int digits = 0;
+    while (p < end && isDigit(*p) && digits < 3) {
+        minutes = minutes * 10 + (*p - '0');
+        p++;
+        digits++;
+    }
+    if (digits == 0 || p >= end || *p != ':') {
+        return NULL;
+    }
+    p++;
+    if (end - p < 2 || !isDigit(p[0]) || !isDigit(p[1])) {
+        return NULL;
+    }
+    int seconds = (p[0] - '0') * 10 + (p[1] - '0');
+    p += 2;
+
+    /** 小数部分取前 3 位, 不足补 0 **/
+    int millis = 0;
+    if (p < end && (*p == '.' || *p == ':')) {
+        p++;
+        int scale = 100;
+        digits = 0;
+        while (p < end && isDigit(*p)) {
+            millis += (*p - '0') * scale;
+            scale /= 10;
+            p++;
+            digits++;
+        }
+        if (digits == 0) {
+            return NULL;
+        }
+    }
+    if (p >= end || *p != ']') {
+        return NULL;
+    }
+    *time = (minutes * 60 + seconds) * 1000 + millis;
+    return p + 1;
+}
+
+static int compareLine(const void *a, const void *b) {
+    const LrcTokenLine *l = a;
+    const LrcTokenLine *r = b;
+    if (l->beginTime != r->beginTime) {
+        return l->beginTime < r->beginTime ? -1 : 1;
+    }
+    return l->textOffset < r->textOffset ? -1 : (l->textOffset > r->textOffset ? 1 : 0);
+}
+
+size_t lrcTokenizeC(const char *data, size_t length, LrcTokenLine *lines, size_t capacity) {
+    const char *p = data;
+    const char *end = data + length;
+    size_t count = 0;
+    int sorted = 1;
+
+    /** utf8 BOM **/
+    if (length >= 3 && (unsigned char)p[0] == 0xEF && (unsigned char)p[1] == 0xBB && (unsigned char)p[2] == 0xBF) {
+        p += 3;
+    }
+    while (p < end) {
+        const char *lineEnd = memchr(p, '\n', end - p);
+        const char *next = lineEnd == NULL ? end : lineEnd + 1;
+        if (lineEnd == NULL) {
+            lineEnd = end;
+        }
+        if (lineEnd > p && lineEnd[-1] == '\r') {
+            lineEnd--;
+        }
+
+        /** 歌词为最后一个 ']' 之后的内容 **/
+        const char *text = p;
+        for (const char *q = lineEnd; q > p; q--) {
+            if (q[-1] == ']') {
+                text = q;
+                break;
+            }
+        }
+
+        const char *q = p;
+        while (q < text && (q = memchr(q, '[', text - q)) != NULL) {
+            int time = 0;
+            const char *after = parseTag(q, text, &time);
+            if (after == NULL) {
+                q++;
+                continue;
+            }
+            if (count < capacity) {
+                lines[count].beginTime = time;
+                lines[count].textOffset = (int)(text - data);
+                lines[count].textLength = (int)(lineEnd - text);
+                if (count > 0 && lines[count - 1].beginTime > time) {
+                    sorted = 0;
+                }
+                count++;
+            }
+            q = after;
+        }
+        p = next;
+    }
+
+    if (!sorted) {
+        qsort(lines, count, sizeof(LrcTokenLine), compareLine);
+    }
+    return count;
+}
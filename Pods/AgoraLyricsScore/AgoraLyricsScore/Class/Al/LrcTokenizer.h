@@ -0,0 +1,27 @@
+//
+//  LrcTokenizer.h
+//  AgoraLyricsScore
+//
+
+#ifndef LrcTokenizer_h
+#define LrcTokenizer_h
+
+#include <stdio.h>
+
+// LRC 的一个时间标签: 开始时间 (ms) 与所在行歌词在源数据中的字节范围
+typedef struct LrcTokenLine {
+    int beginTime;
+    int textOffset;
+    int textLength;
+} LrcTokenLine;
+
+// 标签个数的上限 ('[' 的个数), 用于分配 lines
+size_t lrcTokenCapacityC(const char *data, size_t length);
+
+// 单遍扫描 utf8 的 LRC, 支持 \n 与 \r\n 换行和一行多个标签;
+// 时间标签为 [m:ss], [mm:ss.x], [mm:ss.xx], [mm:ss.xxx] 等, 分钟 1~3 位, 小数点也可以是 ':';
+// 歌词为行内最后一个 ']' 之后的内容, 不含行尾的 \r; [ar:xxx] 等非时间标签忽略;
+// 结果按时间排序, 同一时间保持文件中的顺序; 返回写入 lines 的个数, 不超过 capacity
+size_t lrcTokenizeC(const char *data, size_t length, LrcTokenLine *lines, size_t capacity);
+
+#endif /* LrcTokenizer_h */
@@ -0,0 +1,768 @@
+//
+//  LyricXmlParser.c
+//  AgoraLyricsScore
+//
+
+#include "LyricXmlParser.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define isDigit(c) ((c) >= '0' && (c) <= '9')
+#define isSpace(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+#define isAsciiLetter(c) (((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z'))
+
+#define LYRIC_XML_MAX_DEPTH 256
+
+// 只关心这几个元素, 其余元素不入栈 (与原 XMLParser 回调的处理一致)
+enum {
+    ElementOther = 0,
+    ElementSong,
+    ElementGeneral,
+    ElementName,
+    ElementSinger,
+    ElementType,
+    ElementSentence,
+    ElementTone,
+    ElementWord,
+    ElementOverlap,
+};
+
+typedef struct LyricXmlReader {
+    const char *p;
+    const char *end;
+    LyricXml *xml;
+    // 未闭合元素的名字, 用于校验结束标签
+    const char *names[LYRIC_XML_MAX_DEPTH];
+    int nameLengths[LYRIC_XML_MAX_DEPTH];
+    int depth;
+    // 已知元素的栈
+    int kinds[LYRIC_XML_MAX_DEPTH];
+    int kindCount;
+    int hasSong;
+    // 正在收集 word 的字, -1 表示没有
+    int currentTone;
+    // 正在收集的文本在 arena 中的起点
+    int textStart;
+} LyricXmlReader;
+
+// MARK: - arena
+
+static int reserveArena(LyricXml *xml, int extra) {
+    if (xml->arenaLength + extra + 1 <= xml->arenaCapacity) {
+        return 1;
+    }
+    int capacity = xml->arenaCapacity * 2;
+    while (capacity < xml->arenaLength + extra + 1) {
+        capacity *= 2;
+    }
+    char *arena = realloc(xml->arena, capacity);
+    if (arena == NULL) {
+        return 0;
+    }
+    xml->arena = arena;
+    xml->arenaCapacity = capacity;
+    return 1;
+}
+
+static int appendArena(LyricXml *xml, const char *bytes, int length) {
+    if (!reserveArena(xml, length)) {
+        return 0;
+    }
+    memcpy(xml->arena + xml->arenaLength, bytes, length);
+    xml->arenaLength += length;
+    return 1;
+}
+
+static unsigned int hashBytes(const char *bytes, int length) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static int growInternTable(LyricXml *xml) {
+    int capacity = xml->internCapacity * 2;
+    int *table = calloc(capacity, sizeof(int));
+    if (table == NULL) {
+        return 0;
+    }
+    for (int i = 0; i < xml->internCapacity; i++) {
+        int entry = xml->internTable[i];
+        if (entry == 0) {
+            continue;
+        }
+        const char *string = xml->arena + entry - 1;
+        unsigned int slot = hashBytes(string, (int)strlen(string)) & (capacity - 1);
+        while (table[slot] != 0) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        table[slot] = entry;
+    }
+    free(xml->internTable);
+    xml->internTable = table;
+    xml->internCapacity = capacity;
+    return 1;
+}
+
+// arena 中 start 之后的内容作为一个字符串; 已存在相同的字符串时回退 arena 并返回已有的偏移, 失败返回 -1
+static int internArena(LyricXml *xml, int start) {
+    int length = xml->arenaLength - start;
+    const char *string = xml->arena + start;
+    unsigned int mask = xml->internCapacity - 1;
+    unsigned int slot = hashBytes(string, length) & mask;
+    while (xml->internTable[slot] != 0) {
+        int offset = xml->internTable[slot] - 1;
+        if (memcmp(xml->arena + offset, string, length) == 0 && xml->arena[offset + length] == '\0') {
+            xml->arenaLength = start;
+            return offset;
+        }
+        slot = (slot + 1) & mask;
+    }
+    if (!reserveArena(xml, 0)) {
+        return -1;
+    }
+    xml->arena[xml->arenaLength++] = '\0';
+    xml->internTable[slot] = start + 1;
+    xml->internCount++;
+    if (xml->internCount * 2 > xml->internCapacity && !growInternTable(xml)) {
+        return -1;
+    }
+    return start;
+}
+
+// MARK: - 文本
+
+static int appendUtf8(LyricXml *xml, unsigned int code) {
+    char bytes[4];
+    int length;
+    if (code < 0x80) {
+        bytes[0] = (char)code;
+        length = 1;
+    } else if (code < 0x800) {
+        bytes[0] = (char)(0xC0 | (code >> 6));
+        bytes[1] = (char)(0x80 | (code & 0x3F));
+        length = 2;
+    } else if (code < 0x10000) {
+        bytes[0] = (char)(0xE0 | (code >> 12));
+        bytes[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+        bytes[2] = (char)(0x80 | (code & 0x3F));
+        length = 3;
+    } else {
+        bytes[0] = (char)(0xF0 | (code >> 18));
+        bytes[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+        bytes[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+        bytes[3] = (char)(0x80 | (code & 0x3F));
+        length = 4;
+    }
+    return appendArena(xml, bytes, length);
+}
+
+// 解析 p 处 ('&' 之后) 的实体, 成功时返回 ';' 之后的位置并写入 code, 否则返回 NULL
+static const char *parseEntity(const char *p, const char *end, unsigned int *code) {
+    const char *semicolon = memchr(p, ';', end - p > 12 ? 12 : end - p);
+    if (semicolon == NULL) {
+        return NULL;
+    }
+    int length = (int)(semicolon - p);
+    if (length >= 2 && p[0] == '#') {
+        unsigned int value = 0;
+        int hex = p[1] == 'x' || p[1] == 'X';
+        const char *q = p + (hex ? 2 : 1);
+        if (q == semicolon) {
+            return NULL;
+        }
+        for (; q < semicolon; q++) {
+            char c = *q;
+            if (isDigit(c)) {
+                value = value * (hex ? 16 : 10) + (c - '0');
+            } else if (hex && c >= 'a' && c <= 'f') {
+                value = value * 16 + (c - 'a' + 10);
+            } else if (hex && c >= 'A' && c <= 'F') {
+                value = value * 16 + (c - 'A' + 10);
+            } else {
+                return NULL;
+            }
+            if (value > 0x10FFFF) {
+                return NULL;
+            }
+        }
+        /** '\0' 会截断 arena 中的字符串 **/
+        if (value == 0) {
+            return NULL;
+        }
+        *code = value;
+    } else if (length == 2 && memcmp(p, "lt", 2) == 0) {
+        *code = '<';
+    } else if (length == 2 && memcmp(p, "gt", 2) == 0) {
+        *code = '>';
+    } else if (length == 3 && memcmp(p, "amp", 3) == 0) {
+        *code = '&';
+    } else if (length == 4 && memcmp(p, "quot", 4) == 0) {
+        *code = '"';
+    } else if (length == 4 && memcmp(p, "apos", 4) == 0) {
+        *code = '\'';
+    } else {
+        return NULL;
+    }
+    return semicolon + 1;
+}
+
+// 解码实体后追加到 arena, 无法识别的实体原样保留
+static int appendText(LyricXml *xml, const char *p, const char *end) {
+    while (p < end) {
+        const char *amp = memchr(p, '&', end - p);
+        const char *stop = amp == NULL ? end : amp;
+        if (stop > p && !appendArena(xml, p, (int)(stop - p))) {
+            return 0;
+        }
+        if (amp == NULL) {
+            break;
+        }
+        unsigned int code = 0;
+        const char *next = parseEntity(amp + 1, end, &code);
+        if (next == NULL) {
+            if (!appendArena(xml, "&", 1)) {
+                return 0;
+            }
+            p = amp + 1;
+        } else {
+            if (!appendUtf8(xml, code)) {
+                return 0;
+            }
+            p = next;
+        }
+    }
+    return 1;
+}
+
+// MARK: - 数值
+
+// 秒数 ("12.345") 转为 ms, 小数超过 3 位截断; 不是合法的小数时为 0
+static int parseMillis(const char *p, const char *end) {
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    long long seconds = 0;
+    int millis = 0;
+    int digits = 0;
+    while (p < end && isDigit(*p)) {
+        if (++digits > 9) {
+            return 0;
+        }
+        seconds = seconds * 10 + (*p - '0');
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        int scale = 100;
+        while (p < end && isDigit(*p)) {
+            millis += (*p - '0') * scale;
+            scale /= 10;
+            p++;
+            digits++;
+        }
+    }
+    if (digits == 0 || p != end) {
+        return 0;
+    }
+    long long value = seconds * 1000 + millis;
+    return (int)(negative ? -value : value);
+}
+
+// 不是合法的小数时为 0
+static float parsePitch(const char *p, const char *end) {
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    double value = 0;
+    int digits = 0;
+    while (p < end && isDigit(*p)) {
+        value = value * 10 + (*p - '0');
+        p++;
+        digits++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        double scale = 0.1;
+        while (p < end && isDigit(*p)) {
+            value += (*p - '0') * scale;
+            scale /= 10;
+            p++;
+            digits++;
+        }
+    }
+    if (digits == 0 || p != end) {
+        return 0;
+    }
+    return (float)(negative ? -value : value);
+}
+
+// 不是整数时返回 fallback
+static int parseInt(const char *p, const char *end, int fallback) {
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    int value = 0;
+    int digits = 0;
+    while (p < end && isDigit(*p)) {
+        if (++digits > 9) {
+            return fallback;
+        }
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    if (digits == 0 || p != end) {
+        return fallback;
+    }
+    return negative ? -value : value;
+}
+
+// MARK: - 结构
+
+static int elementKind(const char *name, int length) {
+    switch (length) {
+        case 4:
+            if (memcmp(name, "song", 4) == 0) return ElementSong;
+            if (memcmp(name, "name", 4) == 0) return ElementName;
+            if (memcmp(name, "tone", 4) == 0) return ElementTone;
+            if (memcmp(name, "type", 4) == 0) return ElementType;
+            if (memcmp(name, "word", 4) == 0) return ElementWord;
+            break;
+        case 6:
+            if (memcmp(name, "singer", 6) == 0) return ElementSinger;
+            break;
+        case 7:
+            if (memcmp(name, "general", 7) == 0) return ElementGeneral;
+            if (memcmp(name, "overlap", 7) == 0) return ElementOverlap;
+            break;
+        case 8:
+            if (memcmp(name, "sentence", 8) == 0) return ElementSentence;
+            break;
+    }
+    return ElementOther;
+}
+
+static int appendSentence(LyricXml *xml) {
+    if (xml->sentenceCount == xml->sentenceCapacity) {
+        int capacity = xml->sentenceCapacity * 2;
+        LyricXmlSentence *sentences = realloc(xml->sentences, capacity * sizeof(LyricXmlSentence));
+        if (sentences == NULL) {
+            return 0;
+        }
+        xml->sentences = sentences;
+        xml->sentenceCapacity = capacity;
+    }
+    xml->sentences[xml->sentenceCount].firstTone = xml->toneCount;
+    xml->sentences[xml->sentenceCount].toneCount = 0;
+    xml->sentenceCount++;
+    return 1;
+}
+
+// 追加到最后一句, 返回字的下标, 失败返回 -1
+static int appendTone(LyricXml *xml) {
+    if (xml->toneCount == xml->toneCapacity) {
+        int capacity = xml->toneCapacity * 2;
+        LyricXmlTone *tones = realloc(xml->tones, capacity * sizeof(LyricXmlTone));
+        if (tones == NULL) {
+            return -1;
+        }
+        xml->tones = tones;
+        xml->toneCapacity = capacity;
+    }
+    LyricXmlTone *tone = &xml->tones[xml->toneCount];
+    memset(tone, 0, sizeof(LyricXmlTone));
+    tone->lang = -1;
+    xml->sentences[xml->sentenceCount - 1].toneCount++;
+    return xml->toneCount++;
+}
+
+// 读取 <tone>/<overlap> 的属性, p 指向元素名之后, tagEnd 指向 '>' 或 "/>"
+static int readToneAttributes(LyricXml *xml, int index, const char *p, const char *tagEnd, int isTone) {
+    int pronounceStart = xml->arenaLength;
+    while (p < tagEnd) {
+        while (p < tagEnd && isSpace(*p)) {
+            p++;
+        }
+        const char *name = p;
+        while (p < tagEnd && *p != '=' && !isSpace(*p)) {
+            p++;
+        }
+        int nameLength = (int)(p - name);
+        while (p < tagEnd && isSpace(*p)) {
+            p++;
+        }
+        if (p >= tagEnd || *p != '=') {
+            break;
+        }
+        p++;
+        while (p < tagEnd && isSpace(*p)) {
+            p++;
+        }
+        if (p >= tagEnd || (*p != '"' && *p != '\'')) {
+            return 0;
+        }
+        const char *value = p + 1;
+        const char *valueEnd = memchr(value, *p, tagEnd - value);
+        if (valueEnd == NULL) {
+            return 0;
+        }
+        p = valueEnd + 1;
+
+        LyricXmlTone *tone = &xml->tones[index];
+        if (nameLength == 5 && memcmp(name, "begin", 5) == 0) {
+            tone->beginTime = parseMillis(value, valueEnd);
+        } else if (nameLength == 3 && memcmp(name, "end", 3) == 0) {
+            tone->endTime = parseMillis(value, valueEnd);
+        } else if (nameLength == 4 && memcmp(name, "lang", 4) == 0) {
+            tone->lang = parseInt(value, valueEnd, -1);
+        } else if (isTone && nameLength == 5 && memcmp(name, "pitch", 5) == 0) {
+            tone->pitch = parsePitch(value, valueEnd);
+        } else if (isTone && nameLength == 9 && memcmp(name, "pronounce", 9) == 0) {
+            xml->arenaLength = pronounceStart;
+            if (!appendText(xml, value, valueEnd)) {
+                return 0;
+            }
+        }
+    }
+    int offset = internArena(xml, pronounceStart);
+    if (offset < 0) {
+        return 0;
+    }
+    xml->tones[index].pronounceOffset = offset;
+    xml->tones[index].pronounceLength = (int)strlen(xml->arena + offset);
+    return 1;
+}
+
+static int finishTone(LyricXmlReader *reader) {
+    LyricXml *xml = reader->xml;
+    int offset = internArena(xml, reader->textStart);
+    if (offset < 0) {
+        return 0;
+    }
+    LyricXmlTone *tone = &xml->tones[reader->currentTone];
+    tone->wordOffset = offset;
+    tone->wordLength = (int)strlen(xml->arena + offset);
+    /** 补偿语言 **/
+    if (tone->lang == -1 && tone->wordLength > 0) {
+        tone->lang = isAsciiLetter(xml->arena[offset]) ? 2 : 1;
+    }
+    reader->currentTone = -1;
+    return 1;
+}
+
+static int startElement(LyricXmlReader *reader, int kind, const char *attributes, const char *tagEnd) {
+    LyricXml *xml = reader->xml;
+    switch (kind) {
+        case ElementSong:
+            reader->hasSong = 1;
+            return 1;
+        case ElementName:
+        case ElementSinger:
+        case ElementType:
+            reader->textStart = xml->arenaLength;
+            return 1;
+        case ElementSentence:
+            return appendSentence(xml);
+        case ElementTone:
+        case ElementOverlap: {
+            if (reader->currentTone >= 0 && !finishTone(reader)) {
+                return 0;
+            }
+            if (kind == ElementOverlap && !appendSentence(xml)) {
+                return 0;
+            }
+            if (xml->sentenceCount == 0) {
+                return 1;
+            }
+            int index = appendTone(xml);
+            if (index < 0 || !readToneAttributes(xml, index, attributes, tagEnd, kind == ElementTone)) {
+                return 0;
+            }
+            reader->currentTone = index;
+            reader->textStart = xml->arenaLength;
+            return 1;
+        }
+        default:
+            return 1;
+    }
+}
+
+static int endElement(LyricXmlReader *reader, int kind) {
+    LyricXml *xml = reader->xml;
+    if (reader->kindCount == 0 || reader->kinds[reader->kindCount - 1] != kind) {
+        return 1;
+    }
+    reader->kindCount--;
+    switch (kind) {
+        case ElementName:
+        case ElementSinger: {
+            int offset = internArena(xml, reader->textStart);
+            if (offset < 0) {
+                return 0;
+            }
+            int length = (int)strlen(xml->arena + offset);
+            if (kind == ElementName) {
+                xml->nameOffset = offset;
+                xml->nameLength = length;
+            } else {
+                xml->singerOffset = offset;
+                xml->singerLength = length;
+            }
+            return 1;
+        }
+        case ElementType: {
+            const char *p = xml->arena + reader->textStart;
+            const char *end = xml->arena + xml->arenaLength;
+            while (p < end && isSpace(*p)) {
+                p++;
+            }
+            while (end > p && isSpace(end[-1])) {
+                end--;
+            }
+            xml->type = parseInt(p, end, 0);
+            xml->arenaLength = reader->textStart;
+            return 1;
+        }
+        case ElementTone:
+        case ElementOverlap:
+            return reader->currentTone < 0 || finishTone(reader);
+        default:
+            return 1;
+    }
+}
+
+// 当前元素是否收集文本
+static int wantsText(LyricXmlReader *reader) {
+    if (reader->kindCount == 0) {
+        return 0;
+    }
+    switch (reader->kinds[reader->kindCount - 1]) {
+        case ElementName:
+        case ElementSinger:
+        case ElementType:
+            return 1;
+        case ElementWord:
+        case ElementOverlap:
+            return reader->currentTone >= 0;
+        default:
+            return 0;
+    }
+}
+
+// MARK: - 扫描
+
+// 跳到 pattern 之后, 没有找到返回 NULL
+static const char *skipPast(const char *p, const char *end, const char *pattern, int length) {
+    while (p < end && (p = memchr(p, pattern[0], end - p)) != NULL) {
+        if (end - p >= length && memcmp(p, pattern, length) == 0) {
+            return p + length;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+static int readMarkup(LyricXmlReader *reader) {
+    const char *p = reader->p;
+    const char *end = reader->end;
+    /** p 指向 '<' **/
+    if (end - p >= 4 && memcmp(p, "<!--", 4) == 0) {
+        reader->p = skipPast(p + 4, end, "-->", 3);
+        return reader->p != NULL;
+    }
+    if (end - p >= 9 && memcmp(p, "<![CDATA[", 9) == 0) {
+        const char *close = skipPast(p + 9, end, "]]>", 3);
+        if (close == NULL) {
+            return 0;
+        }
+        if (wantsText(reader) && !appendArena(reader->xml, p + 9, (int)(close - 3 - (p + 9)))) {
+            return 0;
+        }
+        reader->p = close;
+        return 1;
+    }
+    if (end - p >= 2 && p[1] == '?') {
+        reader->p = skipPast(p + 2, end, "?>", 2);
+        return reader->p != NULL;
+    }
+    if (end - p >= 2 && p[1] == '!') {
+        /** <!DOCTYPE ..>, 内部子集以 "]>" 结束 **/
+        const char *bracket = memchr(p, '[', end - p);
+        const char *close = memchr(p, '>', end - p);
+        if (bracket != NULL && close != NULL && bracket < close) {
+            reader->p = skipPast(bracket, end, "]>", 2);
+        } else {
+            reader->p = close == NULL ? NULL : close + 1;
+        }
+        return reader->p != NULL;
+    }
+
+    /** 标签内的属性值可能含有 '>', 按引号跳过 **/
+    const char *tagEnd = p + 1;
+    while (tagEnd < end && *tagEnd != '>') {
+        if (*tagEnd == '"' || *tagEnd == '\'') {
+            const char *quote = memchr(tagEnd + 1, *tagEnd, end - tagEnd - 1);
+            if (quote == NULL) {
+                return 0;
+            }
+            tagEnd = quote;
+        }
+        tagEnd++;
+    }
+    if (tagEnd >= end) {
+        return 0;
+    }
+    reader->p = tagEnd + 1;
+
+    if (p[1] == '/') {
+        const char *name = p + 2;
+        const char *nameEnd = name;
+        while (nameEnd < tagEnd && !isSpace(*nameEnd)) {
+            nameEnd++;
+        }
+        int length = (int)(nameEnd - name);
+        if (reader->depth == 0) {
+            return 0;
+        }
+        reader->depth--;
+        if (reader->nameLengths[reader->depth] != length || memcmp(reader->names[reader->depth], name, length) != 0) {
+            return 0;
+        }
+        return endElement(reader, elementKind(name, length));
+    }
+
+    int selfClosing = tagEnd[-1] == '/' && tagEnd - 1 > p;
+    const char *attributesEnd = selfClosing ? tagEnd - 1 : tagEnd;
+    const char *name = p + 1;
+    const char *nameEnd = name;
+    while (nameEnd < attributesEnd && !isSpace(*nameEnd)) {
+        nameEnd++;
+    }
+    int length = (int)(nameEnd - name);
+    if (length == 0) {
+        return 0;
+    }
+    int kind = elementKind(name, length);
+    if (kind != ElementOther) {
+        if (reader->kindCount == LYRIC_XML_MAX_DEPTH) {
+            return 0;
+        }
+        reader->kinds[reader->kindCount++] = kind;
+    }
+    if (!startElement(reader, kind, nameEnd, attributesEnd)) {
+        return 0;
+    }
+    if (selfClosing) {
+        return kind == ElementOther || endElement(reader, kind);
+    }
+    if (reader->depth == LYRIC_XML_MAX_DEPTH) {
+        return 0;
+    }
+    reader->names[reader->depth] = name;
+    reader->nameLengths[reader->depth] = length;
+    reader->depth++;
+    return 1;
+}
+
+static LyricXml *createXml(size_t length) {
+    LyricXml *xml = calloc(1, sizeof(LyricXml));
+    if (xml == NULL) {
+        return NULL;
+    }
+    /** 按经验估算: 每个字约 80 字节, 每句约 10 个字, 文本约占 1/10 **/
+    xml->toneCapacity = (int)(length / 80) + 16;
+    xml->sentenceCapacity = xml->toneCapacity / 8 + 16;
+    xml->arenaCapacity = (int)(length / 8) + 64;
+    xml->internCapacity = 256;
+    while (xml->internCapacity < xml->toneCapacity) {
+        xml->internCapacity *= 2;
+    }
+    xml->tones = malloc(xml->toneCapacity * sizeof(LyricXmlTone));
+    xml->sentences = malloc(xml->sentenceCapacity * sizeof(LyricXmlSentence));
+    xml->arena = malloc(xml->arenaCapacity);
+    xml->internTable = calloc(xml->internCapacity, sizeof(int));
+    if (xml->tones == NULL || xml->sentences == NULL || xml->arena == NULL || xml->internTable == NULL) {
+        lyricXmlDestroyC(xml);
+        return NULL;
+    }
+    /** 空字符串固定在偏移 0 **/
+    xml->arena[0] = '\0';
+    xml->arenaLength = 0;
+    if (internArena(xml, 0) != 0) {
+        lyricXmlDestroyC(xml);
+        return NULL;
+    }
+    return xml;
+}
+
+LyricXml *lyricXmlParseC(const char *data, size_t length) {
+    if (length >= 0x7FFFFFFF) {
+        return NULL;
+    }
+    LyricXml *xml = createXml(length);
+    if (xml == NULL) {
+        return NULL;
+    }
+    LyricXmlReader *reader = malloc(sizeof(LyricXmlReader));
+    if (reader == NULL) {
+        lyricXmlDestroyC(xml);
+        return NULL;
+    }
+    reader->p = data;
+    reader->end = data + length;
+    reader->xml = xml;
+    reader->depth = 0;
+    reader->kindCount = 0;
+    reader->hasSong = 0;
+    reader->currentTone = -1;
+    reader->textStart = 0;
+
+    /** utf8 BOM **/
+    if (length >= 3 && (unsigned char)data[0] == 0xEF && (unsigned char)data[1] == 0xBB && (unsigned char)data[2] == 0xBF) {
+        reader->p += 3;
+    }
+    int success = 1;
+    while (reader->p < reader->end) {
+        const char *lt = memchr(reader->p, '<', reader->end - reader->p);
+        const char *textEnd = lt == NULL ? reader->end : lt;
+        if (textEnd > reader->p && reader->depth > 0 && wantsText(reader)) {
+            if (!appendText(xml, reader->p, textEnd)) {
+                success = 0;
+                break;
+            }
+        }
+        if (lt == NULL) {
+            break;
+        }
+        reader->p = lt;
+        if (!readMarkup(reader)) {
+            success = 0;
+            break;
+        }
+    }
+    if (!success || reader->depth != 0 || !reader->hasSong) {
+        free(reader);
+        lyricXmlDestroyC(xml);
+        return NULL;
+    }
+    free(reader);
+    return xml;
+}
+
+void lyricXmlDestroyC(LyricXml *xml) {
+    if (xml == NULL) {
+        return;
+    }
+    free(xml->arena);
+    free(xml->tones);
+    free(xml->sentences);
+    free(xml->internTable);
+    free(xml);
+}
@@ -0,0 +1,60 @@
+//
+//  LyricXmlParser.h
+//  AgoraLyricsScore
+//
+
+#ifndef LyricXmlParser_h
+#define LyricXmlParser_h
+
+#include <stdio.h>
+
+// 咪咕 xml 歌词 (<song><general>..</general><paragraph><sentence><tone>..</tone></sentence></paragraph></song>) 的解析结果
+// 直接扫描 utf8 数据, 时间与 pitch 原地转为数值, 文本解码实体后存入同一块 arena, 相同的文本只存一份
+// 字符串用 (arena 中的偏移, 字节数) 表示, arena 中每个字符串以 '\0' 结尾
+
+typedef struct LyricXmlTone {
+    // 单位 ms, 由秒数的小数部分直接换算, 超过 3 位的小数截断
+    int beginTime;
+    int endTime;
+    float pitch;
+    // 1: 中文, 2: 英文, -1: 未知; 未知且有 word 时按 word 首字母补偿 (字母为英文, 否则中文)
+    int lang;
+    int wordOffset;
+    int wordLength;
+    int pronounceOffset;
+    int pronounceLength;
+} LyricXmlTone;
+
+// 一句: <sentence> 或 <overlap>, 后者只有一个字
+typedef struct LyricXmlSentence {
+    int firstTone;
+    int toneCount;
+} LyricXmlSentence;
+
+typedef struct LyricXml {
+    char *arena;
+    int arenaLength;
+    int arenaCapacity;
+    int nameOffset;
+    int nameLength;
+    int singerOffset;
+    int singerLength;
+    // <type> 的值, 缺失或不是整数时为 0
+    int type;
+    LyricXmlTone *tones;
+    int toneCount;
+    int toneCapacity;
+    LyricXmlSentence *sentences;
+    int sentenceCount;
+    int sentenceCapacity;
+    // 文本去重的开放寻址表, 存 arena 偏移 + 1
+    int *internTable;
+    int internCapacity;
+    int internCount;
+} LyricXml;
+
+// 格式错误、没有 <song> 或内存不足时返回 NULL
+LyricXml *lyricXmlParseC(const char *data, size_t length);
+void lyricXmlDestroyC(LyricXml *xml);
+
+#endif /* LyricXmlParser_h */
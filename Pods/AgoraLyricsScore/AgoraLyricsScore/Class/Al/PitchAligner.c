@@ -0,0 +1,242 @@
+//
+//  PitchAligner.c
+//  AgoraLyricsScore
+//
+
+#include "PitchAligner.h"
+#include "Algorithm.h"
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct PitchAligner {
+    int toneCount;
+    int toneCapacity;
+    int bandMs;
+    int scoreLevel;
+    int scoreCompensationOffset;
+    int *beginTimes;
+    int *endTimes;
+    double *stdPitches;
+    // 以第 j 个字结尾的最大累计得分, 只有上一个采样的带 [lastLo, lastHi] 内有效
+    double *totals;
+    double *nextTotals;
+    int *counts;
+    int lastLo;
+    int lastHi;
+    // 每个采样的带 [lo, hi] 与其格子在 cells 中的起点
+    int *los;
+    int *his;
+    int *offsets;
+    int sampleCount;
+    int sampleCapacity;
+    // 带内每个格子: 采样对这个字的得分, 回溯时的上一个字
+    float *cellScores;
+    int *cellBacks;
+    int cellCount;
+    int cellCapacity;
+};
+
+PitchAligner *pitchAlignerCreate(void) {
+    return calloc(1, sizeof(PitchAligner));
+}
+
+void pitchAlignerDestroy(PitchAligner *aligner) {
+    if (aligner == NULL) {
+        return;
+    }
+    free(aligner->beginTimes);
+    free(aligner->endTimes);
+    free(aligner->stdPitches);
+    free(aligner->totals);
+    free(aligner->nextTotals);
+    free(aligner->counts);
+    free(aligner->los);
+    free(aligner->his);
+    free(aligner->offsets);
+    free(aligner->cellScores);
+    free(aligner->cellBacks);
+    free(aligner);
+}
+
+// 容量不足时翻倍, 失败时原指针不变
+static int grow(void **pointer, int *capacity, int needed, size_t itemSize) {
+    if (needed <= *capacity) {
+        return 0;
+    }
+    int newCapacity = *capacity > 0 ? *capacity : 64;
+    while (newCapacity < needed) {
+        newCapacity *= 2;
+    }
+    void *newPointer = realloc(*pointer, itemSize * newCapacity);
+    if (newPointer == NULL) {
+        return -1;
+    }
+    *pointer = newPointer;
+    return 0;
+}
+
+static int growAll(void **pointers[], size_t itemSizes[], int count, int *capacity, int needed) {
+    if (needed <= *capacity) {
+        return 0;
+    }
+    int newCapacity = *capacity;
+    for (int i = 0; i < count; i++) {
+        newCapacity = *capacity;
+        if (grow(pointers[i], &newCapacity, needed, itemSizes[i]) != 0) {
+            return -1;
+        }
+    }
+    *capacity = newCapacity;
+    return 0;
+}
+
+int pitchAlignerBeginLine(PitchAligner *aligner, const int *beginTimes, const int *endTimes, const double *stdPitches,
+                          int toneCount, int bandMs, int scoreLevel, int scoreCompensationOffset) {
+    if (aligner == NULL || toneCount < 0) {
+        return -1;
+    }
+    void **pointers[] = { (void **)&aligner->beginTimes, (void **)&aligner->endTimes, (void **)&aligner->stdPitches,
+        (void **)&aligner->totals, (void **)&aligner->nextTotals, (void **)&aligner->counts };
+    size_t itemSizes[] = { sizeof(int), sizeof(int), sizeof(double), sizeof(double), sizeof(double), sizeof(int) };
+    if (growAll(pointers, itemSizes, 6, &aligner->toneCapacity, toneCount) != 0) {
+        aligner->toneCount = 0;
+        aligner->sampleCount = 0;
+        return -1;
+    }
+    if (toneCount > 0) {
+        memcpy(aligner->beginTimes, beginTimes, sizeof(int) * toneCount);
+        memcpy(aligner->endTimes, endTimes, sizeof(int) * toneCount);
+        memcpy(aligner->stdPitches, stdPitches, sizeof(double) * toneCount);
+    }
+    aligner->toneCount = toneCount;
+    aligner->bandMs = bandMs > 0 ? bandMs : 0;
+    aligner->scoreLevel = scoreLevel;
+    aligner->scoreCompensationOffset = scoreCompensationOffset;
+    aligner->lastLo = 0;
+    aligner->lastHi = -1;
+    aligner->sampleCount = 0;
+    aligner->cellCount = 0;
+    return 0;
+}
+
+int pitchAlignerSampleCount(const PitchAligner *aligner) {
+    return aligner == NULL ? 0 : aligner->sampleCount;
+}
+
+int pitchAlignerAddPitch(PitchAligner *aligner, int progress, double voicePitch) {
+    if (aligner == NULL || voicePitch <= 0) {
+        return 0;
+    }
+    int n = aligner->toneCount;
+    int band = aligner->bandMs;
+
+    /** 带的下界只增不减, 整行的查找是线性的 **/
+    int lo = aligner->lastLo;
+    while (lo < n && aligner->endTimes[lo] + band < progress) {
+        lo++;
+    }
+    if (lo >= n || aligner->beginTimes[lo] - band > progress) {
+        return 0;
+    }
+    int hi = lo;
+    while (hi + 1 < n && aligner->beginTimes[hi + 1] - band <= progress) {
+        hi++;
+    }
+
+    int width = hi - lo + 1;
+    int sampleIndex = aligner->sampleCount;
+    void **samplePointers[] = { (void **)&aligner->los, (void **)&aligner->his, (void **)&aligner->offsets };
+    size_t sampleSizes[] = { sizeof(int), sizeof(int), sizeof(int) };
+    if (growAll(samplePointers, sampleSizes, 3, &aligner->sampleCapacity, sampleIndex + 1) != 0) {
+        return -1;
+    }
+    void **cellPointers[] = { (void **)&aligner->cellScores, (void **)&aligner->cellBacks };
+    size_t cellSizes[] = { sizeof(float), sizeof(int) };
+    if (growAll(cellPointers, cellSizes, 2, &aligner->cellCapacity, aligner->cellCount + width) != 0) {
+        return -1;
+    }
+
+    int offset = aligner->cellCount;
+    int lastLo = aligner->lastLo;
+    int lastHi = aligner->lastHi;
+    double best = sampleIndex == 0 ? 0 : -DBL_MAX;
+    int bestTone = -1;
+    if (sampleIndex > 0) {
+        for (int j = lastLo; j <= lastHi && j < lo; j++) {
+            if (aligner->totals[j] > best) {
+                best = aligner->totals[j];
+                bestTone = j;
+            }
+        }
+    }
+    for (int j = lo; j <= hi; j++) {
+        /** 上一个采样对齐到 j 之前 (含 j) 的字中累计得分最大的 **/
+        if (sampleIndex > 0 && j >= lastLo && j <= lastHi && aligner->totals[j] > best) {
+            best = aligner->totals[j];
+            bestTone = j;
+        }
+
+        double stdPitch = aligner->stdPitches[j];
+        double pitch = pitchScorerHandlePitch(NULL, stdPitch, voicePitch, 0);
+        float score = pitchScorerScore(NULL, pitch, stdPitch, aligner->scoreLevel, aligner->scoreCompensationOffset);
+
+        /** 得分相同时优先对齐到时间上最近的字, 偏离整个带扣 1 分 **/
+        int distance = 0;
+        if (progress < aligner->beginTimes[j]) {
+            distance = aligner->beginTimes[j] - progress;
+        }
+        else if (progress > aligner->endTimes[j]) {
+            distance = progress - aligner->endTimes[j];
+        }
+        double penalty = band > 0 ? (double)distance / band : 0;
+
+        aligner->cellScores[offset + j - lo] = score;
+        aligner->cellBacks[offset + j - lo] = bestTone;
+        aligner->nextTotals[j] = best + score - penalty;
+    }
+
+    double *totals = aligner->totals;
+    aligner->totals = aligner->nextTotals;
+    aligner->nextTotals = totals;
+    aligner->los[sampleIndex] = lo;
+    aligner->his[sampleIndex] = hi;
+    aligner->offsets[sampleIndex] = offset;
+    aligner->cellCount += width;
+    aligner->sampleCount++;
+    aligner->lastLo = lo;
+    aligner->lastHi = hi;
+    return 0;
+}
+
+void pitchAlignerToneScores(PitchAligner *aligner, float *scores) {
+    if (aligner == NULL || aligner->toneCount == 0) {
+        return;
+    }
+    int n = aligner->toneCount;
+    for (int j = 0; j < n; j++) {
+        scores[j] = 0;
+        aligner->counts[j] = 0;
+    }
+    if (aligner->sampleCount == 0) {
+        return;
+    }
+
+    int tone = aligner->lastLo;
+    for (int j = aligner->lastLo + 1; j <= aligner->lastHi; j++) {
+        if (aligner->totals[j] > aligner->totals[tone]) {
+            tone = j;
+        }
+    }
+    for (int i = aligner->sampleCount - 1; i >= 0 && tone >= 0; i--) {
+        int cell = aligner->offsets[i] + tone - aligner->los[i];
+        scores[tone] += aligner->cellScores[cell];
+        aligner->counts[tone]++;
+        tone = aligner->cellBacks[cell];
+    }
+    for (int j = 0; j < n; j++) {
+        if (aligner->counts[j] > 0) {
+            scores[j] /= aligner->counts[j];
+        }
+    }
+}
@@ -0,0 +1,30 @@
+//
+//  PitchAligner.h
+//  AgoraLyricsScore
+//
+
+#ifndef PitchAligner_h
+#define PitchAligner_h
+
+#include <stdio.h>
+
+// 按行对齐演唱 pitch 与标准字: 带约束的动态时间规整 (DTW)
+// 每个采样对齐到时间相差不超过 bandMs 的某个字, 对齐的字随时间单调不减, 使整行得分之和最大;
+// 得分规则与 pitchScorerHandlePitch + pitchScorerScore 一致, 演唱整体提前或落后不超过 bandMs 时不丢分
+// 每个采样只计算带内的字, 一行的耗时与采样数成线性; 单个实例不可多线程同时使用
+typedef struct PitchAligner PitchAligner;
+
+PitchAligner *pitchAlignerCreate(void);
+void pitchAlignerDestroy(PitchAligner *aligner);
+
+// 开始新的一行, 丢弃上一行的采样; 字按开始时间排列, 时间单位 ms; 成功返回 0, 内存不足返回 -1
+int pitchAlignerBeginLine(PitchAligner *aligner, const int *beginTimes, const int *endTimes, const double *stdPitches,
+                          int toneCount, int bandMs, int scoreLevel, int scoreCompensationOffset);
+// 加入一个采样, progress 为歌曲进度 (ms); 无声或不在任何字的带内时忽略; 成功返回 0, 内存不足返回 -1
+int pitchAlignerAddPitch(PitchAligner *aligner, int progress, double voicePitch);
+// 本行已加入的有效采样个数
+int pitchAlignerSampleCount(const PitchAligner *aligner);
+// 回溯最优对齐, scores[i] 为对齐到第 i 个字的采样的平均分, 没有采样的字为 0
+void pitchAlignerToneScores(PitchAligner *aligner, float *scores);
+
+#endif /* PitchAligner_h */
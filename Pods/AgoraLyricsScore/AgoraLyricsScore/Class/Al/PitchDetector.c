@@ -0,0 +1,341 @@
+//
+//  PitchDetector.c
+//  AgoraLyricsScore
+//
+
+#include "PitchDetector.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 降采样后的目标采样率, 人声基频和前几个泛音都在 8kHz 以内
+#define ANALYSIS_RATE 16000
+// 分析窗长 (ms)
+#define WINDOW_MS 20
+// YIN 累积均值归一化差分的阈值, 越小越不容易把噪声判为人声
+#define YIN_THRESHOLD 0.15
+// 静音门限, 分析窗 RMS 低于此值 (约 -50dBFS) 直接输出 0
+#define SILENCE_RMS 0.003
+
+struct PitchDetector {
+    // 输入采样率, 0 表示未配置
+    int sampleRate;
+    // 降采样倍数, 相邻 decimation 个采样取平均
+    int decimation;
+    double analysisRate;
+    // 分析窗长 W, 搜索的周期范围 [tauMin, tauMax], 每次分析需要 frameSize = W + tauMax + 2 个采样
+    int windowSize;
+    int tauMin;
+    int tauMax;
+    int frameSize;
+    int fftSize;
+    // 降采样累加
+    float decimationSum;
+    int decimationCount;
+    // 每个输入采样加 100, 满 sampleRate 即过了 10ms
+    int hopAccumulator;
+    // 降采样后的历史采样, 容量 2 * frameSize, 满了把后一半移到前面
+    float *history;
+    int historyLength;
+    // FFT 缓存
+    double *re;
+    double *im;
+    double *outRe;
+    double *outIm;
+    double *cosTable;
+    double *sinTable;
+    int *bitReverse;
+    // 能量前缀和与差分函数
+    double *prefix;
+    double *diff;
+};
+
+static void freeBuffers(PitchDetector *detector) {
+    free(detector->history);
+    free(detector->re);
+    free(detector->im);
+    free(detector->outRe);
+    free(detector->outIm);
+    free(detector->cosTable);
+    free(detector->sinTable);
+    free(detector->bitReverse);
+    free(detector->prefix);
+    free(detector->diff);
+    memset(detector, 0, sizeof(PitchDetector));
+}
+
+static int configure(PitchDetector *detector, int sampleRate) {
+    freeBuffers(detector);
+
+    int decimation = sampleRate / ANALYSIS_RATE;
+    if (decimation < 1) {
+        decimation = 1;
+    }
+    double analysisRate = (double)sampleRate / decimation;
+    int tauMin = (int)floor(analysisRate / PITCH_DETECTOR_MAX_PITCH);
+    int tauMax = (int)ceil(analysisRate / PITCH_DETECTOR_MIN_PITCH);
+    if (tauMin < 2) {
+        tauMin = 2;
+    }
+    int windowSize = (int)(analysisRate * WINDOW_MS / 1000);
+    if (windowSize < tauMax) {
+        windowSize = tauMax;
+    }
+    int frameSize = windowSize + tauMax + 2;
+    int fftSize = 1;
+    int bits = 0;
+    while (fftSize < frameSize) {
+        fftSize <<= 1;
+        bits++;
+    }
+
+    detector->history = malloc(sizeof(float) * 2 * frameSize);
+    detector->re = malloc(sizeof(double) * fftSize);
+    detector->im = malloc(sizeof(double) * fftSize);
+    detector->outRe = malloc(sizeof(double) * fftSize);
+    detector->outIm = malloc(sizeof(double) * fftSize);
+    detector->cosTable = malloc(sizeof(double) * fftSize / 2);
+    detector->sinTable = malloc(sizeof(double) * fftSize / 2);
+    detector->bitReverse = malloc(sizeof(int) * fftSize);
+    detector->prefix = malloc(sizeof(double) * (frameSize + 1));
+    detector->diff = malloc(sizeof(double) * (tauMax + 2));
+    if (detector->history == NULL || detector->re == NULL || detector->im == NULL ||
+        detector->outRe == NULL || detector->outIm == NULL || detector->cosTable == NULL ||
+        detector->sinTable == NULL || detector->bitReverse == NULL || detector->prefix == NULL ||
+        detector->diff == NULL) {
+        freeBuffers(detector);
+        return -1;
+    }
+
+    for (int k = 0; k < fftSize / 2; k++) {
+        detector->cosTable[k] = cos(2 * M_PI * k / fftSize);
+        detector->sinTable[k] = sin(2 * M_PI * k / fftSize);
+    }
+    for (int i = 0; i < fftSize; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        detector->bitReverse[i] = r;
+    }
+
+    detector->sampleRate = sampleRate;
+    detector->decimation = decimation;
+    detector->analysisRate = analysisRate;
+    detector->windowSize = windowSize;
+    detector->tauMin = tauMin;
+    detector->tauMax = tauMax;
+    detector->frameSize = frameSize;
+    detector->fftSize = fftSize;
+    return 0;
+}
+
+PitchDetector *pitchDetectorCreate(void) {
+    return calloc(1, sizeof(PitchDetector));
+}
+
+void pitchDetectorDestroy(PitchDetector *detector) {
+    if (detector == NULL) {
+        return;
+    }
+    freeBuffers(detector);
+    free(detector);
+}
+
+void pitchDetectorReset(PitchDetector *detector) {
+    if (detector == NULL) {
+        return;
+    }
+    detector->decimationSum = 0;
+    detector->decimationCount = 0;
+    detector->hopAccumulator = 0;
+    detector->historyLength = 0;
+}
+
+// 原地基 2 FFT, inverse 时不做 1/n 缩放
+static void fft(const PitchDetector *detector, double *re, double *im, int inverse) {
+    int n = detector->fftSize;
+    for (int i = 0; i < n; i++) {
+        int j = detector->bitReverse[i];
+        if (i < j) {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    for (int size = 2; size <= n; size <<= 1) {
+        int half = size >> 1;
+        int step = n / size;
+        for (int start = 0; start < n; start += size) {
+            for (int j = 0; j < half; j++) {
+                double wr = detector->cosTable[j * step];
+                double wi = inverse ? detector->sinTable[j * step] : -detector->sinTable[j * step];
+                int a = start + j;
+                int b = a + half;
+                double tr = re[b] * wr - im[b] * wi;
+                double ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+// 对最近 frameSize 个采样做一次 YIN, 返回 pitch, 无人声返回 0
+static double analyze(PitchDetector *detector) {
+    int n = detector->fftSize;
+    int w = detector->windowSize;
+    int frameSize = detector->frameSize;
+    int tauMax = detector->tauMax;
+    const float *x = detector->history + detector->historyLength - frameSize;
+    double *re = detector->re;
+    double *im = detector->im;
+    double *prefix = detector->prefix;
+    double *diff = detector->diff;
+
+    double mean = 0;
+    for (int j = 0; j < frameSize; j++) {
+        mean += x[j];
+    }
+    mean /= frameSize;
+
+    /** 实部放窗口 a = x[0, W), 虚部放整帧 b = x[0, frameSize), 一次复数 FFT 得到两者的频谱 **/
+    prefix[0] = 0;
+    for (int j = 0; j < frameSize; j++) {
+        double v = x[j] - mean;
+        re[j] = j < w ? v : 0;
+        im[j] = v;
+        prefix[j + 1] = prefix[j] + v * v;
+    }
+    double energy = prefix[w];
+    if (energy < SILENCE_RMS * SILENCE_RMS * w) {
+        return 0;
+    }
+    for (int j = frameSize; j < n; j++) {
+        re[j] = 0;
+        im[j] = 0;
+    }
+    fft(detector, re, im, 0);
+
+    /** 互相关 r(tau) = sum a[j] * b[j + tau] 的频谱为 conj(A) * B **/
+    for (int k = 0; k < n; k++) {
+        int nk = (n - k) & (n - 1);
+        double ar = (re[k] + re[nk]) * 0.5;
+        double ai = (im[k] - im[nk]) * 0.5;
+        double br = (im[k] + im[nk]) * 0.5;
+        double bi = (re[nk] - re[k]) * 0.5;
+        detector->outRe[k] = ar * br + ai * bi;
+        detector->outIm[k] = ar * bi - ai * br;
+    }
+    fft(detector, detector->outRe, detector->outIm, 1);
+
+    /** 差分函数 d(tau) = sum (a[j] - b[j + tau])^2, 再做累积均值归一化 **/
+    double scale = 1.0 / n;
+    double sum = 0;
+    diff[0] = 1;
+    for (int tau = 1; tau <= tauMax + 1; tau++) {
+        double d = energy + prefix[tau + w] - prefix[tau] - 2 * detector->outRe[tau] * scale;
+        if (d < 0) {
+            d = 0;
+        }
+        sum += d;
+        diff[tau] = sum > 0 ? d * tau / sum : 1;
+    }
+
+    /** 第一个低于阈值的谷 **/
+    int tau = detector->tauMin;
+    while (tau <= tauMax && diff[tau] >= YIN_THRESHOLD) {
+        tau++;
+    }
+    if (tau > tauMax) {
+        return 0;
+    }
+    while (tau < tauMax && diff[tau + 1] < diff[tau]) {
+        tau++;
+    }
+
+    /** 抛物线插值得到小数周期 **/
+    double s0 = diff[tau - 1];
+    double s1 = diff[tau];
+    double s2 = diff[tau + 1];
+    double denominator = s0 - 2 * s1 + s2;
+    double shift = denominator > 0 ? 0.5 * (s0 - s2) / denominator : 0;
+    if (shift > 0.5) {
+        shift = 0.5;
+    }
+    else if (shift < -0.5) {
+        shift = -0.5;
+    }
+    double pitch = detector->analysisRate / (tau + shift);
+    if (pitch < PITCH_DETECTOR_MIN_PITCH || pitch > PITCH_DETECTOR_MAX_PITCH) {
+        return 0;
+    }
+    return pitch;
+}
+
+static void pushSample(PitchDetector *detector, float sample) {
+    if (detector->historyLength == 2 * detector->frameSize) {
+        memmove(detector->history,
+                detector->history + detector->frameSize,
+                sizeof(float) * detector->frameSize);
+        detector->historyLength = detector->frameSize;
+    }
+    detector->history[detector->historyLength++] = sample;
+}
+
+int pitchDetectorMaxPitches(const PitchAudioFrame *frame) {
+    if (frame == NULL || frame->samplesPerSec <= 0 || frame->samplesPerChannel <= 0) {
+        return 0;
+    }
+    int64_t hops = (int64_t)frame->samplesPerChannel * (1000 / PITCH_DETECTOR_HOP_MS);
+    return (int)((hops + frame->samplesPerSec - 1) / frame->samplesPerSec);
+}
+
+int pitchDetectorProcess(PitchDetector *detector, const PitchAudioFrame *frame, double *pitches, int maxPitches) {
+    if (detector == NULL || frame == NULL) {
+        return -1;
+    }
+    if (frame->bytesPerSample != 2 || frame->channels <= 0 || frame->samplesPerSec <= 0 || frame->samplesPerChannel < 0) {
+        return -1;
+    }
+    if (frame->samplesPerChannel > 0 && frame->buffer == NULL) {
+        return -1;
+    }
+    if (frame->samplesPerSec != detector->sampleRate) {
+        if (configure(detector, frame->samplesPerSec) != 0) {
+            return -1;
+        }
+    }
+
+    const int16_t *samples = frame->buffer;
+    int channels = frame->channels;
+    int hopsPerSecond = 1000 / PITCH_DETECTOR_HOP_MS;
+    float gain = 1.0f / 32768 / channels;
+    int count = 0;
+    for (int i = 0; i < frame->samplesPerChannel; i++) {
+        /** 下混为单声道并降采样 **/
+        int mixed = 0;
+        for (int c = 0; c < channels; c++) {
+            mixed += samples[i * channels + c];
+        }
+        detector->decimationSum += mixed * gain;
+        if (++detector->decimationCount == detector->decimation) {
+            pushSample(detector, detector->decimationSum / detector->decimation);
+            detector->decimationSum = 0;
+            detector->decimationCount = 0;
+        }
+
+        detector->hopAccumulator += hopsPerSecond;
+        if (detector->hopAccumulator < detector->sampleRate) {
+            continue;
+        }
+        detector->hopAccumulator -= detector->sampleRate;
+        if (count >= maxPitches) {
+            continue;
+        }
+        pitches[count++] = detector->historyLength < detector->frameSize ? 0 : analyze(detector);
+    }
+    return count;
+}
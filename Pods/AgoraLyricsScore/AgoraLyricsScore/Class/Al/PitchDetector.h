@@ -0,0 +1,40 @@
+//
+//  PitchDetector.h
+//  AgoraLyricsScore
+//
+
+#ifndef PitchDetector_h
+#define PitchDetector_h
+
+#include <stdio.h>
+
+// 字段与 AgoraMediaBase.h 中 IAudioFrameObserverBase::AudioFrame 一致, 只支持 16bit PCM, 多声道为交错排列
+typedef struct PitchAudioFrame {
+    int samplesPerChannel;
+    int bytesPerSample;
+    int channels;
+    int samplesPerSec;
+    const void *buffer;
+} PitchAudioFrame;
+
+// 每 10ms 输出一个 pitch (Hz), 无人声或静音时为 0
+#define PITCH_DETECTOR_HOP_MS 10
+// 可检测的 pitch 范围 (Hz)
+#define PITCH_DETECTOR_MIN_PITCH 65
+#define PITCH_DETECTOR_MAX_PITCH 1100
+
+// 基于 YIN 的实时音高检测, 差分函数用 FFT 自相关计算; 单个实例不可多线程同时使用
+typedef struct PitchDetector PitchDetector;
+
+PitchDetector *pitchDetectorCreate(void);
+void pitchDetectorDestroy(PitchDetector *detector);
+// 清空缓存的采样, 切歌或采样中断后调用
+void pitchDetectorReset(PitchDetector *detector);
+
+// 输入一帧采样, 返回本帧产生的 pitch 个数, 格式不支持或内存不足时返回 -1
+// pitches 的长度不小于 pitchDetectorMaxPitches(frame), 超出 maxPitches 的部分丢弃
+// 采样率变化时自动清空缓存的采样
+int pitchDetectorProcess(PitchDetector *detector, const PitchAudioFrame *frame, double *pitches, int maxPitches);
+int pitchDetectorMaxPitches(const PitchAudioFrame *frame);
+
+#endif /* PitchDetector_h */
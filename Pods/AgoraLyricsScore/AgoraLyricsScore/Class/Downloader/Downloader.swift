@@ -12,11 +12,13 @@ import UIKit
 typealias DownloadProgressClosure = ((_ progress:Float)->Void)
 typealias DownloadCompletionClosure = ((_ filePath: String)->Void)
 typealias DownloadFailClosure = ((_ error: DownloadError)-> Void)
+typealias DownloadDataClosure = ((_ data: Data)->Void)
 
 class Downloader: NSObject {
     private var fail: DownloadFailClosure?
     private var completion: DownloadCompletionClosure?
     private var progress: DownloadProgressClosure?
+    private var dataReceived: DownloadDataClosure?
     private var downloadUrl: URL?
     private var localUrl: URL?
     private var downloadSession: URLSession?
@@ -39,9 +41,11 @@ class Downloader: NSObject {
     }
   
     // 开始下载
-    func download(url: URL, progress: @escaping DownloadProgressClosure, completion: @escaping DownloadCompletionClosure, fail: @escaping DownloadFailClosure) {
+    /// - Parameter dataReceived: called with each chunk as it arrives, on the session delegate queue
+    func download(url: URL, progress: @escaping DownloadProgressClosure, dataReceived: DownloadDataClosure? = nil, completion: @escaping DownloadCompletionClosure, fail: @escaping DownloadFailClosure) {
         logTag += "[\(url.lastPathComponent)]"
         self.progress = progress
+        self.dataReceived = dataReceived
         self.completion = completion
         self.fail = fail
         self.downloadUrl = url
@@ -86,6 +90,7 @@ class Downloader: NSObject {
         fail = nil
         completion = nil
         progress = nil
+        dataReceived = nil
     }
 }
 
@@ -125,6 +130,7 @@ extension Downloader: URLSessionDataDelegate {
             guard let baseAddress = bufferPointer.baseAddress else { return }
             self.fileOutputStream?.write(baseAddress, maxLength: bufferPointer.count)
         }
+        dataReceived?(data)
         currentLength += Float(data.count)
         // 这里有个问题 有些自己做的数据返回 header里面没有length 那就无法计算进度
         let totalLength = Float(dataTask.response?.expectedContentLength ?? -1)
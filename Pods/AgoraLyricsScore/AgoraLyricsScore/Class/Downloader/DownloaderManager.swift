@@ -27,6 +27,7 @@ class DownloaderManager: NSObject {
     
     func download(url: URL,
                   progress: @escaping DownloadProgressClosure,
+                  dataReceived: DownloadDataClosure? = nil,
                   completion: @escaping DownloadCompletionClosure,
                   fail: @escaping DownloadFailClosure)  {
         self.failback = fail
@@ -42,7 +43,7 @@ class DownloaderManager: NSObject {
         }
         downloader = Downloader()
         downloadCache.set(value: downloader!, forkey: url.absoluteString)
-        downloader?.download(url: url, progress: progress, completion: { [weak self](filePath) in
+        downloader?.download(url: url, progress: progress, dataReceived: dataReceived, completion: { [weak self](filePath) in
             guard let self = self else {
                 return
             }
@@ -31,6 +31,9 @@ class FileCache {
         var fileForMinCreationTime: ExistedFile?
         let currentTime = Date().timeIntervalSince1970
         
+        /** 编译的二进制歌词只按存活时间清理, 不占文件数量 **/
+        let sourceCount = files.filter({ !$0.isCompiledLyric }).count
+        
         for file in files { /** remove out date one **/
             let gap = UInt(currentTime - file.createdTimeStamp)
             let maxAge = UInt(maxFileAge)
@@ -43,7 +46,7 @@ class FileCache {
                     Log.error(error: "removeFilesIfNeed error \(error.localizedDescription)", tag: logTag)
                 }
             }
-            else {
+            else if !file.isCompiledLyric {
                 if let currentFileForMinCreationTime = fileForMinCreationTime {
                     fileForMinCreationTime = currentFileForMinCreationTime.createdTimeStamp <= file.createdTimeStamp ? currentFileForMinCreationTime : file
                 }
@@ -54,7 +57,7 @@ class FileCache {
         }
         
         /// remove earliest one
-        if files.count > maxFileNum,
+        if sourceCount > maxFileNum,
            !hasFileBeRemove,
             let currentFileForMinCreationTime = fileForMinCreationTime {
             do {
@@ -134,5 +137,9 @@ extension FileCache {
     struct ExistedFile {
         let path: String
         let createdTimeStamp: Double
+        
+        var isCompiledLyric: Bool {
+            return path.hasSuffix("." + LyricBinary.pathExtension)
+        }
     }
 }
@@ -120,15 +120,41 @@ public class LyricsFileDownloader: NSObject {
             _resumeTaskIfNeeded()
             return
         }
+        /** xml type: unzip while downloading, the xml is usually ready before the central directory arrives **/
+        var streamReader: ZipStreamReader?
+        var streamUnzipped = false
+        if url.pathExtension == "zip" {
+            let fileName = urlString.fileName.components(separatedBy: ".").first ?? ""
+            streamReader = try? ZipStreamReader { [weak self] entryName, data in
+                guard let self = self, entryName == fileName + ".xml", !streamUnzipped else {
+                    return
+                }
+                streamUnzipped = true
+                self.queue.async { [weak self] in
+                    self?._lyricsUnzipped(data: data, fileName: fileName, requestId: requestId)
+                }
+            }
+        }
         downloaderManager.download(url: url) { [weak self](progress) in
             guard let self = self else {
                 return
             }
             self.invokeOnLyricsFileDownloadProgress(requestId: requestId, progress: progress)
+        } dataReceived: { [weak self](data) in
+            do {
+                try streamReader?.append(data)
+            } catch let error {
+                /** fall back to unzip the downloaded file **/
+                Log.errorText(text: "stream unzip requestId:\(requestId) failed: \(error.localizedDescription)", tag: self?.logTag ?? "")
+                streamReader = nil
+            }
         } completion: { [weak self](filePath) in
             guard let self = self else {
                 return
             }
+            if streamUnzipped {
+                return
+            }
             if filePath.split(separator: ".").last == "lrc" { /** lrc type **/
                 let url = URL(fileURLWithPath: filePath)
                 var data: Data?
@@ -157,6 +183,9 @@ public class LyricsFileDownloader: NSObject {
                     let logText = "get data from [\(url.path)] failed: \(error.localizedDescription)"
                     Log.errorText(text: logText, tag: self.logTag)
                 }
+                if let data = data {
+                    LyricBinary.compile(source: data)
+                }
                 
                 self.invokeOnLyricsFileDownloadCompleted(requestId: requestId,
                                                     fileData: data,
@@ -167,7 +196,7 @@ public class LyricsFileDownloader: NSObject {
             /** xml type **/
             self.unzip(filePath: filePath, requestId: requestId)
         } fail: { [weak self](error) in
-            guard let self = self else {
+            guard let self = self, !streamUnzipped else {
                 return
             }
             self.removeRequest(id: requestId)
@@ -212,10 +241,13 @@ public class LyricsFileDownloader: NSObject {
         let zipFile = URL(fileURLWithPath: filePath)
         let destination = URL(fileURLWithPath: .cacheFolderPath())
         do {
-            try Zip.unzipFile(zipFile, destination: destination, overwrite: true, password: nil)
-            let path = destination.path + "/" + fileName + ".xml"
-            let url = URL(fileURLWithPath: path)
-            let data = try Data(contentsOf: url)
+            /** unzip in memory, only the xml is written back for the local cache **/
+            let zipData = try Data(contentsOf: zipFile, options: .alwaysMapped)
+            let entries = try Zip.unzipData(zipData)
+            guard let data = entries[fileName + ".xml"] else {
+                throw ZipError.fileNotFound
+            }
+            try _saveLyrics(data: data, fileName: fileName, destination: destination)
             removeRequest(id: requestId)
             resumeTaskIfNeeded()
             invokeOnLyricsFileDownloadCompleted(requestId: requestId,
@@ -233,6 +265,31 @@ public class LyricsFileDownloader: NSObject {
         }
     }
     
+    /// xml unzipped while downloading
+    private func _lyricsUnzipped(data: Data, fileName: String, requestId: Int) {
+        guard requestIdDict[requestId] != nil else { /** canceled **/
+            return
+        }
+        let destination = URL(fileURLWithPath: .cacheFolderPath())
+        do {
+            try _saveLyrics(data: data, fileName: fileName, destination: destination)
+        } catch let error {
+            /** the lyrics are still usable, only the local cache misses them **/
+            Log.errorText(text: "save xml requestId:\(requestId) failed: \(error.localizedDescription)", tag: logTag)
+        }
+        _removeRequest(id: requestId)
+        _resumeTaskIfNeeded()
+        invokeOnLyricsFileDownloadCompleted(requestId: requestId,
+                                            fileData: data,
+                                            error: nil)
+    }
+    
+    private func _saveLyrics(data: Data, fileName: String, destination: URL) throws {
+        FileManager.createDirectoryIfNeeded(atPath: destination.path)
+        try data.write(to: destination.appendingPathComponent(fileName + ".xml"))
+        LyricBinary.compile(source: data)
+    }
+    
     private func genId() -> RequestId {
         let id = currentRequestId
         currentRequestId = currentRequestId == Int.max ? 0 : currentRequestId + 1
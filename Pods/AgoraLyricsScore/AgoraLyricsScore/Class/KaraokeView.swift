@@ -140,6 +140,27 @@ extension KaraokeView {
         }
     }
     
+    /// 设置实时采集(mic)的音频帧, 内部每 10ms 检测一个Pitch并打分, 代替 `setPitch(pitch:)`
+    /// - Note: 可以从AgoraRTC回调方法 `- (BOOL)onRecordAudioFrame:(AgoraAudioFrame* _Nonnull)frame channelId:(NSString * _Nonnull)channelId` 获取, 需先调用 `setRecordingAudioFrameParameters`
+    /// - Note: 可在音频回调线程直接调用, 不要与 `setPitch(pitch:)` 同时使用
+    /// - Parameters:
+    ///   - buffer: 16bit PCM 数据, 多声道为交错排列
+    ///   - samplesPerChannel: 每个声道的采样数
+    ///   - bytesPerSample: 每个采样的字节数, 只支持 2
+    ///   - channels: 声道数
+    ///   - samplesPerSec: 采样率
+    @objc public func setAudioFrame(buffer: UnsafeRawPointer,
+                                    samplesPerChannel: Int,
+                                    bytesPerSample: Int,
+                                    channels: Int,
+                                    samplesPerSec: Int) {
+        scoringView.setAudioFrame(buffer: buffer,
+                                  samplesPerChannel: samplesPerChannel,
+                                  bytesPerSample: bytesPerSample,
+                                  channels: channels,
+                                  samplesPerSec: samplesPerSec)
+    }
+    
     /// 设置当前歌曲的进度
     /// - Note: 可以获取播放器的当前进度进行设置
     /// - Parameter progress: 歌曲进度 (ms)
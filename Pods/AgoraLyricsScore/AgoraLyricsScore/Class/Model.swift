@@ -139,7 +139,9 @@ public class ToneScoreModel: NSObject {
     @objc public let tone: LyricToneModel
     /// 0-100
     @objc public var score: Float
-    var scores = [Float]()
+    /// 累加的分数与次数, score 为其均值
+    var scoreSum: Float = 0
+    var scoreCount = 0
     
     @objc public init(tone: LyricToneModel,
                       score: Float) {
@@ -148,8 +150,32 @@ public class ToneScoreModel: NSObject {
     }
     
     func addScore(score: Float) {
-        scores.append(score)
-        self.score = scores.reduce(0, +) / Float(scores.count)
+        scoreSum += score
+        scoreCount += 1
+        self.score = scoreSum / Float(scoreCount)
+    }
+}
+
+/// 整首歌得分 (ScoreEngine 离线打分结果)
+public class PerformanceScore: NSObject {
+    /// 累计分数, 各行分数之和
+    @objc public let cumulativeScore: Int
+    /// 每行分数 [0, 100]
+    @objc public let lineScores: [Int]
+    /// 每行的字得分
+    @objc public let toneScores: [[ToneScoreModel]]
+    
+    @objc public init(cumulativeScore: Int,
+                      lineScores: [Int],
+                      toneScores: [[ToneScoreModel]]) {
+        self.cumulativeScore = cumulativeScore
+        self.lineScores = lineScores
+        self.toneScores = toneScores
+    }
+    
+    /// 满分, 每行100分
+    @objc public var totalScore: Int {
+        return lineScores.count * 100
     }
 }
 
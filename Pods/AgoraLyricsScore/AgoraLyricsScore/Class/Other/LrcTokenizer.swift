@@ -0,0 +1,47 @@
+//
+//  LrcTokenizer.swift
+//  AgoraLyricsScore
+//
+
+import Foundation
+
+/// LRC 时间标签解析, 规则见 LrcTokenizer.h; LrcParser 与 AUIKitCore 的 AgoraLrcParse 共用
+public enum LrcTokenizer {
+    /// 解析 utf8 的 LRC
+    /// - Returns: 按时间排序的 (开始时间 ms, 歌词)
+    public static func tokenize(data: Data) -> [(beginTime: Int, text: String)] {
+        return data.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) in
+            return tokenize(bytes: bytes)
+        }
+    }
+
+    /// 解析 LRC 字符串
+    /// - Returns: 按时间排序的 (开始时间 ms, 歌词)
+    public static func tokenize(string: String) -> [(beginTime: Int, text: String)] {
+        var string = string
+        return string.withUTF8 { (bytes: UnsafeBufferPointer<UInt8>) in
+            return tokenize(bytes: UnsafeRawBufferPointer(bytes))
+        }
+    }
+
+    private static func tokenize(bytes: UnsafeRawBufferPointer) -> [(beginTime: Int, text: String)] {
+        guard let base = bytes.baseAddress?.assumingMemoryBound(to: CChar.self), bytes.count > 0 else {
+            return []
+        }
+        let capacity = lrcTokenCapacityC(base, bytes.count)
+        if capacity == 0 {
+            return []
+        }
+        var tokens = [LrcTokenLine](repeating: LrcTokenLine(), count: capacity)
+        let count = lrcTokenizeC(base, bytes.count, &tokens, capacity)
+        var result = [(beginTime: Int, text: String)]()
+        result.reserveCapacity(count)
+        for token in tokens[0..<count] {
+            let start = Int(token.textOffset)
+            let text = String(decoding: UnsafeRawBufferPointer(rebasing: bytes[start..<start + Int(token.textLength)]),
+                              as: UTF8.self)
+            result.append((beginTime: Int(token.beginTime), text: text))
+        }
+        return result
+    }
+}
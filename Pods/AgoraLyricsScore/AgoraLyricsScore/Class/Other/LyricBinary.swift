@@ -0,0 +1,269 @@
+//
+//  LyricBinary.swift
+//  AgoraLyricsScore
+//
+
+import Foundation
+
+/// 歌词的紧凑二进制格式, 下载时由 xml/lrc 编译一次, 之后加载时直接映射文件, 不再解析 xml
+/// - Note: 布局 (小端): 72 字节头, 行/字的各字段分别连续存放 (struct of arrays), 最后是 utf8 字符串池;
+///         每段按 8 字节对齐, 头中记录源文件的长度和 hash, 源文件不同即视为未命中
+enum LyricBinary {
+    private static let magic: UInt32 = 0x42594C41 /** "ALYB" **/
+    private static let version: UInt32 = 2
+    private static let headerSize = 72
+    private static let logTag = "LyricBinary"
+    /// 缓存文件扩展名, FileCache 按此区分源文件与编译结果
+    static let pathExtension = "lyb"
+
+    /// 各段在文件中的偏移
+    private struct Layout {
+        let lineBegins: Int
+        let lineDurations: Int
+        let lineFirstTones: Int
+        let lineContents: Int
+        let toneBegins: Int
+        let toneDurations: Int
+        let tonePitches: Int
+        let toneLangs: Int
+        let toneWords: Int
+        let tonePronounces: Int
+        let pool: Int
+        let size: Int
+
+        init(lineCount: Int, toneCount: Int, poolSize: Int) {
+            var offset = LyricBinary.headerSize
+            func section(_ size: Int) -> Int {
+                let start = offset
+                offset = (offset + size + 7) & ~7
+                return start
+            }
+            lineBegins = section(4 * lineCount)
+            lineDurations = section(4 * lineCount)
+            lineFirstTones = section(4 * (lineCount + 1))
+            lineContents = section(8 * lineCount)
+            toneBegins = section(4 * toneCount)
+            toneDurations = section(4 * toneCount)
+            tonePitches = section(8 * toneCount)
+            toneLangs = section(4 * toneCount)
+            toneWords = section(8 * toneCount)
+            tonePronounces = section(8 * toneCount)
+            pool = offset
+            size = offset + poolSize
+        }
+    }
+
+    // MARK: - Cache
+
+    /// 源文件对应的二进制缓存路径, 与源文件同在缓存目录
+    static func cachePath(sourceHash: UInt64) -> String {
+        return String.cacheFolderPath() + "/" + String(format: "%016llx.", sourceHash) + pathExtension
+    }
+
+    /// 编译源文件并写入缓存, 下载完成时调用
+    static func compile(source: Data) {
+        guard let first = source.first, first == UInt8(ascii: "<") || first == UInt8(ascii: "[") else {
+            return
+        }
+        guard let model = Parser().parseLyricData(data: source) else {
+            return
+        }
+        let sourceHash = hash(data: source)
+        let data = encode(model: model, sourceLength: source.count, sourceHash: sourceHash)
+        do {
+            FileManager.createDirectoryIfNeeded(atPath: .cacheFolderPath())
+            try data.write(to: URL(fileURLWithPath: cachePath(sourceHash: sourceHash)), options: .atomic)
+        } catch let error {
+            Log.errorText(text: "write binary lyric failed: \(error.localizedDescription)", tag: logTag)
+        }
+    }
+
+    /// 读取源文件的二进制缓存, 未命中或文件损坏时返回nil
+    static func load(source: Data) -> LyricModel? {
+        let sourceHash = hash(data: source)
+        let path = cachePath(sourceHash: sourceHash)
+        guard FileManager.default.fileExists(atPath: path),
+              let data = try? Data(contentsOf: URL(fileURLWithPath: path), options: .alwaysMapped) else {
+            return nil
+        }
+        let model = decode(data: data, sourceLength: source.count, sourceHash: sourceHash)
+        if model == nil {
+            Log.errorText(text: "invalid binary lyric: \(path.fileName)", tag: logTag)
+            try? FileManager.default.removeItem(atPath: path)
+        }
+        return model
+    }
+
+    /// FNV-1a
+    static func hash(data: Data) -> UInt64 {
+        return data.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) -> UInt64 in
+            var value: UInt64 = 0xcbf29ce484222325
+            for byte in bytes {
+                value = (value ^ UInt64(byte)) &* 0x100000001b3
+            }
+            return value
+        }
+    }
+
+    // MARK: - Encode
+
+    static func encode(model: LyricModel, sourceLength: Int, sourceHash: UInt64) -> Data {
+        var pool = [UInt8]()
+        var poolIndex = [String : (UInt32, UInt32)]()
+        func intern(_ string: String) -> (UInt32, UInt32) {
+            if let ref = poolIndex[string] {
+                return ref
+            }
+            let ref = (UInt32(pool.count), UInt32(string.utf8.count))
+            pool.append(contentsOf: string.utf8)
+            poolIndex[string] = ref
+            return ref
+        }
+
+        let lines = model.lines
+        let toneCount = lines.reduce(0, { $0 + $1.tones.count })
+        let name = intern(model.name)
+        let singer = intern(model.singer)
+        let contents = lines.map({ intern($0.content) })
+        var words = [(UInt32, UInt32)]()
+        var pronounces = [(UInt32, UInt32)]()
+        words.reserveCapacity(toneCount)
+        pronounces.reserveCapacity(toneCount)
+        for line in lines {
+            for tone in line.tones {
+                words.append(intern(tone.word))
+                pronounces.append(intern(tone.pronounce))
+            }
+        }
+
+        let layout = Layout(lineCount: lines.count, toneCount: toneCount, poolSize: pool.count)
+        var data = Data(count: layout.size)
+        data.withUnsafeMutableBytes { (bytes: UnsafeMutableRawBufferPointer) in
+            func put<T: FixedWidthInteger>(_ value: T, _ offset: Int) {
+                bytes.storeBytes(of: value.littleEndian, toByteOffset: offset, as: T.self)
+            }
+            func putString(_ ref: (UInt32, UInt32), _ offset: Int) {
+                put(ref.0, offset)
+                put(ref.1, offset + 4)
+            }
+            put(magic, 0)
+            put(version, 4)
+            put(UInt64(sourceLength), 8)
+            put(sourceHash, 16)
+            put(Int32(model.type.rawValue), 24)
+            put(UInt32(model.hasPitch ? 1 : 0), 28)
+            put(Int32(clamping: model.preludeEndPosition), 32)
+            put(Int32(clamping: model.duration), 36)
+            put(UInt32(lines.count), 40)
+            put(UInt32(toneCount), 44)
+            put(UInt32(pool.count), 48)
+            putString(name, 56)
+            putString(singer, 64)
+
+            var toneIndex = 0
+            for (index, line) in lines.enumerated() {
+                put(Int32(clamping: line.beginTime), layout.lineBegins + 4 * index)
+                put(Int32(clamping: line.duration), layout.lineDurations + 4 * index)
+                put(UInt32(toneIndex), layout.lineFirstTones + 4 * index)
+                putString(contents[index], layout.lineContents + 8 * index)
+                for tone in line.tones {
+                    put(Int32(clamping: tone.beginTime), layout.toneBegins + 4 * toneIndex)
+                    put(Int32(clamping: tone.duration), layout.toneDurations + 4 * toneIndex)
+                    put(tone.pitch.bitPattern, layout.tonePitches + 8 * toneIndex)
+                    put(Int32(tone.lang.rawValue), layout.toneLangs + 4 * toneIndex)
+                    putString(words[toneIndex], layout.toneWords + 8 * toneIndex)
+                    putString(pronounces[toneIndex], layout.tonePronounces + 8 * toneIndex)
+                    toneIndex += 1
+                }
+            }
+            put(UInt32(toneIndex), layout.lineFirstTones + 4 * lines.count)
+            if !pool.isEmpty {
+                bytes.baseAddress!.advanced(by: layout.pool).copyMemory(from: pool, byteCount: pool.count)
+            }
+        }
+        return data
+    }
+
+    // MARK: - Decode
+
+    static func decode(data: Data, sourceLength: Int, sourceHash: UInt64) -> LyricModel? {
+        return data.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) -> LyricModel? in
+            guard bytes.count >= headerSize else {
+                return nil
+            }
+            func get<T: FixedWidthInteger>(_ offset: Int, as type: T.Type) -> T {
+                var value: T = 0
+                withUnsafeMutableBytes(of: &value) { $0.copyMemory(from: UnsafeRawBufferPointer(rebasing: bytes[offset..<offset + MemoryLayout<T>.size])) }
+                return T(littleEndian: value)
+            }
+            guard get(0, as: UInt32.self) == magic,
+                  get(4, as: UInt32.self) == version,
+                  get(8, as: UInt64.self) == UInt64(sourceLength),
+                  get(16, as: UInt64.self) == sourceHash else {
+                return nil
+            }
+
+            let lineCount = Int(get(40, as: UInt32.self))
+            let toneCount = Int(get(44, as: UInt32.self))
+            let poolSize = Int(get(48, as: UInt32.self))
+            let layout = Layout(lineCount: lineCount, toneCount: toneCount, poolSize: poolSize)
+            guard layout.size == bytes.count else {
+                return nil
+            }
+            func string(_ offset: Int) -> String? {
+                let start = Int(get(offset, as: UInt32.self))
+                let length = Int(get(offset + 4, as: UInt32.self))
+                guard start + length <= poolSize else {
+                    return nil
+                }
+                let begin = layout.pool + start
+                return String(decoding: UnsafeRawBufferPointer(rebasing: bytes[begin..<begin + length]), as: UTF8.self)
+            }
+
+            guard let name = string(56), let singer = string(64) else {
+                return nil
+            }
+            var lines = [LyricLineModel]()
+            lines.reserveCapacity(lineCount)
+            var toneIndex = Int(get(layout.lineFirstTones, as: UInt32.self))
+            for index in 0..<lineCount {
+                let toneEnd = Int(get(layout.lineFirstTones + 4 * (index + 1), as: UInt32.self))
+                guard toneIndex <= toneEnd, toneEnd <= toneCount,
+                      let content = string(layout.lineContents + 8 * index) else {
+                    return nil
+                }
+                var tones = [LyricToneModel]()
+                tones.reserveCapacity(toneEnd - toneIndex)
+                while toneIndex < toneEnd {
+                    guard let word = string(layout.toneWords + 8 * toneIndex),
+                          let pronounce = string(layout.tonePronounces + 8 * toneIndex) else {
+                        return nil
+                    }
+                    let pitch = Double(bitPattern: get(layout.tonePitches + 8 * toneIndex, as: UInt64.self))
+                    let lang = Lang(rawValue: Int(get(layout.toneLangs + 4 * toneIndex, as: Int32.self))) ?? .unknown
+                    tones.append(LyricToneModel(beginTime: Int(get(layout.toneBegins + 4 * toneIndex, as: Int32.self)),
+                                                duration: Int(get(layout.toneDurations + 4 * toneIndex, as: Int32.self)),
+                                                word: word,
+                                                pitch: pitch,
+                                                lang: lang,
+                                                pronounce: pronounce))
+                    toneIndex += 1
+                }
+                lines.append(LyricLineModel(beginTime: Int(get(layout.lineBegins + 4 * index, as: Int32.self)),
+                                            duration: Int(get(layout.lineDurations + 4 * index, as: Int32.self)),
+                                            content: content,
+                                            tones: tones))
+            }
+            guard let type = MusicType(rawValue: Int(get(24, as: Int32.self))) else {
+                return nil
+            }
+            return LyricModel(name: name,
+                              singer: singer,
+                              type: type,
+                              lines: lines,
+                              preludeEndPosition: Int(get(32, as: Int32.self)),
+                              duration: Int(get(36, as: Int32.self)),
+                              hasPitch: get(28, as: UInt32.self) != 0)
+        }
+    }
+}
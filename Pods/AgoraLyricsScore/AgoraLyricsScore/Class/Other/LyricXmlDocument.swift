@@ -0,0 +1,73 @@
+//
+//  LyricXmlDocument.swift
+//  AgoraLyricsScore
+//
+
+import Foundation
+
+/// 咪咕 xml 歌词的解析结果, 规则见 LyricXmlParser.h; XmlParser 与 AUIKitCore 的 AgoraMiguXmlLrcParse 共用
+/// - Note: 文本在 C 侧已去重, 同一偏移只创建一次 String
+public final class LyricXmlDocument {
+    private let xml: UnsafeMutablePointer<LyricXml>
+    private var strings = [Int32 : String]()
+
+    /// 解析 utf8 的 xml, 格式错误或没有 <song> 时返回nil
+    public init?(data: Data) {
+        let xml = data.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) -> UnsafeMutablePointer<LyricXml>? in
+            guard let base = bytes.baseAddress?.assumingMemoryBound(to: CChar.self) else {
+                return nil
+            }
+            return lyricXmlParseC(base, bytes.count)
+        }
+        guard let xml = xml else {
+            return nil
+        }
+        self.xml = xml
+    }
+
+    deinit {
+        lyricXmlDestroyC(xml)
+    }
+
+    public var name: String {
+        return string(offset: xml.pointee.nameOffset, length: xml.pointee.nameLength)
+    }
+
+    public var singer: String {
+        return string(offset: xml.pointee.singerOffset, length: xml.pointee.singerLength)
+    }
+
+    /// <type> 的值, 缺失或不是整数时为 0
+    public var type: Int {
+        return Int(xml.pointee.type)
+    }
+
+    /// 每一句的字在 tone(at:) 中的下标范围, <overlap> 为只有一个字的句子
+    public var sentences: [Range<Int>] {
+        let sentences = UnsafeBufferPointer(start: xml.pointee.sentences, count: Int(xml.pointee.sentenceCount))
+        return sentences.map { Int($0.firstTone)..<Int($0.firstTone + $0.toneCount) }
+    }
+
+    /// 时间单位 ms, lang 为 1 (中文), 2 (英文) 或 -1 (未知)
+    public func tone(at index: Int) -> LyricXmlTone {
+        return xml.pointee.tones[index]
+    }
+
+    public func word(of tone: LyricXmlTone) -> String {
+        return string(offset: tone.wordOffset, length: tone.wordLength)
+    }
+
+    public func pronounce(of tone: LyricXmlTone) -> String {
+        return string(offset: tone.pronounceOffset, length: tone.pronounceLength)
+    }
+
+    private func string(offset: Int32, length: Int32) -> String {
+        if let string = strings[offset] {
+            return string
+        }
+        let bytes = UnsafeRawBufferPointer(start: xml.pointee.arena.advanced(by: Int(offset)), count: Int(length))
+        let string = String(decoding: bytes, as: UTF8.self)
+        strings[offset] = string
+        return string
+    }
+}
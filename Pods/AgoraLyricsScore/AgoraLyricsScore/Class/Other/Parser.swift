@@ -15,6 +15,11 @@ class Parser {
             return nil
         }
         
+        /** 下载时编译过的直接映射加载 **/
+        if let model = LyricBinary.load(source: data) {
+            return model
+        }
+        
         guard let string = String(data: data, encoding: .utf8) else {
             Log.errorText(text: "can not verified file type", tag: logTag)
             return nil
@@ -9,7 +9,6 @@ import Foundation
 
 class XmlParser: NSObject {
     fileprivate let logTag = "XmlParser"
-    fileprivate var parserTypes: [ParserType] = []
     fileprivate var song: LyricModel!
     
     deinit {
@@ -18,20 +17,26 @@ class XmlParser: NSObject {
     
     func parseLyricData(data: Data) -> LyricModel? {
         song = nil
-        parserTypes = []
-        let parser = XMLParser(data: data)
-        parser.delegate = self
-        let success = parser.parse()
-        if !success {
-            let error = parser.parserError
-            let line = parser.lineNumber
-            let col = parser.columnNumber
-            Log.error(error: "parsing Error(\(error?.localizedDescription ?? "")) at \(line):\(col)", tag: logTag)
+        guard let document = LyricXmlDocument(data: data) else {
+            Log.error(error: "parsing Error", tag: logTag)
             return nil
         }
         
-        if song == nil {
-            return nil
+        song = LyricModel()
+        song.name = document.name
+        song.singer = document.singer
+        song.type = MusicType(rawValue: document.type) ?? .fast
+        song.lines = document.sentences.map { range -> LyricLineModel in
+            let tones = range.map { index -> LyricToneModel in
+                let tone = document.tone(at: index)
+                return LyricToneModel(beginTime: Int(tone.beginTime),
+                                      duration: Int(tone.endTime - tone.beginTime),
+                                      word: document.word(of: tone),
+                                      pitch: Double(tone.pitch),
+                                      lang: Lang(rawValue: Int(tone.lang)) ?? .unknown,
+                                      pronounce: document.pronounce(of: tone))
+            }
+            return LyricLineModel(beginTime: -1, duration: -1, content: "", tones: tones)
         }
         
         return process()
@@ -86,184 +91,3 @@ class XmlParser: NSObject {
         return song
     }
 }
-
-// MARK: - 状态
-extension XmlParser {
-    fileprivate func current(type: ParserType) -> Bool {
-        return parserTypes.last == type
-    }
-    
-    fileprivate func push(_ type: ParserType) {
-        parserTypes.append(type)
-    }
-    
-    fileprivate func pop() {
-        parserTypes.removeLast()
-    }
-    
-    fileprivate func pop(equal: ParserType) {
-        if current(type: equal) {
-            pop()
-        }
-    }
-}
-
-// MARK: - XMLParserDelegate
-extension XmlParser: XMLParserDelegate {
-    func parserDidStartDocument(_: XMLParser) {}
-    
-    func parserDidEndDocument(_: XMLParser) {}
-    
-    func parser(_: XMLParser, parseErrorOccurred parseError: Error) {
-        Log.error(error: parseError.localizedDescription, tag: logTag)
-    }
-    
-    func parser(_: XMLParser, validationErrorOccurred validationError: Error) {
-        Log.error(error: validationError.localizedDescription, tag: logTag)
-    }
-    
-    func parser(_: XMLParser,
-                didStartElement elementName: String,
-                namespaceURI _: String?,
-                qualifiedName _: String?,
-                attributes attributeDict: [String: String] = [:]) {
-        switch elementName {
-        case "song":
-            song = LyricModel()
-        case "general":
-            push(.general)
-        case "name":
-            push(.name)
-        case "singer":
-            push(.singer)
-        case "type":
-            push(.type)
-        case "sentence":
-            push(.sentence)
-            let line = LyricLineModel(beginTime: -1, duration: -1, content: "", tones: [])
-            song.lines.append(line)
-        case "tone":
-            push(.tone)
-            if let sentence = song.lines.last {
-                let beginValue = Double(attributeDict["begin"] ?? "0") ?? 0
-                let endValue = Double(attributeDict["end"] ?? "0") ?? 0
-                let pitchValue = Float(attributeDict["pitch"] ?? "0") ?? 0
-                let begin = Int(beginValue * 1000)
-                let end = Int(endValue * 1000)
-                let pitch = Double(pitchValue)
-                let pronounce = attributeDict["pronounce"] ?? ""
-                let langValue = Int(attributeDict["lang"] ?? "") ?? -1
-                let lang = Lang(rawValue: langValue)!
-                let tone = LyricToneModel(beginTime: begin,
-                                          duration: end - begin,
-                                          word: "",
-                                          pitch: pitch,
-                                          lang: lang,
-                                          pronounce: pronounce)
-                sentence.tones.append(tone)
-            }
-        case "word":
-            push(.word)
-        case "overlap":
-            push(.overlap)
-            let beginValue = Double(attributeDict["begin"] ?? "0") ?? 0
-            let endValue = Double(attributeDict["end"] ?? "0") ?? 0
-            let begin = Int(beginValue * 1000)
-            let end = Int(endValue * 1000)
-            let pitch: Double = 0
-            let pronounce = ""
-            let langValue = Int(attributeDict["lang"] ?? "") ?? -1
-            let lang = Lang(rawValue: langValue)!
-            let tone = LyricToneModel(beginTime: begin,
-                                      duration: end - begin,
-                                      word: "",
-                                      pitch: pitch,
-                                      lang: lang,
-                                      pronounce: pronounce)
-            let line = LyricLineModel(beginTime: 0, duration: 0, content: "", tones: [tone])
-            song.lines.append(line)
-        default:
-            break
-        }
-    }
-    
-    func parser(_: XMLParser, foundCharacters string: String) {
-        if let last = parserTypes.last {
-            switch last {
-            case .name:
-                song.name = string
-//                if song.name != nil {
-//                    song.name += string
-//                }
-//                else {
-//                    song.name = string
-//                }
-            case .singer:
-                song.singer = string
-            case .type:
-                if let value = Int(string) {
-                    song.type = MusicType(rawValue: value) ?? .fast
-                }
-                else {
-                    song.type = .fast
-                }
-            case .word, .overlap:
-                if let tone = song.lines.last?.tones.last {
-                    tone.word = tone.word + string
-                    if tone.lang == .unknown { /** 补偿语言 **/
-                        do {
-                            let regular = try NSRegularExpression(pattern: "[a-zA-Z]", options: .caseInsensitive)
-                            let count = regular.numberOfMatches(in: tone.word, options: .anchored, range: NSRange(location: 0, length: tone.word.count))
-                            if count > 0 {
-                                tone.lang = .en
-                            } else {
-                                tone.lang = .zh
-                            }
-                        } catch {
-                            tone.lang = .en
-                        }
-                    }
-                }
-            default:
-                break
-            }
-        }
-    }
-    
-    func parser(_: XMLParser,
-                didEndElement elementName: String,
-                namespaceURI _: String?,
-                qualifiedName _: String?) {
-        switch elementName {
-        case "general":
-            pop(equal: .general)
-        case "name":
-            pop(equal: .name)
-        case "singer":
-            pop(equal: .singer)
-        case "type":
-            pop(equal: .type)
-        case "sentence":
-            pop(equal: .sentence)
-        case "tone":
-            pop(equal: .tone)
-        case "word":
-            pop(equal: .word)
-        case "overlap":
-            pop(equal: .overlap)
-        default:
-            break
-        }
-    }
-}
-
-private enum ParserType {
-    case general
-    case name
-    case singer
-    case type
-    case sentence
-    case tone
-    case word
-    case overlap
-}
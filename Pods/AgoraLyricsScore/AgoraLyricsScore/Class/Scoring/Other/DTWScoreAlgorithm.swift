@@ -0,0 +1,78 @@
+//
+//  DTWScoreAlgorithm.swift
+//  AgoraLyricsScore
+//
+
+import Foundation
+
+/// 时间对齐打分: 行结束时用带约束的 DTW 把整行演唱的 pitch 与标准字对齐, 再重新计算字得分
+/// - Note: 默认打分只和进度所在的字比较, 演唱整体落后 150ms 时唱准的字也可能不得分; 本算法在 `bandMs` 内的偏差不丢分
+/// - Note: 通过 `KaraokeView.setScoreAlgorithm` 或 `ScoreEngine.scoreAlgorithm` 使用, 一个实例只能同时给一个对象使用
+public class DTWScoreAlgorithm: NSObject, IScoreAlgorithm {
+    /// 允许演唱提前或落后的最大时间 (ms), 行开始前设置生效
+    @objc public var bandMs = 300
+
+    /// C对齐上下文
+    private let aligner = pitchAlignerCreate()
+    /// 正在对齐的行, 与 getLineScore 传入的字一致时才使用对齐结果
+    private var lineTones = [LyricToneModel]()
+    private var alignedScores = [Float]()
+
+    deinit {
+        pitchAlignerDestroy(aligner)
+    }
+
+    /// 开始对齐新的一行, 丢弃上一行的采样
+    func beginLine(tones: [LyricToneModel], scoreLevel: Int, scoreCompensationOffset: Int) {
+        let beginTimes = tones.map({ Int32($0.beginTime) })
+        let endTimes = tones.map({ Int32($0.endTime) })
+        let stdPitches = tones.map({ $0.pitch })
+        let ret = pitchAlignerBeginLine(aligner,
+                                        beginTimes,
+                                        endTimes,
+                                        stdPitches,
+                                        Int32(tones.count),
+                                        Int32(bandMs),
+                                        Int32(scoreLevel),
+                                        Int32(scoreCompensationOffset))
+        lineTones = ret == 0 ? tones : []
+        if alignedScores.count < tones.count {
+            alignedScores = [Float](repeating: 0, count: tones.count)
+        }
+    }
+
+    /// 加入实时pitch
+    /// - Parameters:
+    ///   - progress: 歌曲进度 (ms)
+    ///   - pitch: 原始pitch, 未经 VoicePitchChanger 处理
+    func addPitch(progress: Int, pitch: Double) {
+        if lineTones.isEmpty {
+            return
+        }
+        if pitchAlignerAddPitch(aligner, Int32(progress), pitch) != 0 {
+            lineTones = []
+        }
+    }
+
+    public func getLineScore(with toneScores: [ToneScoreModel]) -> Int {
+        if toneScores.isEmpty { return 0 }
+        if isAligning(toneScores: toneScores), pitchAlignerSampleCount(aligner) > 0 {
+            pitchAlignerToneScores(aligner, &alignedScores)
+            for (index, model) in toneScores.enumerated() {
+                model.score = alignedScores[index]
+            }
+        }
+        let ret = toneScores.map({ $0.score }).reduce(0.0, +) / Float(toneScores.count)
+        return Int(ret)
+    }
+
+    private func isAligning(toneScores: [ToneScoreModel]) -> Bool {
+        guard toneScores.count == lineTones.count else {
+            return false
+        }
+        for (model, tone) in zip(toneScores, lineTones) where model.tone !== tone {
+            return false
+        }
+        return true
+    }
+}
@@ -0,0 +1,169 @@
+//
+//  ScoreEngine.swift
+//  AgoraLyricsScore
+//
+
+import Foundation
+
+/// 离线打分: 对录制好的整段pitch同步打分, 不涉及UI和线程切换
+/// - Note: 与 ScoringMachine 的实时打分规则一致, 可用于重算排行榜、校验客户端上报的分数、回归测试;
+///         可在任意线程使用, 单个实例不可多线程同时使用, 多个实例互不影响
+public class ScoreEngine {
+    /// 打分难度系数, 范围：[0, 100], 同 KaraokeView.setScoreLevel
+    public var scoreLevel = 15
+    /// 打分分值补偿, 同 KaraokeView.setScoreCompensationOffset
+    public var scoreCompensationOffset = 0
+    /// 句子打分算法
+    public var scoreAlgorithm: IScoreAlgorithm = ScoreAlgorithm()
+    /// 为 true 时用批量近似计算字分数, 误差见 Algorithm.h; 校验客户端分数时应保持 false
+    public var useApproximateTone = false
+
+    fileprivate let pitchScorer = pitchScorerCreate()
+    fileprivate lazy var voiceChanger = VoicePitchChanger(scorer: pitchScorer)
+    fileprivate lazy var toneCalculator = ToneCalculator(scorer: pitchScorer)
+    /// 标准pitch的tone表, 覆盖到 pitchToneTableMaxPitch, 歌词的pitch超出时重建
+    fileprivate var pitchToneTable: OpaquePointer?
+    fileprivate var pitchToneTableMaxPitch: Double = -1
+
+    public init() {}
+
+    deinit {
+        pitchScorerDestroy(pitchScorer)
+        pitchToneTableDestroy(pitchToneTable)
+    }
+
+    /// 对整首歌打分
+    /// - Parameters:
+    ///   - lyric: 歌词
+    ///   - pitchTrack: 录制的pitch, timeMs 为歌曲进度 (ms), 按时间递增时查找最快
+    /// - Returns: 整首歌的得分
+    public func score(lyric: LyricModel, pitchTrack: [(timeMs: Int, pitch: Double)]) -> PerformanceScore {
+        guard lyric.hasPitch, !lyric.lines.isEmpty else {
+            return PerformanceScore(cumulativeScore: 0, lineScores: [], toneScores: [])
+        }
+
+        let (_, dataList) = ScoringMachine.createData(data: lyric)
+        let maxPitch = dataList.filter({ $0.word != " " }).map({ $0.pitch }).max() ?? 0
+
+        /** 与实时打分一样, 时间被修复过的字不计分 **/
+        let tonePositions = ScoringMachine.makeTonePositions(data: lyric, dataList: dataList)
+        let maxEndTimes = ScoringMachine.makeMaxEndTimes(dataList: dataList)
+
+        /** 1.get hitedInfo, 2.voice change **/
+        voiceChanger.reset()
+        var hitedIndexes = [Int]()
+        var voicePitches = [Double]()
+        var stdPitches = [Double]()
+        hitedIndexes.reserveCapacity(pitchTrack.count)
+        voicePitches.reserveCapacity(pitchTrack.count)
+        stdPitches.reserveCapacity(pitchTrack.count)
+        var cursor = 0
+        for (progress, pitch) in pitchTrack {
+            if pitch <= 0 {
+                continue
+            }
+            guard let index = ScoringMachine.getHitedIndex(progress: progress,
+                                                           dataList: dataList,
+                                                           maxEndTimes: maxEndTimes,
+                                                           cursor: &cursor) else {
+                continue
+            }
+
+            let stdPitch = dataList[index].pitch
+            hitedIndexes.append(index)
+            stdPitches.append(stdPitch)
+            voicePitches.append(voiceChanger.handlePitch(stdPitch: stdPitch,
+                                                         voicePitch: pitch,
+                                                         stdMaxPitch: maxPitch))
+        }
+
+        /** 3.calculted score **/
+        let scores: [Float]
+        if useApproximateTone {
+            updatePitchToneTable(dataList: dataList, maxPitch: maxPitch)
+            scores = ToneCalculator.calculedScores(voicePitches: voicePitches,
+                                                   stdPitches: stdPitches,
+                                                   scoreLevel: scoreLevel,
+                                                   scoreCompensationOffset: scoreCompensationOffset,
+                                                   stdTable: pitchToneTable)
+        }
+        else {
+            scores = zip(voicePitches, stdPitches).map { voicePitch, stdPitch in
+                toneCalculator.calculedScore(voicePitch: voicePitch,
+                                             stdPitch: stdPitch,
+                                             scoreLevel: scoreLevel,
+                                             scoreCompensationOffset: scoreCompensationOffset)
+            }
+        }
+
+        /** 4.save tone score **/
+        var sums = [Float](repeating: 0, count: dataList.count)
+        var counts = [Int](repeating: 0, count: dataList.count)
+        for (offset, index) in hitedIndexes.enumerated() {
+            sums[index] += scores[offset]
+            counts[index] += 1
+        }
+        let toneScores = lyric.lines.map({ $0.tones.map({ ToneScoreModel(tone: $0, score: 0) }) })
+        for (index, position) in tonePositions.enumerated() {
+            guard let position = position, counts[index] > 0 else {
+                continue
+            }
+            toneScores[position.line][position.tone].score = sums[index] / Float(counts[index])
+        }
+
+        /** 5.line score **/
+        let lineScores: [Int]
+        if let algorithm = scoreAlgorithm as? DTWScoreAlgorithm {
+            lineScores = alignedLineScores(algorithm: algorithm,
+                                           lyric: lyric,
+                                           pitchTrack: pitchTrack,
+                                           toneScores: toneScores)
+        }
+        else {
+            lineScores = toneScores.map({ scoreAlgorithm.getLineScore(with: $0) })
+        }
+        return PerformanceScore(cumulativeScore: lineScores.reduce(0, +),
+                                lineScores: lineScores,
+                                toneScores: toneScores)
+    }
+    
+    /// 歌词的最高pitch在表的范围内时沿用, 同一实例连续打分不重复建表
+    private func updatePitchToneTable(dataList: [ScoringMachine.Info], maxPitch: Double) {
+        guard pitchToneTable == nil || maxPitch > pitchToneTableMaxPitch else {
+            return
+        }
+        pitchToneTableDestroy(pitchToneTable)
+        let stdPitches = dataList.map({ $0.pitch })
+        pitchToneTable = pitchToneTableCreate(stdPitches, stdPitches.count)
+        pitchToneTableMaxPitch = pitchToneTable == nil ? -1 : maxPitch
+    }
+    
+    /// 时间对齐打分: 每行送入 [首字开始 - bandMs, 末字结束 + bandMs] 内的pitch
+    private func alignedLineScores(algorithm: DTWScoreAlgorithm,
+                                   lyric: LyricModel,
+                                   pitchTrack: [(timeMs: Int, pitch: Double)],
+                                   toneScores: [[ToneScoreModel]]) -> [Int] {
+        var track = pitchTrack
+        if !zip(track, track.dropFirst()).allSatisfy({ $0.timeMs <= $1.timeMs }) {
+            track.sort(by: { $0.timeMs < $1.timeMs })
+        }
+        let times = track.map({ $0.timeMs })
+        var lineScores = [Int]()
+        lineScores.reserveCapacity(lyric.lines.count)
+        for (indexOfLine, line) in lyric.lines.enumerated() {
+            algorithm.beginLine(tones: line.tones,
+                                scoreLevel: scoreLevel,
+                                scoreCompensationOffset: scoreCompensationOffset)
+            if let first = line.tones.first, let last = line.tones.last {
+                var index = ScoringMachine.lowerBound(times, first.beginTime - algorithm.bandMs)
+                let end = last.endTime + algorithm.bandMs
+                while index < track.count, track[index].timeMs <= end {
+                    algorithm.addPitch(progress: track[index].timeMs, pitch: track[index].pitch)
+                    index += 1
+                }
+            }
+            lineScores.append(algorithm.getLineScore(with: toneScores[indexOfLine]))
+        }
+        return lineScores
+    }
+}
@@ -10,6 +10,27 @@ import Foundation
 var useC = true
 
 class ToneCalculator {
+    /// C打分上下文, 由创建者持有并释放
+    private let scorer: OpaquePointer?
+    
+    init(scorer: OpaquePointer?) {
+        self.scorer = scorer
+    }
+    
+    /// 计算tone分数, 使用本实例的打分上下文
+    func calculedScore(voicePitch: Double,
+                       stdPitch: Double,
+                       scoreLevel: Int,
+                       scoreCompensationOffset: Int) -> Float {
+        if useC {
+            return pitchScorerScore(scorer, voicePitch, stdPitch, Int32(scoreLevel), Int32(scoreCompensationOffset))
+        }
+        return ToneCalculator.calculedScore(voicePitch: voicePitch,
+                                            stdPitch: stdPitch,
+                                            scoreLevel: scoreLevel,
+                                            scoreCompensationOffset: scoreCompensationOffset)
+    }
+    
     /// 计算tone分数
     static func calculedScore(voicePitch: Double,
                               stdPitch: Double,
@@ -27,6 +48,29 @@ class ToneCalculator {
         return match * 100
     }
     
+    /// 批量计算tone分数, 用于回放整段pitch重新打分
+    /// - Parameters:
+    ///   - voicePitches: 实际值, 与 stdPitches 一一对应
+    ///   - stdPitches: 标准值
+    ///   - stdTable: pitchToneTableCreate 创建的标准pitch查表, 为nil时按近似计算
+    /// - Returns: 每个pitch的分数, 与逐个调用 calculedScore 相差不超过 Algorithm.h 中的误差
+    static func calculedScores(voicePitches: [Double],
+                               stdPitches: [Double],
+                               scoreLevel: Int,
+                               scoreCompensationOffset: Int,
+                               stdTable: OpaquePointer? = nil) -> [Float] {
+        let count = min(voicePitches.count, stdPitches.count)
+        return [Float](unsafeUninitializedCapacity: count) { buffer, initializedCount in
+            voicePitches.withUnsafeBufferPointer { voice in
+                stdPitches.withUnsafeBufferPointer { std in
+                    scorePitchesC(voice.baseAddress, std.baseAddress, count, buffer.baseAddress,
+                                  Int32(scoreLevel), Int32(scoreCompensationOffset), stdTable)
+                }
+            }
+            initializedCount = count
+        }
+    }
+    
     static func pitchToTone(pitch: Double) -> Double {
         if useC {
             return pitchToToneC(pitch)
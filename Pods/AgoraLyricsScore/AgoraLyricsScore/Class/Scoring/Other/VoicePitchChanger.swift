@@ -12,6 +12,12 @@ class VoicePitchChanger {
     var offset: Double = 0.0
     /// 记录调用次数
     var n: Double = 0
+    /// C打分上下文, 由创建者持有并释放
+    private let scorer: OpaquePointer?
+    
+    init(scorer: OpaquePointer?) {
+        self.scorer = scorer
+    }
     
     /// 处理Pitch
     /// - Parameters:
@@ -23,7 +29,7 @@ class VoicePitchChanger {
                      voicePitch: Double,
                      stdMaxPitch: Double) -> Double {
         if useC {
-            return handlePitchC(stdPitch, voicePitch, stdMaxPitch)
+            return pitchScorerHandlePitch(scorer, stdPitch, voicePitch, stdMaxPitch)
         }
         
         if voicePitch <= 0 {
@@ -64,7 +70,7 @@ class VoicePitchChanger {
     
     func reset() {
         if useC {
-            resetC()
+            pitchScorerReset(scorer)
             return
         }
         offset = 0.0
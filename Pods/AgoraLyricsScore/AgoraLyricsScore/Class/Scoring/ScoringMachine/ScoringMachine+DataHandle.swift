@@ -47,7 +47,6 @@ extension ScoringMachine {
     
     func makeHighlightInfos(progress: Int,
                             hitedInfo: Info,
-                            currentVisiableInfos: [Info],
                             currentHighlightInfos: [Info]) -> [Info] {
         let pitchDuration = 50
         if let preHitInfo = currentHighlightInfos.last, preHitInfo.beginTime == hitedInfo.beginTime { /** 判断是否需要追加 **/
@@ -76,17 +75,18 @@ extension ScoringMachine {
         return temp
     }
     
-    /// 生成DrawInfo
-    /// - Returns: (visiableDrawInfos, highlightDrawInfos, currentVisiableInfos, currentHighlightInfos)
+    /// 生成DrawInfo, 可见区间和高亮信息原地更新
+    /// - Returns: (visiableDrawInfos, highlightDrawInfos)
     func makeInfos(progress: Int,
-                   dataList: [Info],
-                   currentHighlightInfos: [Info],
+                   visibleWindow: inout VisibleWindow,
+                   highlightBuffer: inout DrawBuffer,
+                   currentHighlightInfos: inout [Info],
                    defaultPitchCursorX: CGFloat,
                    widthPreMs: CGFloat,
                    canvasViewSize: CGSize,
                    standardPitchStickViewHeight: CGFloat,
                    minPitch: Double,
-                   maxPitch: Double) -> ([DrawInfo], [DrawInfo], [Info], [Info]) {
+                   maxPitch: Double) -> ([DrawInfo], [DrawInfo]) {
         /// 视图最左边到游标这段距离对应的时长
         let defaultPitchCursorXTime = Int(defaultPitchCursorX / widthPreMs)
         /// 游标到视图最右边对应的时长
@@ -96,40 +96,46 @@ extension ScoringMachine {
         /// 需要显示音高的结束时间
         let endTime = progress + remainTime
         
-        let currentVisiableInfos = filterInfos(infos: dataList,
-                                               beginTime: beginTime,
-                                               endTime: endTime)
-        let highlightInfos = filterInfos(infos: currentHighlightInfos,
-                                         beginTime: beginTime,
-                                         endTime: endTime)
+        visibleWindow.move(beginTime: beginTime, endTime: endTime)
+        let visiableDrawInfos = visibleWindow.makeDrawInfos(originTime: progress - defaultPitchCursorXTime,
+                                                            widthPreMs: widthPreMs)
         
-        var visiableDrawInfos = [DrawInfo]()
-        for info in currentVisiableInfos {
-            let rect = calculateDrawRect(progress: progress,
-                                         info: info,
-                                         standardPitchStickViewHeight: standardPitchStickViewHeight,
-                                         widthPreMs: widthPreMs,
-                                         canvasViewSize: canvasViewSize,
-                                         minPitch: minPitch,
-                                         maxPitch: maxPitch)
-            let drawInfo = DrawInfo(rect: rect)
-            visiableDrawInfos.append(drawInfo)
+        currentHighlightInfos.removeAll(where: { $0.endTime <= beginTime || $0.drawBeginTime >= endTime })
+        let highlightInfos = currentHighlightInfos
+        let highlightDrawInfos = highlightBuffer.fill { drawInfos in
+            for info in highlightInfos {
+                let rect = calculateDrawRect(progress: progress,
+                                             info: info,
+                                             standardPitchStickViewHeight: standardPitchStickViewHeight,
+                                             widthPreMs: widthPreMs,
+                                             canvasViewSize: canvasViewSize,
+                                             minPitch: minPitch,
+                                             maxPitch: maxPitch)
+                drawInfos.append(DrawInfo(rect: rect))
+            }
         }
         
-        var highlightDrawInfos = [DrawInfo]()
-        for info in highlightInfos {
-            let rect = calculateDrawRect(progress: progress,
+        return (visiableDrawInfos, highlightDrawInfos)
+    }
+    
+    /// 每个字与进度无关的绘制矩形, x 为 0, 供 VisibleWindow 使用
+    func makeDrawRects(dataList: [Info],
+                       widthPreMs: CGFloat,
+                       canvasViewSize: CGSize,
+                       standardPitchStickViewHeight: CGFloat,
+                       minPitch: Double,
+                       maxPitch: Double) -> [CGRect] {
+        return dataList.map { info in
+            var rect = calculateDrawRect(progress: 0,
                                          info: info,
                                          standardPitchStickViewHeight: standardPitchStickViewHeight,
                                          widthPreMs: widthPreMs,
                                          canvasViewSize: canvasViewSize,
                                          minPitch: minPitch,
                                          maxPitch: maxPitch)
-            let drawInfo = DrawInfo(rect: rect)
-            highlightDrawInfos.append(drawInfo)
+            rect.origin.x = 0
+            return rect
         }
-        
-        return (visiableDrawInfos, highlightDrawInfos, currentVisiableInfos, highlightInfos)
     }
     
     /// 生成最大、最小Pitch值
@@ -142,19 +148,85 @@ extension ScoringMachine {
         return (minValue, maxValue)
     }
     
-    /// 获取击中数据
-    func getHitedInfo(progress: Int,
-                      currentVisiableInfos: [Info]) -> Info? {
-        let pitchBeginTime = progress
-        return currentVisiableInfos.first { info in
-            return pitchBeginTime >= info.drawBeginTime && pitchBeginTime <= info.endTime
+    /// 字结束时间的前缀最大值, 单调不减, 用于二分定位击中查找的起点
+    static func makeMaxEndTimes(dataList: [Info]) -> [Int] {
+        var maxEndTimes = [Int]()
+        maxEndTimes.reserveCapacity(dataList.count)
+        var maxEndTime = Int.min
+        for info in dataList {
+            maxEndTime = max(maxEndTime, info.endTime)
+            maxEndTimes.append(maxEndTime)
+        }
+        return maxEndTimes
+    }
+    
+    /// 每个字在所属行中的位置 (行, 字), 按原始开始时间对应, 时间被修复过的字为nil
+    static func makeTonePositions(data: LyricModel, dataList: [Info]) -> [(line: Int, tone: Int)?] {
+        var positions = [(line: Int, tone: Int)?]()
+        positions.reserveCapacity(dataList.count)
+        for (lineIndex, line) in data.lines.enumerated() {
+            for (toneIndex, tone) in line.tones.enumerated() {
+                let info = dataList[positions.count]
+                positions.append(info.beginTime == tone.beginTime ? (lineIndex, toneIndex) : nil)
+            }
+        }
+        return positions
+    }
+    
+    /// 第一个不小于 value 的元素的索引, array 需单调不减
+    static func lowerBound(_ array: [Int], _ value: Int) -> Int {
+        var low = 0
+        var high = array.count
+        while low < high {
+            let middle = low + (high - low) / 2
+            if array[middle] < value {
+                low = middle + 1
+            }
+            else {
+                high = middle
+            }
+        }
+        return low
+    }
+    
+    /// 获取击中数据的索引
+    /// - Parameters:
+    ///   - maxEndTimes: `makeMaxEndTimes` 的结果
+    ///   - cursor: 查找起点, 其前的字都已结束; 进度正常前进时逐个后移, 拖拽跳转时二分重新定位
+    /// - Returns: 第一个 drawBeginTime <= progress <= endTime 的字
+    static func getHitedIndex(progress: Int,
+                              dataList: [Info],
+                              maxEndTimes: [Int],
+                              cursor: inout Int) -> Int? {
+        let count = maxEndTimes.count
+        if cursor > count || (cursor > 0 && maxEndTimes[cursor - 1] >= progress) {
+            cursor = lowerBound(maxEndTimes, progress)
+        }
+        else if cursor < count, maxEndTimes[cursor] < progress {
+            if cursor + 1 < count, maxEndTimes[cursor + 1] < progress {
+                cursor = lowerBound(maxEndTimes, progress)
+            }
+            else {
+                cursor += 1
+            }
         }
+        
+        var index = cursor
+        while index < count, dataList[index].drawBeginTime <= progress {
+            if progress <= dataList[index].endTime {
+                return index
+            }
+            index += 1
+        }
+        return nil
     }
     
     /// 查找当前句子的索引
     /// - Parameters:
+    ///   - isSorted: lineEndTimes 是否单调不减, 是则二分查找, 否则 (句子重叠) 逐句扫描
     /// - Returns: `nil` 表示不合法, ==`lineEndTimes.count` 表示最后一句已经结束
-    func findCurrentIndexOfLine(progress: Int, lineEndTimes: [Int]) -> Int? {
+    /// - Note: 结果为第一个 上一句结束时间 < progress <= 本句结束时间 的句子, 两句之间的空档属于下一句, 不返回nil
+    func findCurrentIndexOfLine(progress: Int, lineEndTimes: [Int], isSorted: Bool = true) -> Int? {
         if lineEndTimes.isEmpty {
             return nil
         }
@@ -167,6 +239,10 @@ extension ScoringMachine {
             return 0
         }
         
+        if isSorted {
+            return ScoringMachine.lowerBound(lineEndTimes, progress)
+        }
+        
         var lastEnd = 0
         for (offset, value) in lineEndTimes.enumerated() {
             if progress > lastEnd, progress <= value  {
@@ -176,36 +252,6 @@ extension ScoringMachine {
         }
         return nil
     }
-    
-    /// 筛选指定时间下的infos
-    func filterInfos(infos: [Info],
-                     beginTime: Int,
-                     endTime: Int) -> [Info] {
-        var result = [Info]()
-        for info in infos {
-            if info.drawBeginTime >= endTime {
-                break
-            }
-            if info.endTime <= beginTime {
-                continue
-            }
-            result.append(info)
-        }
-        return result
-    }
-    
-    /// 计算累计分数
-    /// - Parameters:
-    ///   - indexOfLine: 计算到此index 如：2, 会计算0,1,2的累加值
-    func calculatedCumulativeScore(indexOfLine: Int, lineScores: [Int]) -> Int {
-        var cumulativeScore = 0
-        for (offset, value) in lineScores.enumerated() {
-            if offset <= indexOfLine {
-                cumulativeScore += value
-            }
-        }
-        return cumulativeScore
-    }
 }
 
 extension ScoringMachine { /** ui 位置 **/
@@ -56,10 +56,141 @@ extension ScoringMachine {
         }
     }
     
+    /// 每行分数, 累计分数由前缀和得出
+    struct LineScores {
+        private(set) var scores: [Int]
+        /// prefixSums[i] 为前i行的分数和, 下标不超过 validCount 的部分有效
+        private var prefixSums: [Int]
+        private var validCount = 0
+        
+        init(count: Int) {
+            scores = .init(repeating: 0, count: count)
+            prefixSums = .init(repeating: 0, count: count + 1)
+        }
+        
+        var count: Int {
+            scores.count
+        }
+        
+        subscript(index: Int) -> Int {
+            get { scores[index] }
+            set {
+                scores[index] = newValue
+                validCount = min(validCount, index)
+            }
+        }
+        
+        /// 计算累计分数
+        /// - Parameters:
+        ///   - indexOfLine: 计算到此index 如：2, 会计算0,1,2的累加值
+        mutating func cumulativeScore(indexOfLine: Int) -> Int {
+            let end = min(indexOfLine + 1, scores.count)
+            if end <= 0 {
+                return 0
+            }
+            while validCount < end {
+                prefixSums[validCount + 1] = prefixSums[validCount] + scores[validCount]
+                validCount += 1
+            }
+            return prefixSums[end]
+        }
+    }
+    
     struct DrawInfo {
         let rect: CGRect
     }
     
+    /// 交替使用的两份绘制缓冲区: 交给界面的一份还被持有时写另一份, 稳定后不再分配内存
+    struct DrawBuffer {
+        private var buffers = ([DrawInfo](), [DrawInfo]())
+        private var useFirst = true
+        
+        mutating func fill(_ body: (inout [DrawInfo]) -> Void) -> [DrawInfo] {
+            var buffer = [DrawInfo]()
+            if useFirst {
+                swap(&buffer, &buffers.0)
+            }
+            else {
+                swap(&buffer, &buffers.1)
+            }
+            buffer.removeAll(keepingCapacity: true)
+            body(&buffer)
+            if useFirst {
+                buffers.0 = buffer
+            }
+            else {
+                buffers.1 = buffer
+            }
+            useFirst.toggle()
+            return buffer
+        }
+    }
+    
+    /// 可见的字所在区间, 进度前进时只移动两端, 后退或跳转时二分定位
+    /// - Note: 绘制矩形中与进度无关的部分 (y、宽、高) 预先算好, 每次只算x
+    struct VisibleWindow {
+        /// dataList 中可见字的区间, 区间内结束时间早于可见开始时间的字不可见
+        private(set) var range = 0..<0
+        private var beginTime = 0
+        private var endTime = 0
+        private var drawBeginTimes = [Int]()
+        private var endTimes = [Int]()
+        private var maxEndTimes = [Int]()
+        /// 每个字的绘制矩形, x 为 0
+        private var rects = [CGRect]()
+        private var buffer = DrawBuffer()
+        
+        init() {}
+        
+        /// - Parameters:
+        ///   - maxEndTimes: `makeMaxEndTimes` 的结果
+        ///   - rects: 每个字的绘制矩形, x 为 0
+        init(dataList: [Info], maxEndTimes: [Int], rects: [CGRect]) {
+            self.drawBeginTimes = dataList.map({ $0.drawBeginTime })
+            self.endTimes = dataList.map({ $0.endTime })
+            self.maxEndTimes = maxEndTimes
+            self.rects = rects
+        }
+        
+        /// 移动到 [beginTime, endTime) 的时间范围
+        mutating func move(beginTime: Int, endTime: Int) {
+            var lower = range.lowerBound
+            var upper = range.upperBound
+            if beginTime >= self.beginTime, endTime >= self.endTime {
+                while lower < maxEndTimes.count, maxEndTimes[lower] <= beginTime {
+                    lower += 1
+                }
+                while upper < drawBeginTimes.count, drawBeginTimes[upper] < endTime {
+                    upper += 1
+                }
+            }
+            else {
+                lower = ScoringMachine.lowerBound(maxEndTimes, beginTime + 1)
+                upper = ScoringMachine.lowerBound(drawBeginTimes, endTime)
+            }
+            self.beginTime = beginTime
+            self.endTime = endTime
+            range = lower..<max(lower, upper)
+        }
+        
+        /// 生成可见字的DrawInfo
+        /// - Parameter originTime: 视图最左边对应的时间
+        mutating func makeDrawInfos(originTime: Int, widthPreMs: CGFloat) -> [DrawInfo] {
+            let range = self.range
+            let beginTime = self.beginTime
+            let drawBeginTimes = self.drawBeginTimes
+            let endTimes = self.endTimes
+            let rects = self.rects
+            return buffer.fill { infos in
+                for index in range where endTimes[index] > beginTime {
+                    var rect = rects[index]
+                    rect.origin.x = CGFloat(drawBeginTimes[index] - originTime) * widthPreMs
+                    infos.append(DrawInfo(rect: rect))
+                }
+            }
+        }
+    }
+    
     struct DebugInfo {
         /// 原始pitch
         let originalPitch: Double
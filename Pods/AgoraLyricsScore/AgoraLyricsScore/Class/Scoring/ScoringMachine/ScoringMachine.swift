@@ -25,19 +25,41 @@ class ScoringMachine {
     fileprivate var widthPreMs: CGFloat { movingSpeedFactor / 1000 }
     fileprivate var dataList = [Info]()
     fileprivate var lineEndTimes = [Int]()
-    fileprivate var currentVisiableInfos = [Info]()
+    /// lineEndTimes 是否单调不减, 句子重叠时为 false
+    fileprivate var isLineEndTimesSorted = true
+    /// dataList 结束时间的前缀最大值
+    fileprivate var maxEndTimes = [Int]()
+    /// dataList 中每个字在所属行中的位置
+    fileprivate var tonePositions = [(line: Int, tone: Int)?]()
+    /// 击中查找的起点
+    fileprivate var hitCursor = 0
+    fileprivate var visibleWindow = VisibleWindow()
+    /// visibleWindow 中矩形对应的 (widthPreMs, standardPitchStickViewHeight), 变化后重建
+    fileprivate var visibleWindowLayout: (CGFloat, CGFloat)?
+    fileprivate var highlightBuffer = DrawBuffer()
     fileprivate var currentHighlightInfos = [Info]()
     fileprivate var maxPitch: Double = 0
     fileprivate var minPitch: Double = 0
     
     fileprivate var canvasViewSize: CGSize = .zero
     fileprivate var toneScores = [ToneScoreModel]()
-    fileprivate var lineScores = [Int]()
+    /// toneScores 所属的行
+    fileprivate var indexOfToneScoresLine = -1
+    fileprivate var lineScores = LineScores(count: 0)
     fileprivate var currentIndexOfLine = 0
     fileprivate var lyricData: LyricModel?
     fileprivate var cumulativeScore = 0
     fileprivate var isDragging = false
-    fileprivate var voiceChanger = VoicePitchChanger()
+    /// 本实例独立的打分上下文, 多个实例可在不同队列上同时打分
+    fileprivate let pitchScorer = pitchScorerCreate()
+    fileprivate lazy var voiceChanger = VoicePitchChanger(scorer: pitchScorer)
+    fileprivate lazy var toneCalculator = ToneCalculator(scorer: pitchScorer)
+    /// 音高检测, 在送入音频帧的线程上运行, 由 pitchDetectorLock 保护
+    fileprivate let pitchDetector = pitchDetectorCreate()
+    fileprivate let pitchDetectorLock = NSLock()
+    fileprivate var detectedPitches = [Double]()
+    /// 检测结果中连续为0的个数, 在 queue 上访问
+    fileprivate var detectedZeroCount = 0
     fileprivate let queue = DispatchQueue(label: "ScoringMachine")
     let logTag = "ScoringMachine"
     
@@ -64,6 +86,41 @@ class ScoringMachine {
         }
     }
     
+    /// 送入麦克风采集的音频帧, 每 10ms 检测一个 pitch 并打分
+    /// - Note: 可在音频回调线程调用, 同一时间只能从一个线程送入
+    func setAudioFrame(buffer: UnsafeRawPointer,
+                       samplesPerChannel: Int,
+                       bytesPerSample: Int,
+                       channels: Int,
+                       samplesPerSec: Int) {
+        var frame = PitchAudioFrame(samplesPerChannel: Int32(samplesPerChannel),
+                                    bytesPerSample: Int32(bytesPerSample),
+                                    channels: Int32(channels),
+                                    samplesPerSec: Int32(samplesPerSec),
+                                    buffer: buffer)
+        pitchDetectorLock.lock()
+        let maxCount = Int(pitchDetectorMaxPitches(&frame))
+        if detectedPitches.count < maxCount {
+            detectedPitches = [Double](repeating: 0, count: maxCount)
+        }
+        let count = Int(pitchDetectorProcess(pitchDetector, &frame, &detectedPitches, Int32(detectedPitches.count)))
+        let pitches = count > 0 ? Array(detectedPitches[0..<count]) : []
+        pitchDetectorLock.unlock()
+        
+        if count < 0 {
+            Log.errorText(text: "unsupported audio frame, bytesPerSample: \(bytesPerSample) channels: \(channels) samplesPerSec: \(samplesPerSec)", tag: logTag)
+            return
+        }
+        if pitches.isEmpty {
+            return
+        }
+        queue.async { [weak self] in
+            for pitch in pitches {
+                self?._setDetectedPitch(pitch: pitch)
+            }
+        }
+    }
+    
     func dragBegain() {
         queue.async { [weak self] in
             self?._dragBegain()
@@ -92,6 +149,8 @@ class ScoringMachine {
     }
     
     deinit {
+        pitchScorerDestroy(pitchScorer)
+        pitchDetectorDestroy(pitchDetector)
         Log.info(text: "deinit", tag: logTag)
     }
     
@@ -103,11 +162,16 @@ class ScoringMachine {
         let (lineEnds, infos) = ScoringMachine.createData(data: lyricData)
         dataList = infos
         lineEndTimes = lineEnds
+        isLineEndTimesSorted = zip(lineEnds, lineEnds.dropFirst()).allSatisfy({ $0 <= $1 })
+        maxEndTimes = ScoringMachine.makeMaxEndTimes(dataList: infos)
+        tonePositions = ScoringMachine.makeTonePositions(data: lyricData, dataList: infos)
+        hitCursor = 0
         let (min, max) = makeMinMaxPitch(dataList: dataList)
         minPitch = min
         maxPitch = max
-        toneScores = lyricData.lines[0].tones.map({ ToneScoreModel(tone: $0, score: 0) })
-        lineScores = .init(repeating: 0, count: lyricData.lines.count)
+        visibleWindowLayout = nil
+        setToneScores(indexOfLine: 0)
+        lineScores = LineScores(count: lyricData.lines.count)
         handleProgress()
     }
     
@@ -133,9 +197,14 @@ class ScoringMachine {
             return
         }
         
+        /** 时间对齐打分需要整行的pitch, 不论是否击中 **/
+        (scoreAlgorithm as? DTWScoreAlgorithm)?.addPitch(progress: progress, pitch: pitch)
+        
         /** 1.get hitedInfo **/
-        guard let hitedInfo = getHitedInfo(progress: progress,
-                                           currentVisiableInfos: currentVisiableInfos) else {
+        guard let hitedIndex = ScoringMachine.getHitedIndex(progress: progress,
+                                                            dataList: dataList,
+                                                            maxEndTimes: maxEndTimes,
+                                                            cursor: &hitCursor) else {
             let y = calculatedY(pitch: pitch,
                                 viewHeight: canvasViewSize.height,
                                 minPitch: minPitch,
@@ -154,6 +223,8 @@ class ScoringMachine {
             return
         }
         
+        let hitedInfo = dataList[hitedIndex]
+        
         /** 2.voice change **/
         let voicePitch = voiceChanger.handlePitch(stdPitch: hitedInfo.pitch,
                                                   voicePitch: pitch,
@@ -161,19 +232,19 @@ class ScoringMachine {
         Log.debug(text: "pitch: \(pitch) after: \(voicePitch) stdPitch:\(hitedInfo.pitch)", tag: logTag)
         
         /** 3.calculted score **/
-        let score = ToneCalculator.calculedScore(voicePitch: voicePitch,
+        let score = toneCalculator.calculedScore(voicePitch: voicePitch,
                                                  stdPitch: hitedInfo.pitch,
                                                  scoreLevel: scoreLevel,
                                                  scoreCompensationOffset: scoreCompensationOffset)
         
         /** 4.save tone score  **/
-        var hitToneScore = toneScores.first(where: { $0.tone.beginTime == hitedInfo.beginTime })
+        var hitToneScore = toneScore(of: hitedIndex)
         if hitToneScore != nil {
             hitToneScore!.addScore(score: score)
         }
         else { /** reresetToneScores while can not find a specific one  **/
             resetToneScores(position: progress)
-            hitToneScore = toneScores.first(where: { $0.tone.beginTime == hitedInfo.beginTime })
+            hitToneScore = toneScore(of: hitedIndex)
             if hitToneScore != nil {
                 hitToneScore!.addScore(score: score)
             }
@@ -186,7 +257,6 @@ class ScoringMachine {
         if score >= hitScoreThreshold * 100 {
             currentHighlightInfos = makeHighlightInfos(progress: progress,
                                                        hitedInfo: hitedInfo,
-                                                       currentVisiableInfos: currentVisiableInfos,
                                                        currentHighlightInfos: currentHighlightInfos)
         }
         Log.debug(text: "progress:\(progress) score: \(score) pitch: \(pitch) after: \(voicePitch) stdPitch:\(hitedInfo.pitch)", tag: logTag)
@@ -208,21 +278,35 @@ class ScoringMachine {
         invokeScoringMachine(didUpdateCursor: yValue, showAnimation: showAnimation, debugInfo: debugInfo)
     }
     
+    /// 与 KaraokeView.setPitch 一致, 连续10个0才送入0
+    private func _setDetectedPitch(pitch: Double) {
+        if pitch > 0 {
+            detectedZeroCount = 0
+            _setPitch(pitch: pitch)
+            return
+        }
+        detectedZeroCount += 1
+        if detectedZeroCount >= 10 {
+            detectedZeroCount = 0
+            _setPitch(pitch: 0)
+        }
+    }
+    
     private func _dragBegain() {
         isDragging = true
     }
     
     private func _dragDidEnd(position: Int) {
-        guard let index = findCurrentIndexOfLine(progress: position, lineEndTimes: lineEndTimes) else {
+        guard let index = findCurrentIndexOfLine(progress: position, lineEndTimes: lineEndTimes, isSorted: isLineEndTimesSorted) else {
             return
         }
         
         let indexOfLine = index-1
-        cumulativeScore = calculatedCumulativeScore(indexOfLine: indexOfLine, lineScores: lineScores)
+        cumulativeScore = lineScores.cumulativeScore(indexOfLine: indexOfLine)
         Log.debug(text: "== dragDidEnd cumulativeScore:\(cumulativeScore)", tag: "drag")
         
-        if index >= 0, index < lineEndTimes.count, let data = lyricData {
-            toneScores = data.lines[index].tones.map({ ToneScoreModel(tone: $0, score: 0) })
+        if index >= 0, index < lineEndTimes.count {
+            setToneScores(indexOfLine: index)
             for offset in index..<lineEndTimes.count {
                 lineScores[offset] = 0
             }
@@ -234,11 +318,11 @@ class ScoringMachine {
     }
     
     private func resetToneScores(position: Int) {
-        guard let index = findCurrentIndexOfLine(progress: position, lineEndTimes: lineEndTimes) else {
+        guard let index = findCurrentIndexOfLine(progress: position, lineEndTimes: lineEndTimes, isSorted: isLineEndTimesSorted) else {
             return
         }
-        if index >= 0, index < lineEndTimes.count, let data = lyricData {
-            toneScores = data.lines[index].tones.map({ ToneScoreModel(tone: $0, score: 0) })
+        if index >= 0, index < lineEndTimes.count {
+            setToneScores(indexOfLine: index)
             for offset in index..<lineEndTimes.count {
                 lineScores[offset] = 0
             }
@@ -247,38 +331,83 @@ class ScoringMachine {
         Log.info(text: "resetToneScores", tag: logTag)
     }
     
+    /// 切换 toneScores 到指定行
+    private func setToneScores(indexOfLine: Int) {
+        guard let data = lyricData, indexOfLine >= 0, indexOfLine < data.lines.count else {
+            return
+        }
+        toneScores = data.lines[indexOfLine].tones.map({ ToneScoreModel(tone: $0, score: 0) })
+        indexOfToneScoresLine = indexOfLine
+        (scoreAlgorithm as? DTWScoreAlgorithm)?.beginLine(tones: data.lines[indexOfLine].tones,
+                                                          scoreLevel: scoreLevel,
+                                                          scoreCompensationOffset: scoreCompensationOffset)
+    }
+    
+    /// 击中的字在 toneScores 中对应的得分, 不在当前行时为nil
+    private func toneScore(of hitedIndex: Int) -> ToneScoreModel? {
+        guard hitedIndex < tonePositions.count,
+              let position = tonePositions[hitedIndex],
+              position.line == indexOfToneScoresLine,
+              position.tone < toneScores.count else {
+            return nil
+        }
+        return toneScores[position.tone]
+    }
+    
     private func _reset() {
         cumulativeScore = 0
         lyricData = nil
-        currentVisiableInfos = []
+        visibleWindow = VisibleWindow()
+        visibleWindowLayout = nil
         currentHighlightInfos = []
         dataList = []
         lineEndTimes = []
+        isLineEndTimesSorted = true
+        maxEndTimes = []
+        tonePositions = []
+        hitCursor = 0
         cumulativeScore = 0
         currentIndexOfLine = 0
-        lineScores = []
+        lineScores = LineScores(count: 0)
         toneScores = []
+        indexOfToneScoresLine = -1
         progress = 0
         minPitch = 0
         maxPitch = 0
         voiceChanger.reset()
+        detectedZeroCount = 0
+        pitchDetectorLock.lock()
+        pitchDetectorReset(pitchDetector)
+        pitchDetectorLock.unlock()
     }
     
     private func handleProgress() {
+        /// 布局参数变化时重建可见区间
+        let layout = (widthPreMs, standardPitchStickViewHeight)
+        if visibleWindowLayout == nil || visibleWindowLayout! != layout {
+            let rects = makeDrawRects(dataList: dataList,
+                                      widthPreMs: widthPreMs,
+                                      canvasViewSize: canvasViewSize,
+                                      standardPitchStickViewHeight: standardPitchStickViewHeight,
+                                      minPitch: minPitch,
+                                      maxPitch: maxPitch)
+            visibleWindow = VisibleWindow(dataList: dataList, maxEndTimes: maxEndTimes, rects: rects)
+            visibleWindowLayout = layout
+        }
+        
         /// 计算需要绘制的数据
-        let (visiableDrawInfos, highlightDrawInfos, visiableInfos, highlightInfos) = makeInfos(progress: progress,
-                                                                                               dataList: dataList,
-                                                                                               currentHighlightInfos: currentHighlightInfos,
-                                                                                               defaultPitchCursorX: defaultPitchCursorX,
-                                                                                               widthPreMs: widthPreMs,
-                                                                                               canvasViewSize: canvasViewSize,
-                                                                                               standardPitchStickViewHeight: standardPitchStickViewHeight,
-                                                                                               minPitch: minPitch,
-                                                                                               maxPitch: maxPitch)
-        currentVisiableInfos = visiableInfos
-        currentHighlightInfos = highlightInfos
+        let (visiableDrawInfos, highlightDrawInfos) = makeInfos(progress: progress,
+                                                                visibleWindow: &visibleWindow,
+                                                                highlightBuffer: &highlightBuffer,
+                                                                currentHighlightInfos: &currentHighlightInfos,
+                                                                defaultPitchCursorX: defaultPitchCursorX,
+                                                                widthPreMs: widthPreMs,
+                                                                canvasViewSize: canvasViewSize,
+                                                                standardPitchStickViewHeight: standardPitchStickViewHeight,
+                                                                minPitch: minPitch,
+                                                                maxPitch: maxPitch)
         invokeScoringMachine(didUpdateDraw: visiableDrawInfos, highlightInfos: highlightDrawInfos)
-        guard let index = findCurrentIndexOfLine(progress: progress, lineEndTimes: lineEndTimes)  else {
+        guard let index = findCurrentIndexOfLine(progress: progress, lineEndTimes: lineEndTimes, isSorted: isLineEndTimesSorted)  else {
             return
         }
         if currentIndexOfLine != index {
@@ -298,9 +427,8 @@ class ScoringMachine {
         let lineScore = scoreAlgorithm.getLineScore(with: toneScores)
         lineScores[indexOfLineEnd] = lineScore
         
-        cumulativeScore = calculatedCumulativeScore(indexOfLine: indexOfLineEnd,
-                                                    lineScores: lineScores)
-        Log.debug(text: "score didLineEnd indexOfLineEnd: \(indexOfLineEnd) \(lineScore) \(lineScores) cumulativeScore:\(cumulativeScore)", tag: logTag)
+        cumulativeScore = lineScores.cumulativeScore(indexOfLine: indexOfLineEnd)
+        Log.debug(text: "score didLineEnd indexOfLineEnd: \(indexOfLineEnd) \(lineScore) \(lineScores.scores) cumulativeScore:\(cumulativeScore)", tag: logTag)
         invokeScoringMachine(didFinishLineWith: data.lines[indexOfLineEnd],
                              score: lineScore,
                              cumulativeScore: cumulativeScore,
@@ -308,7 +436,7 @@ class ScoringMachine {
                              lineCount: data.lines.count)
         let nextIndex = indexOfLineEnd + 1
         if nextIndex < data.lines.count {
-            toneScores = data.lines[nextIndex].tones.map({ ToneScoreModel(tone: $0, score: 0) })
+            setToneScores(indexOfLine: nextIndex)
         }
     }
 }
@@ -80,6 +80,18 @@ public class ScoringView: UIView {
         scoringMachine.setPitch(pitch: pitch)
     }
     
+    func setAudioFrame(buffer: UnsafeRawPointer,
+                       samplesPerChannel: Int,
+                       bytesPerSample: Int,
+                       channels: Int,
+                       samplesPerSec: Int) {
+        scoringMachine.setAudioFrame(buffer: buffer,
+                                     samplesPerChannel: samplesPerChannel,
+                                     bytesPerSample: bytesPerSample,
+                                     channels: channels,
+                                     samplesPerSec: samplesPerSec)
+    }
+    
     func setScoreAlgorithm(algorithm: IScoreAlgorithm) {
         scoringMachine.scoreAlgorithm = algorithm
     }
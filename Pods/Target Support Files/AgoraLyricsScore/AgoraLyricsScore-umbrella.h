@@ -11,6 +11,10 @@
 #endif
 
 #import "Algorithm.h"
+#import "LrcTokenizer.h"
+#import "LyricXmlParser.h"
+#import "PitchAligner.h"
+#import "PitchDetector.h"
 
 FOUNDATION_EXPORT double AgoraLyricsScoreVersionNumber;
 FOUNDATION_EXPORT const unsigned char AgoraLyricsScoreVersionString[];
@@ -33,6 +33,8 @@ public enum ZipCompression: Int {
     case BestSpeed
     case DefaultCompression
     case BestCompression
+    /// Default compression level, with large files deflated block by block on all active cores.
+    case ParallelCompression
 
     internal var minizipCompression: Int32 {
         switch self {
@@ -40,12 +42,22 @@ public enum ZipCompression: Int {
             return Z_NO_COMPRESSION
         case .BestSpeed:
             return Z_BEST_SPEED
-        case .DefaultCompression:
+        case .DefaultCompression, .ParallelCompression:
             return Z_DEFAULT_COMPRESSION
         case .BestCompression:
             return Z_BEST_COMPRESSION
         }
     }
+
+    /// Number of deflate worker threads passed to `zipOpenNewFileInZip5`, 0 for the single stream.
+    internal var minizipThreads: Int32 {
+        switch self {
+        case .ParallelCompression:
+            return Int32(ProcessInfo.processInfo.activeProcessorCount)
+        default:
+            return 0
+        }
+    }
 }
 
 /// Data in memory that will be archived as a file.
@@ -93,7 +105,8 @@ public class Zip {
      
      - throws: Error if unzipping fails or if fail is not found. Can be printed with a description variable.
      
-     - notes: Supports implicit progress composition
+     - notes: Supports implicit progress composition. Files are extracted on worker threads, but progress
+              and fileOutputHandler are always called on the calling thread, before unzipFile returns.
      */
     
     public class func unzipFile(_ zipFilePath: URL, destination: URL, overwrite: Bool, password: String?, progress: ((_ progress: Double) -> ())? = nil, fileOutputHandler: ((_ unzippedFile: URL) -> Void)? = nil) throws {
@@ -108,12 +121,6 @@ public class Zip {
             throw ZipError.fileNotFound
         }
         
-        // Unzip set up
-        var ret: Int32 = 0
-        var crc_ret: Int32 = 0
-        let bufferSize: UInt32 = 4096
-        var buffer = Array<CUnsignedChar>(repeating: 0, count: Int(bufferSize))
-        
         // Progress handler set up
         var totalSize: Double = 0.0
         var currentPosition: Double = 0.0
@@ -127,147 +134,537 @@ public class Zip {
         progressTracker.isPausable = false
         progressTracker.kind = ProgressKind.file
         
-        // Begin unzipping
-        let zip = unzOpen64(path)
+        // Read the central directory once
+        let entries = try readEntries(path, destination: destination)
+        
+        let creationDate = Date()
+        
+        let directoryAttributes: [FileAttributeKey: Any]?
+        #if os(Linux)
+            // On Linux, setting attributes is not yet really implemented.
+            // In Swift 4.2, the only settable attribute is `.posixPermissions`.
+            // See https://github.com/apple/swift-corelibs-foundation/blob/swift-4.2-branch/Foundation/FileManager.swift#L182-L196
+            directoryAttributes = nil
+        #else
+            directoryAttributes = [.creationDate : creationDate,
+                                   .modificationDate : creationDate]
+        #endif
+        
+        // Create the directory tree up front, the workers below only create files
+        var fileEntries = [UnzipEntry]()
+        for entry in entries {
+            do {
+                if entry.isDirectory {
+                    try fileManager.createDirectory(atPath: entry.fullPath, withIntermediateDirectories: true, attributes: directoryAttributes)
+                }
+                else {
+                    let parentDirectory = (entry.fullPath as NSString).deletingLastPathComponent
+                    try fileManager.createDirectory(atPath: parentDirectory, withIntermediateDirectories: true, attributes: directoryAttributes)
+                }
+            } catch {}
+            
+            if entry.isDirectory {
+                currentPosition += Double(entry.compressedSize)
+                notifyUnzipped(entry, currentPosition: currentPosition, totalSize: totalSize, progressTracker: progressTracker, progress: progress, fileOutputHandler: fileOutputHandler)
+            }
+            else {
+                fileEntries.append(entry)
+            }
+        }
+        
+        // Entries that land on the same path are written by the last one only, as a sequential
+        // extraction would leave them, so no two workers ever open the same file
+        var lastEntryIndexes = [String: Int]()
+        for (index, entry) in fileEntries.enumerated() {
+            lastEntryIndexes[(entry.fullPath as NSString).standardizingPath] = index
+        }
+        if lastEntryIndexes.count < fileEntries.count {
+            fileEntries = fileEntries.enumerated().filter { index, entry in
+                lastEntryIndexes[(entry.fullPath as NSString).standardizingPath] == index
+            }.map { $0.element }
+        }
+        
+        // Begin unzipping, every worker reads through its own handle.
+        // Finished entries are queued for the calling thread, which runs all callbacks itself.
+        let work = UnzipWork(entries: fileEntries)
+        let workerCount = max(1, min(maxUnzipWorkers, ProcessInfo.processInfo.activeProcessorCount, fileEntries.count))
+        if !fileEntries.isEmpty {
+            work.runningWorkers = workerCount
+            for _ in 0..<workerCount {
+                DispatchQueue.global(qos: .userInitiated).async {
+                    Zip.unzipWorker(work, path: path, password: password, overwrite: overwrite)
+                }
+            }
+        }
+        
+        while let entries = work.waitFinishedEntries() {
+            // Callbacks run on the calling thread, in completion order
+            for entry in entries {
+                currentPosition += Double(entry.compressedSize)
+                notifyUnzipped(entry, currentPosition: currentPosition, totalSize: totalSize, progressTracker: progressTracker, progress: progress, fileOutputHandler: fileOutputHandler)
+            }
+        }
+        if let error = work.error {
+            throw error
+        }
+        
+        // Completed. Update progress handler.
+        if let progressHandler = progress{
+            progressHandler(1.0)
+        }
+        
+        progressTracker.completedUnitCount = Int64(totalSize)
+        
+    }
+    
+    /**
+     Unzip an archive held in memory, without writing it to disk.
+     
+     - parameter data:     Zipped data.
+     - parameter password: Optional password if data is protected.
+     
+     - throws: Error if the archive cannot be read or an entry fails its CRC check.
+     
+     - returns: File entries keyed by their path in the archive. Directories are skipped.
+     */
+    public class func unzipData(_ data: Data, password: String? = nil) throws -> [String: Data] {
+        return try data.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) -> [String: Data] in
+            guard let baseAddress = bytes.baseAddress, let zip = unzOpenMemory(baseAddress, UInt64(bytes.count)) else {
+                throw ZipError.unzipFail
+            }
+            defer {
+                unzClose(zip)
+            }
+            if unzGoToFirstFile(zip) != UNZ_OK {
+                throw ZipError.unzipFail
+            }
+            
+            var entries = [String: Data]()
+            var fileName = Array<CChar>(repeating: 0, count: 256)
+            var ret: Int32 = 0
+            repeat {
+                var fileInfo = unz_file_info64()
+                memset(&fileInfo, 0, MemoryLayout<unz_file_info64>.size)
+                ret = unzGetCurrentFileInfo64(zip, &fileInfo, nil, 0, nil, 0, nil, 0)
+                if ret != UNZ_OK {
+                    throw ZipError.unzipFail
+                }
+                let fileNameSize = Int(fileInfo.size_filename) + 1
+                if fileName.count < fileNameSize {
+                    fileName = Array<CChar>(repeating: 0, count: fileNameSize)
+                }
+                unzGetCurrentFileInfo64(zip, &fileInfo, &fileName, UInt(fileNameSize), nil, 0, nil, 0)
+                fileName[Int(fileInfo.size_filename)] = 0
+                
+                let pathString = String(cString: fileName).replacingOccurrences(of: "\\", with: "/")
+                
+                guard pathString.count > 0 else {
+                    throw ZipError.unzipFail
+                }
+                
+                if !pathString.hasSuffix("/") {
+                    entries[pathString] = try readCurrentEntry(zip, uncompressedSize: UInt64(fileInfo.uncompressed_size), compressedSize: UInt64(fileInfo.compressed_size), password: password)
+                }
+                
+                ret = unzGoToNextFile(zip)
+            } while (ret == UNZ_OK)
+            
+            if ret != UNZ_END_OF_LIST_OF_FILE {
+                throw ZipError.unzipFail
+            }
+            return entries
+        }
+    }
+    
+    /**
+     Unzip selected entries of an archive into memory.
+     
+     - parameter zipFilePath: Local file path of zipped file. NSURL.
+     - parameter entryNames:  Paths of the wanted entries in the archive.
+     - parameter password:    Optional password if file is protected.
+     
+     - throws: Error if the archive cannot be read or an entry fails its CRC check.
+     
+     - returns: The entries found, keyed by their path in the archive. Missing names are left out.
+     */
+    public class func unzipEntries(_ zipFilePath: URL, entryNames: [String], password: String? = nil) throws -> [String: Data] {
+        
+        // The filename index turns every lookup into a hash probe instead of a central directory scan
+        guard let zip = openArchive(zipFilePath.path, options: UNZ_OPTION_INDEX) else {
+            throw ZipError.unzipFail
+        }
         defer {
             unzClose(zip)
         }
-        if unzGoToFirstFile(zip) != UNZ_OK {
+        
+        var entries = [String: Data]()
+        for entryName in entryNames {
+            if unzLocateFile(zip, entryName, nil) != UNZ_OK {
+                continue
+            }
+            var fileInfo = unz_file_info64()
+            if unzGetCurrentFileInfo64(zip, &fileInfo, nil, 0, nil, 0, nil, 0) != UNZ_OK {
+                throw ZipError.unzipFail
+            }
+            entries[entryName] = try readCurrentEntry(zip, uncompressedSize: UInt64(fileInfo.uncompressed_size), compressedSize: UInt64(fileInfo.compressed_size), password: password)
+        }
+        return entries
+    }
+    
+    /**
+     Read the current entry of an archive into memory.
+     
+     - parameter zip:              Archive handle positioned on the entry.
+     - parameter uncompressedSize: Size recorded in the central directory.
+     - parameter compressedSize:   Compressed size recorded in the central directory.
+     - parameter password:         Optional password if file is protected.
+     
+     - throws: Error if the entry cannot be read, fails its CRC check or does not match its recorded size.
+     
+     - returns: The entry content.
+     */
+    private class func readCurrentEntry(_ zip: unzFile, uncompressedSize: UInt64, compressedSize: UInt64, password: String?) throws -> Data {
+        var ret: Int32 = 0
+        if let cPassword = password?.cString(using: String.Encoding.ascii) {
+            ret = unzOpenCurrentFilePassword(zip, cPassword)
+        }
+        else {
+            ret = unzOpenCurrentFile(zip);
+        }
+        if ret != UNZ_OK {
             throw ZipError.unzipFail
         }
-        repeat {
-            if let cPassword = password?.cString(using: String.Encoding.ascii) {
-                ret = unzOpenCurrentFilePassword(zip, cPassword)
+        
+        // The recorded size comes from the archive and is not trusted: the buffer starts in proportion
+        // to the compressed bytes and only doubles as inflated data actually arrives, up to that size
+        guard let entrySize = Int(exactly: uncompressedSize) else {
+            unzCloseCurrentFile(zip)
+            throw ZipError.unzipFail
+        }
+        let initialCapacity = Int(clamping: compressedSize.multipliedReportingOverflow(by: 4).partialValue)
+        var entryData = Data(count: min(entrySize, max(initialCapacity, Int(unzipBufferSize))))
+        var readBytes = 0
+        var readRet: Int32 = 0
+        while readBytes < entrySize {
+            if readBytes == entryData.count {
+                entryData.count = min(entrySize, entryData.count * 2)
             }
-            else {
-                ret = unzOpenCurrentFile(zip);
+            readRet = entryData.withUnsafeMutableBytes { (buffer: UnsafeMutableRawBufferPointer) -> Int32 in
+                let chunkSize = UInt32(min(buffer.count - readBytes, Int(Int32.max)))
+                return unzReadCurrentFile(zip, buffer.baseAddress! + readBytes, chunkSize)
             }
-            if ret != UNZ_OK {
-                throw ZipError.unzipFail
+            if readRet <= 0 {
+                break
             }
+            readBytes += Int(readRet)
+        }
+        
+        let crc_ret = unzCloseCurrentFile(zip)
+        guard readRet >= 0, readBytes == entrySize, crc_ret == UNZ_OK else {
+            throw ZipError.unzipFail
+        }
+        return entryData
+    }
+    
+    /**
+     Upper bound of concurrent extraction workers used by unzipFile.
+     */
+    internal static let maxUnzipWorkers = 8
+    
+    /**
+     Read buffer size of each extraction worker.
+     */
+    internal static let unzipBufferSize: UInt32 = 64 * 1024
+    
+    /**
+     Open an archive for reading through the memory mapped file functions.
+     
+     - parameter path:    Local file path of zipped file.
+     - parameter options: unzOpen3_64 options, UNZ_OPTION_INDEX to index the filenames.
+     
+     - returns: The archive handle, nil if it cannot be opened.
+     */
+    private class func openArchive(_ path: String, options: Int32 = 0) -> unzFile? {
+        var fileFunctions = zlib_filefunc64_def()
+        fill_mmap_filefunc64(&fileFunctions)
+        return unzOpen3_64(path, &fileFunctions, options)
+    }
+    
+    /**
+     An archive entry collected from the central directory.
+     */
+    private struct UnzipEntry {
+        var filePos: unz64_file_pos
+        var fullPath: String
+        var isDirectory: Bool
+        var compressedSize: UInt64
+        var uncompressedSize: UInt64
+        var externalFileAttributes: UInt
+    }
+    
+    /**
+     Walk the central directory once and remember where each entry lives.
+     
+     - parameter path:        Local file path of zipped file.
+     - parameter destination: Local file path to unzip to. NSURL.
+     
+     - throws: Error if the central directory cannot be read.
+     
+     - returns: Entries in archive order.
+     */
+    private class func readEntries(_ path: String, destination: URL) throws -> [UnzipEntry] {
+        guard let zip = openArchive(path) else {
+            throw ZipError.unzipFail
+        }
+        defer {
+            unzClose(zip)
+        }
+        if unzGoToFirstFile(zip) != UNZ_OK {
+            throw ZipError.unzipFail
+        }
+        
+        var entries = [UnzipEntry]()
+        var fileName = Array<CChar>(repeating: 0, count: 256)
+        var ret: Int32 = 0
+        repeat {
             var fileInfo = unz_file_info64()
-            memset(&fileInfo, 0, MemoryLayout<unz_file_info>.size)
+            memset(&fileInfo, 0, MemoryLayout<unz_file_info64>.size)
             ret = unzGetCurrentFileInfo64(zip, &fileInfo, nil, 0, nil, 0, nil, 0)
             if ret != UNZ_OK {
-                unzCloseCurrentFile(zip)
                 throw ZipError.unzipFail
             }
-            currentPosition += Double(fileInfo.compressed_size)
             let fileNameSize = Int(fileInfo.size_filename) + 1
-            //let fileName = UnsafeMutablePointer<CChar>(allocatingCapacity: fileNameSize)
-            let fileName = UnsafeMutablePointer<CChar>.allocate(capacity: fileNameSize)
-
-            unzGetCurrentFileInfo64(zip, &fileInfo, fileName, UInt(fileNameSize), nil, 0, nil, 0)
+            if fileName.count < fileNameSize {
+                fileName = Array<CChar>(repeating: 0, count: fileNameSize)
+            }
+            unzGetCurrentFileInfo64(zip, &fileInfo, &fileName, UInt(fileNameSize), nil, 0, nil, 0)
             fileName[Int(fileInfo.size_filename)] = 0
-
+            
             var pathString = String(cString: fileName)
             
             guard pathString.count > 0 else {
                 throw ZipError.unzipFail
             }
-
+            
             var isDirectory = false
-            let fileInfoSizeFileName = Int(fileInfo.size_filename-1)
-            if (fileName[fileInfoSizeFileName] == "/".cString(using: String.Encoding.utf8)?.first || fileName[fileInfoSizeFileName] == "\\".cString(using: String.Encoding.utf8)?.first) {
-                isDirectory = true;
+            let lastCharacter = fileName[Int(fileInfo.size_filename) - 1]
+            if lastCharacter == CChar(UInt8(ascii: "/")) || lastCharacter == CChar(UInt8(ascii: "\\")) {
+                isDirectory = true
             }
-            free(fileName)
             if pathString.rangeOfCharacter(from: CharacterSet(charactersIn: "/\\")) != nil {
                 pathString = pathString.replacingOccurrences(of: "\\", with: "/")
             }
-
-            let fullPath = destination.appendingPathComponent(pathString).path
-
-            let creationDate = Date()
-
-            let directoryAttributes: [FileAttributeKey: Any]?
-            #if os(Linux)
-                // On Linux, setting attributes is not yet really implemented.
-                // In Swift 4.2, the only settable attribute is `.posixPermissions`.
-                // See https://github.com/apple/swift-corelibs-foundation/blob/swift-4.2-branch/Foundation/FileManager.swift#L182-L196
-                directoryAttributes = nil
-            #else
-                directoryAttributes = [.creationDate : creationDate,
-                                       .modificationDate : creationDate]
-            #endif
-
-            do {
-                if isDirectory {
-                    try fileManager.createDirectory(atPath: fullPath, withIntermediateDirectories: true, attributes: directoryAttributes)
-                }
-                else {
-                    let parentDirectory = (fullPath as NSString).deletingLastPathComponent
-                    try fileManager.createDirectory(atPath: parentDirectory, withIntermediateDirectories: true, attributes: directoryAttributes)
-                }
-            } catch {}
-            if fileManager.fileExists(atPath: fullPath) && !isDirectory && !overwrite {
-                unzCloseCurrentFile(zip)
-                ret = unzGoToNextFile(zip)
+            
+            var filePos = unz64_file_pos()
+            if unzGetFilePos64(zip, &filePos) != UNZ_OK {
+                throw ZipError.unzipFail
             }
-
-            var writeBytes: UInt64 = 0
-            var filePointer: UnsafeMutablePointer<FILE>?
-            filePointer = fopen(fullPath, "wb")
-            while filePointer != nil {
-                let readBytes = unzReadCurrentFile(zip, &buffer, bufferSize)
-                if readBytes > 0 {
-                    guard fwrite(buffer, Int(readBytes), 1, filePointer) == 1 else {
-                        throw ZipError.unzipFail
-                    }
-                    writeBytes += UInt64(readBytes)
-                }
-                else {
-                    break
-                }
+            
+            entries.append(UnzipEntry(filePos: filePos,
+                                      fullPath: destination.appendingPathComponent(pathString).path,
+                                      isDirectory: isDirectory,
+                                      compressedSize: UInt64(fileInfo.compressed_size),
+                                      uncompressedSize: UInt64(fileInfo.uncompressed_size),
+                                      externalFileAttributes: UInt(fileInfo.external_fa)))
+            
+            ret = unzGoToNextFile(zip)
+        } while (ret == UNZ_OK)
+        
+        if ret != UNZ_END_OF_LIST_OF_FILE {
+            throw ZipError.unzipFail
+        }
+        return entries
+    }
+    
+    /**
+     Extraction state shared by the unzipFile workers and the calling thread.
+     */
+    private final class UnzipWork {
+        let condition = NSCondition()
+        let entries: [UnzipEntry]
+        var nextEntryIndex = 0
+        var runningWorkers = 0
+        var finishedEntries = [UnzipEntry]()
+        var error: Error?
+        
+        init(entries: [UnzipEntry]) {
+            self.entries = entries
+        }
+        
+        /**
+         Next entry for a worker, nil once everything is taken or an entry failed.
+         */
+        func nextEntry() -> UnzipEntry? {
+            condition.lock()
+            defer {
+                condition.unlock()
             }
-
-            if let fp = filePointer { fclose(fp) }
-
-            crc_ret = unzCloseCurrentFile(zip)
-            if crc_ret == UNZ_CRCERROR {
-                throw ZipError.unzipFail
+            guard error == nil, nextEntryIndex < entries.count else {
+                return nil
             }
-            guard writeBytes == fileInfo.uncompressed_size else {
-                throw ZipError.unzipFail
+            nextEntryIndex += 1
+            return entries[nextEntryIndex - 1]
+        }
+        
+        func finish(_ entry: UnzipEntry) {
+            condition.lock()
+            finishedEntries.append(entry)
+            condition.signal()
+            condition.unlock()
+        }
+        
+        func fail(_ error: Error) {
+            condition.lock()
+            self.error = self.error ?? error
+            condition.unlock()
+        }
+        
+        func workerDidExit() {
+            condition.lock()
+            runningWorkers -= 1
+            condition.signal()
+            condition.unlock()
+        }
+        
+        /**
+         Block until entries are finished, nil once all workers have exited and everything was reported.
+         */
+        func waitFinishedEntries() -> [UnzipEntry]? {
+            condition.lock()
+            defer {
+                condition.unlock()
             }
-
-            //Set file permissions from current fileInfo
-            if fileInfo.external_fa != 0 {
-                let permissions = (fileInfo.external_fa >> 16) & 0x1FF
-                //We will devifne a valid permission range between Owner read only to full access
-                if permissions >= 0o400 && permissions <= 0o777 {
-                    do {
-                        try fileManager.setAttributes([.posixPermissions : permissions], ofItemAtPath: fullPath)
-                    } catch {
-                        print("Failed to set permissions to file \(fullPath), error: \(error)")
-                    }
-                }
+            while finishedEntries.isEmpty && runningWorkers > 0 {
+                condition.wait()
             }
-
-            ret = unzGoToNextFile(zip)
-            
-            // Update progress handler
-            if let progressHandler = progress{
-                progressHandler((currentPosition/totalSize))
+            if finishedEntries.isEmpty {
+                return nil
             }
-            
-            if let fileHandler = fileOutputHandler,
-                let encodedString = fullPath.addingPercentEncoding(withAllowedCharacters: .urlQueryAllowed),
-                let fileUrl = URL(string: encodedString) {
-                fileHandler(fileUrl)
+            let entries = finishedEntries
+            finishedEntries.removeAll()
+            return entries
+        }
+    }
+    
+    /**
+     Extraction worker of unzipFile: takes entries until none are left or one fails.
+     */
+    private class func unzipWorker(_ work: UnzipWork, path: String, password: String?, overwrite: Bool) {
+        defer {
+            work.workerDidExit()
+        }
+        guard let zip = openArchive(path) else {
+            work.fail(ZipError.unzipFail)
+            return
+        }
+        defer {
+            unzClose(zip)
+        }
+        var buffer = Array<CUnsignedChar>(repeating: 0, count: Int(unzipBufferSize))
+        while let entry = work.nextEntry() {
+            do {
+                try unzipEntry(entry, from: zip, password: password, overwrite: overwrite, buffer: &buffer)
+            } catch {
+                work.fail(error)
+                return
             }
-            
-            progressTracker.completedUnitCount = Int64(currentPosition)
-            
-        } while (ret == UNZ_OK && ret != UNZ_END_OF_LIST_OF_FILE)
+            work.finish(entry)
+        }
+    }
+    
+    /**
+     Extract one file entry through the given handle.
+     
+     - parameter entry:     Entry from readEntries.
+     - parameter zip:       Archive handle owned by the calling worker.
+     - parameter password:  Optional password if file is protected.
+     - parameter overwrite: Overwrite bool.
+     - parameter buffer:    Read buffer owned by the calling worker.
+     
+     - throws: Error if the entry cannot be read, fails its CRC check or cannot be written.
+     */
+    private class func unzipEntry(_ entry: UnzipEntry, from zip: unzFile, password: String?, overwrite: Bool, buffer: inout [CUnsignedChar]) throws {
+        let fileManager = FileManager.default
+        let fullPath = entry.fullPath
         
-        // Completed. Update progress handler.
+        if fileManager.fileExists(atPath: fullPath) && !overwrite {
+            throw ZipError.unzipFail
+        }
+        
+        var filePos = entry.filePos
+        if unzGoToFilePos64(zip, &filePos) != UNZ_OK {
+            throw ZipError.unzipFail
+        }
+        
+        var ret: Int32 = 0
+        if let cPassword = password?.cString(using: String.Encoding.ascii) {
+            ret = unzOpenCurrentFilePassword(zip, cPassword)
+        }
+        else {
+            ret = unzOpenCurrentFile(zip);
+        }
+        if ret != UNZ_OK {
+            throw ZipError.unzipFail
+        }
+        
+        var writeBytes: UInt64 = 0
+        var filePointer: UnsafeMutablePointer<FILE>?
+        filePointer = fopen(fullPath, "wb")
+        while filePointer != nil {
+            let readBytes = unzReadCurrentFile(zip, &buffer, UInt32(buffer.count))
+            if readBytes > 0 {
+                guard fwrite(buffer, Int(readBytes), 1, filePointer) == 1 else {
+                    fclose(filePointer)
+                    unzCloseCurrentFile(zip)
+                    throw ZipError.unzipFail
+                }
+                writeBytes += UInt64(readBytes)
+            }
+            else {
+                break
+            }
+        }
+        
+        if let fp = filePointer { fclose(fp) }
+        
+        let crc_ret = unzCloseCurrentFile(zip)
+        if crc_ret == UNZ_CRCERROR {
+            throw ZipError.unzipFail
+        }
+        guard writeBytes == entry.uncompressedSize else {
+            throw ZipError.unzipFail
+        }
+        
+        //Set file permissions from current fileInfo
+        if entry.externalFileAttributes != 0 {
+            let permissions = (entry.externalFileAttributes >> 16) & 0x1FF
+            //We will devifne a valid permission range between Owner read only to full access
+            if permissions >= 0o400 && permissions <= 0o777 {
+                do {
+                    try fileManager.setAttributes([.posixPermissions : permissions], ofItemAtPath: fullPath)
+                } catch {
+                    print("Failed to set permissions to file \(fullPath), error: \(error)")
+                }
+            }
+        }
+    }
+    
+    /**
+     Report a finished entry to the progress closure, the file output handler and the progress tracker.
+     */
+    private class func notifyUnzipped(_ entry: UnzipEntry, currentPosition: Double, totalSize: Double, progressTracker: Progress, progress: ((_ progress: Double) -> ())?, fileOutputHandler: ((_ unzippedFile: URL) -> Void)?) {
+        // Update progress handler
         if let progressHandler = progress{
-            progressHandler(1.0)
+            progressHandler((currentPosition/totalSize))
         }
         
-        progressTracker.completedUnitCount = Int64(totalSize)
+        if let fileHandler = fileOutputHandler,
+            let encodedString = entry.fullPath.addingPercentEncoding(withAllowedCharacters: .urlQueryAllowed),
+            let fileUrl = URL(string: encodedString) {
+            fileHandler(fileUrl)
+        }
         
+        progressTracker.completedUnitCount = Int64(currentPosition)
     }
     
     // MARK: Zip
@@ -353,13 +750,9 @@ public class Zip {
                 guard let buffer = malloc(chunkSize) else {
                     throw ZipError.zipFail
                 }
-                if let password = password, let fileName = fileName {
-                    zipOpenNewFileInZip3(zip, fileName, &zipInfo, nil, 0, nil, 0, nil,Z_DEFLATED, compression.minizipCompression, 0, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY, password, 0)
-                }
-                else if let fileName = fileName {
-                    zipOpenNewFileInZip3(zip, fileName, &zipInfo, nil, 0, nil, 0, nil,Z_DEFLATED, compression.minizipCompression, 0, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY, nil, 0)
-                }
-                else {
+                guard let fileName = fileName,
+                      openNewFile(in: zip, fileName: fileName, zipInfo: &zipInfo, password: password, compression: compression) == ZIP_OK else {
+                    free(buffer)
                     throw ZipError.zipFail
                 }
                 var length: Int = 0
@@ -431,42 +824,13 @@ public class Zip {
                 continue
             }
 
-            // Setup the zip file info
-            var zipInfo = zip_fileinfo(tmz_date: tm_zip(tm_sec: 0, tm_min: 0, tm_hour: 0, tm_mday: 0, tm_mon: 0, tm_year: 0),
-                                       dosDate: 0,
-                                       internal_fa: 0,
-                                       external_fa: 0)
-
-            if let modifiedTime = archiveFile.modifiedTime {
-                let calendar = Calendar.current
-                zipInfo.tmz_date.tm_sec = UInt32(calendar.component(.second, from: modifiedTime))
-                zipInfo.tmz_date.tm_min = UInt32(calendar.component(.minute, from: modifiedTime))
-                zipInfo.tmz_date.tm_hour = UInt32(calendar.component(.hour, from: modifiedTime))
-                zipInfo.tmz_date.tm_mday = UInt32(calendar.component(.day, from: modifiedTime))
-                zipInfo.tmz_date.tm_mon = UInt32(calendar.component(.month, from: modifiedTime))
-                zipInfo.tmz_date.tm_year = UInt32(calendar.component(.year, from: modifiedTime))
+            do {
+                try writeArchiveFile(archiveFile, to: zip, password: password, compression: compression)
+            } catch {
+                zipClose(zip, nil)
+                throw error
             }
 
-            // Write the data as a file to zip
-            zipOpenNewFileInZip3(zip,
-                                 archiveFile.filename,
-                                 &zipInfo,
-                                 nil,
-                                 0,
-                                 nil,
-                                 0,
-                                 nil,
-                                 Z_DEFLATED,
-                                 compression.minizipCompression,
-                                 0,
-                                 -MAX_WBITS,
-                                 DEF_MEM_LEVEL,
-                                 Z_DEFAULT_STRATEGY,
-                                 password,
-                                 0)
-            zipWriteInFileInZip(zip, archiveFile.data.bytes, UInt32(archiveFile.data.length))
-            zipCloseFileInZip(zip)
-
             // Update progress handler
             currentPosition += archiveFile.data.length
 
@@ -487,6 +851,264 @@ public class Zip {
         progressTracker.completedUnitCount = Int64(totalSize)
     }
     
+    /**
+     Zip data in memory to an in-memory archive.
+     
+     - parameter archiveFiles: Array of Archive Files.
+     - parameter password:     Password string. Optional.
+     - parameter compression:  Compression strategy
+     
+     - throws: Error if zipping fails.
+     
+     - returns: The zipped archive.
+     */
+    public class func zipToData(_ archiveFiles: [ArchiveFile], password: String? = nil, compression: ZipCompression = .DefaultCompression) throws -> Data {
+        
+        // The descriptor is updated by every write until zipClose, so it needs a stable address
+        let memory = UnsafeMutablePointer<zlib_memory_def>.allocate(capacity: 1)
+        memory.initialize(to: zlib_memory_def())
+        defer {
+            memory.deallocate()
+        }
+        
+        guard let zip = zipOpenMemory(memory, APPEND_STATUS_CREATE) else {
+            throw ZipError.zipFail
+        }
+        
+        for archiveFile in archiveFiles {
+            
+            // Skip empty data
+            if archiveFile.data.length == 0 {
+                continue
+            }
+            
+            do {
+                try writeArchiveFile(archiveFile, to: zip, password: password, compression: compression)
+            } catch {
+                zipClose(zip, nil)
+                free(memory.pointee.base)
+                throw error
+            }
+        }
+        
+        guard zipClose(zip, nil) == ZIP_OK, let base = memory.pointee.base else {
+            free(memory.pointee.base)
+            throw ZipError.zipFail
+        }
+        
+        return Data(bytesNoCopy: base, count: Int(memory.pointee.size), deallocator: .free)
+    }
+    
+    /**
+     Merge archives into one without recompressing their entries.
+     
+     - parameter zipFilePaths: Local file paths of the archives to merge. NSURL.
+     - parameter destination:  Destination NSURL, should lead to a .zip filepath.
+     
+     - throws: Error if an archive cannot be read, holds an encrypted entry, or the destination cannot be written.
+     
+     - notes: An entry of a later archive replaces a same-named entry of an earlier one.
+     */
+    public class func merge(_ zipFilePaths: [URL], into destination: URL) throws {
+        
+        // Walk every central directory once, remembering where each entry lives and which archive
+        // provides each name, so that every name is written once
+        var sources = [unzFile]()
+        defer {
+            sources.forEach { unzClose($0) }
+        }
+        var sourceEntries = [[(entryName: String, filePos: unz64_file_pos)]]()
+        var providers = [String: Int]()
+        for (index, zipFilePath) in zipFilePaths.enumerated() {
+            guard let source = openArchive(zipFilePath.path) else {
+                throw ZipError.unzipFail
+            }
+            sources.append(source)
+            var entries = [(entryName: String, filePos: unz64_file_pos)]()
+            try forEachEntry(source) { entryName in
+                var filePos = unz64_file_pos()
+                if unzGetFilePos64(source, &filePos) != UNZ_OK {
+                    throw ZipError.unzipFail
+                }
+                entries.append((entryName, filePos))
+                providers[entryName] = index
+            }
+            sourceEntries.append(entries)
+        }
+        
+        try createArchive(destination) { zip in
+            for (index, source) in sources.enumerated() {
+                for entry in sourceEntries[index] where providers[entry.entryName] == index {
+                    var filePos = entry.filePos
+                    if unzGoToFilePos64(source, &filePos) != UNZ_OK {
+                        throw ZipError.unzipFail
+                    }
+                    if zipCopyEntryRaw(source, zip) != ZIP_OK {
+                        throw ZipError.zipFail
+                    }
+                }
+            }
+        }
+    }
+    
+    /**
+     Copy the wanted entries of an archive into a new one without recompressing them.
+     
+     - parameter zipFilePath: Local file path of zipped file. NSURL.
+     - parameter destination: Destination NSURL, should lead to a .zip filepath.
+     - parameter isIncluded:  Closure deciding from its path in the archive whether an entry is kept.
+     
+     - throws: Error if the archive cannot be read, a kept entry is encrypted, or the destination cannot be written.
+     */
+    public class func filter(_ zipFilePath: URL, destination: URL, isIncluded: (_ entryName: String) throws -> Bool) throws {
+        try copyEntries(from: zipFilePath, to: destination, isIncluded: isIncluded)
+    }
+    
+    /**
+     Raw copy the wanted entries of an archive into a new archive with zipCopyEntryRaw.
+     
+     - parameter zipFilePath: Local file path of the source archive.
+     - parameter destination: Destination NSURL, should lead to a .zip filepath.
+     - parameter isIncluded:  Closure given the entry path, true to copy the entry.
+     
+     - throws: Error if the source cannot be read or an entry cannot be copied.
+     */
+    private class func copyEntries(from zipFilePath: URL, to destination: URL, isIncluded: (_ entryName: String) throws -> Bool) throws {
+        // Stored entries are read straight out of the mapping
+        guard let source = openArchive(zipFilePath.path) else {
+            throw ZipError.unzipFail
+        }
+        defer {
+            unzClose(source)
+        }
+        try createArchive(destination) { zip in
+            try forEachEntry(source) { entryName in
+                if try isIncluded(entryName) == false {
+                    return
+                }
+                if zipCopyEntryRaw(source, zip) != ZIP_OK {
+                    throw ZipError.zipFail
+                }
+            }
+        }
+    }
+    
+    /**
+     Create an archive, fill it with body and close it. The archive is removed if anything fails.
+     
+     - parameter destination: Destination NSURL, should lead to a .zip filepath.
+     - parameter body:        Closure writing the entries of the open zip.
+     
+     - throws: Error if the destination cannot be written, or the error of body.
+     */
+    private class func createArchive(_ destination: URL, body: (_ zip: zipFile) throws -> Void) throws {
+        guard let zip = zipOpen(destination.path, APPEND_STATUS_CREATE) else {
+            throw ZipError.zipFail
+        }
+        
+        var copyError: Error?
+        do {
+            try body(zip)
+        }
+        catch {
+            copyError = error
+        }
+        
+        if zipClose(zip, nil) != ZIP_OK && copyError == nil {
+            copyError = ZipError.zipFail
+        }
+        if let copyError = copyError {
+            try? FileManager.default.removeItem(at: destination)
+            throw copyError
+        }
+    }
+    
+    /**
+     Walk the central directory and call body positioned on each entry.
+     
+     - parameter zip:  Archive handle.
+     - parameter body: Closure given the path of the current entry in the archive.
+     
+     - throws: Error if the central directory cannot be read, or the error of body.
+     */
+    private class func forEachEntry(_ zip: unzFile, body: (_ entryName: String) throws -> Void) throws {
+        var ret = unzGoToFirstFile(zip)
+        var fileName = Array<CChar>(repeating: 0, count: 256)
+        while ret == UNZ_OK {
+            var fileInfo = unz_file_info64()
+            if unzGetCurrentFileInfo64(zip, &fileInfo, nil, 0, nil, 0, nil, 0) != UNZ_OK {
+                throw ZipError.unzipFail
+            }
+            let fileNameSize = Int(fileInfo.size_filename) + 1
+            if fileName.count < fileNameSize {
+                fileName = Array<CChar>(repeating: 0, count: fileNameSize)
+            }
+            unzGetCurrentFileInfo64(zip, &fileInfo, &fileName, UInt(fileNameSize), nil, 0, nil, 0)
+            fileName[Int(fileInfo.size_filename)] = 0
+            
+            try body(String(cString: fileName))
+            
+            ret = unzGoToNextFile(zip)
+        }
+        if ret != UNZ_END_OF_LIST_OF_FILE {
+            throw ZipError.unzipFail
+        }
+    }
+    
+    /**
+     Write one archive file as a new entry of an open zip.
+     
+     - parameter archiveFile: Archive File to write.
+     - parameter zip:         Open zip handle.
+     - parameter password:    Password string. Optional.
+     - parameter compression: Compression strategy
+     
+     - throws: Error if the entry cannot be written.
+     */
+    private class func writeArchiveFile(_ archiveFile: ArchiveFile, to zip: zipFile, password: String?, compression: ZipCompression) throws {
+        
+        // Setup the zip file info
+        var zipInfo = zip_fileinfo(tmz_date: tm_zip(tm_sec: 0, tm_min: 0, tm_hour: 0, tm_mday: 0, tm_mon: 0, tm_year: 0),
+                                   dosDate: 0,
+                                   internal_fa: 0,
+                                   external_fa: 0)
+
+        if let modifiedTime = archiveFile.modifiedTime {
+            let calendar = Calendar.current
+            zipInfo.tmz_date.tm_sec = UInt32(calendar.component(.second, from: modifiedTime))
+            zipInfo.tmz_date.tm_min = UInt32(calendar.component(.minute, from: modifiedTime))
+            zipInfo.tmz_date.tm_hour = UInt32(calendar.component(.hour, from: modifiedTime))
+            zipInfo.tmz_date.tm_mday = UInt32(calendar.component(.day, from: modifiedTime))
+            zipInfo.tmz_date.tm_mon = UInt32(calendar.component(.month, from: modifiedTime)) - 1
+            zipInfo.tmz_date.tm_year = UInt32(calendar.component(.year, from: modifiedTime))
+        }
+
+        // Write the data as a file to zip
+        guard archiveFile.data.length <= Int(UInt32.max),
+              openNewFile(in: zip, fileName: archiveFile.filename, zipInfo: &zipInfo, password: password, compression: compression) == ZIP_OK else {
+            throw ZipError.zipFail
+        }
+        let ret = zipWriteInFileInZip(zip, archiveFile.data.bytes, UInt32(archiveFile.data.length))
+        if zipCloseFileInZip(zip) != ZIP_OK || ret != ZIP_OK {
+            throw ZipError.zipFail
+        }
+    }
+
+    /**
+     Open a new deflated entry of an open zip with the level of the compression strategy.
+
+     - parameter zip:         Open zip handle.
+     - parameter fileName:    Name of the entry.
+     - parameter zipInfo:     Date and attributes of the entry.
+     - parameter password:    Password string. Optional.
+     - parameter compression: Compression strategy
+
+     - returns: The minizip status, ZIP_OK if the entry is open.
+     */
+    private class func openNewFile(in zip: zipFile, fileName: String, zipInfo: inout zip_fileinfo, password: String?, compression: ZipCompression) -> Int32 {
+        return zipOpenNewFileInZip5(zip, fileName, &zipInfo, nil, 0, nil, 0, nil, Z_DEFLATED, compression.minizipCompression, 0, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY, password, 0, 0, 0, 0, compression.minizipThreads)
+    }
+    
     /**
      Check if file extension is invalid.
      
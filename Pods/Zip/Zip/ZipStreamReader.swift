@@ -0,0 +1,137 @@
+//
+//  ZipStreamReader.swift
+//  Zip
+//
+
+import Foundation
+@_implementationOnly import Minizip
+
+/// Unzips an archive while it is still arriving, entry by entry from its local headers.
+public class ZipStreamReader {
+
+    /// Closure called with each file entry once it is complete and its CRC is checked.
+    public typealias EntryHandler = (_ entryName: String, _ data: Data) -> Void
+
+    private let stream: UnsafeMutableRawPointer
+    private let entryHandler: EntryHandler
+    private var entryName: String?
+    private var entryData = Data()
+    private var buffer = [CUnsignedChar](repeating: 0, count: 64 * 1024)
+    private var fileName = [CChar](repeating: 0, count: 1024)
+    private var reachedEnd = false
+
+    /// Upper bound of the buffer reserved up front for an entry.
+    private static let maxReservedCapacity: UInt64 = 1024 * 1024
+
+    /**
+     Create a reader. It is not thread safe, feed it from one queue at a time.
+
+     - parameter entryHandler: Closure called with each file entry, on the queue feeding the reader.
+
+     - throws: Error if the reader cannot be created.
+     */
+    public init(entryHandler: @escaping EntryHandler) throws {
+        guard let stream = unzStreamOpen() else {
+            throw ZipError.unzipFail
+        }
+        self.stream = stream
+        self.entryHandler = entryHandler
+    }
+
+    deinit {
+        unzStreamClose(stream)
+    }
+
+    /// True once the central directory was reached, every entry has been handled.
+    public var isComplete: Bool {
+        return reachedEnd
+    }
+
+    /**
+     Append the next bytes of the archive and handle the entries they complete.
+
+     - parameter data: Next chunk of the archive.
+
+     - throws: Error if the archive is malformed, an entry fails its CRC check or cannot be decoded.
+     */
+    public func append(_ data: Data) throws {
+        if data.isEmpty || reachedEnd {
+            return
+        }
+        let ret = data.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) -> Int32 in
+            return unzStreamWrite(stream, bytes.baseAddress, UInt(bytes.count))
+        }
+        if ret != UNZ_OK {
+            throw ZipError.unzipFail
+        }
+        try readEntries()
+    }
+
+    /**
+     Mark the end of the archive.
+
+     - throws: Error if the archive is truncated.
+     */
+    public func finish() throws {
+        if reachedEnd {
+            return
+        }
+        if unzStreamWrite(stream, nil, 0) != UNZ_OK {
+            throw ZipError.unzipFail
+        }
+        try readEntries()
+        if !reachedEnd {
+            throw ZipError.unzipFail
+        }
+    }
+
+    /**
+     Inflate as far as the bytes received so far allow.
+
+     - throws: Error if the archive is malformed, an entry fails its CRC check or cannot be decoded.
+     */
+    private func readEntries() throws {
+        while !reachedEnd {
+            if entryName == nil {
+                var fileInfo = unz_file_info64()
+                let ret = unzStreamNextEntry(stream, &fileInfo, &fileName, UInt(fileName.count))
+                if ret == UNZ_NEEDINPUT {
+                    return
+                }
+                if ret == UNZ_END_OF_LIST_OF_FILE {
+                    reachedEnd = true
+                    return
+                }
+                if ret != UNZ_OK {
+                    throw ZipError.unzipFail
+                }
+
+                let pathString = String(cString: fileName).replacingOccurrences(of: "\\", with: "/")
+                if pathString.isEmpty || pathString.hasSuffix("/") {
+                    continue
+                }
+                entryName = pathString
+                // The size comes from the local header and is not trusted, larger entries grow as they inflate
+                entryData = Data(capacity: Int(min(fileInfo.uncompressed_size, ZipStreamReader.maxReservedCapacity)))
+            }
+
+            let readBytes = unzStreamReadEntry(stream, &buffer, UInt32(buffer.count))
+            if readBytes > 0 {
+                entryData.append(buffer, count: Int(readBytes))
+                continue
+            }
+            if readBytes == UNZ_NEEDINPUT {
+                return
+            }
+            if readBytes != 0 {
+                throw ZipError.unzipFail
+            }
+
+            if let name = entryName {
+                entryName = nil
+                entryHandler(name, entryData)
+                entryData = Data()
+            }
+        }
+    }
+}
@@ -139,8 +139,23 @@ typedef struct zlib_filefunc64_def_s
     voidpf               opaque;
 } zlib_filefunc64_def;
 
+/* Archive held in memory, passed as the path to the open functions when using fill_memory_filefunc64.
+   Readers take a copy of the descriptor when opening. Writers update it in place, base must then be
+   NULL or come from malloc, it is grown with realloc and owned by the caller after closing. */
+typedef struct zlib_memory_def_s
+{
+    void*    base;                      /* archive bytes */
+    ZPOS64_T size;                      /* number of valid bytes */
+    ZPOS64_T limit;                     /* number of allocated bytes, only used when writing */
+} zlib_memory_def;
+
 void fill_fopen_filefunc OF((zlib_filefunc_def* pzlib_filefunc_def));
 void fill_fopen64_filefunc OF((zlib_filefunc64_def* pzlib_filefunc_def));
+void fill_memory_filefunc64 OF((zlib_filefunc64_def* pzlib_filefunc_def));
+#ifndef _WIN32
+/* Read-only functions that map the whole archive in memory, for opening with unzOpen2_64 */
+void fill_mmap_filefunc64 OF((zlib_filefunc64_def* pzlib_filefunc_def));
+#endif
 
 /* now internal definition, only for zip.c and unzip.h */
 typedef struct zlib_filefunc64_32_def_s
@@ -163,6 +178,9 @@ voidpf   call_zopen64 OF((const zlib_filefunc64_32_def* pfilefunc,const void*fil
 voidpf   call_zopendisk64 OF((const zlib_filefunc64_32_def* pfilefunc, voidpf filestream, int number_disk, int mode));
 long     call_zseek64 OF((const zlib_filefunc64_32_def* pfilefunc,voidpf filestream, ZPOS64_T offset, int origin));
 ZPOS64_T call_ztell64 OF((const zlib_filefunc64_32_def* pfilefunc,voidpf filestream));
+/* Pointer to size bytes at offset of a stream opened by fill_mmap_filefunc64 or fill_memory_filefunc64,
+   NULL for other streams */
+const void* call_zmap64 OF((const zlib_filefunc64_32_def* pfilefunc,voidpf filestream, ZPOS64_T offset, ZPOS64_T size));
 
 void fill_zlib_filefunc64_32_def_from_filefunc32 OF((zlib_filefunc64_32_def* p_filefunc64_32,const zlib_filefunc_def* p_filefunc32));
 
@@ -170,6 +188,7 @@ void fill_zlib_filefunc64_32_def_from_filefunc32 OF((zlib_filefunc64_32_def* p_f
 #define ZOPENDISK64(filefunc,filestream,diskn,mode) (call_zopendisk64((&(filefunc)),(filestream),(diskn),(mode)))
 #define ZTELL64(filefunc,filestream)                (call_ztell64((&(filefunc)),(filestream)))
 #define ZSEEK64(filefunc,filestream,pos,mode)       (call_zseek64((&(filefunc)),(filestream),(pos),(mode)))
+#define ZMAP64(filefunc,filestream,offset,size)     (call_zmap64((&(filefunc)),(filestream),(offset),(size)))
 
 #ifdef __cplusplus
 }
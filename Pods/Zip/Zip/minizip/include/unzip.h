@@ -52,6 +52,7 @@ typedef voidp unzFile;
 #define UNZ_BADZIPFILE                  (-103)
 #define UNZ_INTERNALERROR               (-104)
 #define UNZ_CRCERROR                    (-105)
+#define UNZ_NEEDINPUT                   (-106)
 
 /* tm_unz contain date/time info */
 typedef struct tm_unz_s
@@ -146,6 +147,16 @@ extern unzFile ZEXPORT unzOpen2 OF((const char *path, zlib_filefunc_def* pzlib_f
 /* Open a Zip file, like unzOpen, but provide a set of file low level API for read/write operations */
 extern unzFile ZEXPORT unzOpen2_64 OF((const void *path, zlib_filefunc64_def* pzlib_filefunc_def));
 /* Open a Zip file, like unz64Open, but provide a set of file low level API for read/write 64-bit operations */
+#define UNZ_OPTION_INDEX    (1)
+
+extern unzFile ZEXPORT unzOpen3_64 OF((const void *path, zlib_filefunc64_def* pzlib_filefunc_def, int options));
+/* Open a Zip file, like unzOpen2_64, with options.
+
+   UNZ_OPTION_INDEX reads the central directory once while opening and keeps a filename hash index,
+   so unzLocateFile without a comparison function takes constant time and unzGetIndexedEntry can
+   list the entries */
+extern unzFile ZEXPORT unzOpenMemory OF((const void *buffer, ZPOS64_T size));
+/* Open a Zip archive held in memory. The buffer is not copied and must stay valid until unzClose */
 
 extern int ZEXPORT unzClose OF((unzFile file));
 /* Close a ZipFile opened with unzipOpen. If there is files inside the .Zip opened with unzOpenCurrentFile,
@@ -291,6 +302,15 @@ typedef struct unz64_file_pos_s
 extern int ZEXPORT unzGetFilePos64 OF((unzFile file, unz64_file_pos* file_pos));
 extern int ZEXPORT unzGoToFilePos64 OF((unzFile file, const unz64_file_pos* file_pos));
 
+extern int ZEXPORT unzGetIndexedEntry OF((unzFile file, ZPOS64_T number, unz_file_info64 *pfile_info,
+    const char **filename, unz64_file_pos *file_pos));
+/* Get the entry number of an archive opened with UNZ_OPTION_INDEX, without reading the central directory.
+   filename points into the index and stays valid until unzClose. Pass file_pos to unzGoToFilePos64.
+
+   return UNZ_OK if no error
+   return UNZ_END_OF_LIST_OF_FILE if number is past the last entry
+   return UNZ_PARAMERROR if the archive has no index */
+
 extern uLong ZEXPORT unzGetOffset OF((unzFile file));
 extern ZPOS64_T ZEXPORT unzGetOffset64 OF((unzFile file));
 /* Get the current file offset */
@@ -305,11 +325,71 @@ extern ZPOS64_T ZEXPORT unztell64 OF((unzFile file));
 
 extern int ZEXPORT unzseek OF((unzFile file, z_off_t offset, int origin));
 extern int ZEXPORT unzseek64 OF((unzFile file, ZPOS64_T offset, int origin));
-/* Seek within the uncompressed data if compression method is storage */
+/* Seek within the uncompressed data of the current file.
+
+   Deflated files are inflated from the nearest checkpoint built by unzBuildSeekIndex or loaded by
+   unzLoadSeekIndex, otherwise from the current position or the beginning. Once a seek skips data the
+   crc is no longer checked by unzCloseCurrentFile */
+
+extern int ZEXPORT unzBuildSeekIndex OF((unzFile file, ZPOS64_T span));
+/* Inflate the current deflated file once and keep a checkpoint about every span uncompressed bytes,
+   each holding 32K of window, so unzseek64 inflates less than span bytes. The checkpoints are released
+   by unzCloseCurrentFile. Not available for encrypted files.
+
+   return UNZ_OK if no error */
+
+extern int ZEXPORT unzSaveSeekIndex OF((unzFile file, const char* path));
+extern int ZEXPORT unzLoadSeekIndex OF((unzFile file, const char* path));
+/* Write the checkpoints of the current file to path, or read them back instead of building them.
+   Loading fails with UNZ_BADZIPFILE if they were built for a file with another crc or sizes.
+
+   return UNZ_OK if no error */
 
 extern int ZEXPORT unzeof OF((unzFile file));
 /* return 1 if the end of file was reached, 0 elsewhere */
 
+/***************************************************************************/
+/* Streaming reader
+
+   Reads an archive front to back from its local headers while it is still arriving, without the
+   central directory. Deflated files may use a data descriptor, stored files need their sizes in the
+   local header. Encrypted files and other methods can only be skipped. */
+
+#if defined(STRICTUNZIP) || defined(STRICTZIPUNZIP)
+typedef struct TagunzStream__ { int unused; } unzStream__;
+typedef unzStream__ *unzStream;
+#else
+typedef voidp unzStream;
+#endif
+
+extern unzStream ZEXPORT unzStreamOpen OF((void));
+/* Open a streaming reader, return NULL if there is not enough memory */
+
+extern int ZEXPORT unzStreamWrite OF((unzStream stream, const void* buf, uLong len));
+/* Append the next bytes of the archive, they are copied. A len of 0 marks the end of input,
+   after which incomplete data is reported as UNZ_BADZIPFILE instead of UNZ_NEEDINPUT */
+
+extern int ZEXPORT unzStreamNextEntry OF((unzStream stream, unz_file_info64* pfile_info, char* filename,
+    uLong filename_size));
+/* Skip what is left of the current file and read the next local header. Only the fields stored
+   in the local header are filled, the sizes and crc of a file with a data descriptor are 0 until
+   unzStreamReadEntry returned 0, see unzStreamGetCurrentFileInfo64.
+
+   return UNZ_OK, UNZ_NEEDINPUT if more bytes must be written first, UNZ_END_OF_LIST_OF_FILE once the
+   central directory is reached, or an error */
+
+extern int ZEXPORT unzStreamReadEntry OF((unzStream stream, voidp buf, unsigned len));
+/* Read bytes from the current file
+
+   return the number of bytes read, 0 once the whole file was read and its crc and sizes checked,
+   UNZ_NEEDINPUT if more bytes must be written first, UNZ_CRCERROR or another error */
+
+extern int ZEXPORT unzStreamGetCurrentFileInfo64 OF((unzStream stream, unz_file_info64* pfile_info));
+/* Get the information of the current file, with the data descriptor values once it was read */
+
+extern int ZEXPORT unzStreamClose OF((unzStream stream));
+/* Close the streaming reader */
+
 /***************************************************************************/
 
 #ifdef __cplusplus
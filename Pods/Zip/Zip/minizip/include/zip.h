@@ -116,6 +116,10 @@ extern zipFile ZEXPORT zipOpen3 OF((const char *pathname, int append, ZPOS64_T d
 extern zipFile ZEXPORT zipOpen3_64 OF((const void *pathname, int append, ZPOS64_T disk_size,
     const char ** globalcomment, zlib_filefunc64_def* pzlib_filefunc_def));
 
+extern zipFile ZEXPORT zipOpenMemory OF((zlib_memory_def* memory, int append));
+/* Create a zipfile in memory. The archive is written to memory->base, which is grown with realloc
+   and holds memory->size bytes after zipClose. The caller frees it, memory must stay valid until zipClose */
+
 extern int ZEXPORT zipOpenNewFileInZip OF((zipFile file, const char* filename, const zip_fileinfo* zipfi,
     const void* extrafield_local, uInt size_extrafield_local, const void* extrafield_global,
     uInt size_extrafield_global, const char* comment, int method, int level));
@@ -175,6 +179,18 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 OF((zipFile file, const char* filenam
     int strategy, const char* password, uLong crcForCrypting, uLong versionMadeBy, uLong flagBase, int zip64));
 /* Same as zipOpenNewFileInZip4 with zip64 support */
 
+extern int ZEXPORT zipOpenNewFileInZip5 OF((zipFile file, const char* filename, const zip_fileinfo* zipfi,
+    const void* extrafield_local, uInt size_extrafield_local, const void* extrafield_global,
+    uInt size_extrafield_global, const char* comment, int method, int level, int raw, int windowBits, int memLevel,
+    int strategy, const char* password, uLong crcForCrypting, uLong versionMadeBy, uLong flagBase, int zip64,
+    int threads));
+/* Same as zipOpenNewFileInZip4_64, except
+    threads : number of worker threads deflating the file, 0 or 1 for the single stream (method Z_DEFLATED only).
+              The data is cut into blocks of PARALLEL_BLOCKSIZE that are deflated independently, each primed with
+              the last 32K of the previous block, and concatenated into one deflate stream; the crc is combined
+              with crc32_combine. Files smaller than one block are deflated on the calling thread.
+              Define NO_PARALLEL_DEFLATE to build without pthread support. */
+
 extern int ZEXPORT zipWriteInFileInZip OF((zipFile file, const void* buf, unsigned len));
 /* Write data in the zipfile */
 
@@ -186,6 +202,12 @@ extern int ZEXPORT zipCloseFileInZipRaw64 OF((zipFile file, ZPOS64_T uncompresse
 /* Close the current file in the zipfile, for file opened with parameter raw=1 in zipOpenNewFileInZip2
    uncompressed_size and crc32 are value for the uncompressed size */
 
+extern int ZEXPORT zipCopyEntryRaw OF((voidp source, zipFile file));
+/* Copy the current file of source, an unzFile opened with unzip.h, into the zipfile without recompressing it
+     the compressed data, crc, sizes, date, attributes, extra fields and comment are carried over
+     as they are, the source stays positioned on the copied file
+     returns ZIP_PARAMERROR for encrypted files, which can't be carried over */
+
 extern int ZEXPORT zipClose OF((zipFile file, const char* global_comment));
 /* Close the zipfile */
 
@@ -18,6 +18,11 @@
 
 #if defined(_WIN32)
 #  define snprintf _snprintf
+#else
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
 #endif
 
 #ifdef __APPLE__
@@ -78,6 +83,52 @@ ZPOS64_T call_ztell64 (const zlib_filefunc64_32_def* pfilefunc,voidpf filestream
     return tell_uLong;
 }
 
+#ifndef _WIN32
+typedef struct
+{
+    const unsigned char *base;
+    ZPOS64_T size;
+    ZPOS64_T pos;
+    int filenameLength;
+    void *filename;
+} FILE_IOMMAP;
+
+static uLong ZCALLBACK mread_file_func OF((voidpf opaque, voidpf stream, void* buf, uLong size));
+#endif
+
+typedef struct
+{
+    zlib_memory_def *memory;
+    zlib_memory_def readonly;
+    ZPOS64_T pos;
+} MEMORY_IO;
+
+static uLong ZCALLBACK memread_file_func OF((voidpf opaque, voidpf stream, void* buf, uLong size));
+
+const void* call_zmap64 (const zlib_filefunc64_32_def* pfilefunc,voidpf filestream, ZPOS64_T offset, ZPOS64_T size)
+{
+    const unsigned char *base = NULL;
+    ZPOS64_T base_size = 0;
+
+    if (filestream == NULL)
+        return NULL;
+    if (pfilefunc->zfile_func64.zread_file == memread_file_func)
+    {
+        base = (const unsigned char*)((MEMORY_IO*)filestream)->memory->base;
+        base_size = ((MEMORY_IO*)filestream)->memory->size;
+    }
+#ifndef _WIN32
+    else if (pfilefunc->zfile_func64.zread_file == mread_file_func)
+    {
+        base = ((FILE_IOMMAP*)filestream)->base;
+        base_size = ((FILE_IOMMAP*)filestream)->size;
+    }
+#endif
+    if ((base == NULL) || (offset > base_size) || (size > base_size - offset))
+        return NULL;
+    return base + offset;
+}
+
 void fill_zlib_filefunc64_32_def_from_filefunc32(zlib_filefunc64_32_def* p_filefunc64_32,const zlib_filefunc_def* p_filefunc32)
 {
     p_filefunc64_32->zfile_func64.zopen64_file = NULL;
@@ -367,3 +418,315 @@ void fill_fopen64_filefunc (zlib_filefunc64_def* pzlib_filefunc_def)
     pzlib_filefunc_def->zerror_file = ferror_file_func;
     pzlib_filefunc_def->opaque = NULL;
 }
+
+/* Backend over a zlib_memory_def, passed as the path when opening */
+static voidpf ZCALLBACK memopen64_file_func (voidpf opaque, const void* filename, int mode)
+{
+    MEMORY_IO *iomem = NULL;
+    zlib_memory_def *memory = (zlib_memory_def*)filename;
+
+    if (memory == NULL)
+        return NULL;
+
+    iomem = (MEMORY_IO*)malloc(sizeof(MEMORY_IO));
+    if (iomem == NULL)
+        return NULL;
+    iomem->pos = 0;
+    if ((mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER) == ZLIB_FILEFUNC_MODE_READ)
+    {
+        /* Readers keep their own copy so the caller's descriptor may go out of scope */
+        iomem->readonly = *memory;
+        iomem->memory = &iomem->readonly;
+    }
+    else
+    {
+        iomem->memory = memory;
+        if (mode & ZLIB_FILEFUNC_MODE_CREATE)
+            memory->size = 0;
+    }
+    return (voidpf)iomem;
+}
+
+static voidpf ZCALLBACK memopendisk64_file_func (voidpf opaque, voidpf stream, int number_disk, int mode)
+{
+    /* Spanning is not supported for a single buffer */
+    return NULL;
+}
+
+static uLong ZCALLBACK memread_file_func (voidpf opaque, voidpf stream, void* buf, uLong size)
+{
+    MEMORY_IO *iomem = NULL;
+    if (stream == NULL)
+        return -1;
+    iomem = (MEMORY_IO*)stream;
+    if (iomem->pos >= iomem->memory->size)
+        return 0;
+    if (size > iomem->memory->size - iomem->pos)
+        size = (uLong)(iomem->memory->size - iomem->pos);
+    memcpy(buf, (const char*)iomem->memory->base + iomem->pos, (size_t)size);
+    iomem->pos += size;
+    return size;
+}
+
+static uLong ZCALLBACK memwrite_file_func (voidpf opaque, voidpf stream, const void* buf, uLong size)
+{
+    MEMORY_IO *iomem = NULL;
+    zlib_memory_def *memory = NULL;
+    if (stream == NULL)
+        return -1;
+    iomem = (MEMORY_IO*)stream;
+    memory = iomem->memory;
+    if (memory == &iomem->readonly)
+        return 0;
+
+    if (iomem->pos + size > memory->limit)
+    {
+        ZPOS64_T new_limit = (memory->limit > 0) ? memory->limit : 4096;
+        void *new_base = NULL;
+        while (new_limit < iomem->pos + size)
+            new_limit *= 2;
+        new_base = realloc(memory->base, (size_t)new_limit);
+        if (new_base == NULL)
+            return 0;
+        memory->base = new_base;
+        memory->limit = new_limit;
+    }
+    /* A seek past the end leaves a hole, fill it like a file would */
+    if (iomem->pos > memory->size)
+        memset((char*)memory->base + memory->size, 0, (size_t)(iomem->pos - memory->size));
+    memcpy((char*)memory->base + iomem->pos, buf, (size_t)size);
+    iomem->pos += size;
+    if (iomem->pos > memory->size)
+        memory->size = iomem->pos;
+    return size;
+}
+
+static ZPOS64_T ZCALLBACK memtell64_file_func (voidpf opaque, voidpf stream)
+{
+    MEMORY_IO *iomem = NULL;
+    if (stream == NULL)
+        return -1;
+    iomem = (MEMORY_IO*)stream;
+    return iomem->pos;
+}
+
+static long ZCALLBACK memseek64_file_func (voidpf opaque, voidpf stream, ZPOS64_T offset, int origin)
+{
+    MEMORY_IO *iomem = NULL;
+    ZPOS64_T new_pos = 0;
+
+    if (stream == NULL)
+        return -1;
+    iomem = (MEMORY_IO*)stream;
+
+    switch (origin)
+    {
+        case ZLIB_FILEFUNC_SEEK_CUR:
+            new_pos = iomem->pos + offset;
+            break;
+        case ZLIB_FILEFUNC_SEEK_END:
+            new_pos = iomem->memory->size + offset;
+            break;
+        case ZLIB_FILEFUNC_SEEK_SET:
+            new_pos = offset;
+            break;
+        default:
+            return -1;
+    }
+
+    /* Only writers may move past the end of the data */
+    if ((new_pos > iomem->memory->size) && (iomem->memory == &iomem->readonly))
+        return -1;
+    iomem->pos = new_pos;
+    return 0;
+}
+
+static int ZCALLBACK memclose_file_func (voidpf opaque, voidpf stream)
+{
+    if (stream == NULL)
+        return -1;
+    free(stream);
+    return 0;
+}
+
+static int ZCALLBACK memerror_file_func (voidpf opaque, voidpf stream)
+{
+    if (stream == NULL)
+        return -1;
+    return 0;
+}
+
+void fill_memory_filefunc64 (zlib_filefunc64_def* pzlib_filefunc_def)
+{
+    pzlib_filefunc_def->zopen64_file = memopen64_file_func;
+    pzlib_filefunc_def->zopendisk64_file = memopendisk64_file_func;
+    pzlib_filefunc_def->zread_file = memread_file_func;
+    pzlib_filefunc_def->zwrite_file = memwrite_file_func;
+    pzlib_filefunc_def->ztell64_file = memtell64_file_func;
+    pzlib_filefunc_def->zseek64_file = memseek64_file_func;
+    pzlib_filefunc_def->zclose_file = memclose_file_func;
+    pzlib_filefunc_def->zerror_file = memerror_file_func;
+    pzlib_filefunc_def->opaque = NULL;
+}
+
+#ifndef _WIN32
+/* Read-only backend that maps the whole archive, reads are served with memcpy */
+static voidpf ZCALLBACK mopen64_file_func (voidpf opaque, const void* filename, int mode)
+{
+    FILE_IOMMAP *iommap = NULL;
+    struct stat st;
+    void *base = NULL;
+    int fd = -1;
+
+    if ((filename == NULL) || ((mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER) != ZLIB_FILEFUNC_MODE_READ))
+        return NULL;
+
+    fd = open((const char*)filename, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+    if ((fstat(fd, &st) != 0) || (st.st_size < 0))
+    {
+        close(fd);
+        return NULL;
+    }
+    if (st.st_size > 0)
+    {
+        base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED)
+        {
+            close(fd);
+            return NULL;
+        }
+    }
+    /* The mapping stays valid after the descriptor is closed */
+    close(fd);
+
+    iommap = (FILE_IOMMAP*)malloc(sizeof(FILE_IOMMAP));
+    iommap->base = (const unsigned char*)base;
+    iommap->size = (ZPOS64_T)st.st_size;
+    iommap->pos = 0;
+    iommap->filenameLength = (int)strlen((const char*)filename) + 1;
+    iommap->filename = (char*)malloc(iommap->filenameLength * sizeof(char));
+    strncpy(iommap->filename, (const char*)filename, iommap->filenameLength);
+    return (voidpf)iommap;
+}
+
+static voidpf ZCALLBACK mopendisk64_file_func (voidpf opaque, voidpf stream, int number_disk, int mode)
+{
+    FILE_IOMMAP *iommap = NULL;
+    char *diskFilename = NULL;
+    voidpf ret = NULL;
+    int i = 0;
+
+    if (stream == NULL)
+        return NULL;
+    iommap = (FILE_IOMMAP*)stream;
+    diskFilename = (char*)malloc(iommap->filenameLength * sizeof(char));
+    strncpy(diskFilename, iommap->filename, iommap->filenameLength);
+    for (i = iommap->filenameLength - 1; i >= 0; i -= 1)
+    {
+        if (diskFilename[i] != '.')
+            continue;
+        snprintf(&diskFilename[i], iommap->filenameLength - i, ".z%02d", number_disk + 1);
+        break;
+    }
+    if (i >= 0)
+        ret = mopen64_file_func(opaque, diskFilename, mode);
+    free(diskFilename);
+    return ret;
+}
+
+static uLong ZCALLBACK mread_file_func (voidpf opaque, voidpf stream, void* buf, uLong size)
+{
+    FILE_IOMMAP *iommap = NULL;
+    if (stream == NULL)
+        return -1;
+    iommap = (FILE_IOMMAP*)stream;
+    if (iommap->pos >= iommap->size)
+        return 0;
+    if (size > iommap->size - iommap->pos)
+        size = (uLong)(iommap->size - iommap->pos);
+    memcpy(buf, iommap->base + iommap->pos, (size_t)size);
+    iommap->pos += size;
+    return size;
+}
+
+static uLong ZCALLBACK mwrite_file_func (voidpf opaque, voidpf stream, const void* buf, uLong size)
+{
+    return 0;
+}
+
+static ZPOS64_T ZCALLBACK mtell64_file_func (voidpf opaque, voidpf stream)
+{
+    FILE_IOMMAP *iommap = NULL;
+    if (stream == NULL)
+        return -1;
+    iommap = (FILE_IOMMAP*)stream;
+    return iommap->pos;
+}
+
+static long ZCALLBACK mseek64_file_func (voidpf opaque, voidpf stream, ZPOS64_T offset, int origin)
+{
+    FILE_IOMMAP *iommap = NULL;
+    ZPOS64_T new_pos = 0;
+
+    if (stream == NULL)
+        return -1;
+    iommap = (FILE_IOMMAP*)stream;
+
+    switch (origin)
+    {
+        case ZLIB_FILEFUNC_SEEK_CUR:
+            new_pos = iommap->pos + offset;
+            break;
+        case ZLIB_FILEFUNC_SEEK_END:
+            new_pos = iommap->size + offset;
+            break;
+        case ZLIB_FILEFUNC_SEEK_SET:
+            new_pos = offset;
+            break;
+        default:
+            return -1;
+    }
+
+    if (new_pos > iommap->size)
+        return -1;
+    iommap->pos = new_pos;
+    return 0;
+}
+
+static int ZCALLBACK mclose_file_func (voidpf opaque, voidpf stream)
+{
+    FILE_IOMMAP *iommap = NULL;
+    int ret = 0;
+    if (stream == NULL)
+        return -1;
+    iommap = (FILE_IOMMAP*)stream;
+    if (iommap->filename != NULL)
+        free(iommap->filename);
+    if (iommap->base != NULL)
+        ret = munmap((void*)iommap->base, (size_t)iommap->size);
+    free(iommap);
+    return ret;
+}
+
+static int ZCALLBACK merror_file_func (voidpf opaque, voidpf stream)
+{
+    if (stream == NULL)
+        return -1;
+    return 0;
+}
+
+void fill_mmap_filefunc64 (zlib_filefunc64_def* pzlib_filefunc_def)
+{
+    pzlib_filefunc_def->zopen64_file = mopen64_file_func;
+    pzlib_filefunc_def->zopendisk64_file = mopendisk64_file_func;
+    pzlib_filefunc_def->zread_file = mread_file_func;
+    pzlib_filefunc_def->zwrite_file = mwrite_file_func;
+    pzlib_filefunc_def->ztell64_file = mtell64_file_func;
+    pzlib_filefunc_def->zseek64_file = mseek64_file_func;
+    pzlib_filefunc_def->zclose_file = mclose_file_func;
+    pzlib_filefunc_def->zerror_file = merror_file_func;
+    pzlib_filefunc_def->opaque = NULL;
+}
+#endif
@@ -80,6 +80,12 @@
 #  define UNZ_MAXFILENAMEINZIP (256)
 #endif
 
+#ifndef UNZ_SEEKWINDOW
+#  define UNZ_SEEKWINDOW (32768U)
+#endif
+#define UNZ_SEEKINDEXMAGIC       (0x5849535a) /* "ZSIX" */
+#define UNZ_SEEKINDEXVERSION     (1)
+
 #ifndef ALLOC
 #  define ALLOC(size) (malloc(size))
 #endif
@@ -102,6 +108,24 @@ typedef struct unz_file_info64_internal_s
 #endif
 } unz_file_info64_internal;
 
+/* unz64_seek_point contain the inflate state at a checkpoint of a deflated file */
+typedef struct
+{
+    ZPOS64_T out;                       /* offset in the uncompressed data */
+    ZPOS64_T in;                        /* offset of the first full byte in the compressed data */
+    int bits;                           /* number of bits (1-7) of the byte before in, or 0 */
+    unsigned char window[UNZ_SEEKWINDOW];
+                                        /* uncompressed data before the checkpoint */
+} unz64_seek_point;
+
+/* unz64_seek_index contain the checkpoints of the current file, in increasing offset order */
+typedef struct
+{
+    unz64_seek_point* points;
+    uLong number_point;
+    ZPOS64_T span;                      /* minimal uncompressed distance between checkpoints */
+} unz64_seek_index;
+
 /* file_in_zip_read_info_s contain internal information about a file in zipfile */
 typedef struct
 {
@@ -134,8 +158,32 @@ typedef struct
     uLong compression_method;           /* compression method (0==store) */
     ZPOS64_T byte_before_the_zipfile;   /* byte before the zipfile, (>0 for sfx) */
     int raw;
+    int zero_copy;                      /* flag set if stored data is read straight from a mapped archive */
+    ZPOS64_T pos_data_begin;            /* position of the compressed data in the zipfile */
+    int crc_lost;                       /* flag set if a seek skipped data, so crc32 cannot be checked */
+    unz64_seek_index* seek_index;       /* checkpoints for unzseek64, NULL if not built */
 } file_in_zip64_read_info_s;
 
+/* unz64_index_entry contain what is needed to make a file current without reading the central dir */
+typedef struct
+{
+    unz_file_info64 file_info;
+    unz_file_info64_internal file_info_internal;
+    ZPOS64_T pos_in_central_dir;        /* pos of the file in the central dir */
+    ZPOS64_T name_offset;               /* offset of the filename in the index names */
+    uLong hash;                         /* hash of the filename */
+} unz64_index_entry;
+
+/* unz64_index map filenames to entries of the central dir, built when opening with UNZ_OPTION_INDEX */
+typedef struct
+{
+    unz64_index_entry* entries;         /* entries in central dir order */
+    ZPOS64_T number_entry;              /* number of entries */
+    char* names;                        /* filenames, each followed by a zero */
+    ZPOS64_T* slots;                    /* open addressed table of entry number + 1, 0 for an empty slot */
+    ZPOS64_T number_slot;               /* size of the table, a power of two */
+} unz64_index;
+
 /* unz64_s contain internal information about the zipfile */
 typedef struct
 {
@@ -159,6 +207,7 @@ typedef struct
     file_in_zip64_read_info_s* pfile_in_zip_read;
                                         /* structure about the current file if we are decompressing it */
     int isZip64;                        /* is the current file zip64 */
+    unz64_index* index;                 /* filename index, NULL if not opened with UNZ_OPTION_INDEX */
 #ifndef NOUNCRYPT
     unsigned long keys[3];              /* keys defining the pseudo-random sequence */
     const unsigned long* pcrc_32_tab;
@@ -389,7 +438,10 @@ local ZPOS64_T unz64local_SearchCentralDir64(const zlib_filefunc64_32_def* pzlib
     return offset;
 }
 
-local unzFile unzOpenInternal(const void *path, zlib_filefunc64_32_def* pzlib_filefunc64_32_def)
+local unz64_index* unz64local_BuildIndex OF((unzFile file));
+local void unz64local_FreeIndex OF((unz64_index* index));
+
+local unzFile unzOpenInternal(const void *path, zlib_filefunc64_32_def* pzlib_filefunc64_32_def, int options)
 {
     unz64_s us;
     unz64_s *s;
@@ -539,11 +591,15 @@ local unzFile unzOpenInternal(const void *path, zlib_filefunc64_32_def* pzlib_fi
     us.byte_before_the_zipfile = central_pos - (us.offset_central_dir + us.size_central_dir);
     us.central_pos = central_pos;
     us.pfile_in_zip_read = NULL;
+    us.index = NULL;
 
     s = (unz64_s*)ALLOC(sizeof(unz64_s));
     if (s != NULL)
     {
         *s = us;
+        /* Without an index lookups fall back to scanning the central dir */
+        if (options & UNZ_OPTION_INDEX)
+            s->index = unz64local_BuildIndex((unzFile)s);
         unzGoToFirstFile((unzFile)s);
     }
     return (unzFile)s;
@@ -555,9 +611,9 @@ extern unzFile ZEXPORT unzOpen2(const char *path, zlib_filefunc_def* pzlib_filef
     {
         zlib_filefunc64_32_def zlib_filefunc64_32_def_fill;
         fill_zlib_filefunc64_32_def_from_filefunc32(&zlib_filefunc64_32_def_fill, pzlib_filefunc32_def);
-        return unzOpenInternal(path, &zlib_filefunc64_32_def_fill);
+        return unzOpenInternal(path, &zlib_filefunc64_32_def_fill, 0);
     }
-    return unzOpenInternal(path, NULL);
+    return unzOpenInternal(path, NULL, 0);
 }
 
 extern unzFile ZEXPORT unzOpen2_64(const void *path, zlib_filefunc64_def* pzlib_filefunc_def)
@@ -568,19 +624,47 @@ extern unzFile ZEXPORT unzOpen2_64(const void *path, zlib_filefunc64_def* pzlib_
         zlib_filefunc64_32_def_fill.zfile_func64 = *pzlib_filefunc_def;
         zlib_filefunc64_32_def_fill.ztell32_file = NULL;
         zlib_filefunc64_32_def_fill.zseek32_file = NULL;
-        return unzOpenInternal(path, &zlib_filefunc64_32_def_fill);
+        return unzOpenInternal(path, &zlib_filefunc64_32_def_fill, 0);
+    }
+    return unzOpenInternal(path, NULL, 0);
+}
+
+extern unzFile ZEXPORT unzOpen3_64(const void *path, zlib_filefunc64_def* pzlib_filefunc_def, int options)
+{
+    if (pzlib_filefunc_def != NULL)
+    {
+        zlib_filefunc64_32_def zlib_filefunc64_32_def_fill;
+        zlib_filefunc64_32_def_fill.zfile_func64 = *pzlib_filefunc_def;
+        zlib_filefunc64_32_def_fill.ztell32_file = NULL;
+        zlib_filefunc64_32_def_fill.zseek32_file = NULL;
+        return unzOpenInternal(path, &zlib_filefunc64_32_def_fill, options);
     }
-    return unzOpenInternal(path, NULL);
+    return unzOpenInternal(path, NULL, options);
+}
+
+extern unzFile ZEXPORT unzOpenMemory(const void *buffer, ZPOS64_T size)
+{
+    zlib_filefunc64_32_def zlib_filefunc64_32_def_fill;
+    zlib_memory_def memory;
+
+    memory.base = (void*)buffer;
+    memory.size = size;
+    memory.limit = 0;
+
+    fill_memory_filefunc64(&zlib_filefunc64_32_def_fill.zfile_func64);
+    zlib_filefunc64_32_def_fill.ztell32_file = NULL;
+    zlib_filefunc64_32_def_fill.zseek32_file = NULL;
+    return unzOpenInternal(&memory, &zlib_filefunc64_32_def_fill, 0);
 }
 
 extern unzFile ZEXPORT unzOpen(const char *path)
 {
-    return unzOpenInternal(path, NULL);
+    return unzOpenInternal(path, NULL, 0);
 }
 
 extern unzFile ZEXPORT unzOpen64(const void *path)
 {
-    return unzOpenInternal(path, NULL);
+    return unzOpenInternal(path, NULL, 0);
 }
 
 extern int ZEXPORT unzClose(unzFile file)
@@ -600,6 +684,7 @@ extern int ZEXPORT unzClose(unzFile file)
 
     s->filestream = NULL;
     s->filestream_with_CD = NULL;
+    unz64local_FreeIndex(s->index);
     TRYFREE(s);
     return UNZ_OK;
 }
@@ -1227,9 +1312,16 @@ extern int ZEXPORT unzOpenCurrentFile3(unzFile file, int* method, int* level, in
         }
     }
 
+    /* Stored data needs no decoding, so a mapped archive can hand it out without the read buffer */
+    pfile_in_zip_read_info->zero_copy = ((compression_method == 0) || (pfile_in_zip_read_info->raw)) &&
+        ((s->cur_file_info.flag & 1) == 0);
+
     pfile_in_zip_read_info->rest_read_compressed = s->cur_file_info.compressed_size;
     pfile_in_zip_read_info->rest_read_uncompressed = s->cur_file_info.uncompressed_size;
     pfile_in_zip_read_info->pos_in_zipfile = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER + iSizeVar;
+    pfile_in_zip_read_info->pos_data_begin = pfile_in_zip_read_info->pos_in_zipfile;
+    pfile_in_zip_read_info->crc_lost = 0;
+    pfile_in_zip_read_info->seek_index = NULL;
     pfile_in_zip_read_info->stream.avail_in = (uInt)0;
 
     s->pfile_in_zip_read = pfile_in_zip_read_info;
@@ -1346,6 +1438,33 @@ extern int ZEXPORT unzReadCurrentFile(unzFile file, voidp buf, unsigned len)
 
     while (s->pfile_in_zip_read->stream.avail_out > 0)
     {
+        if ((s->pfile_in_zip_read->stream.avail_in == 0) && (s->pfile_in_zip_read->zero_copy))
+        {
+            const void* mapped = NULL;
+            uInt bytes_to_map = s->pfile_in_zip_read->stream.avail_out;
+
+            if (s->pfile_in_zip_read->rest_read_compressed < bytes_to_map)
+                bytes_to_map = (uInt)s->pfile_in_zip_read->rest_read_compressed;
+            if (bytes_to_map > 0)
+                mapped = ZMAP64(s->pfile_in_zip_read->z_filefunc, s->pfile_in_zip_read->filestream,
+                    s->pfile_in_zip_read->pos_in_zipfile + s->pfile_in_zip_read->byte_before_the_zipfile,
+                    bytes_to_map);
+
+            if (mapped != NULL)
+            {
+                s->pfile_in_zip_read->pos_in_zipfile += bytes_to_map;
+                s->pfile_in_zip_read->rest_read_compressed -= bytes_to_map;
+                s->pfile_in_zip_read->stream.next_in = (Bytef*)mapped;
+                s->pfile_in_zip_read->stream.avail_in = bytes_to_map;
+            }
+            else
+            {
+                /* Not mapped, spanned to the next disk or already at the end, use the read buffer */
+                s->pfile_in_zip_read->zero_copy = 0;
+                s->pfile_in_zip_read->stream.next_in = NULL;
+            }
+        }
+
         if (s->pfile_in_zip_read->stream.avail_in == 0)
         {
             uLong bytes_to_read = UNZ_BUFSIZE;
@@ -1417,7 +1536,7 @@ extern int ZEXPORT unzReadCurrentFile(unzFile file, voidp buf, unsigned len)
 
         if ((s->pfile_in_zip_read->compression_method == 0) || (s->pfile_in_zip_read->raw))
         {
-            uInt copy, i;
+            uInt copy;
 
             if ((s->pfile_in_zip_read->stream.avail_in == 0) &&
                 (s->pfile_in_zip_read->rest_read_compressed == 0))
@@ -1428,9 +1547,7 @@ extern int ZEXPORT unzReadCurrentFile(unzFile file, voidp buf, unsigned len)
             else
                 copy = s->pfile_in_zip_read->stream.avail_in;
 
-            for (i = 0; i < copy; i++)
-                *(s->pfile_in_zip_read->stream.next_out+i) =
-                        *(s->pfile_in_zip_read->stream.next_in+i);
+            memcpy(s->pfile_in_zip_read->stream.next_out, s->pfile_in_zip_read->stream.next_in, copy);
 
             s->pfile_in_zip_read->total_out_64 = s->pfile_in_zip_read->total_out_64 + copy;
             s->pfile_in_zip_read->rest_read_uncompressed -= copy;
@@ -1581,6 +1698,15 @@ extern int ZEXPORT unzGetLocalExtrafield(unzFile file, voidp buf, unsigned len)
     return (int)read_now;
 }
 
+local void unz64local_FreeSeekIndex OF((unz64_seek_index* index));
+local void unz64local_FreeSeekIndex(unz64_seek_index* index)
+{
+    if (index == NULL)
+        return;
+    TRYFREE(index->points);
+    TRYFREE(index);
+}
+
 extern int ZEXPORT unzCloseCurrentFile(unzFile file)
 {
     int err = UNZ_OK;
@@ -1615,7 +1741,7 @@ extern int ZEXPORT unzCloseCurrentFile(unzFile file)
 #endif
     {
         if ((pfile_in_zip_read_info->rest_read_uncompressed == 0) &&
-            (!pfile_in_zip_read_info->raw))
+            (!pfile_in_zip_read_info->raw) && (!pfile_in_zip_read_info->crc_lost))
         {
             if (pfile_in_zip_read_info->crc32 != pfile_in_zip_read_info->crc32_wait)
                 err = UNZ_CRCERROR;
@@ -1632,6 +1758,7 @@ extern int ZEXPORT unzCloseCurrentFile(unzFile file)
 #endif
 
     pfile_in_zip_read_info->stream_initialised = 0;
+    unz64local_FreeSeekIndex(pfile_in_zip_read_info->seek_index);
     TRYFREE(pfile_in_zip_read_info);
 
     s->pfile_in_zip_read = NULL;
@@ -1692,6 +1819,143 @@ extern int ZEXPORT unzGoToNextFile(unzFile file)
     return unzGoToNextFile2(file, NULL, NULL, 0, NULL, 0, NULL, 0);
 }
 
+/* FNV-1a hash of a filename */
+local uLong unz64local_HashName OF((const char *filename));
+local uLong unz64local_HashName(const char *filename)
+{
+    uLong hash = 2166136261UL;
+    while (*filename != 0)
+    {
+        hash ^= (unsigned char)*filename++;
+        hash = (hash * 16777619UL) & 0xffffffffUL;
+    }
+    return hash;
+}
+
+local void unz64local_FreeIndex(unz64_index* index)
+{
+    if (index == NULL)
+        return;
+    TRYFREE(index->entries);
+    TRYFREE(index->names);
+    TRYFREE(index->slots);
+    TRYFREE(index);
+}
+
+/* Walk the central dir once, the current file is left undefined */
+local unz64_index* unz64local_BuildIndex(unzFile file)
+{
+    unz64_s* s = (unz64_s*)file;
+    unz64_index* index;
+    unz_file_info64 file_info;
+    ZPOS64_T number_entry_alloc = s->gi.number_entry;
+    ZPOS64_T names_size;
+    ZPOS64_T names_used = 0;
+    ZPOS64_T i;
+    int err;
+
+    index = (unz64_index*)ALLOC(sizeof(unz64_index));
+    if (index == NULL)
+        return NULL;
+    memset(index, 0, sizeof(unz64_index));
+
+    /* Filenames are part of the central dir, so its size bounds them */
+    names_size = s->size_central_dir + number_entry_alloc + 1;
+    if (number_entry_alloc == 0)
+        number_entry_alloc = 1;
+    index->entries = (unz64_index_entry*)ALLOC((size_t)(number_entry_alloc * sizeof(unz64_index_entry)));
+    index->names = (char*)ALLOC((size_t)names_size);
+    if ((index->entries == NULL) || (index->names == NULL))
+    {
+        unz64local_FreeIndex(index);
+        return NULL;
+    }
+
+    err = unzGoToFirstFile2(file, &file_info, index->names, (uLong)names_size, NULL, 0, NULL, 0);
+    while (err == UNZ_OK)
+    {
+        unz64_index_entry* entry;
+
+        if (file_info.size_filename >= names_size - names_used)
+            break;
+
+        if (index->number_entry == number_entry_alloc)
+        {
+            /* More entries than announced, the 2^16 files overflow hack */
+            unz64_index_entry* entries = (unz64_index_entry*)realloc(index->entries,
+                (size_t)(number_entry_alloc * 2 * sizeof(unz64_index_entry)));
+            if (entries == NULL)
+                break;
+            index->entries = entries;
+            number_entry_alloc *= 2;
+        }
+
+        entry = &index->entries[index->number_entry++];
+        entry->file_info = s->cur_file_info;
+        entry->file_info_internal = s->cur_file_info_internal;
+        entry->pos_in_central_dir = s->pos_in_central_dir;
+        entry->name_offset = names_used;
+        entry->hash = unz64local_HashName(index->names + names_used);
+        names_used += file_info.size_filename + 1;
+
+        err = unzGoToNextFile2(file, &file_info, index->names + names_used, (uLong)(names_size - names_used),
+            NULL, 0, NULL, 0);
+    }
+
+    if (err != UNZ_END_OF_LIST_OF_FILE)
+    {
+        unz64local_FreeIndex(index);
+        return NULL;
+    }
+
+    /* Keep the table at most half full */
+    index->number_slot = 16;
+    while (index->number_slot < index->number_entry * 2)
+        index->number_slot *= 2;
+    index->slots = (ZPOS64_T*)ALLOC((size_t)(index->number_slot * sizeof(ZPOS64_T)));
+    if (index->slots == NULL)
+    {
+        unz64local_FreeIndex(index);
+        return NULL;
+    }
+    memset(index->slots, 0, (size_t)(index->number_slot * sizeof(ZPOS64_T)));
+
+    for (i = 0; i < index->number_entry; i++)
+    {
+        ZPOS64_T slot = index->entries[i].hash & (index->number_slot - 1);
+        while (index->slots[slot] != 0)
+            slot = (slot + 1) & (index->number_slot - 1);
+        index->slots[slot] = i + 1;
+    }
+    return index;
+}
+
+local int unz64local_LocateIndexed OF((unz64_s* s, const char *filename));
+local int unz64local_LocateIndexed(unz64_s* s, const char *filename)
+{
+    unz64_index* index = s->index;
+    uLong hash = unz64local_HashName(filename);
+    ZPOS64_T slot = hash & (index->number_slot - 1);
+
+    while (index->slots[slot] != 0)
+    {
+        ZPOS64_T number = index->slots[slot] - 1;
+        unz64_index_entry* entry = &index->entries[number];
+
+        if ((entry->hash == hash) && (strcmp(index->names + entry->name_offset, filename) == 0))
+        {
+            s->num_file = number;
+            s->pos_in_central_dir = entry->pos_in_central_dir;
+            s->cur_file_info = entry->file_info;
+            s->cur_file_info_internal = entry->file_info_internal;
+            s->current_file_ok = 1;
+            return UNZ_OK;
+        }
+        slot = (slot + 1) & (index->number_slot - 1);
+    }
+    return UNZ_END_OF_LIST_OF_FILE;
+}
+
 extern int ZEXPORT unzLocateFile(unzFile file, const char *filename, unzFileNameComparer filename_compare_func)
 {
     unz64_s* s;
@@ -1704,9 +1968,11 @@ extern int ZEXPORT unzLocateFile(unzFile file, const char *filename, unzFileName
 
     if (file == NULL)
         return UNZ_PARAMERROR;
+    s = (unz64_s*)file;
+    if ((s->index != NULL) && (filename_compare_func == NULL))
+        return unz64local_LocateIndexed(s, filename);
     if (strlen(filename) >= UNZ_MAXFILENAMEINZIP)
         return UNZ_PARAMERROR;
-    s = (unz64_s*)file;
     if (!s->current_file_ok)
         return UNZ_END_OF_LIST_OF_FILE;
 
@@ -1796,6 +2062,33 @@ extern int ZEXPORT unzGoToFilePos64(unzFile file, const unz64_file_pos* file_pos
     return err;
 }
 
+extern int ZEXPORT unzGetIndexedEntry(unzFile file, ZPOS64_T number, unz_file_info64 *pfile_info,
+    const char **filename, unz64_file_pos *file_pos)
+{
+    unz64_s* s;
+    unz64_index_entry* entry;
+
+    if (file == NULL)
+        return UNZ_PARAMERROR;
+    s = (unz64_s*)file;
+    if (s->index == NULL)
+        return UNZ_PARAMERROR;
+    if (number >= s->index->number_entry)
+        return UNZ_END_OF_LIST_OF_FILE;
+
+    entry = &s->index->entries[number];
+    if (pfile_info != NULL)
+        *pfile_info = entry->file_info;
+    if (filename != NULL)
+        *filename = s->index->names + entry->name_offset;
+    if (file_pos != NULL)
+    {
+        file_pos->pos_in_zip_directory = entry->pos_in_central_dir;
+        file_pos->num_of_file = number;
+    }
+    return UNZ_OK;
+}
+
 extern uLong ZEXPORT unzGetOffset(unzFile file)
 {
     ZPOS64_T offset64;
@@ -1870,6 +2163,429 @@ extern int ZEXPORT unzseek(unzFile file, z_off_t offset, int origin)
     return unzseek64(file, (ZPOS64_T)offset, origin);
 }
 
+local int unz64local_AddSeekPoint OF((unz64_seek_index* index, int bits, ZPOS64_T in, ZPOS64_T out,
+    uInt left, const unsigned char *window));
+local int unz64local_AddSeekPoint(unz64_seek_index* index, int bits, ZPOS64_T in, ZPOS64_T out,
+    uInt left, const unsigned char *window)
+{
+    unz64_seek_point* point;
+
+    if ((index->number_point & (index->number_point - 1)) == 0)
+    {
+        /* Grow at every power of two */
+        uLong number_alloc = (index->number_point == 0) ? 1 : index->number_point * 2;
+        unz64_seek_point* points = NULL;
+        if (number_alloc > index->number_point)
+            points = (unz64_seek_point*)realloc(index->points, number_alloc * sizeof(unz64_seek_point));
+        if (points == NULL)
+            return UNZ_INTERNALERROR;
+        index->points = points;
+    }
+
+    point = &index->points[index->number_point++];
+    point->out = out;
+    point->in = in;
+    point->bits = bits;
+    /* The output window is circular, left bytes at its end are the oldest */
+    if (left != 0)
+        memcpy(point->window, window + UNZ_SEEKWINDOW - left, left);
+    if (left < UNZ_SEEKWINDOW)
+        memcpy(point->window + left, window, UNZ_SEEKWINDOW - left);
+    return UNZ_OK;
+}
+
+extern int ZEXPORT unzBuildSeekIndex(unzFile file, ZPOS64_T span)
+{
+    unz64_s* s;
+    file_in_zip64_read_info_s* pfile_in_zip_read_info;
+    unz64_seek_index* index;
+    unsigned char *input;
+    unsigned char *window;
+    z_stream strm;
+    ZPOS64_T rest_read_compressed;
+    ZPOS64_T total_in = 0;
+    ZPOS64_T total_out = 0;
+    ZPOS64_T last = 0;
+    int err = Z_OK;
+
+    if (file == NULL)
+        return UNZ_PARAMERROR;
+    s = (unz64_s*)file;
+    pfile_in_zip_read_info = s->pfile_in_zip_read;
+    if (pfile_in_zip_read_info == NULL)
+        return UNZ_PARAMERROR;
+    /* Checkpoints cannot restore a decryption state */
+    if ((pfile_in_zip_read_info->stream_initialised != Z_DEFLATED) || (pfile_in_zip_read_info->raw) ||
+        ((s->cur_file_info.flag & 1) != 0))
+        return UNZ_PARAMERROR;
+
+    index = (unz64_seek_index*)ALLOC(sizeof(unz64_seek_index));
+    input = (unsigned char*)ALLOC(UNZ_BUFSIZE);
+    window = (unsigned char*)ALLOC(UNZ_SEEKWINDOW);
+    if ((index == NULL) || (input == NULL) || (window == NULL))
+    {
+        TRYFREE(index);
+        TRYFREE(input);
+        TRYFREE(window);
+        return UNZ_INTERNALERROR;
+    }
+    index->points = NULL;
+    index->number_point = 0;
+    index->span = span;
+
+    strm.zalloc = (alloc_func)0;
+    strm.zfree = (free_func)0;
+    strm.opaque = (voidpf)0;
+    strm.next_in = NULL;
+    strm.avail_in = 0;
+    if (inflateInit2(&strm, -MAX_WBITS) != Z_OK)
+        err = UNZ_INTERNALERROR;
+    strm.avail_out = 0;
+
+    /* Inflate the whole file with its own stream, unzReadCurrentFile seeks before every read */
+    if ((err == Z_OK) && (ZSEEK64(pfile_in_zip_read_info->z_filefunc, pfile_in_zip_read_info->filestream,
+            pfile_in_zip_read_info->pos_data_begin + pfile_in_zip_read_info->byte_before_the_zipfile,
+            ZLIB_FILEFUNC_SEEK_SET) != 0))
+        err = UNZ_ERRNO;
+
+    rest_read_compressed = s->cur_file_info.compressed_size;
+    while (err == Z_OK)
+    {
+        uLong bytes_to_read = UNZ_BUFSIZE;
+
+        if (rest_read_compressed < bytes_to_read)
+            bytes_to_read = (uLong)rest_read_compressed;
+        if ((bytes_to_read == 0) || (ZREAD64(pfile_in_zip_read_info->z_filefunc,
+                pfile_in_zip_read_info->filestream, input, bytes_to_read) != bytes_to_read))
+        {
+            err = UNZ_ERRNO;
+            break;
+        }
+        rest_read_compressed -= bytes_to_read;
+        strm.next_in = input;
+        strm.avail_in = (uInt)bytes_to_read;
+
+        do
+        {
+            if (strm.avail_out == 0)
+            {
+                strm.avail_out = UNZ_SEEKWINDOW;
+                strm.next_out = window;
+            }
+
+            total_in += strm.avail_in;
+            total_out += strm.avail_out;
+            err = inflate(&strm, Z_BLOCK);
+            total_in -= strm.avail_in;
+            total_out -= strm.avail_out;
+
+            if (err == Z_NEED_DICT)
+                err = Z_DATA_ERROR;
+            /* Without a trailer raw inflate can stop at the end of the last block */
+            if ((err == Z_OK) && ((strm.data_type & 192) == 192))
+                err = Z_STREAM_END;
+            if ((err == Z_MEM_ERROR) || (err == Z_DATA_ERROR) || (err == Z_STREAM_END))
+                break;
+            err = Z_OK;
+
+            /* At the end of a deflate block, that is not the last one */
+            if (((strm.data_type & 128) != 0) && ((strm.data_type & 64) == 0) &&
+                ((total_out == 0) || (total_out - last > span)))
+            {
+                err = unz64local_AddSeekPoint(index, strm.data_type & 7, total_in, total_out, strm.avail_out, window);
+                if (err != UNZ_OK)
+                    break;
+                last = total_out;
+            }
+        }
+        /* A full window may leave output pending in inflate after the input is used up */
+        while ((err == Z_OK) && ((strm.avail_in != 0) || (strm.avail_out == 0)));
+    }
+
+    inflateEnd(&strm);
+    TRYFREE(input);
+    TRYFREE(window);
+
+    if (err != Z_STREAM_END)
+    {
+        unz64local_FreeSeekIndex(index);
+        return (err == Z_OK) ? UNZ_BADZIPFILE : err;
+    }
+
+    unz64local_FreeSeekIndex(pfile_in_zip_read_info->seek_index);
+    pfile_in_zip_read_info->seek_index = index;
+    return UNZ_OK;
+}
+
+local int unz64local_putValue OF((FILE* f, ZPOS64_T x, int nbByte));
+local int unz64local_putValue(FILE* f, ZPOS64_T x, int nbByte)
+{
+    unsigned char buf[8];
+    int n;
+    for (n = 0; n < nbByte; n++)
+    {
+        buf[n] = (unsigned char)(x & 0xff);
+        x >>= 8;
+    }
+    return (fwrite(buf, 1, (size_t)nbByte, f) == (size_t)nbByte) ? UNZ_OK : UNZ_ERRNO;
+}
+
+local int unz64local_getValue OF((FILE* f, ZPOS64_T* pX, int nbByte));
+local int unz64local_getValue(FILE* f, ZPOS64_T* pX, int nbByte)
+{
+    unsigned char buf[8];
+    int n;
+    if (fread(buf, 1, (size_t)nbByte, f) != (size_t)nbByte)
+        return UNZ_ERRNO;
+    *pX = 0;
+    for (n = nbByte - 1; n >= 0; n--)
+        *pX = (*pX << 8) | buf[n];
+    return UNZ_OK;
+}
+
+extern int ZEXPORT unzSaveSeekIndex(unzFile file, const char* path)
+{
+    unz64_s* s;
+    unz64_seek_index* index;
+    FILE* f;
+    uLong i;
+    int err = UNZ_OK;
+
+    if ((file == NULL) || (path == NULL))
+        return UNZ_PARAMERROR;
+    s = (unz64_s*)file;
+    if ((s->pfile_in_zip_read == NULL) || (s->pfile_in_zip_read->seek_index == NULL))
+        return UNZ_PARAMERROR;
+    index = s->pfile_in_zip_read->seek_index;
+
+    f = fopen(path, "wb");
+    if (f == NULL)
+        return UNZ_ERRNO;
+
+    /* The file sizes and crc tie the checkpoints to the file they were built for */
+    err = unz64local_putValue(f, UNZ_SEEKINDEXMAGIC, 4);
+    if (err == UNZ_OK)
+        err = unz64local_putValue(f, UNZ_SEEKINDEXVERSION, 4);
+    if (err == UNZ_OK)
+        err = unz64local_putValue(f, s->cur_file_info.crc, 4);
+    if (err == UNZ_OK)
+        err = unz64local_putValue(f, s->cur_file_info.compressed_size, 8);
+    if (err == UNZ_OK)
+        err = unz64local_putValue(f, s->cur_file_info.uncompressed_size, 8);
+    if (err == UNZ_OK)
+        err = unz64local_putValue(f, index->span, 8);
+    if (err == UNZ_OK)
+        err = unz64local_putValue(f, index->number_point, 8);
+
+    for (i = 0; (err == UNZ_OK) && (i < index->number_point); i++)
+    {
+        err = unz64local_putValue(f, index->points[i].out, 8);
+        if (err == UNZ_OK)
+            err = unz64local_putValue(f, index->points[i].in, 8);
+        if (err == UNZ_OK)
+            err = unz64local_putValue(f, (ZPOS64_T)index->points[i].bits, 1);
+        if ((err == UNZ_OK) && (fwrite(index->points[i].window, 1, UNZ_SEEKWINDOW, f) != UNZ_SEEKWINDOW))
+            err = UNZ_ERRNO;
+    }
+
+    if (fclose(f) != 0)
+        err = UNZ_ERRNO;
+    return err;
+}
+
+extern int ZEXPORT unzLoadSeekIndex(unzFile file, const char* path)
+{
+    unz64_s* s;
+    unz64_seek_index* index;
+    FILE* f;
+    ZPOS64_T value = 0;
+    ZPOS64_T number_point = 0;
+    uLong i;
+    int err = UNZ_OK;
+
+    if ((file == NULL) || (path == NULL))
+        return UNZ_PARAMERROR;
+    s = (unz64_s*)file;
+    if ((s->pfile_in_zip_read == NULL) || (s->pfile_in_zip_read->stream_initialised != Z_DEFLATED) ||
+        (s->pfile_in_zip_read->raw) || ((s->cur_file_info.flag & 1) != 0))
+        return UNZ_PARAMERROR;
+
+    f = fopen(path, "rb");
+    if (f == NULL)
+        return UNZ_ERRNO;
+
+    index = (unz64_seek_index*)ALLOC(sizeof(unz64_seek_index));
+    if (index == NULL)
+    {
+        fclose(f);
+        return UNZ_INTERNALERROR;
+    }
+    index->points = NULL;
+    index->number_point = 0;
+    index->span = 0;
+
+    if ((unz64local_getValue(f, &value, 4) != UNZ_OK) || (value != UNZ_SEEKINDEXMAGIC))
+        err = UNZ_BADZIPFILE;
+    if ((err == UNZ_OK) && ((unz64local_getValue(f, &value, 4) != UNZ_OK) || (value != UNZ_SEEKINDEXVERSION)))
+        err = UNZ_BADZIPFILE;
+    if ((err == UNZ_OK) && ((unz64local_getValue(f, &value, 4) != UNZ_OK) || (value != s->cur_file_info.crc)))
+        err = UNZ_BADZIPFILE;
+    if ((err == UNZ_OK) && ((unz64local_getValue(f, &value, 8) != UNZ_OK) ||
+            (value != s->cur_file_info.compressed_size)))
+        err = UNZ_BADZIPFILE;
+    if ((err == UNZ_OK) && ((unz64local_getValue(f, &value, 8) != UNZ_OK) ||
+            (value != s->cur_file_info.uncompressed_size)))
+        err = UNZ_BADZIPFILE;
+    if ((err == UNZ_OK) && (unz64local_getValue(f, &index->span, 8) != UNZ_OK))
+        err = UNZ_BADZIPFILE;
+    if ((err == UNZ_OK) && ((unz64local_getValue(f, &number_point, 8) != UNZ_OK) || (number_point == 0) ||
+            (number_point > s->cur_file_info.uncompressed_size + 1)))
+        err = UNZ_BADZIPFILE;
+
+    if (err == UNZ_OK)
+    {
+        index->points = (unz64_seek_point*)ALLOC((size_t)number_point * sizeof(unz64_seek_point));
+        if (index->points == NULL)
+            err = UNZ_INTERNALERROR;
+    }
+
+    for (i = 0; (err == UNZ_OK) && (i < number_point); i++)
+    {
+        unz64_seek_point* point = &index->points[i];
+
+        if ((unz64local_getValue(f, &point->out, 8) != UNZ_OK) ||
+            (unz64local_getValue(f, &point->in, 8) != UNZ_OK) ||
+            (unz64local_getValue(f, &value, 1) != UNZ_OK) ||
+            (fread(point->window, 1, UNZ_SEEKWINDOW, f) != UNZ_SEEKWINDOW))
+            err = UNZ_BADZIPFILE;
+        else if ((value > 7) || (point->out > s->cur_file_info.uncompressed_size) ||
+            (point->in > s->cur_file_info.compressed_size) || ((point->in == 0) && (value != 0)) ||
+            ((i > 0) && (point->out < index->points[i - 1].out)))
+            err = UNZ_BADZIPFILE;
+        point->bits = (int)value;
+        index->number_point = i + 1;
+    }
+
+    fclose(f);
+
+    if (err != UNZ_OK)
+    {
+        unz64local_FreeSeekIndex(index);
+        return err;
+    }
+
+    unz64local_FreeSeekIndex(s->pfile_in_zip_read->seek_index);
+    s->pfile_in_zip_read->seek_index = index;
+    return UNZ_OK;
+}
+
+/* Seek in a deflated file: restart from the nearest checkpoint, or the beginning, then inflate up to position */
+local int unz64local_SeekInflated OF((unzFile file, ZPOS64_T offset, int origin));
+local int unz64local_SeekInflated(unzFile file, ZPOS64_T offset, int origin)
+{
+    unz64_s* s = (unz64_s*)file;
+    file_in_zip64_read_info_s* pfile_in_zip_read_info = s->pfile_in_zip_read;
+    unz64_seek_index* index = pfile_in_zip_read_info->seek_index;
+    unz64_seek_point* point = NULL;
+    ZPOS64_T position;
+    ZPOS64_T restart_out = 0;
+    char discard[8192];
+
+    if (origin == SEEK_SET)
+        position = offset;
+    else if (origin == SEEK_CUR)
+        position = pfile_in_zip_read_info->total_out_64 + offset;
+    else if (origin == SEEK_END)
+        position = s->cur_file_info.uncompressed_size + offset;
+    else
+        return UNZ_PARAMERROR;
+
+    if (position > s->cur_file_info.uncompressed_size)
+        return UNZ_PARAMERROR;
+
+    if (index != NULL)
+    {
+        /* Last checkpoint at or before position */
+        uLong low = 0;
+        uLong high = index->number_point;
+        while (low < high)
+        {
+            uLong middle = low + (high - low) / 2;
+            if (index->points[middle].out <= position)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        if (low > 0)
+        {
+            point = &index->points[low - 1];
+            restart_out = point->out;
+        }
+    }
+
+    /* Restart only when going back, or when the checkpoint skips more than inflating forward would */
+    if ((position < pfile_in_zip_read_info->total_out_64) || (restart_out > pfile_in_zip_read_info->total_out_64))
+    {
+        /* The decryption state cannot be rewound */
+        if ((s->cur_file_info.flag & 1) != 0)
+            return UNZ_ERRNO;
+        if (inflateReset(&pfile_in_zip_read_info->stream) != Z_OK)
+            return UNZ_INTERNALERROR;
+
+        pfile_in_zip_read_info->stream.next_in = NULL;
+        pfile_in_zip_read_info->stream.avail_in = 0;
+        pfile_in_zip_read_info->pos_in_zipfile = pfile_in_zip_read_info->pos_data_begin;
+        pfile_in_zip_read_info->rest_read_compressed = s->cur_file_info.compressed_size;
+        pfile_in_zip_read_info->rest_read_uncompressed = s->cur_file_info.uncompressed_size;
+        pfile_in_zip_read_info->total_out_64 = 0;
+        pfile_in_zip_read_info->crc32 = 0;
+        pfile_in_zip_read_info->crc_lost = 0;
+
+        if (point != NULL)
+        {
+            ZPOS64_T in = point->in;
+
+            if (point->bits != 0)
+            {
+                /* The checkpoint starts inside the previous byte */
+                unsigned char c;
+                in -= 1;
+                if (ZSEEK64(pfile_in_zip_read_info->z_filefunc, pfile_in_zip_read_info->filestream,
+                        pfile_in_zip_read_info->pos_data_begin + pfile_in_zip_read_info->byte_before_the_zipfile + in,
+                        ZLIB_FILEFUNC_SEEK_SET) != 0)
+                    return UNZ_ERRNO;
+                if (ZREAD64(pfile_in_zip_read_info->z_filefunc, pfile_in_zip_read_info->filestream, &c, 1) != 1)
+                    return UNZ_ERRNO;
+                in += 1;
+                if (inflatePrime(&pfile_in_zip_read_info->stream, point->bits, c >> (8 - point->bits)) != Z_OK)
+                    return UNZ_INTERNALERROR;
+            }
+            if (inflateSetDictionary(&pfile_in_zip_read_info->stream, point->window, UNZ_SEEKWINDOW) != Z_OK)
+                return UNZ_INTERNALERROR;
+
+            pfile_in_zip_read_info->pos_in_zipfile += in;
+            pfile_in_zip_read_info->rest_read_compressed -= in;
+            pfile_in_zip_read_info->rest_read_uncompressed -= point->out;
+            pfile_in_zip_read_info->total_out_64 = point->out;
+            pfile_in_zip_read_info->crc_lost = 1;
+        }
+        pfile_in_zip_read_info->stream.total_out = (uLong)pfile_in_zip_read_info->total_out_64;
+    }
+
+    while (pfile_in_zip_read_info->total_out_64 < position)
+    {
+        ZPOS64_T bytes_to_discard = position - pfile_in_zip_read_info->total_out_64;
+        int err;
+
+        if (bytes_to_discard > sizeof(discard))
+            bytes_to_discard = sizeof(discard);
+        err = unzReadCurrentFile(file, discard, (unsigned)bytes_to_discard);
+        if (err <= 0)
+            return (err == 0) ? UNZ_EOF : err;
+    }
+    return UNZ_OK;
+}
+
 extern int ZEXPORT unzseek64(unzFile file, ZPOS64_T offset, int origin)
 {
     unz64_s* s;
@@ -1885,6 +2601,8 @@ extern int ZEXPORT unzseek64(unzFile file, ZPOS64_T offset, int origin)
 
     if (s->pfile_in_zip_read == NULL)
         return UNZ_ERRNO;
+    if ((s->pfile_in_zip_read->stream_initialised == Z_DEFLATED) && (!s->pfile_in_zip_read->raw))
+        return unz64local_SeekInflated(file, offset, origin);
     if (s->pfile_in_zip_read->compression_method != 0)
         return UNZ_ERRNO;
 
@@ -1926,6 +2644,8 @@ extern int ZEXPORT unzseek64(unzFile file, ZPOS64_T offset, int origin)
         s->pfile_in_zip_read->rest_read_compressed = s->cur_file_info.compressed_size - position;
     }
 
+    if (position != s->pfile_in_zip_read->total_out_64)
+        s->pfile_in_zip_read->crc_lost = 1;
     s->pfile_in_zip_read->rest_read_uncompressed -= (position - s->pfile_in_zip_read->total_out_64);
     s->pfile_in_zip_read->stream.total_out = (uLong)position;
     s->pfile_in_zip_read->total_out_64 = position;
@@ -1945,3 +2665,450 @@ extern int ZEXPORT unzeof(unzFile file)
         return 1;
     return 0;
 }
+
+/* Streaming reader, fed sequentially with the bytes of the archive as they arrive */
+
+#define UNZ_STREAM_HEADER        (0)  /* waiting for a local header */
+#define UNZ_STREAM_DATA          (1)  /* reading the data of the current file */
+#define UNZ_STREAM_DESCRIPTOR    (2)  /* waiting for the data descriptor of the current file */
+#define UNZ_STREAM_ENTRYEND      (3)  /* current file read and checked */
+#define UNZ_STREAM_DONE          (4)  /* central directory reached */
+
+typedef struct
+{
+    unsigned char* buffer;          /* bytes received but not consumed yet, from start to end */
+    uLong start;
+    uLong end;
+    uLong allocated;
+    int finished;                   /* the end of input was written */
+    int state;                      /* UNZ_STREAM_ state */
+    int error;                      /* sticky error once the stream is unusable */
+    unz_file_info64 cur_file_info;  /* information of the current file from its local header */
+    int zip64;                      /* the local header had a zip64 extra field */
+    int decode;                     /* the data can be decoded, otherwise it is only skipped */
+    ZPOS64_T rest_read_compressed;  /* compressed bytes left when the sizes are in the local header */
+    ZPOS64_T total_in;              /* compressed bytes read for the current file */
+    ZPOS64_T total_out;             /* uncompressed bytes read for the current file */
+    uLong crc32;                    /* crc32 of the uncompressed bytes read */
+    z_stream stream;                /* zLib stream structure for inflate */
+    int stream_initialised;
+} unz64_stream_s;
+
+local uLong unz64local_getLong_inmemory OF((const unsigned char* p));
+local uLong unz64local_getLong_inmemory(const unsigned char* p)
+{
+    return (uLong)p[0] | ((uLong)p[1] << 8) | ((uLong)p[2] << 16) | ((uLong)p[3] << 24);
+}
+
+local ZPOS64_T unz64local_getLong64_inmemory OF((const unsigned char* p));
+local ZPOS64_T unz64local_getLong64_inmemory(const unsigned char* p)
+{
+    return (ZPOS64_T)unz64local_getLong_inmemory(p) | ((ZPOS64_T)unz64local_getLong_inmemory(p + 4) << 32);
+}
+
+extern unzStream ZEXPORT unzStreamOpen()
+{
+    unz64_stream_s* s = (unz64_stream_s*)ALLOC(sizeof(unz64_stream_s));
+    if (s == NULL)
+        return NULL;
+    memset(s, 0, sizeof(unz64_stream_s));
+    s->state = UNZ_STREAM_HEADER;
+    return (unzStream)s;
+}
+
+extern int ZEXPORT unzStreamWrite(unzStream stream, const void* buf, uLong len)
+{
+    unz64_stream_s* s;
+    uLong size;
+
+    if (stream == NULL)
+        return UNZ_PARAMERROR;
+    s = (unz64_stream_s*)stream;
+    if (s->finished)
+        return UNZ_PARAMERROR;
+    if (len == 0)
+    {
+        s->finished = 1;
+        return UNZ_OK;
+    }
+    /* Nothing after the central directory is read, drop it instead of buffering */
+    if (s->state == UNZ_STREAM_DONE)
+    {
+        TRYFREE(s->buffer);
+        s->buffer = NULL;
+        s->start = s->end = s->allocated = 0;
+        return UNZ_OK;
+    }
+
+    /* Move the unconsumed bytes to the front once they are less than the consumed ones */
+    size = s->end - s->start;
+    if ((s->start > 0) && (s->start >= size))
+    {
+        memmove(s->buffer, s->buffer + s->start, size);
+        s->start = 0;
+        s->end = size;
+    }
+
+    if (s->end + len > s->allocated)
+    {
+        uLong allocated = (s->allocated == 0) ? UNZ_BUFSIZE : s->allocated;
+        unsigned char* buffer;
+
+        while (allocated < s->end + len)
+            allocated *= 2;
+        buffer = (unsigned char*)realloc(s->buffer, allocated);
+        if (buffer == NULL)
+            return UNZ_INTERNALERROR;
+        s->buffer = buffer;
+        s->allocated = allocated;
+    }
+
+    memcpy(s->buffer + s->end, buf, len);
+    s->end += len;
+    return UNZ_OK;
+}
+
+/* Parse the local header at the start of the buffer, UNZ_NEEDINPUT until it is complete */
+local int unz64local_StreamReadHeader OF((unz64_stream_s* s, char* filename, uLong filename_size));
+local int unz64local_StreamReadHeader(unz64_stream_s* s, char* filename, uLong filename_size)
+{
+    const unsigned char* p = s->buffer + s->start;
+    uLong available = s->end - s->start;
+    uLong magic;
+    uLong size_filename;
+    uLong size_extra;
+    uLong pos;
+
+    if (available < 4)
+    {
+        if (s->finished)
+            return (available == 0) ? UNZ_END_OF_LIST_OF_FILE : UNZ_BADZIPFILE;
+        return UNZ_NEEDINPUT;
+    }
+
+    magic = unz64local_getLong_inmemory(p);
+    if ((magic == CENTRALHEADERMAGIC) || (magic == ENDHEADERMAGIC) || (magic == ZIP64ENDHEADERMAGIC))
+    {
+        s->state = UNZ_STREAM_DONE;
+        return UNZ_END_OF_LIST_OF_FILE;
+    }
+    /* Spanned archives may begin with a marker looking like a data descriptor */
+    if (magic == DISKHEADERMAGIC)
+    {
+        s->start += 4;
+        return unz64local_StreamReadHeader(s, filename, filename_size);
+    }
+    if (magic != LOCALHEADERMAGIC)
+        return UNZ_BADZIPFILE;
+
+    if (available < SIZEZIPLOCALHEADER)
+        return s->finished ? UNZ_BADZIPFILE : UNZ_NEEDINPUT;
+    size_filename = (uLong)p[26] | ((uLong)p[27] << 8);
+    size_extra = (uLong)p[28] | ((uLong)p[29] << 8);
+    if (available < SIZEZIPLOCALHEADER + size_filename + size_extra)
+        return s->finished ? UNZ_BADZIPFILE : UNZ_NEEDINPUT;
+
+    memset(&s->cur_file_info, 0, sizeof(unz_file_info64));
+    s->cur_file_info.version_needed = (uLong)p[4] | ((uLong)p[5] << 8);
+    s->cur_file_info.flag = (uLong)p[6] | ((uLong)p[7] << 8);
+    s->cur_file_info.compression_method = (uLong)p[8] | ((uLong)p[9] << 8);
+    s->cur_file_info.dosDate = unz64local_getLong_inmemory(p + 10);
+    s->cur_file_info.crc = unz64local_getLong_inmemory(p + 14);
+    s->cur_file_info.compressed_size = unz64local_getLong_inmemory(p + 18);
+    s->cur_file_info.uncompressed_size = unz64local_getLong_inmemory(p + 22);
+    s->cur_file_info.size_filename = size_filename;
+    s->cur_file_info.size_file_extra = size_extra;
+    unz64local_DosDateToTmuDate(s->cur_file_info.dosDate, &s->cur_file_info.tmu_date);
+
+    /* Zip64 extended information holds the sizes that don't fit in the header */
+    s->zip64 = 0;
+    pos = SIZEZIPLOCALHEADER + size_filename;
+    while (pos + 4 <= SIZEZIPLOCALHEADER + size_filename + size_extra)
+    {
+        uLong header = (uLong)p[pos] | ((uLong)p[pos+1] << 8);
+        uLong datasize = (uLong)p[pos+2] | ((uLong)p[pos+3] << 8);
+        uLong field = pos + 4;
+
+        if (pos + 4 + datasize > SIZEZIPLOCALHEADER + size_filename + size_extra)
+            break;
+        if (header == 0x0001)
+        {
+            s->zip64 = 1;
+            if ((s->cur_file_info.uncompressed_size == 0xffffffff) && (field + 8 <= pos + 4 + datasize))
+            {
+                s->cur_file_info.uncompressed_size = unz64local_getLong64_inmemory(p + field);
+                field += 8;
+            }
+            if ((s->cur_file_info.compressed_size == 0xffffffff) && (field + 8 <= pos + 4 + datasize))
+                s->cur_file_info.compressed_size = unz64local_getLong64_inmemory(p + field);
+        }
+        pos += 4 + datasize;
+    }
+
+    if ((filename != NULL) && (filename_size > 0))
+    {
+        uLong size_copy = (size_filename < filename_size) ? size_filename : filename_size - 1;
+        memcpy(filename, p + SIZEZIPLOCALHEADER, size_copy);
+        filename[size_copy] = 0;
+    }
+
+    /* Without sizes in the header a stored file has no way to tell where it ends */
+    if (((s->cur_file_info.flag & 8) != 0) && (s->cur_file_info.compression_method != Z_DEFLATED))
+        return UNZ_BADZIPFILE;
+
+    s->decode = ((s->cur_file_info.flag & 1) == 0) &&
+        ((s->cur_file_info.compression_method == 0) || (s->cur_file_info.compression_method == Z_DEFLATED));
+    if (((s->cur_file_info.flag & 8) != 0) && (!s->decode))
+        return UNZ_BADZIPFILE;
+
+    if (s->decode && (s->cur_file_info.compression_method == Z_DEFLATED))
+    {
+        int err;
+        if (s->stream_initialised)
+            err = inflateReset(&s->stream);
+        else
+        {
+            s->stream.zalloc = (alloc_func)0;
+            s->stream.zfree = (free_func)0;
+            s->stream.opaque = (voidpf)0;
+            s->stream.next_in = 0;
+            s->stream.avail_in = 0;
+            err = inflateInit2(&s->stream, -MAX_WBITS);
+            if (err == Z_OK)
+                s->stream_initialised = Z_DEFLATED;
+        }
+        if (err != Z_OK)
+            return UNZ_INTERNALERROR;
+    }
+
+    s->rest_read_compressed = s->cur_file_info.compressed_size;
+    s->total_in = 0;
+    s->total_out = 0;
+    s->crc32 = 0;
+    s->start += SIZEZIPLOCALHEADER + size_filename + size_extra;
+    s->state = UNZ_STREAM_DATA;
+    return UNZ_OK;
+}
+
+/* Check the data read against the data descriptor or the local header */
+local int unz64local_StreamCheckEntry OF((unz64_stream_s* s));
+local int unz64local_StreamCheckEntry(unz64_stream_s* s)
+{
+    if ((s->cur_file_info.flag & 8) != 0)
+    {
+        const unsigned char* p = s->buffer + s->start;
+        uLong available = s->end - s->start;
+        uLong size_descriptor = s->zip64 ? 20 : 12;
+
+        /* The signature of the data descriptor is optional */
+        if (available < 4)
+            return s->finished ? UNZ_BADZIPFILE : UNZ_NEEDINPUT;
+        if (unz64local_getLong_inmemory(p) == DISKHEADERMAGIC)
+            size_descriptor += 4;
+        if (available < size_descriptor)
+            return s->finished ? UNZ_BADZIPFILE : UNZ_NEEDINPUT;
+        if (size_descriptor == 16 || size_descriptor == 24)
+            p += 4;
+
+        s->cur_file_info.crc = unz64local_getLong_inmemory(p);
+        if (s->zip64)
+        {
+            s->cur_file_info.compressed_size = unz64local_getLong64_inmemory(p + 4);
+            s->cur_file_info.uncompressed_size = unz64local_getLong64_inmemory(p + 12);
+        }
+        else
+        {
+            s->cur_file_info.compressed_size = unz64local_getLong_inmemory(p + 4);
+            s->cur_file_info.uncompressed_size = unz64local_getLong_inmemory(p + 8);
+        }
+        s->start += size_descriptor;
+    }
+
+    s->state = UNZ_STREAM_ENTRYEND;
+    if (!s->decode)
+        return UNZ_OK;
+    if ((s->crc32 != s->cur_file_info.crc) || (s->total_in != s->cur_file_info.compressed_size) ||
+        (s->total_out != s->cur_file_info.uncompressed_size))
+        return UNZ_CRCERROR;
+    return UNZ_OK;
+}
+
+/* Skip the compressed data of a file that can't be decoded */
+local int unz64local_StreamSkipData OF((unz64_stream_s* s));
+local int unz64local_StreamSkipData(unz64_stream_s* s)
+{
+    uLong available = s->end - s->start;
+
+    if (available > s->rest_read_compressed)
+        available = (uLong)s->rest_read_compressed;
+    s->start += available;
+    s->rest_read_compressed -= available;
+    s->total_in += available;
+    if (s->rest_read_compressed > 0)
+        return s->finished ? UNZ_BADZIPFILE : UNZ_NEEDINPUT;
+    return unz64local_StreamCheckEntry(s);
+}
+
+extern int ZEXPORT unzStreamReadEntry(unzStream stream, voidp buf, unsigned len)
+{
+    unz64_stream_s* s;
+    uLong available;
+    uInt read = 0;
+
+    if (stream == NULL)
+        return UNZ_PARAMERROR;
+    s = (unz64_stream_s*)stream;
+    if (s->error != UNZ_OK)
+        return s->error;
+    if (s->state == UNZ_STREAM_DESCRIPTOR)
+    {
+        int err = unz64local_StreamCheckEntry(s);
+        if ((err != UNZ_OK) && (err != UNZ_NEEDINPUT))
+            s->error = err;
+        return err;
+    }
+    if (s->state != UNZ_STREAM_DATA)
+        return (s->state == UNZ_STREAM_ENTRYEND) ? 0 : UNZ_PARAMERROR;
+    if (!s->decode)
+        return UNZ_BADZIPFILE;
+    if ((buf == NULL) || (len == 0))
+        return 0;
+    if (len > 0x7fffffff)
+        len = 0x7fffffff;
+
+    available = s->end - s->start;
+    if (((s->cur_file_info.flag & 8) == 0) && (available > s->rest_read_compressed))
+        available = (uLong)s->rest_read_compressed;
+
+    if (s->cur_file_info.compression_method == 0)
+    {
+        read = (len < available) ? len : (uInt)available;
+        memcpy(buf, s->buffer + s->start, read);
+        s->start += read;
+        s->rest_read_compressed -= read;
+        s->total_in += read;
+        if (s->rest_read_compressed == 0)
+            s->state = UNZ_STREAM_DESCRIPTOR;
+    }
+    else
+    {
+        int err;
+        uLong avail_in = (available > 0xffffffff) ? 0xffffffff : available;
+
+        s->stream.next_in = s->buffer + s->start;
+        s->stream.avail_in = (uInt)avail_in;
+        s->stream.next_out = (Bytef*)buf;
+        s->stream.avail_out = (uInt)len;
+
+        err = inflate(&s->stream, Z_SYNC_FLUSH);
+        if ((err != Z_OK) && (err != Z_STREAM_END) && (err != Z_BUF_ERROR))
+        {
+            s->error = UNZ_BADZIPFILE;
+            return s->error;
+        }
+
+        read = len - s->stream.avail_out;
+        s->start += (uLong)(avail_in - s->stream.avail_in);
+        s->rest_read_compressed -= (avail_in - s->stream.avail_in);
+        s->total_in += (avail_in - s->stream.avail_in);
+        if (err == Z_STREAM_END)
+            s->state = UNZ_STREAM_DESCRIPTOR;
+        else if (((s->cur_file_info.flag & 8) == 0) && (s->rest_read_compressed == 0))
+        {
+            s->error = UNZ_BADZIPFILE;
+            return s->error;
+        }
+    }
+
+    s->crc32 = crc32(s->crc32, (const Bytef*)buf, read);
+    s->total_out += read;
+
+    if (read > 0)
+        return (int)read;
+
+    if (s->state == UNZ_STREAM_DESCRIPTOR)
+    {
+        int err = unz64local_StreamCheckEntry(s);
+        if ((err != UNZ_OK) && (err != UNZ_NEEDINPUT))
+            s->error = err;
+        return err;
+    }
+    if (s->finished)
+    {
+        s->error = UNZ_BADZIPFILE;
+        return s->error;
+    }
+    return UNZ_NEEDINPUT;
+}
+
+extern int ZEXPORT unzStreamNextEntry(unzStream stream, unz_file_info64* pfile_info, char* filename, uLong filename_size)
+{
+    unz64_stream_s* s;
+    int err = UNZ_OK;
+
+    if (stream == NULL)
+        return UNZ_PARAMERROR;
+    s = (unz64_stream_s*)stream;
+    if (s->error != UNZ_OK)
+        return s->error;
+
+    /* Skip what is left of the current file */
+    while ((err == UNZ_OK) && ((s->state == UNZ_STREAM_DATA) || (s->state == UNZ_STREAM_DESCRIPTOR)))
+    {
+        if ((s->state == UNZ_STREAM_DATA) && (!s->decode))
+            err = unz64local_StreamSkipData(s);
+        else
+        {
+            unsigned char discard[8192];
+            int read = unzStreamReadEntry(stream, discard, sizeof(discard));
+            if (read < 0)
+                err = read;
+        }
+    }
+    if (err != UNZ_OK)
+    {
+        if (err != UNZ_NEEDINPUT)
+            s->error = err;
+        return err;
+    }
+
+    if (s->state == UNZ_STREAM_DONE)
+        return UNZ_END_OF_LIST_OF_FILE;
+
+    err = unz64local_StreamReadHeader(s, filename, filename_size);
+    if (err == UNZ_OK)
+    {
+        if (pfile_info != NULL)
+            *pfile_info = s->cur_file_info;
+    }
+    else if ((err != UNZ_NEEDINPUT) && (err != UNZ_END_OF_LIST_OF_FILE))
+        s->error = err;
+    return err;
+}
+
+extern int ZEXPORT unzStreamGetCurrentFileInfo64(unzStream stream, unz_file_info64* pfile_info)
+{
+    unz64_stream_s* s;
+
+    if ((stream == NULL) || (pfile_info == NULL))
+        return UNZ_PARAMERROR;
+    s = (unz64_stream_s*)stream;
+    if ((s->state != UNZ_STREAM_DATA) && (s->state != UNZ_STREAM_DESCRIPTOR) && (s->state != UNZ_STREAM_ENTRYEND))
+        return UNZ_PARAMERROR;
+    *pfile_info = s->cur_file_info;
+    return UNZ_OK;
+}
+
+extern int ZEXPORT unzStreamClose(unzStream stream)
+{
+    unz64_stream_s* s;
+
+    if (stream == NULL)
+        return UNZ_PARAMERROR;
+    s = (unz64_stream_s*)stream;
+    if (s->stream_initialised == Z_DEFLATED)
+        inflateEnd(&s->stream);
+    TRYFREE(s->buffer);
+    TRYFREE(s);
+    return UNZ_OK;
+}
@@ -20,6 +20,7 @@
 #include <time.h>
 #include <zlib.h>
 #include "zip.h"
+#include "unzip.h"
 
 #ifdef STDC
 #  include <stddef.h>
@@ -51,12 +52,16 @@
 #  include "crypt.h"
 #endif
 
+#ifndef NO_PARALLEL_DEFLATE
+#  include <pthread.h>
+#endif
+
 #ifndef local
 #  define local static
 #endif
 /* compile with -Dlocal if your debugger can't find static symbols */
 
-#define SIZEDATA_INDATABLOCK        (4096-(4*4))
+#define SIZEDATA_INITIALARENA       (4096)
 
 #define DISKHEADERMAGIC             (0x08074b50)
 #define LOCALHEADERMAGIC            (0x04034b50)
@@ -87,6 +92,14 @@
 #  define Z_MAXFILENAMEINZIP (256)
 #endif
 
+#ifndef NO_PARALLEL_DEFLATE
+#  ifndef PARALLEL_BLOCKSIZE
+#    define PARALLEL_BLOCKSIZE (128*1024) /* uncompressed bytes per independently deflated block */
+#  endif
+#  define PARALLEL_DICTSIZE        (32*1024)  /* deflate window carried over from the previous block */
+#  define PARALLEL_MAXTHREADS      (16)
+#endif
+
 #ifndef ALLOC
 #  define ALLOC(size) (malloc(size))
 #endif
@@ -107,20 +120,58 @@
 
 const char zip_copyright[] = " zip 1.01 Copyright 1998-2004 Gilles Vollant - http://www.winimage.com/zLibDll";
 
-typedef struct linkedlist_datablock_internal_s
+typedef struct arena_data_s
 {
-    struct linkedlist_datablock_internal_s* next_datablock;
-    uLong  avail_in_this_block;
-    uLong  filled_in_this_block;
-    uLong  unused; /* for future use and alignment */
-    unsigned char data[SIZEDATA_INDATABLOCK];
-} linkedlist_datablock_internal;
-
-typedef struct linkedlist_data_s
+    unsigned char* data;            /* contiguous buffer, grown geometrically */
+    uLong filled;                   /* bytes committed to the buffer */
+    uLong allocated;                /* bytes allocated for the buffer */
+} arena_data;
+
+#ifndef NO_PARALLEL_DEFLATE
+typedef struct parallel_block_s
 {
-    linkedlist_datablock_internal* first_block;
-    linkedlist_datablock_internal* last_block;
-} linkedlist_data;
+    unsigned char* in;              /* uncompressed input of this block */
+    uInt in_len;
+    unsigned char* dict;            /* tail of the previous block, used as preset dictionary */
+    uInt dict_len;
+    unsigned char* out;             /* raw deflate output, byte aligned */
+    uLong out_len;
+    uLong out_size;
+    uLong crc32;                    /* crc of in[0..in_len) only, combined in order by the writer */
+    int last;                       /* 1 if this block ends the deflate stream */
+    int state;                      /* PARALLEL_BLOCK_xxx */
+    int err;
+} parallel_block;
+
+#define PARALLEL_BLOCK_FREE     (0)
+#define PARALLEL_BLOCK_FILLING  (1)
+#define PARALLEL_BLOCK_QUEUED   (2)
+#define PARALLEL_BLOCK_BUSY     (3)
+#define PARALLEL_BLOCK_DONE     (4)
+
+typedef struct parallel_deflate_s
+{
+    pthread_t threads[PARALLEL_MAXTHREADS];
+    int number_threads;             /* number of workers actually started */
+    int started;                    /* 1 once the worker pool is running */
+    int stop;                       /* asks the workers to exit */
+    pthread_mutex_t lock;
+    pthread_cond_t block_queued;
+    pthread_cond_t block_done;
+
+    parallel_block* blocks;         /* ring of blocks, written out in submission order */
+    int number_blocks;
+    int next_to_fill;               /* slot used by the next block the caller fills */
+    int next_to_write;              /* oldest submitted block not written yet */
+    int filling;                    /* block receiving caller input, -1 if none */
+    int pending;                    /* blocks submitted but not written yet */
+    ZPOS64_T number_submitted;
+
+    int level;
+    int memLevel;
+    int strategy;
+} parallel_deflate;
+#endif
 
 typedef struct
 {
@@ -159,6 +210,9 @@ typedef struct
     const unsigned long* pcrc_32_tab;
     int crypt_header_size;
 #endif
+#ifndef NO_PARALLEL_DEFLATE
+    parallel_deflate* parallel;     /* non NULL if blocks are deflated on a worker pool */
+#endif
 } curfile64_info;
 
 typedef struct
@@ -166,7 +220,7 @@ typedef struct
     zlib_filefunc64_32_def z_filefunc;
     voidpf filestream;              /* io structure of the zipfile */
     voidpf filestream_with_CD;      /* io structure of the zipfile with the central dir */
-    linkedlist_data central_dir;    /* datablock with central dir in construction*/
+    arena_data central_dir;         /* arena with central dir in construction*/
     int in_opened_file_inzip;       /* 1 if a file in the zip is currently writ.*/
     int append;                     /* append mode */
     curfile64_info ci;              /* info on the file currently writing */
@@ -182,100 +236,64 @@ typedef struct
 #endif
 } zip64_internal;
 
-/* Allocate a new data block */
-local linkedlist_datablock_internal* allocate_new_datablock OF((void));
-local linkedlist_datablock_internal* allocate_new_datablock()
+/* Initialize arena */
+local void init_arena OF((arena_data* arena));
+local void init_arena(arena_data* arena)
 {
-    linkedlist_datablock_internal* ldi;
-
-    ldi = (linkedlist_datablock_internal*)ALLOC(sizeof(linkedlist_datablock_internal));
-
-    if (ldi != NULL)
-    {
-        ldi->next_datablock = NULL;
-        ldi->filled_in_this_block = 0;
-        ldi->avail_in_this_block = SIZEDATA_INDATABLOCK;
-    }
-    return ldi;
+    arena->data = NULL;
+    arena->filled = arena->allocated = 0;
 }
 
-/* Free data block in linked list */
-local void free_datablock OF((linkedlist_datablock_internal* ldi));
-local void free_datablock(linkedlist_datablock_internal* ldi)
+/* Free arena buffer */
+local void free_arena OF((arena_data* arena));
+local void free_arena(arena_data* arena)
 {
-    while (ldi != NULL)
-    {
-        linkedlist_datablock_internal* ldinext = ldi->next_datablock;
-        TRYFREE(ldi);
-        ldi = ldinext;
-    }
+    TRYFREE(arena->data);
+    init_arena(arena);
 }
 
-/* Initialize linked list */
-local void init_linkedlist OF((linkedlist_data* ll));
-local void init_linkedlist(linkedlist_data* ll)
+/* Ensure room for len more bytes after the filled part, returns pointer to it */
+local unsigned char* reserve_in_arena OF((arena_data* arena, uLong len));
+local unsigned char* reserve_in_arena(arena_data* arena, uLong len)
 {
-    ll->first_block = ll->last_block = NULL;
-}
+    uLong allocated = arena->allocated;
+    unsigned char* data;
 
-/* Free entire linked list and all data blocks */
-local void free_linkedlist OF((linkedlist_data* ll));
-local void free_linkedlist(linkedlist_data* ll)
-{
-    free_datablock(ll->first_block);
-    ll->first_block = ll->last_block = NULL;
-}
-
-/* Add data to linked list data block */
-local int add_data_in_datablock OF((linkedlist_data* ll, const void* buf, uLong len));
-local int add_data_in_datablock(linkedlist_data* ll, const void* buf, uLong len)
-{
-    linkedlist_datablock_internal* ldi;
-    const unsigned char* from_copy;
-
-    if (ll == NULL)
-        return ZIP_INTERNALERROR;
-
-    if (ll->last_block == NULL)
-    {
-        ll->first_block = ll->last_block = allocate_new_datablock();
-        if (ll->first_block == NULL)
-            return ZIP_INTERNALERROR;
-    }
-
-    ldi = ll->last_block;
-    from_copy = (unsigned char*)buf;
+    if (len > (uLong)-1 - arena->filled)
+        return NULL;
+    if (arena->filled + len <= allocated)
+        return arena->data + arena->filled;
 
-    while (len > 0)
+    if (allocated == 0)
+        allocated = SIZEDATA_INITIALARENA;
+    while (allocated < arena->filled + len)
     {
-        uInt copy_this;
-        uInt i;
-        unsigned char* to_copy;
-
-        if (ldi->avail_in_this_block == 0)
+        if (allocated > ((uLong)-1) / 2)
         {
-            ldi->next_datablock = allocate_new_datablock();
-            if (ldi->next_datablock == NULL)
-                return ZIP_INTERNALERROR;
-            ldi = ldi->next_datablock ;
-            ll->last_block = ldi;
+            allocated = arena->filled + len;
+            break;
         }
+        allocated *= 2;
+    }
 
-        if (ldi->avail_in_this_block < len)
-            copy_this = (uInt)ldi->avail_in_this_block;
-        else
-            copy_this = (uInt)len;
-
-        to_copy = &(ldi->data[ldi->filled_in_this_block]);
-
-        for (i = 0; i < copy_this; i++)
-            *(to_copy+i) = *(from_copy+i);
+    data = (unsigned char*)realloc(arena->data, allocated);
+    if (data == NULL)
+        return NULL;
+    arena->data = data;
+    arena->allocated = allocated;
+    return arena->data + arena->filled;
+}
 
-        ldi->filled_in_this_block += copy_this;
-        ldi->avail_in_this_block -= copy_this;
-        from_copy += copy_this;
-        len -= copy_this;
-    }
+/* Add data to the end of the arena */
+local int add_data_in_arena OF((arena_data* arena, const void* buf, uLong len));
+local int add_data_in_arena(arena_data* arena, const void* buf, uLong len)
+{
+    unsigned char* to_copy = reserve_in_arena(arena, len);
+    if (to_copy == NULL)
+        return ZIP_INTERNALERROR;
+    if (to_copy != buf)
+        memmove(to_copy, buf, len);
+    arena->filled += len;
     return ZIP_OK;
 }
 
@@ -673,7 +691,6 @@ extern zipFile ZEXPORT zipOpen4(const void *pathname, int append, ZPOS64_T disk_
     ZPOS64_T size_central_dir_to_read;
     uLong uL;
     uLong size_comment = 0;
-    size_t buf_size = SIZEDATA_INDATABLOCK;
     void* buf_read;
 #endif
     int err = ZIP_OK;
@@ -712,9 +729,12 @@ extern zipFile ZEXPORT zipOpen4(const void *pathname, int append, ZPOS64_T disk_
     ziinit.begin_pos = ZTELL64(ziinit.z_filefunc,ziinit.filestream);
     ziinit.in_opened_file_inzip = 0;
     ziinit.ci.stream_initialised = 0;
+#ifndef NO_PARALLEL_DEFLATE
+    ziinit.ci.parallel = NULL;
+#endif
     ziinit.number_entry = 0;
     ziinit.add_position_when_writting_offset = 0;
-    init_linkedlist(&(ziinit.central_dir));
+    init_arena(&(ziinit.central_dir));
 
     zi = (zip64_internal*)ALLOC(sizeof(zip64_internal));
     if (zi == NULL)
@@ -855,28 +875,24 @@ extern zipFile ZEXPORT zipOpen4(const void *pathname, int append, ZPOS64_T disk_
 
         /* Store central directory in memory */
         size_central_dir_to_read = size_central_dir;
-        buf_size = SIZEDATA_INDATABLOCK;
-        buf_read = (void*)ALLOC(buf_size);
+        if ((ZPOS64_T)(uLong)size_central_dir_to_read != size_central_dir_to_read)
+            err = ZIP_BADZIPFILE;
 
-        if (ZSEEK64(ziinit.z_filefunc, ziinit.filestream,
-                offset_central_dir + byte_before_the_zipfile, ZLIB_FILEFUNC_SEEK_SET) != 0)
+        if ((err == ZIP_OK) && (ZSEEK64(ziinit.z_filefunc, ziinit.filestream,
+                offset_central_dir + byte_before_the_zipfile, ZLIB_FILEFUNC_SEEK_SET) != 0))
             err = ZIP_ERRNO;
 
-        while ((size_central_dir_to_read > 0) && (err == ZIP_OK))
+        if ((err == ZIP_OK) && (size_central_dir_to_read > 0))
         {
-            ZPOS64_T read_this = SIZEDATA_INDATABLOCK;
-            if (read_this > size_central_dir_to_read)
-                read_this = size_central_dir_to_read;
-
-            if (ZREAD64(ziinit.z_filefunc, ziinit.filestream, buf_read, (uLong)read_this) != read_this)
+            buf_read = reserve_in_arena(&ziinit.central_dir, (uLong)size_central_dir_to_read);
+            if (buf_read == NULL)
+                err = ZIP_INTERNALERROR;
+            else if (ZREAD64(ziinit.z_filefunc, ziinit.filestream, buf_read,
+                    (uLong)size_central_dir_to_read) != size_central_dir_to_read)
                 err = ZIP_ERRNO;
-
-            if (err == ZIP_OK)
-                err = add_data_in_datablock(&ziinit.central_dir, buf_read, (uLong)read_this);
-
-            size_central_dir_to_read -= read_this;
+            else
+                ziinit.central_dir.filled += (uLong)size_central_dir_to_read;
         }
-        TRYFREE(buf_read);
 
         ziinit.begin_pos = byte_before_the_zipfile;
         ziinit.number_entry = number_entry_CD;
@@ -895,6 +911,7 @@ extern zipFile ZEXPORT zipOpen4(const void *pathname, int append, ZPOS64_T disk_
 #ifndef NO_ADDFILEINEXISTINGZIP
         TRYFREE(ziinit.globalcomment);
 #endif
+        free_arena(&ziinit.central_dir);
         TRYFREE(zi);
         return NULL;
     }
@@ -956,6 +973,15 @@ extern zipFile ZEXPORT zipOpen3_64(const void *pathname, int append, ZPOS64_T di
     return zipOpen4(pathname, append, disk_size, globalcomment, NULL);
 }
 
+extern zipFile ZEXPORT zipOpenMemory(zlib_memory_def* memory, int append)
+{
+    zlib_filefunc64_32_def zlib_filefunc64_32_def_fill;
+    fill_memory_filefunc64(&zlib_filefunc64_32_def_fill.zfile_func64);
+    zlib_filefunc64_32_def_fill.ztell32_file = NULL;
+    zlib_filefunc64_32_def_fill.zseek32_file = NULL;
+    return zipOpen4(memory, append, 0, NULL, &zlib_filefunc64_32_def_fill);
+}
+
 extern zipFile ZEXPORT zipOpen(const char* pathname, int append)
 {
     return zipOpen3((const void*)pathname,append,0,NULL,NULL);
@@ -966,10 +992,382 @@ extern zipFile ZEXPORT zipOpen64(const void* pathname, int append)
     return zipOpen3(pathname,append,0,NULL,NULL);
 }
 
-extern int ZEXPORT zipOpenNewFileInZip4_64(zipFile file, const char* filename, const zip_fileinfo* zipfi,
+#ifndef NO_PARALLEL_DEFLATE
+local int zip64FlushWriteBuffer OF((zip64_internal* zi));
+
+/* Deflates one block into a byte aligned piece of a raw deflate stream.
+   Every block but the last ends with a sync flush, so the pieces can simply be concatenated. */
+local int zip64local_parallel_deflate_block OF((z_stream* strm, parallel_block* blk));
+local int zip64local_parallel_deflate_block(z_stream* strm, parallel_block* blk)
+{
+    int err;
+    uLong bound;
+
+    blk->crc32 = crc32(0L, blk->in, blk->in_len);
+
+    err = deflateReset(strm);
+    if ((err == Z_OK) && (blk->dict_len > 0))
+        err = deflateSetDictionary(strm, blk->dict, blk->dict_len);
+    if (err != Z_OK)
+        return err;
+
+    /* deflateBound covers Z_FINISH, leave some room for the empty stored block of the sync flush */
+    bound = deflateBound(strm, blk->in_len) + 16;
+    if (blk->out_size < bound)
+    {
+        unsigned char* out = (unsigned char*)realloc(blk->out, bound);
+        if (out == NULL)
+            return Z_MEM_ERROR;
+        blk->out = out;
+        blk->out_size = bound;
+    }
+
+    strm->next_in = blk->in;
+    strm->avail_in = blk->in_len;
+    strm->next_out = blk->out;
+    strm->avail_out = (uInt)blk->out_size;
+    blk->out_len = 0;
+
+    for (;;)
+    {
+        err = deflate(strm, blk->last ? Z_FINISH : Z_SYNC_FLUSH);
+        blk->out_len = blk->out_size - strm->avail_out;
+
+        if (blk->last && (err == Z_STREAM_END))
+            return Z_OK;
+        if (!blk->last && (err == Z_OK) && (strm->avail_in == 0) && (strm->avail_out > 0))
+            return Z_OK;
+        if ((err != Z_OK) && (err != Z_BUF_ERROR))
+            return err;
+
+        /* Ran out of output space, grow and continue */
+        {
+            uLong size = blk->out_size * 2;
+            unsigned char* out = (unsigned char*)realloc(blk->out, size);
+            if (out == NULL)
+                return Z_MEM_ERROR;
+            blk->out = out;
+            blk->out_size = size;
+            strm->next_out = blk->out + blk->out_len;
+            strm->avail_out = (uInt)(blk->out_size - blk->out_len);
+        }
+    }
+}
+
+local void* zip64local_parallel_worker OF((void* arg));
+local void* zip64local_parallel_worker(void* arg)
+{
+    parallel_deflate* pd = (parallel_deflate*)arg;
+    z_stream strm;
+    int init_err;
+    int i;
+
+    memset(&strm, 0, sizeof(strm));
+    init_err = deflateInit2(&strm, pd->level, Z_DEFLATED, -MAX_WBITS, pd->memLevel, pd->strategy);
+
+    pthread_mutex_lock(&pd->lock);
+    for (;;)
+    {
+        parallel_block* blk = NULL;
+
+        /* Take the oldest queued block so the writer is never starved */
+        for (i = 0; i < pd->number_blocks; i++)
+        {
+            parallel_block* candidate = &pd->blocks[(pd->next_to_write + i) % pd->number_blocks];
+            if (candidate->state == PARALLEL_BLOCK_QUEUED)
+            {
+                blk = candidate;
+                break;
+            }
+        }
+        if (blk == NULL)
+        {
+            if (pd->stop)
+                break;
+            pthread_cond_wait(&pd->block_queued, &pd->lock);
+            continue;
+        }
+
+        blk->state = PARALLEL_BLOCK_BUSY;
+        pthread_mutex_unlock(&pd->lock);
+
+        if (init_err == Z_OK)
+            blk->err = zip64local_parallel_deflate_block(&strm, blk);
+        else
+            blk->err = init_err;
+
+        pthread_mutex_lock(&pd->lock);
+        blk->state = PARALLEL_BLOCK_DONE;
+        pthread_cond_broadcast(&pd->block_done);
+    }
+    pthread_mutex_unlock(&pd->lock);
+
+    if (init_err == Z_OK)
+        deflateEnd(&strm);
+    return NULL;
+}
+
+local parallel_deflate* zip64local_parallel_create OF((int threads, int level, int memLevel, int strategy));
+local parallel_deflate* zip64local_parallel_create(int threads, int level, int memLevel, int strategy)
+{
+    parallel_deflate* pd;
+
+    if (threads > PARALLEL_MAXTHREADS)
+        threads = PARALLEL_MAXTHREADS;
+
+    pd = (parallel_deflate*)ALLOC(sizeof(parallel_deflate));
+    if (pd == NULL)
+        return NULL;
+    memset(pd, 0, sizeof(parallel_deflate));
+
+    /* Two blocks per worker keeps every worker busy while the caller fills the next one */
+    pd->number_blocks = threads * 2;
+    pd->blocks = (parallel_block*)ALLOC(sizeof(parallel_block) * pd->number_blocks);
+    if (pd->blocks == NULL)
+    {
+        TRYFREE(pd);
+        return NULL;
+    }
+    memset(pd->blocks, 0, sizeof(parallel_block) * pd->number_blocks);
+
+    pd->number_threads = threads;
+    pd->filling = -1;
+    pd->level = level;
+    pd->memLevel = memLevel;
+    pd->strategy = strategy;
+
+    pthread_mutex_init(&pd->lock, NULL);
+    pthread_cond_init(&pd->block_queued, NULL);
+    pthread_cond_init(&pd->block_done, NULL);
+    return pd;
+}
+
+local void zip64local_parallel_free OF((parallel_deflate* pd));
+local void zip64local_parallel_free(parallel_deflate* pd)
+{
+    int i;
+
+    if (pd == NULL)
+        return;
+
+    if (pd->started)
+    {
+        pthread_mutex_lock(&pd->lock);
+        pd->stop = 1;
+        pthread_cond_broadcast(&pd->block_queued);
+        pthread_mutex_unlock(&pd->lock);
+
+        for (i = 0; i < pd->number_threads; i++)
+            pthread_join(pd->threads[i], NULL);
+    }
+
+    for (i = 0; i < pd->number_blocks; i++)
+    {
+        TRYFREE(pd->blocks[i].in);
+        TRYFREE(pd->blocks[i].dict);
+        TRYFREE(pd->blocks[i].out);
+    }
+    TRYFREE(pd->blocks);
+
+    pthread_cond_destroy(&pd->block_done);
+    pthread_cond_destroy(&pd->block_queued);
+    pthread_mutex_destroy(&pd->lock);
+    TRYFREE(pd);
+}
+
+local int zip64local_parallel_start OF((parallel_deflate* pd));
+local int zip64local_parallel_start(parallel_deflate* pd)
+{
+    int i;
+
+    for (i = 0; i < pd->number_threads; i++)
+    {
+        if (pthread_create(&pd->threads[i], NULL, zip64local_parallel_worker, pd) != 0)
+            break;
+    }
+    if (i == 0)
+        return ZIP_INTERNALERROR;
+
+    pd->number_threads = i;
+    pd->started = 1;
+    return ZIP_OK;
+}
+
+/* Writes the compressed output of a finished block through the regular write buffer */
+local int zip64local_parallel_write_block OF((zip64_internal* zi, parallel_block* blk));
+local int zip64local_parallel_write_block(zip64_internal* zi, parallel_block* blk)
+{
+    uLong written = 0;
+    int err = ZIP_OK;
+
+    if (blk->err != Z_OK)
+        return ZIP_INTERNALERROR;
+
+    zi->ci.crc32 = crc32_combine(zi->ci.crc32, blk->crc32, (z_off_t)blk->in_len);
+    zi->ci.stream.total_in += blk->in_len;
+
+    while ((err == ZIP_OK) && (written < blk->out_len))
+    {
+        uInt copy_this = Z_BUFSIZE - zi->ci.pos_in_buffered_data;
+        if (copy_this > blk->out_len - written)
+            copy_this = (uInt)(blk->out_len - written);
+
+        memcpy(zi->ci.buffered_data + zi->ci.pos_in_buffered_data, blk->out + written, copy_this);
+        zi->ci.pos_in_buffered_data += copy_this;
+        written += copy_this;
+
+        if (zi->ci.pos_in_buffered_data == Z_BUFSIZE)
+        {
+            if (zip64FlushWriteBuffer(zi) == ZIP_ERRNO)
+                err = ZIP_ERRNO;
+        }
+    }
+    return err;
+}
+
+/* Writes finished blocks in submission order. Blocks until at least min_blocks have been
+   written (or nothing is pending), then keeps going while the next block is already done. */
+local int zip64local_parallel_drain OF((zip64_internal* zi, int min_blocks));
+local int zip64local_parallel_drain(zip64_internal* zi, int min_blocks)
+{
+    parallel_deflate* pd = zi->ci.parallel;
+    int written = 0;
+    int err = ZIP_OK;
+
+    pthread_mutex_lock(&pd->lock);
+    while ((err == ZIP_OK) && (pd->pending > 0))
+    {
+        parallel_block* blk = &pd->blocks[pd->next_to_write];
+
+        if (blk->state != PARALLEL_BLOCK_DONE)
+        {
+            if (written >= min_blocks)
+                break;
+            pthread_cond_wait(&pd->block_done, &pd->lock);
+            continue;
+        }
+
+        pthread_mutex_unlock(&pd->lock);
+        err = zip64local_parallel_write_block(zi, blk);
+        pthread_mutex_lock(&pd->lock);
+
+        blk->state = PARALLEL_BLOCK_FREE;
+        pd->next_to_write = (pd->next_to_write + 1) % pd->number_blocks;
+        pd->pending--;
+        written++;
+    }
+    pthread_mutex_unlock(&pd->lock);
+    return err;
+}
+
+/* Returns the block receiving caller input, writing out the oldest block first if the ring is full */
+local parallel_block* zip64local_parallel_filling_block OF((zip64_internal* zi));
+local parallel_block* zip64local_parallel_filling_block(zip64_internal* zi)
+{
+    parallel_deflate* pd = zi->ci.parallel;
+    parallel_block* blk;
+
+    if (pd->filling >= 0)
+        return &pd->blocks[pd->filling];
+
+    if (pd->pending == pd->number_blocks)
+    {
+        if (zip64local_parallel_drain(zi, 1) != ZIP_OK)
+            return NULL;
+    }
+
+    blk = &pd->blocks[pd->next_to_fill];
+    if (blk->in == NULL)
+        blk->in = (unsigned char*)ALLOC(PARALLEL_BLOCKSIZE);
+    if (blk->dict == NULL)
+        blk->dict = (unsigned char*)ALLOC(PARALLEL_DICTSIZE);
+    if ((blk->in == NULL) || (blk->dict == NULL))
+        return NULL;
+
+    blk->in_len = 0;
+    blk->dict_len = 0;
+    blk->last = 0;
+    blk->err = Z_OK;
+    blk->state = PARALLEL_BLOCK_FILLING;
+
+    /* Prime with the end of the previous block so matches may reach back across the boundary.
+       The previous block keeps its input until its slot is filled again, which cannot happen yet. */
+    if (pd->number_submitted > 0)
+    {
+        parallel_block* prev = &pd->blocks[(pd->next_to_fill + pd->number_blocks - 1) % pd->number_blocks];
+        blk->dict_len = prev->in_len < PARALLEL_DICTSIZE ? prev->in_len : PARALLEL_DICTSIZE;
+        memcpy(blk->dict, prev->in + prev->in_len - blk->dict_len, blk->dict_len);
+    }
+
+    pd->filling = pd->next_to_fill;
+    pd->next_to_fill = (pd->next_to_fill + 1) % pd->number_blocks;
+    return blk;
+}
+
+/* Hands the filling block to the workers, starting them on first use */
+local int zip64local_parallel_submit OF((zip64_internal* zi, int last));
+local int zip64local_parallel_submit(zip64_internal* zi, int last)
+{
+    parallel_deflate* pd = zi->ci.parallel;
+    parallel_block* blk = zip64local_parallel_filling_block(zi);
+    int err = ZIP_OK;
+
+    if (blk == NULL)
+        return ZIP_INTERNALERROR;
+
+    if (!pd->started)
+        err = zip64local_parallel_start(pd);
+    if (err != ZIP_OK)
+        return err;
+
+    pthread_mutex_lock(&pd->lock);
+    blk->last = last;
+    blk->state = PARALLEL_BLOCK_QUEUED;
+    pd->filling = -1;
+    pd->pending++;
+    pd->number_submitted++;
+    pthread_cond_signal(&pd->block_queued);
+    pthread_mutex_unlock(&pd->lock);
+
+    /* Keep the output flowing without stalling the caller */
+    return zip64local_parallel_drain(zi, 0);
+}
+
+local int zip64local_parallel_write OF((zip64_internal* zi, const void* buf, unsigned int len));
+local int zip64local_parallel_write(zip64_internal* zi, const void* buf, unsigned int len)
+{
+    const unsigned char* from_copy = (const unsigned char*)buf;
+    int err = ZIP_OK;
+
+    while ((err == ZIP_OK) && (len > 0))
+    {
+        parallel_block* blk = zip64local_parallel_filling_block(zi);
+        uInt copy_this;
+
+        if (blk == NULL)
+            return ZIP_INTERNALERROR;
+
+        copy_this = PARALLEL_BLOCKSIZE - blk->in_len;
+        if (copy_this > len)
+            copy_this = len;
+
+        memcpy(blk->in + blk->in_len, from_copy, copy_this);
+        blk->in_len += copy_this;
+        from_copy += copy_this;
+        len -= copy_this;
+
+        if (blk->in_len == PARALLEL_BLOCKSIZE)
+            err = zip64local_parallel_submit(zi, 0);
+    }
+    return err;
+}
+#endif
+
+extern int ZEXPORT zipOpenNewFileInZip5(zipFile file, const char* filename, const zip_fileinfo* zipfi,
     const void* extrafield_local, uInt size_extrafield_local, const void* extrafield_global,
     uInt size_extrafield_global, const char* comment, int method, int level, int raw, int windowBits, int memLevel,
-    int strategy, const char* password, uLong crcForCrypting, uLong versionMadeBy, uLong flagBase, int zip64)
+    int strategy, const char* password, uLong crcForCrypting, uLong versionMadeBy, uLong flagBase, int zip64,
+    int threads)
 {
     zip64_internal* zi;
     uInt size_filename;
@@ -1069,7 +1467,12 @@ extern int ZEXPORT zipOpenNewFileInZip4_64(zipFile file, const char* filename, c
     if (zi->ci.method == AES_METHOD)
         zi->ci.size_centralextrafree += 11; /* Extra space reserved for AES extra info */
 #endif
-    zi->ci.central_header = (char*)ALLOC((uInt)zi->ci.size_centralheader + zi->ci.size_centralextrafree + size_comment);
+    /* Build the central header in place at the end of the central dir arena, it is committed
+       when the file is closed. No other data is added to the arena while the file is open. */
+    zi->ci.central_header = (char*)reserve_in_arena(&zi->central_dir,
+        zi->ci.size_centralheader + zi->ci.size_centralextrafree + size_comment);
+    if (zi->ci.central_header == NULL)
+        return ZIP_INTERNALERROR;
     zi->ci.number_disk = zi->number_disk;
 
     /* Write central directory header */
@@ -1111,8 +1514,6 @@ extern int ZEXPORT zipOpenNewFileInZip4_64(zipFile file, const char* filename, c
         zi->ci.central_header[zi->ci.size_centralheader+
             zi->ci.size_centralextrafree+i] = comment[i];
 
-    if (zi->ci.central_header == NULL)
-        return ZIP_INTERNALERROR;
 
     zi->ci.zip64 = zip64;
     zi->ci.total_compressed = 0;
@@ -1308,11 +1709,31 @@ extern int ZEXPORT zipOpenNewFileInZip4_64(zipFile file, const char* filename, c
     }
 #endif
 
+#ifndef NO_PARALLEL_DEFLATE
+    zi->ci.parallel = NULL;
+    /* The workers use their own raw streams, the regular stream stays initialised for entries
+       smaller than one block, which are deflated on the caller thread when closed */
+    if ((err == Z_OK) && (threads > 1) && (zi->ci.stream_initialised == Z_DEFLATED))
+        zi->ci.parallel = zip64local_parallel_create(threads, level, memLevel, strategy);
+#else
+    (threads);
+#endif
+
     if (err == Z_OK)
         zi->in_opened_file_inzip = 1;
     return err;
 }
 
+extern int ZEXPORT zipOpenNewFileInZip4_64(zipFile file, const char* filename, const zip_fileinfo* zipfi,
+    const void* extrafield_local, uInt size_extrafield_local, const void* extrafield_global,
+    uInt size_extrafield_global, const char* comment, int method, int level, int raw, int windowBits, int memLevel,
+    int strategy, const char* password, uLong crcForCrypting, uLong versionMadeBy, uLong flagBase, int zip64)
+{
+    return zipOpenNewFileInZip5(file, filename, zipfi, extrafield_local, size_extrafield_local,
+        extrafield_global, size_extrafield_global, comment, method, level, raw, windowBits, memLevel,
+        strategy, password, crcForCrypting, versionMadeBy, flagBase, zip64, 0);
+}
+
 extern int ZEXPORT zipOpenNewFileInZip4(zipFile file, const char* filename, const zip_fileinfo* zipfi,
     const void* extrafield_local, uInt size_extrafield_local, const void* extrafield_global,
     uInt size_extrafield_global, const char* comment, int method, int level, int raw, int windowBits,
@@ -1380,7 +1801,6 @@ extern int ZEXPORT zipOpenNewFileInZip(zipFile file, const char* filename, const
 }
 
 /* Flushes the write buffer to disk */
-local int zip64FlushWriteBuffer OF((zip64_internal* zi));
 local int zip64FlushWriteBuffer(zip64_internal* zi)
 {
     int err = ZIP_OK;
@@ -1478,7 +1898,14 @@ extern int ZEXPORT zipWriteInFileInZip(zipFile file,const void* buf,unsigned int
     if (zi->in_opened_file_inzip == 0)
         return ZIP_PARAMERROR;
 
-    zi->ci.crc32 = crc32(zi->ci.crc32, buf, (uInt)len);
+#ifndef NO_PARALLEL_DEFLATE
+    if (zi->ci.parallel != NULL)
+        return zip64local_parallel_write(zi, buf, len);
+#endif
+
+    /* Raw data is already compressed, its crc is given to zipCloseFileInZipRaw */
+    if (!zi->ci.raw)
+        zi->ci.crc32 = crc32(zi->ci.crc32, buf, (uInt)len);
 
 #ifdef HAVE_BZIP2
     if ((zi->ci.compression_method == Z_BZIP2ED) && (!zi->ci.raw))
@@ -1537,15 +1964,13 @@ extern int ZEXPORT zipWriteInFileInZip(zipFile file,const void* buf,unsigned int
             }
             else
             {
-                uInt copy_this,i;
+                uInt copy_this;
                 if (zi->ci.stream.avail_in < zi->ci.stream.avail_out)
                     copy_this = zi->ci.stream.avail_in;
                 else
                     copy_this = zi->ci.stream.avail_out;
 
-                for (i = 0; i < copy_this; i++)
-                    *(((char*)zi->ci.stream.next_out)+i) =
-                        *(((const char*)zi->ci.stream.next_in)+i);
+                memcpy(zi->ci.stream.next_out, zi->ci.stream.next_in, copy_this);
 
                 zi->ci.stream.avail_in  -= copy_this;
                 zi->ci.stream.avail_out -= copy_this;
@@ -1574,6 +1999,7 @@ extern int ZEXPORT zipCloseFileInZipRaw64(zipFile file, ZPOS64_T uncompressed_si
     uLong i = 0;
     short datasize = 0;
     int err = ZIP_OK;
+    int parallel_finished = 0;
 
     if (file == NULL)
         return ZIP_PARAMERROR;
@@ -1583,9 +2009,32 @@ extern int ZEXPORT zipCloseFileInZipRaw64(zipFile file, ZPOS64_T uncompressed_si
         return ZIP_PARAMERROR;
     zi->ci.stream.avail_in = 0;
 
+#ifndef NO_PARALLEL_DEFLATE
+    if (zi->ci.parallel != NULL)
+    {
+        parallel_deflate* pd = zi->ci.parallel;
+
+        if (pd->started)
+        {
+            /* The last block terminates the stream, the regular stream must not add another end */
+            err = zip64local_parallel_submit(zi, 1);
+            if (err == ZIP_OK)
+                err = zip64local_parallel_drain(zi, pd->number_blocks);
+            if (err == ZIP_OK)
+                parallel_finished = 1;
+        }
+        zi->ci.parallel = NULL;
+
+        /* Never got past the first block: deflate it on this thread with the regular stream */
+        if ((err == ZIP_OK) && !parallel_finished && (pd->filling >= 0))
+            err = zipWriteInFileInZip(file, pd->blocks[pd->filling].in, pd->blocks[pd->filling].in_len);
+        zip64local_parallel_free(pd);
+    }
+#endif
+
     if (!zi->ci.raw)
     {
-        if (zi->ci.compression_method == Z_DEFLATED)
+        if ((zi->ci.compression_method == Z_DEFLATED) && !parallel_finished)
         {
             while (err == ZIP_OK)
             {
@@ -1782,9 +2231,9 @@ extern int ZEXPORT zipCloseFileInZipRaw64(zipFile file, ZPOS64_T uncompressed_si
     zi->ci.size_centralheader += zi->ci.size_comment;
 
     if (err == ZIP_OK)
-        err = add_data_in_datablock(&zi->central_dir, zi->ci.central_header, (uLong)zi->ci.size_centralheader);
+        err = add_data_in_arena(&zi->central_dir, zi->ci.central_header, (uLong)zi->ci.size_centralheader);
 
-    free(zi->ci.central_header);
+    zi->ci.central_header = NULL;
 
     if (err == ZIP_OK)
     {
@@ -1844,6 +2293,135 @@ extern int ZEXPORT zipCloseFileInZip(zipFile file)
     return zipCloseFileInZipRaw(file, 0, 0);
 }
 
+/* Remove the zip64 extended information (0x0001) from an extra field, zip.c writes its own */
+local uInt zip64local_StripZip64Extra OF((char* extra, uInt size_extra));
+local uInt zip64local_StripZip64Extra(char* extra, uInt size_extra)
+{
+    uInt pos = 0;
+
+    while (pos + 4 <= size_extra)
+    {
+        uInt header = (uInt)(unsigned char)extra[pos] | ((uInt)(unsigned char)extra[pos+1] << 8);
+        uInt datasize = (uInt)(unsigned char)extra[pos+2] | ((uInt)(unsigned char)extra[pos+3] << 8);
+
+        if (pos + 4 + datasize > size_extra)
+            break;
+        if (header == 0x0001)
+        {
+            memmove(extra + pos, extra + pos + 4 + datasize, size_extra - pos - 4 - datasize);
+            size_extra -= 4 + datasize;
+        }
+        else
+            pos += 4 + datasize;
+    }
+    return size_extra;
+}
+
+extern int ZEXPORT zipCopyEntryRaw(voidp source_file, zipFile file)
+{
+    unzFile source = (unzFile)source_file;
+    unz_file_info64 file_info;
+    zip_fileinfo zipfi;
+    char* filename = NULL;
+    char* extrafield_global = NULL;
+    char* extrafield_local = NULL;
+    char* comment = NULL;
+    void* buf = NULL;
+    int size_extrafield_local = 0;
+    int method = 0;
+    int level = 0;
+    int zip64 = 0;
+    int read = 0;
+    int err = ZIP_OK;
+
+    if ((source == NULL) || (file == NULL))
+        return ZIP_PARAMERROR;
+
+    if (unzGetCurrentFileInfo64(source, &file_info, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
+        return ZIP_BADZIPFILE;
+    /* Encrypted data can't be carried over, zip.c would encrypt it again */
+    if ((file_info.flag & 1) != 0)
+        return ZIP_PARAMERROR;
+
+    filename = (char*)ALLOC(file_info.size_filename + 1);
+    extrafield_global = (char*)ALLOC(file_info.size_file_extra + 1);
+    comment = (char*)ALLOC(file_info.size_file_comment + 1);
+    buf = ALLOC(Z_BUFSIZE);
+    if ((filename == NULL) || (extrafield_global == NULL) || (comment == NULL) || (buf == NULL))
+        err = ZIP_INTERNALERROR;
+
+    if (err == ZIP_OK)
+    {
+        if (unzGetCurrentFileInfo64(source, &file_info, filename, file_info.size_filename + 1,
+                extrafield_global, file_info.size_file_extra, comment, file_info.size_file_comment + 1) != UNZ_OK)
+            err = ZIP_BADZIPFILE;
+        filename[file_info.size_filename] = 0;
+        comment[file_info.size_file_comment] = 0;
+    }
+
+    if ((err == ZIP_OK) && (unzOpenCurrentFile2(source, &method, &level, 1) != UNZ_OK))
+        err = ZIP_BADZIPFILE;
+
+    if (err == ZIP_OK)
+    {
+        size_extrafield_local = unzGetLocalExtrafield(source, NULL, 0);
+        if (size_extrafield_local < 0)
+            err = ZIP_BADZIPFILE;
+        else if (size_extrafield_local > 0)
+        {
+            extrafield_local = (char*)ALLOC((uInt)size_extrafield_local);
+            if (extrafield_local == NULL)
+                err = ZIP_INTERNALERROR;
+            else if (unzGetLocalExtrafield(source, extrafield_local, (unsigned)size_extrafield_local) != size_extrafield_local)
+                err = ZIP_BADZIPFILE;
+            else
+                size_extrafield_local = (int)zip64local_StripZip64Extra(extrafield_local, (uInt)size_extrafield_local);
+        }
+
+        if (err == ZIP_OK)
+        {
+            memset(&zipfi, 0, sizeof(zipfi));
+            zipfi.dosDate = file_info.dosDate;
+            zipfi.internal_fa = file_info.internal_fa;
+            zipfi.external_fa = file_info.external_fa;
+
+            if ((file_info.uncompressed_size >= 0xffffffff) || (file_info.compressed_size >= 0xffffffff))
+                zip64 = 1;
+
+            /* Keep the deflate option bits (1 and 2), level 0 leaves them untouched */
+            err = zipOpenNewFileInZip4_64(file, filename, &zipfi,
+                extrafield_local, (uInt)size_extrafield_local, extrafield_global,
+                zip64local_StripZip64Extra(extrafield_global, (uInt)file_info.size_file_extra),
+                (file_info.size_file_comment > 0) ? comment : NULL, method, 0, 1,
+                -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY, NULL, 0,
+                file_info.version, file_info.flag & 6, zip64);
+        }
+
+        while (err == ZIP_OK)
+        {
+            read = unzReadCurrentFile(source, buf, Z_BUFSIZE);
+            if (read < 0)
+                err = ZIP_BADZIPFILE;
+            if (read <= 0)
+                break;
+            err = zipWriteInFileInZip(file, buf, (unsigned)read);
+        }
+
+        if (err == ZIP_OK)
+            err = zipCloseFileInZipRaw64(file, file_info.uncompressed_size, file_info.crc);
+
+        if ((unzCloseCurrentFile(source) != UNZ_OK) && (err == ZIP_OK))
+            err = ZIP_BADZIPFILE;
+    }
+
+    TRYFREE(filename);
+    TRYFREE(extrafield_global);
+    TRYFREE(extrafield_local);
+    TRYFREE(comment);
+    TRYFREE(buf);
+    return err;
+}
+
 extern int ZEXPORT zipClose(zipFile file, const char* global_comment)
 {
     zip64_internal* zi;
@@ -1881,22 +2459,17 @@ extern int ZEXPORT zipClose(zipFile file, const char* global_comment)
 
     if (err == ZIP_OK)
     {
-        linkedlist_datablock_internal* ldi = zi->central_dir.first_block;
-        while (ldi!= NULL)
+        /* Whole central dir is contiguous, write it at once */
+        if (zi->central_dir.filled > 0)
         {
-            if ((err == ZIP_OK) && (ldi->filled_in_this_block > 0))
-            {
-                write = ZWRITE64(zi->z_filefunc, zi->filestream, ldi->data, ldi->filled_in_this_block);
-                if (write != ldi->filled_in_this_block)
-                    err = ZIP_ERRNO;
-            }
-
-            size_centraldir += ldi->filled_in_this_block;
-            ldi = ldi->next_datablock;
+            write = ZWRITE64(zi->z_filefunc, zi->filestream, zi->central_dir.data, zi->central_dir.filled);
+            if (write != zi->central_dir.filled)
+                err = ZIP_ERRNO;
         }
+        size_centraldir = zi->central_dir.filled;
     }
 
-    free_linkedlist(&(zi->central_dir));
+    free_arena(&(zi->central_dir));
 
     pos = centraldir_pos_inzip - zi->add_position_when_writting_offset;
 